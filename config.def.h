@@ -28,9 +28,8 @@ static const int topbar      = 1; /* 0 means bottom bar */
 static const unsigned int iconsize =
     16;                             /* size of client window icons in bar */
 const unsigned int sniconsize = 22; /* size of StatusNotifier systray icons */
-const unsigned int iconcachesize = 128; /* icon cache hash table size */
-const unsigned int iconcachemaxentries =
-    128; /* max cached icons before LRU eviction */
+const unsigned int iconcachebytes =
+    4 << 20; /* icon cache budget in bytes before LRU eviction */
 static const unsigned int motionfps =
     60; /* motion event throttle FPS (higher = more responsive) */
 const unsigned int dbustimeout =
@@ -41,6 +40,8 @@ const unsigned int dbustimeout =
 #define NOTIF_WIDTH 320       /* popup width in pixels               */
 #define NOTIF_DEFAULT_TIMEOUT 5000 /* auto-dismiss timeout in ms          */
 #define NOTIF_MAX_VISIBLE 5        /* max simultaneous popups             */
+#define NOTIF_RATE 1.0             /* new popups per second, per app      */
+#define NOTIF_BURST 5              /* ...after a burst of this many       */
 #define NOTIF_MARGIN_X 12          /* horizontal gap from screen edge     */
 #define NOTIF_MARGIN_Y 12          /* vertical gap from screen edge       */
 #define NOTIF_GAP 6                /* gap between stacked popups          */
@@ -34,8 +34,7 @@ static const unsigned int motionfps =
  * config.h); all other translation units get extern declarations via awm.h. */
 #ifdef AWM_CONFIG_IMPL
 const unsigned int sniconsize          = 22;  /* StatusNotifier icon size */
-const unsigned int iconcachesize       = 128; /* icon cache hash table size */
-const unsigned int iconcachemaxentries = 128; /* max cached icons (LRU) */
+const unsigned int iconcachebytes      = 4 << 20; /* icon cache budget */
 const unsigned int dbustimeout         = 100; /* D-Bus timeout (ms) */
 #endif
 
@@ -44,6 +43,8 @@ const unsigned int dbustimeout         = 100; /* D-Bus timeout (ms) */
 #define NOTIF_WIDTH 320       /* popup width in pixels               */
 #define NOTIF_DEFAULT_TIMEOUT 5000 /* auto-dismiss timeout in ms          */
 #define NOTIF_MAX_VISIBLE 5        /* max simultaneous popups             */
+#define NOTIF_RATE 1.0             /* new popups per second, per app      */
+#define NOTIF_BURST 5              /* ...after a burst of this many       */
 #define NOTIF_MARGIN_X 12          /* horizontal gap from screen edge     */
 #define NOTIF_MARGIN_Y 12          /* vertical gap from screen edge       */
 #define NOTIF_GAP 6                /* gap between stacked popups          */
@@ -25,6 +25,7 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <signal.h>
+#include <stdatomic.h>
 #include <sys/mman.h>
 #include <sys/socket.h>
 #include <sys/types.h>
@@ -41,6 +42,13 @@ awm_memfd_create(const char *name, unsigned int flags)
 {
 	return (int) syscall(SYS_memfd_create, name, flags);
 }
+/* glibc only declares the seal fcntls under _GNU_SOURCE */
+#ifndef F_ADD_SEALS
+#define F_ADD_SEALS 1033
+#define F_SEAL_SEAL 0x0001
+#define F_SEAL_SHRINK 0x0002
+#define F_SEAL_GROW 0x0004
+#endif
 #endif
 
 #include <glib-unix.h>
@@ -57,6 +65,7 @@ awm_memfd_create(const char *name, unsigned int flags)
 #include "icon.h"
 #include "monitor.h"
 #include "spawn.h"
+#include "startup.h"
 #include "status.h"
 #include "switcher.h"
 #include "systray.h"
@@ -71,6 +80,8 @@ awm_memfd_create(const char *name, unsigned int flags)
 Systray     *systray          = NULL;
 static pid_t ui_pid           = -1; /* awm-ui child process */
 static int   ui_fd            = -1; /* socket fd to awm-ui */
+static uint32_t ui_version;  /* protocol spoken with awm-ui, 0 until HELLO */
+static int      ui_disabled; /* awm-ui speaks another protocol: leave it */
 int          launcher_visible = 0;  /* 1 while the launcher window is open */
 xcb_window_t launcher_xwin    = 0;  /* X window ID sent by awm-ui on startup */
 static GMainContext *ui_ctx = NULL; /* GMainContext used by run() — kept for
@@ -178,6 +189,8 @@ cleanup(void)
 		systray = NULL;
 	}
 	status_cleanup();
+	ewmh_cleanup();
+	startup_cleanup();
 	/* Signal awm-ui to exit and reap it.
 	 * setup() sets SA_NOCLDWAIT so children are auto-reaped; just kill and
 	 * give the process a moment to exit — no waitpid needed. */
@@ -236,38 +249,29 @@ quit(const Arg *arg)
  * IPC helpers — awm → awm-ui
  * ---------------------------------------------------------------------- */
 
-/* Send a fixed-size inline payload to awm-ui.  Returns 0 on success. */
+/* Log a failed ui_msg_send_*() to awm-ui.  Returns r. */
 static int
-ui_send_inline(UiMsgType type, const void *payload, uint32_t len)
+ui_sent(UiMsgType type, int r)
 {
-	uint8_t buf[sizeof(UiMsgHeader) + UI_MSG_MAX_PAYLOAD];
-	ssize_t n;
-
-	if (ui_fd < 0)
-		return -1;
-	if (len > UI_MSG_MAX_PAYLOAD) {
-		awm_error("ui_send_inline: payload too large (%u)", len);
-		return -1;
-	}
-	{
-		UiMsgHeader *hdr = (UiMsgHeader *) buf;
-		hdr->type        = (uint32_t) type;
-		hdr->payload_len = len;
-		if (len > 0 && payload)
-			memcpy(buf + sizeof(UiMsgHeader), payload, len);
-	}
-	n = send(ui_fd, buf, sizeof(UiMsgHeader) + len, MSG_NOSIGNAL);
-	if (n < 0) {
-		awm_error("ui_send_inline: send: %s", strerror(errno));
-		return -1;
-	}
-	return 0;
+	if (r < 0)
+		awm_error("awm: send %s to awm-ui: %s", ui_msg_name(type),
+		    strerror(errno));
+	return r;
 }
 
-/* Broadcast current selmon workarea geometry to awm-ui so it can position
- * popups correctly.  Called once on startup and again on monitor changes. */
-void
-ui_send_monitor_geom(void)
+/* State messages (monitor geometry, theme) are coalesced: the public
+ * ui_send_*() calls only mark the state dirty, and one idle callback sends
+ * the latest value of each once the current main-loop iteration is done.
+ * A RandR storm or an xrdb reload that touches several resources thus
+ * costs awm-ui one message per kind instead of one per change. */
+enum { UI_DIRTY_GEOM = 1 << 0, UI_DIRTY_THEME = 1 << 1 };
+
+static unsigned int ui_dirty;
+static guint        ui_flush_id;
+
+/* Current selmon workarea geometry, so awm-ui can position popups. */
+static void
+ui_write_monitor_geom(void)
 {
 	UiMonitorGeomPayload p;
 
@@ -277,14 +281,13 @@ ui_send_monitor_geom(void)
 	p.wy = (int32_t) g_awm_selmon->wy;
 	p.ww = (int32_t) g_awm_selmon->ww;
 	p.wh = (int32_t) g_awm_selmon->wh;
-	ui_send_inline(UI_MSG_MONITOR_GEOM, &p, sizeof(p));
+	ui_sent(UI_MSG_MONITOR_GEOM, ui_msg_send_monitor_geom(ui_fd, &p));
 }
 
-/* Send current color scheme and bar font to awm-ui so notification popups
- * can match the WM visual theme.  Called once on startup and after every
- * xrdb reload. */
-void
-ui_send_theme(void)
+/* Current color scheme and bar font, so notification popups can match the
+ * WM visual theme. */
+static void
+ui_write_theme(void)
 {
 	UiThemePayload p;
 
@@ -327,105 +330,240 @@ ui_send_theme(void)
 
 	p.dpi = ui_dpi;
 
-	ui_send_inline(UI_MSG_THEME, &p, sizeof(p));
+	ui_sent(UI_MSG_THEME, ui_msg_send_theme(ui_fd, &p));
 }
 
-/* Send a bulk SHM message to awm-ui.  Creates an anonymous SHM fd, writes
- * shm_size bytes from base into it, and transmits the fd via SCM_RIGHTS.
- * The message header has type=type and payload_len=shm_size.
- * Returns 0 on success, -1 on failure.
+static gboolean
+ui_flush_state(gpointer data)
+{
+	(void) data;
+	ui_flush_id = 0;
+	if (ui_dirty & UI_DIRTY_GEOM)
+		ui_write_monitor_geom();
+	if (ui_dirty & UI_DIRTY_THEME)
+		ui_write_theme();
+	ui_dirty = 0;
+	return G_SOURCE_REMOVE;
+}
+
+static void
+ui_mark_dirty(unsigned int what)
+{
+	if (ui_fd < 0)
+		return;
+	ui_dirty |= what;
+	if (!ui_flush_id)
+		ui_flush_id = g_idle_add(ui_flush_state, NULL);
+}
+
+/* Broadcast current selmon workarea geometry to awm-ui.  Called once on
+ * startup and again on monitor changes. */
+void
+ui_send_monitor_geom(void)
+{
+	ui_mark_dirty(UI_DIRTY_GEOM);
+}
+
+/* Send current color scheme and bar font to awm-ui.  Called once on
+ * startup and after every xrdb reload. */
+void
+ui_send_theme(void)
+{
+	ui_mark_dirty(UI_DIRTY_THEME);
+}
+
+/* Create an anonymous SHM fd of size bytes.  Returns the fd or -1.
  *
- * We prefer memfd_create(2) for the anonymous fd: it is truly nameless,
- * never appears in /dev/shm, and avoids the PID-based shm_open name that
- * could collide if the process is restarted under the same PID.  If
- * memfd_create is not available at runtime we fall back to a shm_open name
- * that includes both the PID and a call-site sequence counter. */
+ * We prefer memfd_create(2): it is truly nameless, never appears in
+ * /dev/shm, and avoids the PID-based shm_open name that could collide if
+ * the process is restarted under the same PID.  If memfd_create is not
+ * available at runtime we fall back to a shm_open name that includes both
+ * the PID and a call-site sequence counter.  With seal set, a memfd is
+ * sealed against resizing so the peer's mapping can never be cut short
+ * under it (SIGBUS).  awm-ui refuses such an fd unsealed, so where seals
+ * exist, failing to seal (or having only the unsealable shm_open
+ * fallback) fails the call. */
 static int
-ui_send_shm(UiMsgType type, const void *base, size_t shm_size)
+ui_shm_create(const char *what, size_t size, int seal)
 {
 	int                 shm_fd = -1;
-	void               *mapped = MAP_FAILED;
-	int                 ret    = -1;
 	static unsigned int seq    = 0;
 
-	/* Prefer memfd_create — anonymous, no name-collision risk */
 #ifdef __linux__
-	shm_fd = awm_memfd_create("awm-preview", MFD_CLOEXEC);
+	shm_fd = awm_memfd_create(
+	    what, MFD_CLOEXEC | (seal ? MFD_ALLOW_SEALING : 0));
 #elif defined(__FreeBSD__)
-	shm_fd = memfd_create("awm-preview", MFD_CLOEXEC);
+	shm_fd = memfd_create(what, MFD_CLOEXEC | (seal ? MFD_ALLOW_SEALING : 0));
+#endif
+#ifdef F_ADD_SEALS
+	int memfd = shm_fd >= 0; /* only a memfd can be sealed */
 #endif
 	if (shm_fd < 0) {
 		/* Fallback: shm_open with a name that includes pid + seq counter */
 		char name[48];
-		snprintf(
-		    name, sizeof(name), "/awm-preview-%d-%u", (int) getpid(), seq++);
+		snprintf(name, sizeof(name), "/%s-%d-%u", what, (int) getpid(), seq++);
 		shm_fd = shm_open(name, O_CREAT | O_RDWR | O_TRUNC, 0600);
 		if (shm_fd < 0) {
-			awm_error("ui_send_shm: shm_open: %s", strerror(errno));
-			goto out;
+			awm_error("ui_shm_create: shm_open: %s", strerror(errno));
+			return -1;
 		}
 		shm_unlink(name); /* unlink immediately; fd keeps it alive */
 	}
 
-	if (ftruncate(shm_fd, (off_t) shm_size) < 0) {
-		awm_error("ui_send_shm: ftruncate: %s", strerror(errno));
-		goto out;
+	if (ftruncate(shm_fd, (off_t) size) < 0) {
+		awm_error("ui_shm_create: ftruncate: %s", strerror(errno));
+		close(shm_fd);
+		return -1;
+	}
+#ifdef F_ADD_SEALS
+	if (seal &&
+	    (!memfd ||
+	        fcntl(shm_fd, F_ADD_SEALS,
+	            F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) < 0)) {
+		awm_warn("ui_shm_create: cannot seal %s: %s", what,
+		    memfd ? strerror(errno) : "no memfd");
+		close(shm_fd);
+		return -1;
+	}
+#endif
+	return shm_fd;
+}
+
+/* Send a header-only message to awm-ui with fd attached as SCM_RIGHTS
+ * ancillary data; payload_len carries len.  Returns 0 on success. */
+static int
+ui_send_fd(UiMsgType type, int fd, size_t len)
+{
+	UiMsgHeader     hdr;
+	struct iovec    iov;
+	struct msghdr   mhdr;
+	uint8_t         cmsgbuf[CMSG_SPACE(sizeof(int))];
+	struct cmsghdr *cm;
+
+	hdr.type        = (uint32_t) type;
+	hdr.payload_len = (uint32_t) len;
+
+	iov.iov_base = &hdr;
+	iov.iov_len  = sizeof(hdr);
+
+	memset(&mhdr, 0, sizeof(mhdr));
+	mhdr.msg_iov        = &iov;
+	mhdr.msg_iovlen     = 1;
+	mhdr.msg_control    = cmsgbuf;
+	mhdr.msg_controllen = sizeof(cmsgbuf);
+
+	cm             = CMSG_FIRSTHDR(&mhdr);
+	cm->cmsg_level = SOL_SOCKET;
+	cm->cmsg_type  = SCM_RIGHTS;
+	cm->cmsg_len   = CMSG_LEN(sizeof(int));
+	memcpy(CMSG_DATA(cm), &fd, sizeof(int));
+
+	if (sendmsg(ui_fd, &mhdr, MSG_NOSIGNAL) < 0) {
+		awm_error("ui_send_fd: sendmsg: %s", strerror(errno));
+		return -1;
 	}
+	return 0;
+}
 
+/* Send a bulk message to awm-ui in a one-off SHM fd.  Only used when the
+ * arena below is unavailable or full.  Returns 0 on success, -1 on
+ * failure. */
+static int
+ui_send_shm(UiMsgType type, const void *base, size_t shm_size)
+{
+	void *mapped;
+	int   shm_fd, ret = -1;
+
+	if ((shm_fd = ui_shm_create("awm-preview", shm_size, 0)) < 0)
+		return -1;
 	mapped =
 	    mmap(NULL, shm_size, PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
 	if (mapped == MAP_FAILED) {
 		awm_error("ui_send_shm: mmap: %s", strerror(errno));
-		goto out;
+	} else {
+		memcpy(mapped, base, shm_size);
+		munmap(mapped, shm_size);
+		ret = ui_send_fd(type, shm_fd, shm_size);
 	}
-	memcpy(mapped, base, shm_size);
-	munmap(mapped, shm_size);
-	mapped = MAP_FAILED;
+	close(shm_fd);
+	return ret;
+}
 
-	/* Build SCM_RIGHTS message */
-	{
-		UiMsgHeader     hdr;
-		struct iovec    iov;
-		struct msghdr   mhdr;
-		uint8_t         cmsgbuf[CMSG_SPACE(sizeof(int))];
-		struct cmsghdr *cm;
-		ssize_t         n;
-
-		hdr.type        = (uint32_t) type;
-		hdr.payload_len = (uint32_t) shm_size;
-
-		iov.iov_base = &hdr;
-		iov.iov_len  = sizeof(hdr);
-
-		memset(&mhdr, 0, sizeof(mhdr));
-		mhdr.msg_iov        = &iov;
-		mhdr.msg_iovlen     = 1;
-		mhdr.msg_control    = cmsgbuf;
-		mhdr.msg_controllen = sizeof(cmsgbuf);
-
-		cm             = CMSG_FIRSTHDR(&mhdr);
-		cm->cmsg_level = SOL_SOCKET;
-		cm->cmsg_type  = SCM_RIGHTS;
-		cm->cmsg_len   = CMSG_LEN(sizeof(int));
-		memcpy(CMSG_DATA(cm), &shm_fd, sizeof(int));
-
-		n = sendmsg(ui_fd, &mhdr, MSG_NOSIGNAL);
-		if (n < 0) {
-			awm_error("ui_send_shm: sendmsg: %s", strerror(errno));
-			goto out;
-		}
+/* -------------------------------------------------------------------------
+ * Bulk arena — see "Bulk arena" in ui_proto.h
+ * ---------------------------------------------------------------------- */
+
+static uint8_t *ui_arena;      /* shared mapping, NULL if not set up */
+static uint32_t ui_arena_head; /* ring position of the next write */
+
+/* Create the arena and hand it to awm-ui.  Called once per awm-ui
+ * connection; on failure bulk messages use ui_send_shm(). */
+static void
+ui_arena_open(void)
+{
+	UiArenaHeader *h;
+	void          *p;
+	int            fd;
+
+	if ((fd = ui_shm_create("awm-arena", UI_ARENA_MAP_SIZE, 1)) < 0)
+		return;
+	p = mmap(NULL, UI_ARENA_MAP_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+	    0);
+	if (p == MAP_FAILED) {
+		awm_error("ui_arena_open: mmap: %s", strerror(errno));
+		close(fd);
+		return;
+	}
+	h        = p;
+	h->magic = UI_ARENA_MAGIC;
+	h->size  = UI_ARENA_RING;
+	atomic_init(&h->tail, 0);
+	if (ui_send_fd(UI_MSG_ARENA, fd, UI_ARENA_MAP_SIZE) < 0) {
+		munmap(p, UI_ARENA_MAP_SIZE);
+	} else {
+		ui_arena      = p;
+		ui_arena_head = 0;
 	}
-	ret = 0;
+	close(fd);
+}
 
-out:
-	if (shm_fd >= 0)
-		close(shm_fd);
-	return ret;
+static void
+ui_arena_close(void)
+{
+	if (ui_arena)
+		munmap(ui_arena, UI_ARENA_MAP_SIZE);
+	ui_arena = NULL;
+}
+
+/* Reserve len bytes of the ring for one message and fill in *ref.  Returns
+ * where to write the message, or NULL if there is no arena or awm-ui has
+ * not yet released enough space. */
+static uint8_t *
+ui_arena_reserve(uint32_t len, UiArenaRef *ref)
+{
+	UiArenaHeader *h = (UiArenaHeader *) ui_arena;
+	uint32_t       pos, skip, need, used;
+
+	if (!ui_arena || len == 0 || len > UI_ARENA_RING)
+		return NULL;
+	pos  = ui_arena_head & (UI_ARENA_RING - 1);
+	skip = pos + len > UI_ARENA_RING ? UI_ARENA_RING - pos : 0;
+	need = skip + ((len + 7u) & ~7u);
+	used = ui_arena_head -
+	    atomic_load_explicit(&h->tail, memory_order_acquire);
+	if (used + need > UI_ARENA_RING)
+		return NULL;
+
+	ui_arena_head += need;
+	ref->offset = skip ? 0 : pos;
+	ref->len    = len;
+	ref->end    = ui_arena_head;
+	return ui_arena + sizeof(UiArenaHeader) + ref->offset;
 }
 
 /* Build and send a UI_MSG_PREVIEW_SHOW message for bar hover on Monitor m.
  * Acquires fresh snapshot pixmaps from the compositor and transmits them
- * to awm-ui via SHM + SCM_RIGHTS. */
+ * to awm-ui through the bulk arena. */
 void
 bar_hover_enter(Monitor *m)
 {
@@ -433,8 +571,10 @@ bar_hover_enter(Monitor *m)
 	UiPreviewEntry      *entries;
 	unsigned int         count;
 	UiPreviewShowPayload hdr;
+	UiArenaRef           ref;
 	size_t               shm_size;
 	uint8_t             *shm_buf;
+	int                  sent = -1;
 
 	if (ui_fd < 0 || !m)
 		return;
@@ -445,37 +585,32 @@ bar_hover_enter(Monitor *m)
 		return;
 	}
 
-	shm_size = sizeof(UiPreviewShowPayload) + count * sizeof(UiPreviewEntry);
-	shm_buf  = malloc(shm_size);
-	if (!shm_buf) {
-		/* Free any snapshot pixmaps we just acquired */
-		{
-			unsigned int k;
-			for (k = 0; k < count; k++)
-				if (entries[k].pixmap_xid)
-					xcb_free_pixmap(xc, (xcb_pixmap_t) entries[k].pixmap_xid);
-		}
-		free(entries);
-		return;
-	}
+	shm_size = ui_bulk_size(UI_MSG_PREVIEW_SHOW, count);
 
 	/* anchor_x/y: centre of the hovered bar window */
 	hdr.anchor_x = (int32_t) (m->mx + m->ww / 2);
 	hdr.anchor_y = (int32_t) (m->by + bh / 2);
 	hdr.count    = count;
-	memcpy(shm_buf, &hdr, sizeof(hdr));
-	memcpy(shm_buf + sizeof(hdr), entries, count * sizeof(UiPreviewEntry));
-	free(entries);
 
-	if (ui_send_shm(UI_MSG_PREVIEW_SHOW, shm_buf, shm_size) < 0) {
+	/* Write straight into the arena; a one-off SHM fd only if it is full */
+	if ((shm_buf = ui_arena_reserve((uint32_t) shm_size, &ref))) {
+		ui_bulk_put_preview_show(shm_buf, shm_size, &hdr, entries, count);
+		sent = ui_sent(
+		    UI_MSG_PREVIEW_SHOW, ui_msg_send_preview_show(ui_fd, &ref));
+	} else if ((shm_buf = malloc(shm_size))) {
+		ui_bulk_put_preview_show(shm_buf, shm_size, &hdr, entries, count);
+		sent = ui_send_shm(UI_MSG_PREVIEW_SHOW, shm_buf, shm_size);
+		free(shm_buf);
+	}
+
+	if (sent < 0) {
 		/* Send failed — free the snapshot pixmaps ourselves */
-		UiPreviewEntry *ep = (UiPreviewEntry *) (shm_buf + sizeof(hdr));
-		unsigned int    k;
+		unsigned int k;
 		for (k = 0; k < count; k++)
-			if (ep[k].pixmap_xid)
-				xcb_free_pixmap(xc, (xcb_pixmap_t) ep[k].pixmap_xid);
+			if (entries[k].pixmap_xid)
+				xcb_free_pixmap(xc, (xcb_pixmap_t) entries[k].pixmap_xid);
 	}
-	free(shm_buf);
+	free(entries);
 #else
 	(void) m;
 #endif
@@ -485,7 +620,8 @@ bar_hover_enter(Monitor *m)
 void
 bar_hover_leave(void)
 {
-	ui_send_inline(UI_MSG_PREVIEW_HIDE, NULL, 0);
+	if (ui_fd >= 0)
+		ui_sent(UI_MSG_PREVIEW_HIDE, ui_msg_send_preview_hide(ui_fd));
 }
 
 /* Keybind handler: trigger the window preview popup via bar_hover_enter. */
@@ -499,11 +635,9 @@ preview_show_keybind(const Arg *arg)
 void
 launchermenu(const Arg *arg)
 {
-	UiMsgHeader           hdr;
 	UiLauncherShowPayload p;
-	uint8_t  buf[sizeof(UiMsgHeader) + sizeof(UiLauncherShowPayload)];
-	Monitor *m;
-	int      px, py;
+	Monitor              *m;
+	int                   px, py;
 	(void) arg;
 
 	if (ui_fd < 0)
@@ -565,12 +699,7 @@ launchermenu(const Arg *arg)
 	p.ww = (int32_t) m->ww;
 	p.wh = (int32_t) m->wh;
 
-	hdr.type        = (uint32_t) UI_MSG_LAUNCHER_SHOW;
-	hdr.payload_len = sizeof(p);
-	memcpy(buf, &hdr, sizeof(hdr));
-	memcpy(buf + sizeof(hdr), &p, sizeof(p));
-
-	if (send(ui_fd, buf, sizeof(buf), MSG_NOSIGNAL) < 0) {
+	if (ui_msg_send_launcher_show(ui_fd, &p) < 0) {
 		awm_error("launchermenu: send: %s", strerror(errno));
 		return;
 	}
@@ -646,6 +775,7 @@ x_dispatch_cb(gpointer user_data)
 		free(ev);
 	}
 
+	ewmh_flush();
 	if (barsdirty) {
 		drawbars();
 		updatesystray();
@@ -792,49 +922,36 @@ ui_source_check(GSource *src)
 	return (s->pfd.revents & (G_IO_IN | G_IO_HUP | G_IO_ERR)) != 0;
 }
 
-/* Handle a single message received from awm-ui */
+/* Handle a single message received from awm-ui, already validated
+ * against the schema by ui_msg_decode(). */
 static void
-ui_handle_message(UiMsgType type, const uint8_t *payload, uint32_t len)
+ui_handle_message(const UiMsgView *v)
 {
-	switch (type) {
-	case UI_MSG_LAUNCHER_EXEC: {
-		/* payload is a NUL-terminated command string */
-		launcher_visible = 0;
-		if (len == 0) {
-			awm_warn("awm: UI_MSG_LAUNCHER_EXEC with zero payload");
+	switch (v->type) {
+	case UI_MSG_HELLO: {
+		UiHelloPayload h;
+		ui_msg_get_hello(v, &h);
+		if (!(ui_version = ui_proto_negotiate(&h))) {
+			awm_error("awm: awm-ui speaks protocol %u (min %u), awm %u "
+			          "(min %u); not using it",
+			    h.version, h.min_version, UI_PROTO_VERSION,
+			    UI_PROTO_MIN_VERSION);
+			ui_disabled = 1;
+			if (ui_pid > 0)
+				kill(ui_pid, SIGTERM);
 			break;
 		}
-		char   cmd[4096];
-		size_t cmdlen = len < sizeof(cmd) ? len : sizeof(cmd) - 1;
-		memcpy(cmd, payload, cmdlen);
-		cmd[cmdlen] = '\0';
-		awm_info("awm: launching: %s", cmd);
-
-		pid_t epid = fork();
-		if (epid < 0) {
-			awm_error("awm: fork for exec: %s", strerror(errno));
-		} else if (epid == 0) {
-			struct sigaction sa;
-
-			if (xc)
-				close(xcb_get_file_descriptor(xc));
-			setsid();
-
-			/* setup() installs SIGCHLD=SIG_IGN|SA_NOCLDWAIT in awm so the WM
-			 * never accumulates zombies.  A forked launcher child must restore
-			 * default SIGCHLD semantics before exec'ing /bin/sh; some shells
-			 * and launch wrappers rely on waitpid()-based child tracking and
-			 * can fail when SIGCHLD is inherited as ignored (observed on
-			 * FreeBSD). */
-			sigemptyset(&sa.sa_mask);
-			sa.sa_flags   = 0;
-			sa.sa_handler = SIG_DFL;
-			sigaction(SIGCHLD, &sa, NULL);
-
-			execl("/bin/sh", "sh", "-c", cmd, NULL);
-			awm_error("awm: execl /bin/sh failed: %s", strerror(errno));
-			_exit(1);
-		}
+		awm_debug("awm: awm-ui protocol version %u", ui_version);
+		break;
+	}
+	case UI_MSG_LAUNCHER_EXEC: {
+		/* a command string, optionally followed by the application name */
+		const char *name = v->count > 1 && *v->str[1] ? v->str[1] : NULL;
+		char       *argv[] = { "/bin/sh", "-c", (char *) v->str[0], NULL };
+
+		launcher_visible = 0;
+		awm_info("awm: launching: %s", v->str[0]);
+		startup_launch(argv, name);
 		break;
 	}
 	case UI_MSG_LAUNCHER_DISMISSED:
@@ -845,10 +962,8 @@ ui_handle_message(UiMsgType type, const uint8_t *payload, uint32_t len)
 		 * giving us its X window ID so we can call xcb_set_input_focus
 		 * directly on our own connection (avoids the _NET_ACTIVE_WINDOW
 		 * redirect race).  Store it for use in launchermenu(). */
-		if (len < sizeof(UiLauncherReadyPayload))
-			break;
 		UiLauncherReadyPayload p;
-		memcpy(&p, payload, sizeof(p));
+		ui_msg_get_launcher_ready(v, &p);
 		launcher_xwin = (xcb_window_t) p.xwin;
 		awm_debug("awm: launcher ready, xwin=0x%x", (unsigned) launcher_xwin);
 		break;
@@ -867,94 +982,122 @@ ui_handle_message(UiMsgType type, const uint8_t *payload, uint32_t len)
 		break;
 	case UI_MSG_PREVIEW_FOCUS: {
 		/* awm-ui reports that the user clicked a preview card. */
-		if (len < sizeof(UiPreviewFocusPayload))
-			break;
-		{
-			UiPreviewFocusPayload fp;
-			Client               *c;
-			memcpy(&fp, payload, sizeof(fp));
-			c = wintoclient((xcb_window_t) fp.xwin);
-			if (c) {
-				if (c->mon != g_awm_selmon) {
-					unfocus(g_awm_selmon->sel, 0);
-					g_awm_set_selmon(c->mon);
-				}
-				if (!ISVISIBLE(c, c->mon)) {
-					Arg a = { .ui = c->tags };
-					view(&a);
-				}
-				focus(c);
-				xcb_warp_pointer(xc, XCB_WINDOW_NONE, c->win, 0, 0, 0, 0,
-				    (int16_t) (c->w / 2), (int16_t) (c->h / 2));
-				xcb_flush(xc);
+		UiPreviewFocusPayload fp;
+		Client               *c;
+		ui_msg_get_preview_focus(v, &fp);
+		c = wintoclient((xcb_window_t) fp.xwin);
+		if (c) {
+			if (c->mon != g_awm_selmon) {
+				unfocus(g_awm_selmon->sel, 0);
+				g_awm_set_selmon(c->mon);
 			}
+			if (!ISVISIBLE(c, c->mon)) {
+				Arg a = { .ui = c->tags };
+				view(&a);
+			}
+			focus(c);
+			xcb_warp_pointer(xc, XCB_WINDOW_NONE, c->win, 0, 0, 0, 0,
+			    (int16_t) (c->w / 2), (int16_t) (c->h / 2));
+			xcb_flush(xc);
 		}
 		break;
 	}
 	case UI_MSG_PREVIEW_DONE: {
 		/* awm-ui is finished with the snapshot pixmaps; free them. */
-		if (len < sizeof(UiPreviewDonePayload))
-			break;
-		{
-			UiPreviewDonePayload dp;
-			uint32_t             k;
-			memcpy(&dp, payload, sizeof(dp));
-			for (k = 0; k < dp.count && k < 32; k++) {
-				if (dp.xids[k])
-					xcb_free_pixmap(xc, (xcb_pixmap_t) dp.xids[k]);
-			}
-			xcb_flush(xc);
-		}
+		uint32_t xid, k;
+		for (k = 0; ui_msg_elem_preview_done(v, k, &xid) == 0; k++)
+			if (xid)
+				xcb_free_pixmap(xc, (xcb_pixmap_t) xid);
+		xcb_flush(xc);
 		break;
 	}
 	default:
-		awm_warn("awm: unknown message from awm-ui: type=%u", (unsigned) type);
+		awm_warn("awm: unexpected %s message from awm-ui",
+		    ui_msg_name(v->type));
 		break;
 	}
 }
 
+/* The awm-ui socket went away: drop it and respawn awm-ui shortly. */
+static void
+ui_lost(void)
+{
+	ui_arena_close();
+	close(ui_fd);
+	ui_fd            = -1;
+	ui_pid           = -1;
+	ui_version       = 0;
+	launcher_xwin    = 0;
+	launcher_visible = 0;
+	if (!ui_disabled)
+		g_timeout_add(2000, ui_respawn_cb, NULL);
+}
+
+/* Receive and handle one message without blocking.  Returns 1 if a
+ * message was consumed, 0 if none is pending, -1 if the socket is gone or
+ * must be dropped. */
+static int
+ui_recv_one(void)
+{
+	uint8_t   buf[sizeof(UiMsgHeader) + UI_MSG_MAX_PAYLOAD];
+	UiMsgView v;
+	ssize_t   n;
+
+	do
+		n = recv(ui_fd, buf, sizeof(buf), MSG_DONTWAIT);
+	while (n < 0 && errno == EINTR);
+	if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+		return 0;
+	if (n <= 0) {
+		awm_warn("awm: awm-ui recv: %s", n == 0 ? "EOF" : strerror(errno));
+		return -1;
+	}
+	if (ui_msg_decode(buf, (size_t) n, &v) < 0) {
+		awm_warn("awm: dropped malformed message from awm-ui (%zd bytes)", n);
+		return 1;
+	}
+	ui_handle_message(&v);
+	/* a HELLO we cannot speak: nothing else it sent may be handled */
+	return ui_disabled ? -1 : 1;
+}
+
+/* Drain every message awm-ui has queued, not just one per main-loop
+ * iteration: a burst (launcher exec + dismiss, preview focus + done) is
+ * handled in a single wakeup.  UI_DRAIN_MAX bounds the batch so a chatty
+ * peer cannot starve X event dispatch. */
 static gboolean
 ui_source_dispatch(GSource *src, GSourceFunc cb, gpointer data)
 {
+	static unsigned long wakeups, msgs;
+	static int           most;
+	UiSource            *s = (UiSource *) src;
+	int                  n = 0, r = 0;
+
 	(void) cb;
 	(void) data;
-	UiSource *s = (UiSource *) src;
 
 	if (s->pfd.revents & (G_IO_HUP | G_IO_ERR)) {
 		awm_warn("awm: awm-ui socket closed — scheduling respawn");
-		close(ui_fd);
-		ui_fd            = -1;
-		ui_pid           = -1;
-		launcher_xwin    = 0;
-		launcher_visible = 0;
-		g_timeout_add(2000, ui_respawn_cb, NULL);
+		ui_lost();
 		return G_SOURCE_REMOVE;
 	}
 
-	uint8_t buf[sizeof(UiMsgHeader) + UI_MSG_MAX_PAYLOAD];
-	ssize_t n = recv(ui_fd, buf, sizeof(buf), 0);
-	if (n <= 0) {
-		awm_warn("awm: awm-ui recv: %s", n == 0 ? "EOF" : strerror(errno));
-		close(ui_fd);
-		ui_fd            = -1;
-		ui_pid           = -1;
-		launcher_xwin    = 0;
-		launcher_visible = 0;
-		g_timeout_add(2000, ui_respawn_cb, NULL);
+	while (n < UI_DRAIN_MAX && (r = ui_recv_one()) > 0)
+		n++;
+
+	wakeups++;
+	msgs += (unsigned long) n;
+	if (n > most)
+		most = n;
+	if (n > 1)
+		awm_debug("awm: %d messages from awm-ui in one wakeup "
+		          "(%lu in %lu wakeups, most %d)",
+		    n, msgs, wakeups, most);
+
+	if (r < 0) {
+		ui_lost();
 		return G_SOURCE_REMOVE;
 	}
-	if ((size_t) n < sizeof(UiMsgHeader))
-		return G_SOURCE_CONTINUE;
-
-	UiMsgHeader hdr;
-	memcpy(&hdr, buf, sizeof(hdr));
-	if (hdr.payload_len > UI_MSG_MAX_PAYLOAD)
-		return G_SOURCE_CONTINUE;
-	if ((size_t) n < sizeof(UiMsgHeader) + hdr.payload_len)
-		return G_SOURCE_CONTINUE;
-
-	ui_handle_message(
-	    (UiMsgType) hdr.type, buf + sizeof(UiMsgHeader), hdr.payload_len);
 	return G_SOURCE_CONTINUE;
 }
 
@@ -1062,6 +1205,14 @@ ui_spawn(GMainContext *ctx)
 
 	awm_debug("awm: awm-ui spawned (pid=%d, fd=%d)", (int) ui_pid, ui_fd);
 
+	/* HELLO first: awm-ui checks the protocol version before anything
+	 * else, then the bulk arena so it is in place before any preview */
+	{
+		UiHelloPayload h = { UI_PROTO_VERSION, UI_PROTO_MIN_VERSION };
+		ui_sent(UI_MSG_HELLO, ui_msg_send_hello(ui_fd, &h));
+	}
+	ui_arena_open();
+
 	/* Inform awm-ui of the initial monitor geometry so it can position
 	 * popups before any geometry-change events arrive. */
 	ui_send_monitor_geom();
@@ -1244,6 +1395,9 @@ intern_atoms(void)
 		{ &netatom[NetFrameExtents], "_NET_FRAME_EXTENTS" },
 		{ &netatom[NetWMWindowOpacity], "_NET_WM_WINDOW_OPACITY" },
 		{ &netatom[NetWMBypassCompositor], "_NET_WM_BYPASS_COMPOSITOR" },
+		{ &netatom[NetStartupId], "_NET_STARTUP_ID" },
+		{ &netatom[NetStartupInfoBegin], "_NET_STARTUP_INFO_BEGIN" },
+		{ &netatom[NetStartupInfo], "_NET_STARTUP_INFO" },
 		{ &xatom[Manager], "MANAGER" },
 		{ &xatom[Xembed], "_XEMBED" },
 		{ &xatom[XembedInfo], "_XEMBED_INFO" },
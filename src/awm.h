@@ -122,6 +122,9 @@ enum {
 	NetFrameExtents,
 	NetWMWindowOpacity,
 	NetWMBypassCompositor,
+	NetStartupId,
+	NetStartupInfoBegin,
+	NetStartupInfo,
 	NetLast
 }; /* EWMH atoms */
 enum { Manager, Xembed, XembedInfo, XLast }; /* Xembed atoms */
@@ -298,8 +301,7 @@ extern xcb_timestamp_t
 extern xcb_key_symbols_t *keysyms;
 /* config-derived globals referenced by dbus.c / icon.c */
 extern const unsigned int sniconsize;
-extern const unsigned int iconcachesize;
-extern const unsigned int iconcachemaxentries;
+extern const unsigned int iconcachebytes;
 extern const unsigned int dbustimeout;
 /* DPI-scaled runtime pixel constants — set in setup() after resolve_dpi() */
 extern unsigned int ui_borderpx; /* borderpx * ui_scale */
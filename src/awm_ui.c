@@ -11,22 +11,27 @@
  *
  * Communication with awm is over a Unix SOCK_SEQPACKET socket pair created
  * before the fork.  The child fd is passed in argv[1].  Each send()/recv() is
- * exactly one message: UiMsgHeader followed by payload_len bytes.
+ * exactly one message: UiMsgHeader followed by payload_len bytes, encoded
+ * and validated by ui_proto.c.  Both ends open with UI_MSG_HELLO; awm-ui
+ * exits if awm speaks an incompatible protocol version.
  *
- * Bulk messages (UI_MSG_PREVIEW_SHOW, UI_MSG_PREVIEW_UPDATE) carry a POSIX SHM
- * fd as SCM_RIGHTS ancillary data.  The header's payload_len describes the
- * byte size of the SHM segment.  The receiver mmap()s the fd, reads entries,
- * then closes and munmap()s it.
+ * Bulk messages (UI_MSG_PREVIEW_SHOW, UI_MSG_PREVIEW_UPDATE) normally live in
+ * the shared arena awm hands over once with UI_MSG_ARENA; the message
+ * carries only a UiArenaRef.  A bulk message that did not fit instead
+ * carries a one-off SHM fd as SCM_RIGHTS ancillary data, which is mapped,
+ * read and unmapped.
  */
 
 #include <errno.h>
 #include <fcntl.h>
 #include <signal.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/mman.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 #include <glib.h>
@@ -36,6 +41,12 @@
 #ifndef MSG_NOSIGNAL
 #define MSG_NOSIGNAL 0
 #endif
+/* glibc only declares the seal fcntls under _GNU_SOURCE */
+#if defined(__linux__) && !defined(F_GET_SEALS)
+#define F_GET_SEALS 1034
+#define F_SEAL_SHRINK 0x0002
+#define F_SEAL_GROW 0x0004
+#endif
 
 #include "launcher.h"
 #include "log.h"
@@ -45,49 +56,21 @@
 
 /* Icon cache configuration — defined here since awm_ui doesn't include
  * config.h (which needs full WM types).  icon.c declares these extern. */
-const unsigned int iconcachesize       = 128;
-const unsigned int iconcachemaxentries = 128;
+const unsigned int iconcachebytes = 4 << 20;
 
 /* -------------------------------------------------------------------------
  * Global state
  * ---------------------------------------------------------------------- */
 
 static int        ui_fd     = -1; /* socket fd to awm */
+static uint8_t   *arena     = NULL; /* bulk arena shared with awm */
+static uint32_t   proto_version; /* spoken with awm, 0 until its HELLO */
 static GMainLoop *main_loop = NULL;
 static Launcher  *launcher  = NULL;
 
 /* Monitor workarea — updated by UI_MSG_MONITOR_GEOM */
 static int mon_wx = 0, mon_wy = 0, mon_ww = 0, mon_wh = 0;
 
-/* -------------------------------------------------------------------------
- * Send helpers
- * ---------------------------------------------------------------------- */
-
-/* Send a fixed-size struct as payload.  Returns 0 on success, -1 on error. */
-static int
-ui_send(UiMsgType type, const void *payload, uint32_t len)
-{
-	uint8_t      buf[sizeof(UiMsgHeader) + UI_MSG_MAX_PAYLOAD];
-	UiMsgHeader *hdr = (UiMsgHeader *) buf;
-
-	if (len > UI_MSG_MAX_PAYLOAD) {
-		awm_error("awm-ui: send: payload too large (%u)", len);
-		return -1;
-	}
-
-	hdr->type        = (uint32_t) type;
-	hdr->payload_len = len;
-	if (len > 0 && payload)
-		memcpy(buf + sizeof(UiMsgHeader), payload, len);
-
-	ssize_t n = send(ui_fd, buf, sizeof(UiMsgHeader) + len, MSG_NOSIGNAL);
-	if (n < 0) {
-		awm_error("awm-ui: send failed: %s", strerror(errno));
-		return -1;
-	}
-	return 0;
-}
-
 /* -------------------------------------------------------------------------
  * Launcher callback — called when the user activates a row
  * ---------------------------------------------------------------------- */
@@ -97,42 +80,48 @@ ui_launcher_exec_cb(const char *cmd)
 {
 	if (!cmd || !*cmd)
 		return;
-
-	size_t   len = strlen(cmd) + 1; /* include NUL */
-	uint8_t *buf = malloc(len);
-	if (!buf)
-		return;
-	memcpy(buf, cmd, len);
-	ui_send(UI_MSG_LAUNCHER_EXEC, buf, (uint32_t) len);
-	free(buf);
+	if (ui_msg_send_launcher_exec(ui_fd, &cmd, 1) < 0)
+		awm_error("awm-ui: send failed: %s", strerror(errno));
 }
 
 /* -------------------------------------------------------------------------
  * Message dispatch
+ *
+ * Every message reaching these has been validated against the schema by
+ * ui_msg_decode() / ui_bulk_decode(), so payload sizes need no checks.
  * ---------------------------------------------------------------------- */
 
 static void
-dispatch_launcher_show(const uint8_t *payload, uint32_t len)
+dispatch_hello(const UiMsgView *v)
 {
-	if (len < sizeof(UiLauncherShowPayload)) {
-		awm_warn("awm-ui: LAUNCHER_SHOW payload too short");
+	UiHelloPayload h;
+
+	ui_msg_get_hello(v, &h);
+	if (!(proto_version = ui_proto_negotiate(&h))) {
+		awm_error("awm-ui: awm speaks protocol %u (min %u), awm-ui %u "
+		          "(min %u) — exiting",
+		    h.version, h.min_version, UI_PROTO_VERSION, UI_PROTO_MIN_VERSION);
+		g_main_loop_quit(main_loop);
 		return;
 	}
+	awm_debug("awm-ui: protocol version %u", proto_version);
+}
+
+static void
+dispatch_launcher_show(const UiMsgView *v)
+{
 	UiLauncherShowPayload p;
-	memcpy(&p, payload, sizeof(p));
+
+	ui_msg_get_launcher_show(v, &p);
 	launcher_show(launcher, (int) p.wx, (int) p.wy, (int) p.ww, (int) p.wh);
 }
 
 static void
-dispatch_monitor_geom(const uint8_t *payload, uint32_t len)
+dispatch_monitor_geom(const UiMsgView *v)
 {
 	UiMonitorGeomPayload p;
 
-	if (len < sizeof(p)) {
-		awm_warn("awm-ui: MONITOR_GEOM payload too short");
-		return;
-	}
-	memcpy(&p, payload, sizeof(p));
+	ui_msg_get_monitor_geom(v, &p);
 	mon_wx = (int) p.wx;
 	mon_wy = (int) p.wy;
 	mon_ww = (int) p.ww;
@@ -143,86 +132,149 @@ dispatch_monitor_geom(const uint8_t *payload, uint32_t len)
 }
 
 static void
-dispatch_theme(const uint8_t *payload, uint32_t len)
+dispatch_theme(const UiMsgView *v)
 {
 	UiThemePayload t;
 
-	if (len < sizeof(t)) {
-		awm_warn("awm-ui: THEME payload too short");
-		return;
-	}
-	memcpy(&t, payload, sizeof(t));
+	ui_msg_get_theme(v, &t);
 	notif_update_theme(&t);
 	preview_update_theme(&t);
 	launcher_update_theme(launcher, &t);
 }
 
+/* Handle a bulk message (PREVIEW_SHOW / PREVIEW_UPDATE) of size bytes at
+ * base.  Everything needed is copied out before returning. */
+static void
+handle_bulk(UiMsgType type, const uint8_t *base, size_t size)
+{
+	UiPreviewShowPayload hdr;
+	UiMsgView            v;
+
+	if (ui_bulk_decode(type, base, size, &v) < 0) {
+		awm_warn("awm-ui: dropped malformed %s (%zu bytes)",
+		    ui_msg_name(type), size);
+		return;
+	}
+	/* the two preview messages share one layout */
+	memcpy(&hdr, v.payload, sizeof(hdr));
+	preview_show((const UiPreviewEntry *) v.elems, v.count,
+	    (int) hdr.anchor_x, (int) hdr.anchor_y);
+}
+
+/* Handle a bulk message carried in the arena, then release its space. */
+static void
+handle_arena_message(const UiMsgView *v)
+{
+	UiArenaHeader *h = (UiArenaHeader *) arena;
+	UiArenaRef     ref;
+
+	if (!arena) {
+		awm_warn("awm-ui: %s without arena", ui_msg_name(v->type));
+		return;
+	}
+	ui_msg_get_arena_ref(v, &ref);
+	if (ref.offset > h->size || ref.len > h->size - ref.offset) {
+		awm_warn("awm-ui: arena reference out of range");
+		return;
+	}
+	handle_bulk(v->type, arena + sizeof(*h) + ref.offset, ref.len);
+	atomic_store_explicit(&h->tail, ref.end, memory_order_release);
+}
+
 static void
-handle_message(UiMsgType type, const uint8_t *payload, uint32_t len)
+handle_message(const UiMsgView *v)
 {
-	switch (type) {
+	switch (v->type) {
+	case UI_MSG_HELLO:
+		dispatch_hello(v);
+		break;
 	case UI_MSG_LAUNCHER_SHOW:
-		dispatch_launcher_show(payload, len);
+		dispatch_launcher_show(v);
 		break;
 	case UI_MSG_LAUNCHER_HIDE:
 		launcher_hide(launcher);
 		break;
 	case UI_MSG_MONITOR_GEOM:
-		dispatch_monitor_geom(payload, len);
+		dispatch_monitor_geom(v);
 		break;
 	case UI_MSG_THEME:
-		dispatch_theme(payload, len);
+		dispatch_theme(v);
+		break;
+	case UI_MSG_PREVIEW_SHOW:
+	case UI_MSG_PREVIEW_UPDATE:
+		handle_arena_message(v);
 		break;
 	case UI_MSG_PREVIEW_HIDE:
 		preview_hide();
 		break;
 	default:
-		awm_warn("awm-ui: unknown message type %u", (unsigned) type);
+		awm_warn("awm-ui: unexpected %s message", ui_msg_name(v->type));
 		break;
 	}
 }
 
-/* Handle a bulk SHM message (PREVIEW_SHOW / PREVIEW_UPDATE).
- * shm_fd is the POSIX SHM fd received via SCM_RIGHTS; shm_size is the
- * mapping byte length from header.payload_len.  This function owns shm_fd
- * and must close it before returning. */
+/* Handle a message that arrived with an SCM_RIGHTS fd: the arena itself
+ * (kept mapped) or a one-off bulk segment.  shm_size is the mapping byte
+ * length from header.payload_len.  This function owns shm_fd and must
+ * close it before returning. */
 static void
 handle_shm_message(UiMsgType type, int shm_fd, size_t shm_size)
 {
-	void *base;
-
-	base = mmap(NULL, shm_size, PROT_READ, MAP_SHARED, shm_fd, 0);
+	const UiMsgSpec *spec = ui_msg_spec(type);
+	void            *base;
+	int              prot = PROT_READ;
+	struct stat      st;
+
+	if (!spec ||
+	    (spec->shape != UI_SHAPE_FD && spec->shape != UI_SHAPE_BULK) ||
+	    shm_size == 0 ||
+	    (type == UI_MSG_ARENA && shm_size != UI_ARENA_MAP_SIZE)) {
+		awm_warn("awm-ui: unexpected fd with %s (%zu bytes)",
+		    ui_msg_name(type), shm_size);
+		close(shm_fd);
+		return;
+	}
+	if (type == UI_MSG_ARENA) {
+		/* The arena stays mapped, so its size must be fixed for good:
+		 * a shrink would turn later reads into SIGBUS. */
+#ifdef F_GET_SEALS
+		int seals = fcntl(shm_fd, F_GET_SEALS);
+
+		if (seals < 0 || (seals & (F_SEAL_SHRINK | F_SEAL_GROW)) !=
+		        (F_SEAL_SHRINK | F_SEAL_GROW)) {
+			awm_warn("awm-ui: arena fd is not sealed against resizing");
+			close(shm_fd);
+			return;
+		}
+#endif
+		prot |= PROT_WRITE; /* for the tail */
+	}
+	if (fstat(shm_fd, &st) < 0 || st.st_size < (off_t) shm_size) {
+		awm_warn("awm-ui: %s fd is smaller than %zu bytes",
+		    ui_msg_name(type), shm_size);
+		close(shm_fd);
+		return;
+	}
+	base = mmap(NULL, shm_size, prot, MAP_SHARED, shm_fd, 0);
 	close(shm_fd);
 	if (base == MAP_FAILED) {
 		awm_error("awm-ui: mmap SHM fd: %s", strerror(errno));
 		return;
 	}
 
-	switch (type) {
-	case UI_MSG_PREVIEW_SHOW:
-	case UI_MSG_PREVIEW_UPDATE: {
-		UiPreviewShowPayload hdr;
-		if (shm_size < sizeof(hdr))
-			break;
-		memcpy(&hdr, base, sizeof(hdr));
-		{
-			unsigned int count = hdr.count;
-			size_t       exp   = sizeof(hdr) + count * sizeof(UiPreviewEntry);
-			const UiPreviewEntry *entries;
-			if (shm_size < exp)
-				break;
-			entries = (const UiPreviewEntry *) ((const uint8_t *) base +
-			    sizeof(hdr));
-			preview_show(
-			    entries, count, (int) hdr.anchor_x, (int) hdr.anchor_y);
+	if (type == UI_MSG_ARENA) {
+		if (((UiArenaHeader *) base)->magic != UI_ARENA_MAGIC ||
+		    ((UiArenaHeader *) base)->size != UI_ARENA_RING) {
+			awm_warn("awm-ui: bad arena header");
+			munmap(base, shm_size);
+			return;
 		}
-		break;
-	}
-	default:
-		awm_warn("awm-ui: unexpected SHM message type %u", (unsigned) type);
-		break;
+		if (arena)
+			munmap(arena, UI_ARENA_MAP_SIZE);
+		arena = base;
+		return;
 	}
-
+	handle_bulk(type, base, shm_size);
 	munmap(base, shm_size);
 }
 
@@ -250,21 +302,14 @@ socket_check(GSource *src)
 	return (s->pfd.revents & (G_IO_IN | G_IO_HUP | G_IO_ERR)) != 0;
 }
 
-static gboolean
-socket_dispatch(GSource *src, GSourceFunc cb, gpointer data)
+/* Receive and handle one message without blocking.  Returns 1 if a
+ * message was consumed, 0 if none is pending, -1 if awm has gone away or
+ * speaks a protocol we cannot. */
+static int
+socket_recv_one(void)
 {
-	(void) cb;
-	(void) data;
-	UiSocketSource *s = (UiSocketSource *) src;
-
-	if (s->pfd.revents & (G_IO_HUP | G_IO_ERR)) {
-		awm_warn("awm-ui: socket closed/error — exiting");
-		g_main_loop_quit(main_loop);
-		return G_SOURCE_REMOVE;
-	}
-
-	/* Receive one message; use recvmsg so we can pick up any SCM_RIGHTS
-	 * ancillary data carrying a SHM fd for bulk PREVIEW messages. */
+	/* Use recvmsg so we can pick up any SCM_RIGHTS ancillary data
+	 * carrying a SHM fd for bulk PREVIEW messages. */
 	uint8_t       buf[sizeof(UiMsgHeader) + UI_MSG_MAX_PAYLOAD];
 	uint8_t       cmsgbuf[CMSG_SPACE(sizeof(int))];
 	struct iovec  iov   = { buf, sizeof(buf) };
@@ -274,23 +319,28 @@ socket_dispatch(GSource *src, GSourceFunc cb, gpointer data)
 	mhdr.msg_control    = cmsgbuf;
 	mhdr.msg_controllen = sizeof(cmsgbuf);
 
-	ssize_t n = recvmsg(ui_fd, &mhdr, 0);
+	ssize_t n;
+	do
+		n = recvmsg(ui_fd, &mhdr, MSG_DONTWAIT);
+	while (n < 0 && errno == EINTR);
+	if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+		return 0;
 	if (n <= 0) {
 		if (n == 0 || errno == ECONNRESET) {
 			awm_warn("awm-ui: socket disconnected — exiting");
 		} else {
 			awm_error("awm-ui: recvmsg: %s", strerror(errno));
 		}
-		g_main_loop_quit(main_loop);
-		return G_SOURCE_REMOVE;
+		return -1;
 	}
 
 	if ((size_t) n < sizeof(UiMsgHeader)) {
 		awm_warn("awm-ui: short read (%zd bytes)", n);
-		return G_SOURCE_CONTINUE;
+		return 1;
 	}
 
 	UiMsgHeader hdr;
+	UiMsgView   v;
 	memcpy(&hdr, buf, sizeof(hdr));
 
 	/* Check for SCM_RIGHTS fd (bulk SHM path) */
@@ -308,24 +358,57 @@ socket_dispatch(GSource *src, GSourceFunc cb, gpointer data)
 		/* Bulk SHM message: payload_len is the SHM byte size */
 		handle_shm_message(
 		    (UiMsgType) hdr.type, shm_fd, (size_t) hdr.payload_len);
-		return G_SOURCE_CONTINUE;
+		return 1;
 	}
 
-	/* Inline payload */
-	if (hdr.payload_len > UI_MSG_MAX_PAYLOAD) {
-		awm_warn("awm-ui: payload_len %u exceeds cap", hdr.payload_len);
-		return G_SOURCE_CONTINUE;
+	if (ui_msg_decode(buf, (size_t) n, &v) < 0) {
+		awm_warn("awm-ui: dropped malformed %s message (%zd bytes)",
+		    ui_msg_name(hdr.type), n);
+		return 1;
 	}
+	handle_message(&v);
+	/* a failed HELLO: nothing else awm sent may be handled */
+	if (v.type == UI_MSG_HELLO && !proto_version)
+		return -1;
+	return 1;
+}
+
+/* Drain up to UI_DRAIN_MAX queued messages per wakeup, so that e.g. a
+ * THEME + MONITOR_GEOM + LAUNCHER_SHOW burst is applied before GTK next
+ * lays out and paints, rather than over three main-loop iterations. */
+static gboolean
+socket_dispatch(GSource *src, GSourceFunc cb, gpointer data)
+{
+	static unsigned long wakeups, msgs;
+	static int           most;
+	UiSocketSource      *s = (UiSocketSource *) src;
+	int                  n = 0, r = 0;
+
+	(void) cb;
+	(void) data;
 
-	if ((size_t) n < sizeof(UiMsgHeader) + hdr.payload_len) {
-		awm_warn("awm-ui: message truncated (got %zd want %zu)", n,
-		    sizeof(UiMsgHeader) + hdr.payload_len);
-		return G_SOURCE_CONTINUE;
+	if (s->pfd.revents & (G_IO_HUP | G_IO_ERR)) {
+		awm_warn("awm-ui: socket closed/error — exiting");
+		g_main_loop_quit(main_loop);
+		return G_SOURCE_REMOVE;
 	}
 
-	handle_message(
-	    (UiMsgType) hdr.type, buf + sizeof(UiMsgHeader), hdr.payload_len);
+	while (n < UI_DRAIN_MAX && (r = socket_recv_one()) > 0)
+		n++;
+
+	wakeups++;
+	msgs += (unsigned long) n;
+	if (n > most)
+		most = n;
+	if (n > 1)
+		awm_debug("awm-ui: %d messages from awm in one wakeup "
+		          "(%lu in %lu wakeups, most %d)",
+		    n, msgs, wakeups, most);
 
+	if (r < 0) {
+		g_main_loop_quit(main_loop);
+		return G_SOURCE_REMOVE;
+	}
 	return G_SOURCE_CONTINUE;
 }
 
@@ -384,6 +467,13 @@ main(int argc, char *argv[])
 	/* Ignore SIGPIPE — we detect broken socket via send() errno */
 	signal(SIGPIPE, SIG_IGN);
 
+	/* HELLO before anything else, so awm can check the protocol version */
+	{
+		UiHelloPayload h = { UI_PROTO_VERSION, UI_PROTO_MIN_VERSION };
+		if (ui_msg_send_hello(ui_fd, &h) < 0)
+			awm_error("awm-ui: send HELLO: %s", strerror(errno));
+	}
+
 	/* Route all GLib/GTK log messages through the awm logging system so
 	 * g_warning, g_critical, and g_error output appears in journald.
 	 * Register for every domain we care about; NULL catches the default
@@ -433,6 +523,8 @@ main(int argc, char *argv[])
 	preview_cleanup();
 	notif_cleanup();
 	launcher_free(launcher);
+	if (arena)
+		munmap(arena, UI_ARENA_MAP_SIZE);
 	close(ui_fd);
 	log_cleanup();
 	return 0;
@@ -10,7 +10,9 @@
 #include "events.h"
 #include "ewmh.h"
 #include "monitor.h"
+#include "pixel.h"
 #include "spawn.h"
+#include "startup.h"
 #include "systray.h"
 #include "wmstate.h"
 #include "xrdb.h"
@@ -26,7 +28,7 @@ void
 applyrules(Client *c)
 {
 	const char  *class, *instance;
-	unsigned int i;
+	unsigned int i, launchtags;
 	const Rule  *r;
 	Monitor     *m;
 
@@ -37,6 +39,10 @@ applyrules(Client *c)
 	c->tags       = 0;
 	c->scratchkey = 0;
 
+	/* A window from a tracked launch starts on the monitor and tags the
+	 * launch was made from, unless a rule below says otherwise. */
+	launchtags = startup_claim(c);
+
 	/* Fetch WM_CLASS via XCB: value is "instance\0class\0" (STRING).
 	 * Parse the two null-separated fields from the raw reply data. */
 	char cls_buf[256]  = { 0 };
@@ -90,13 +96,16 @@ applyrules(Client *c)
 	}
 
 	/* Scratchpads always start hidden (tags=0 means off-screen until
-	 * toggled).  For normal clients, fall back to the monitor's current
-	 * tagset if no tag was assigned by the rule. */
+	 * toggled).  For normal clients, fall back to the launch's tagset, then
+	 * the monitor's current one, if no tag was assigned by the rule. */
 	if (c->scratchkey)
 		c->tags = 0;
+	else if (c->tags & TAGMASK)
+		c->tags &= TAGMASK;
+	else if (launchtags & TAGMASK)
+		c->tags = launchtags & TAGMASK;
 	else
-		c->tags = c->tags & TAGMASK ? c->tags & TAGMASK
-		                            : c->mon->tagset[c->mon->seltags];
+		c->tags = c->mon->tagset[c->mon->seltags];
 }
 
 int
@@ -500,109 +509,226 @@ gettextprop(xcb_window_t w, xcb_atom_t atom, char *text, unsigned int size)
 	return 1;
 }
 
-cairo_surface_t *
-getwmicon(xcb_window_t w, int size)
+/* _NET_WM_ICON is a list of images, each a width, a height and
+ * width * height non-premultiplied ARGB words, and applications often ship
+ * a 256x256 one.  getwmicon() walks the image headers to choose the
+ * smallest image covering size (else the largest), fetching a few KiB from
+ * a header only when the walk reaches one it has not seen, then fetches
+ * just the chosen image's pixels, unless they came along with its header.
+ * The result is interned by WM_CLASS and a hash of those pixels, so every
+ * window showing the same icon shares one surface.  The table holds no
+ * reference: an entry goes with its surface's last user. */
+
+#define WMICON_MAX_IMAGES 16   /* headers walked before giving up */
+#define WMICON_MAX_SIDE   1024 /* larger images are taken as garbage */
+/* Words fetched from each header the walk reaches: the header and up to a
+ * 32x32 image, 4 KiB. */
+#define WMICON_WINDOW (2 + 32 * 32)
+
+typedef struct {
+	char     class[64];
+	uint64_t hash;
+	uint32_t w, h;
+	int      size;
+} WmIconKey;
+
+static GHashTable                 *wmicons; /* WmIconKey -> surface */
+static const cairo_user_data_key_t wmicon_ud;
+
+static guint
+wmicon_hash(gconstpointer p)
 {
-	xcb_get_property_cookie_t ck = xcb_get_property(
-	    xc, 0, w, netatom[NetWMIcon], XCB_ATOM_ANY, 0, UINT32_MAX / 4);
-	xcb_get_property_reply_t *r       = xcb_get_property_reply(xc, ck, NULL);
-	cairo_surface_t          *surface = NULL;
+	const WmIconKey *k = p;
 
-	if (!r || xcb_get_property_value_length(r) == 0) {
-		free(r);
-		return NULL;
-	}
+	return g_str_hash(k->class) ^ (guint) k->hash ^
+	    (guint) (k->hash >> 32) ^ ((guint) k->size << 20);
+}
 
-	{
-		int       vlen   = xcb_get_property_value_length(r);
-		uint32_t *data   = (uint32_t *) xcb_get_property_value(r);
-		uint32_t  nitems = (uint32_t) vlen / sizeof(uint32_t);
-
-		if (nitems > 2) {
-			unsigned long icon_w = data[0];
-			unsigned long icon_h = data[1];
-
-			if (nitems >= 2 + icon_w * icon_h) {
-				cairo_surface_t *src;
-				cairo_t         *cr;
-				unsigned char   *argb_data;
-				unsigned long    i;
-				int              stride;
-
-				awm_debug("extracting %lux%lu icon, nitems=%lu", icon_w,
-				    icon_h, nitems);
-
-				stride =
-				    cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32, icon_w);
-				argb_data = calloc(icon_h, stride);
-				if (!argb_data) {
-					free(r);
-					return NULL;
-				}
+static gboolean
+wmicon_equal(gconstpointer a, gconstpointer b)
+{
+	const WmIconKey *x = a, *y = b;
 
-				for (i = 0; i < icon_w * icon_h; i++) {
-					unsigned long pixel = data[2 + i];
-					unsigned char a     = (pixel >> 24) & 0xff;
-					unsigned char rv    = (pixel >> 16) & 0xff;
-					unsigned char g     = (pixel >> 8) & 0xff;
-					unsigned char b     = pixel & 0xff;
-
-					unsigned char *q =
-					    argb_data + (i / icon_w) * stride + (i % icon_w) * 4;
-
-					if (a == 0) {
-						q[0] = q[1] = q[2] = q[3] = 0;
-					} else if (a == 255) {
-						q[0] = b;
-						q[1] = g;
-						q[2] = rv;
-						q[3] = a;
-					} else {
-						q[0] = (b * a) / 255;
-						q[1] = (g * a) / 255;
-						q[2] = (rv * a) / 255;
-						q[3] = a;
-					}
-				}
+	return x->hash == y->hash && x->w == y->w && x->h == y->h &&
+	    x->size == y->size && strcmp(x->class, y->class) == 0;
+}
 
-				awm_debug("first 4 pixels (BGRA): [%02x%02x%02x%02x] "
-				          "[%02x%02x%02x%02x] "
-				          "[%02x%02x%02x%02x] [%02x%02x%02x%02x]",
-				    argb_data[3], argb_data[2], argb_data[1], argb_data[0],
-				    argb_data[7], argb_data[6], argb_data[5], argb_data[4],
-				    argb_data[11], argb_data[10], argb_data[9], argb_data[8],
-				    argb_data[15], argb_data[14], argb_data[13],
-				    argb_data[12]);
-
-				src = cairo_image_surface_create_for_data(
-				    argb_data, CAIRO_FORMAT_ARGB32, icon_w, icon_h, stride);
-
-				surface = cairo_image_surface_create(
-				    CAIRO_FORMAT_ARGB32, size, size);
-				cr = cairo_create(surface);
-
-				cairo_set_operator(cr, CAIRO_OPERATOR_CLEAR);
-				cairo_paint(cr);
-				cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
-
-				if (icon_w != (unsigned long) size ||
-				    icon_h != (unsigned long) size) {
-					double scale_x = (double) size / icon_w;
-					double scale_y = (double) size / icon_h;
-					cairo_scale(cr, scale_x, scale_y);
-				}
+/* cairo user-data destructor: the surface's last reference is gone */
+static void
+wmicon_forget(void *key)
+{
+	g_hash_table_remove(wmicons, key);
+}
 
-				cairo_set_source_surface(cr, src, 0, 0);
-				cairo_paint(cr);
+/* Find the image to use, fetching WMICON_WINDOW words from each header
+ * that lies past the words already fetched.  Sets *off (in 32-bit units,
+ * at the image's header), *iw and *ih; returns 0, or -1 if the property
+ * holds none.  If the chosen image's pixels were fetched along the way,
+ * *img is the reply holding them, starting at word *base (the caller frees
+ * it); else *img is NULL. */
+static int
+wmicon_pick(xcb_window_t w, int size, xcb_get_property_reply_t **img,
+    uint32_t *base, uint32_t *off, uint32_t *iw, uint32_t *ih)
+{
+	xcb_get_property_reply_t *r = NULL;
+	uint32_t                  o = 0, start = 0, have = 0, total = 0;
+	uint32_t                  bw = 0, bh = 0, iwv, ihv;
+	const uint32_t           *v = NULL;
+
+	*img = NULL;
+	for (int i = 0; i < WMICON_MAX_IMAGES; i++) {
+		if (o + 2 > start + have) {
+			if (r != *img)
+				free(r);
+			r = xcb_get_property_reply(xc,
+			    xcb_get_property(xc, 0, w, netatom[NetWMIcon],
+			        XCB_ATOM_ANY, o, WMICON_WINDOW),
+			    NULL);
+			if (!r || r->format != 32 ||
+			    xcb_get_property_value_length(r) < 8)
+				break;
+			v     = xcb_get_property_value(r);
+			start = o;
+			have  = (uint32_t) xcb_get_property_value_length(r) / 4;
+			total = o + have + r->bytes_after / 4;
+		}
+		iwv = v[o - start];
+		ihv = v[o - start + 1];
+		if (!iwv || !ihv || iwv > WMICON_MAX_SIDE || ihv > WMICON_MAX_SIDE ||
+		    (uint64_t) iwv * ihv > total - o - 2)
+			break;
+		/* smallest covering size, else largest */
+		if (!bw ||
+		    (bw < (uint32_t) size ? iwv > bw
+		                          : iwv >= (uint32_t) size && iwv < bw)) {
+			bw   = iwv;
+			bh   = ihv;
+			*off = o;
+			if (*img != r)
+				free(*img);
+			*img  = o + 2 + iwv * ihv <= start + have ? r : NULL;
+			*base = start;
+		}
+		o += 2 + iwv * ihv;
+		if (o + 2 > total)
+			break;
+	}
+	if (r != *img)
+		free(r);
+	*iw = bw;
+	*ih = bh;
+	return bw ? 0 : -1;
+}
 
-				cairo_destroy(cr);
-				cairo_surface_destroy(src);
-				free(argb_data);
-			}
+/* Premultiply the w x h image px and scale it to a new size x size
+ * surface: box-filtered when shrinking, by cairo when enlarging */
+static cairo_surface_t *
+wmicon_render(const uint32_t *px, uint32_t w, uint32_t h, int size)
+{
+	cairo_surface_t *src, *surface;
+	cairo_t         *cr;
+
+	src = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, (int) w, (int) h);
+	if (cairo_surface_status(src) != CAIRO_STATUS_SUCCESS) {
+		cairo_surface_destroy(src);
+		return NULL;
+	}
+	pixel_to_argb32(cairo_image_surface_get_data(src),
+	    (size_t) cairo_image_surface_get_stride(src), px, (size_t) w * 4,
+	    (int) w, (int) h, PIXEL_ARGB32);
+	cairo_surface_mark_dirty(src);
+	if (w == (uint32_t) size && h == (uint32_t) size)
+		return src;
+
+	surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, size, size);
+	cairo_surface_flush(surface);
+	if (w >= (uint32_t) size && h >= (uint32_t) size &&
+	    pixel_downscale_box(cairo_image_surface_get_data(surface),
+	        (size_t) cairo_image_surface_get_stride(surface), size, size,
+	        cairo_image_surface_get_data(src),
+	        (size_t) cairo_image_surface_get_stride(src), (int) w,
+	        (int) h) == 0) {
+		cairo_surface_mark_dirty(surface);
+	} else {
+		cr = cairo_create(surface);
+		cairo_scale(cr, (double) size / w, (double) size / h);
+		cairo_set_source_surface(cr, src, 0, 0);
+		cairo_paint(cr);
+		cairo_destroy(cr);
+	}
+	cairo_surface_destroy(src);
+	return surface;
+}
+
+cairo_surface_t *
+getwmicon(xcb_window_t w, int size)
+{
+	xcb_get_property_cookie_t cls_ck;
+	xcb_get_property_reply_t *r, *img;
+	cairo_surface_t          *surface;
+	const uint32_t           *px;
+	WmIconKey                 key = { .size = size }, *k;
+	uint32_t                  base = 0, off = 0, iw, ih, n;
+	uint64_t                  hash = 0xcbf29ce484222325ull;
+
+	/* WM_CLASS ("instance\0class\0") rides along with the header walk */
+	cls_ck = xcb_get_property(
+	    xc, 0, w, XCB_ATOM_WM_CLASS, XCB_ATOM_STRING, 0, 64);
+	if (wmicon_pick(w, size, &img, &base, &off, &iw, &ih) < 0) {
+		free(xcb_get_property_reply(xc, cls_ck, NULL));
+		return NULL;
+	}
+	if ((r = xcb_get_property_reply(xc, cls_ck, NULL))) {
+		const char *val = xcb_get_property_value(r);
+		int         len = xcb_get_property_value_length(r);
+		int         il  = (int) strnlen(val, (size_t) len);
+		if (il + 1 < len)
+			snprintf(key.class, sizeof(key.class), "%.*s", len - il - 1,
+			    val + il + 1);
+		free(r);
+	}
+
+	/* small images come with their header */
+	n = iw * ih;
+	if (img) {
+		r  = img;
+		px = (const uint32_t *) xcb_get_property_value(r) + off - base + 2;
+	} else {
+		r = xcb_get_property_reply(xc,
+		    xcb_get_property(
+		        xc, 0, w, netatom[NetWMIcon], XCB_ATOM_ANY, off + 2, n),
+		    NULL);
+		if (!r || xcb_get_property_value_length(r) != (int) (n * 4)) {
+			free(r);
+			return NULL;
 		}
+		px = xcb_get_property_value(r);
+	}
+	for (uint32_t i = 0; i < n; i++) /* FNV-1a over whole words */
+		hash = (hash ^ px[i]) * 0x100000001b3ull;
+	key.hash = hash;
+	key.w    = iw;
+	key.h    = ih;
+
+	if (!wmicons)
+		wmicons = g_hash_table_new_full(wmicon_hash, wmicon_equal, free, NULL);
+	if ((surface = g_hash_table_lookup(wmicons, &key))) {
+		free(r);
+		awm_debug("wmicon: 0x%x shares the %ux%u icon of %s", (unsigned) w,
+		    iw, ih, key.class);
+		return cairo_surface_reference(surface);
 	}
 
+	surface = wmicon_render(px, iw, ih, size);
 	free(r);
+	if (!surface)
+		return NULL;
+	k  = ecalloc(1, sizeof(*k));
+	*k = key;
+	g_hash_table_insert(wmicons, k, surface);
+	cairo_surface_set_user_data(surface, &wmicon_ud, k, wmicon_forget);
+	awm_debug("wmicon: 0x%x has a %ux%u icon (%d px) for %s", (unsigned) w,
+	    iw, ih, size, key.class);
 	return surface;
 }
 
@@ -831,11 +957,7 @@ manage(xcb_window_t w, xcb_get_geometry_reply_t *gr)
 	}
 	attach(c);
 	attachstack(c);
-	{
-		uint32_t winxid = (uint32_t) c->win;
-		xcb_change_property(xc, XCB_PROP_MODE_APPEND, root,
-		    netatom[NetClientList], XCB_ATOM_WINDOW, 32, 1, &winxid);
-	}
+	updateclientlist();
 
 	setewmhdesktop(c);
 	setwmstate(c);
@@ -5,6 +5,7 @@
 
 #include <fcntl.h>
 
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -115,8 +116,8 @@ dbus_helper_call_method_async(DBusConnection *conn, const char *service,
     const char *path, const char *interface, const char *method,
     dbus_async_reply_callback callback, void *user_data)
 {
-	DBusMessage     *msg;
-	DBusPendingCall *pending;
+	DBusMessage *msg;
+	int          ok;
 
 	if (!conn || !callback)
 		return 0;
@@ -125,14 +126,23 @@ dbus_helper_call_method_async(DBusConnection *conn, const char *service,
 	if (!msg)
 		return 0;
 
-	if (!dbus_connection_send_with_reply(conn, msg, &pending, -1)) {
-		dbus_message_unref(msg);
-		return 0;
-	}
-
+	ok = dbus_helper_send_async(conn, msg, callback, user_data);
 	dbus_message_unref(msg);
+	return ok;
+}
 
-	if (!pending)
+/* Send a method call built by the caller, who keeps its reference */
+int
+dbus_helper_send_async(DBusConnection *conn, DBusMessage *msg,
+    dbus_async_reply_callback callback, void *user_data)
+{
+	DBusPendingCall *pending;
+
+	if (!conn || !msg || !callback)
+		return 0;
+
+	if (!dbus_connection_send_with_reply(conn, msg, &pending, -1) ||
+	    !pending)
 		return 0;
 
 	return setup_async_callback(pending, callback, user_data);
@@ -199,9 +209,10 @@ dbus_helper_get_property_string(DBusConnection *conn, const char *service,
 	return 0;
 }
 
-/* Async string property getter */
+/* Async Properties.Get: the reply carries the value as a single variant,
+ * whatever its type */
 int
-dbus_helper_get_property_string_async(DBusConnection *conn,
+dbus_helper_get_property_async(DBusConnection *conn,
     const char *service, const char *path, const char *interface,
     const char *property, dbus_async_reply_callback callback, void *user_data)
 {
@@ -234,6 +245,16 @@ dbus_helper_get_property_string_async(DBusConnection *conn,
 	return setup_async_callback(pending, callback, user_data);
 }
 
+/* Async string property getter */
+int
+dbus_helper_get_property_string_async(DBusConnection *conn,
+    const char *service, const char *path, const char *interface,
+    const char *property, dbus_async_reply_callback callback, void *user_data)
+{
+	return dbus_helper_get_property_async(
+	    conn, service, path, interface, property, callback, user_data);
+}
+
 /* Get int32 property via org.freedesktop.DBus.Properties (BLOCKING) */
 int
 dbus_helper_get_property_int(DBusConnection *conn, const char *service,
@@ -290,33 +311,8 @@ dbus_helper_get_property_int_async(DBusConnection *conn, const char *service,
     const char *path, const char *interface, const char *property,
     dbus_async_reply_callback callback, void *user_data)
 {
-	DBusMessage     *msg;
-	DBusPendingCall *pending;
-	DBusMessageIter  args;
-
-	if (!conn || !callback)
-		return 0;
-
-	msg = dbus_message_new_method_call(
-	    service, path, PROPERTIES_INTERFACE, "Get");
-	if (!msg)
-		return 0;
-
-	dbus_message_iter_init_append(msg, &args);
-	dbus_message_iter_append_basic(&args, DBUS_TYPE_STRING, &interface);
-	dbus_message_iter_append_basic(&args, DBUS_TYPE_STRING, &property);
-
-	if (!dbus_connection_send_with_reply(conn, msg, &pending, -1)) {
-		dbus_message_unref(msg);
-		return 0;
-	}
-
-	dbus_message_unref(msg);
-
-	if (!pending)
-		return 0;
-
-	return setup_async_callback(pending, callback, user_data);
+	return dbus_helper_get_property_async(
+	    conn, service, path, interface, property, callback, user_data);
 }
 
 /* Async GetAll properties - fetches all properties in one call
@@ -723,175 +719,230 @@ dbus_is_signal(DBusMessage *msg, const char *interface, const char *member)
  * ============================================================================
  */
 
-/* Handler entry structures */
-typedef struct MethodHandler {
-	char                 *interface;
-	char                 *method;
-	dbus_method_handler   handler;
-	void                 *user_data;
-	struct MethodHandler *next;
-} MethodHandler;
-
-typedef struct SignalHandler {
-	char                 *interface;
-	char                 *member;
-	dbus_signal_handler   handler;
-	void                 *user_data;
-	struct SignalHandler *next;
-} SignalHandler;
+/* Handlers live in a chained hash table keyed by (message type, interface,
+ * member), so routing a message costs one hash of its two names and
+ * usually a single compare, however many handlers are registered.  The
+ * handler typedefs are identical, so one entry type serves both kinds. */
+typedef struct Handler {
+	uint32_t            hash;
+	int                 type; /* DBUS_MESSAGE_TYPE_METHOD_CALL or _SIGNAL */
+	char               *interface;
+	char               *member;
+	dbus_method_handler handler;
+	void               *user_data;
+	struct Handler     *next;
+} Handler;
+
+#define DISPATCH_BUCKETS_MIN 16
 
 struct DBusDispatcher {
-	MethodHandler *methods;
-	SignalHandler *signals;
+	Handler **buckets;
+	size_t    nbuckets; /* power of two */
+	size_t    count;
 };
 
-DBusDispatcher *
-dbus_dispatcher_new(void)
-{
-	DBusDispatcher *dispatcher = calloc(1, sizeof(DBusDispatcher));
-	return dispatcher;
+/* FNV-1a over the type byte and member.  Members are short and mostly
+ * distinct, while interfaces share long prefixes; leaving the interface
+ * to the compare keeps the per-message cost near the old few-handler
+ * list walk.  Chains stay short: a member name rarely recurs. */
+static uint32_t
+dispatch_hash(int type, const char *member)
+{
+	uint32_t             h = 2166136261u;
+	const unsigned char *p;
+
+	h = (h ^ (unsigned char) type) * 16777619u;
+	for (p = (const unsigned char *) member; *p; p++)
+		h = (h ^ *p) * 16777619u;
+	return h;
+}
+
+/* Latest registration first, like the lists this replaced: a handler
+ * registered twice for the same key shadows the older one. */
+static Handler *
+dispatch_lookup(DBusDispatcher *dispatcher, int type, const char *interface,
+    const char *member, Handler ***link_out)
+{
+	uint32_t  hash = dispatch_hash(type, member);
+	Handler **link = &dispatcher->buckets[hash & (dispatcher->nbuckets - 1)];
+
+	for (; *link; link = &(*link)->next) {
+		Handler *h = *link;
+		if (h->hash == hash && h->type == type &&
+		    strcmp(h->member, member) == 0 &&
+		    strcmp(h->interface, interface) == 0) {
+			if (link_out)
+				*link_out = link;
+			return h;
+		}
+	}
+	return NULL;
 }
 
-void
-dbus_dispatcher_free(DBusDispatcher *dispatcher)
+/* Double the bucket array once the load factor passes 1 */
+static void
+dispatch_grow(DBusDispatcher *dispatcher)
 {
-	MethodHandler *mh, *mh_next;
-	SignalHandler *sh, *sh_next;
+	size_t    n = dispatcher->nbuckets * 2, i;
+	Handler **buckets;
 
-	if (!dispatcher)
-		return;
+	buckets = calloc(n, sizeof(*buckets));
+	if (!buckets)
+		return; /* keep the longer chains, still correct */
 
-	/* Free method handlers */
-	for (mh = dispatcher->methods; mh; mh = mh_next) {
-		mh_next = mh->next;
-		free(mh->interface);
-		free(mh->method);
-		free(mh);
-	}
+	/* Walk each old chain back to front so equal keys keep their order */
+	for (i = 0; i < dispatcher->nbuckets; i++) {
+		Handler *rev = NULL, *h, *next;
 
-	/* Free signal handlers */
-	for (sh = dispatcher->signals; sh; sh = sh_next) {
-		sh_next = sh->next;
-		free(sh->interface);
-		free(sh->member);
-		free(sh);
-	}
+		for (h = dispatcher->buckets[i]; h; h = next) {
+			next    = h->next;
+			h->next = rev;
+			rev     = h;
+		}
+		for (h = rev; h; h = next) {
+			Handler **head = &buckets[h->hash & (n - 1)];
 
-	free(dispatcher);
+			next    = h->next;
+			h->next = *head;
+			*head   = h;
+		}
+	}
+	free(dispatcher->buckets);
+	dispatcher->buckets  = buckets;
+	dispatcher->nbuckets = n;
 }
 
-int
-dbus_dispatcher_register_method(DBusDispatcher *dispatcher,
-    const char *interface, const char *method, dbus_method_handler handler,
-    void *user_data)
+static int
+dispatch_register(DBusDispatcher *dispatcher, int type, const char *interface,
+    const char *member, dbus_method_handler handler, void *user_data)
 {
-	MethodHandler *mh;
+	Handler  *h;
+	Handler **head;
 
-	if (!dispatcher || !interface || !method || !handler)
+	if (!dispatcher || !interface || !member || !handler)
 		return 0;
 
-	mh = calloc(1, sizeof(MethodHandler));
-	if (!mh)
+	h = calloc(1, sizeof(Handler));
+	if (!h)
 		return 0;
 
-	mh->interface = strdup(interface);
-	mh->method    = strdup(method);
-	if (!mh->interface || !mh->method) {
-		free(mh->interface);
-		free(mh->method);
-		free(mh);
+	h->interface = strdup(interface);
+	h->member    = strdup(member);
+	if (!h->interface || !h->member) {
+		free(h->interface);
+		free(h->member);
+		free(h);
 		return 0;
 	}
-	mh->handler   = handler;
-	mh->user_data = user_data;
+	h->hash      = dispatch_hash(type, member);
+	h->type      = type;
+	h->handler   = handler;
+	h->user_data = user_data;
+
+	if (dispatcher->count >= dispatcher->nbuckets)
+		dispatch_grow(dispatcher);
 
-	/* Add to front of list */
-	mh->next            = dispatcher->methods;
-	dispatcher->methods = mh;
+	/* Add to front of chain */
+	head    = &dispatcher->buckets[h->hash & (dispatcher->nbuckets - 1)];
+	h->next = *head;
+	*head   = h;
+	dispatcher->count++;
 
 	return 1;
 }
 
-int
-dbus_dispatcher_register_signal(DBusDispatcher *dispatcher,
-    const char *interface, const char *member, dbus_signal_handler handler,
-    void *user_data)
+static void
+dispatch_unregister(DBusDispatcher *dispatcher, int type,
+    const char *interface, const char *member)
 {
-	SignalHandler *sh;
+	Handler  *h;
+	Handler **link;
 
-	if (!dispatcher || !interface || !member || !handler)
-		return 0;
+	if (!dispatcher || !interface || !member)
+		return;
 
-	sh = calloc(1, sizeof(SignalHandler));
-	if (!sh)
-		return 0;
+	h = dispatch_lookup(dispatcher, type, interface, member, &link);
+	if (!h)
+		return;
 
-	sh->interface = strdup(interface);
-	sh->member    = strdup(member);
-	if (!sh->interface || !sh->member) {
-		free(sh->interface);
-		free(sh->member);
-		free(sh);
-		return 0;
-	}
-	sh->handler   = handler;
-	sh->user_data = user_data;
+	*link = h->next;
+	dispatcher->count--;
+	free(h->interface);
+	free(h->member);
+	free(h);
+}
 
-	/* Add to front of list */
-	sh->next            = dispatcher->signals;
-	dispatcher->signals = sh;
+DBusDispatcher *
+dbus_dispatcher_new(void)
+{
+	DBusDispatcher *dispatcher = calloc(1, sizeof(DBusDispatcher));
 
-	return 1;
+	if (!dispatcher)
+		return NULL;
+
+	dispatcher->nbuckets = DISPATCH_BUCKETS_MIN;
+	dispatcher->buckets  = calloc(dispatcher->nbuckets, sizeof(Handler *));
+	if (!dispatcher->buckets) {
+		free(dispatcher);
+		return NULL;
+	}
+	return dispatcher;
 }
 
 void
-dbus_dispatcher_unregister_method(
-    DBusDispatcher *dispatcher, const char *interface, const char *method)
+dbus_dispatcher_free(DBusDispatcher *dispatcher)
 {
-	MethodHandler *mh, *prev = NULL;
+	Handler *h, *next;
+	size_t   i;
 
-	if (!dispatcher || !interface || !method)
+	if (!dispatcher)
 		return;
 
-	for (mh = dispatcher->methods; mh; prev = mh, mh = mh->next) {
-		if (strcmp(mh->interface, interface) == 0 &&
-		    strcmp(mh->method, method) == 0) {
-			if (prev)
-				prev->next = mh->next;
-			else
-				dispatcher->methods = mh->next;
-
-			free(mh->interface);
-			free(mh->method);
-			free(mh);
-			return;
+	for (i = 0; i < dispatcher->nbuckets; i++) {
+		for (h = dispatcher->buckets[i]; h; h = next) {
+			next = h->next;
+			free(h->interface);
+			free(h->member);
+			free(h);
 		}
 	}
+
+	free(dispatcher->buckets);
+	free(dispatcher);
+}
+
+int
+dbus_dispatcher_register_method(DBusDispatcher *dispatcher,
+    const char *interface, const char *method, dbus_method_handler handler,
+    void *user_data)
+{
+	return dispatch_register(dispatcher, DBUS_MESSAGE_TYPE_METHOD_CALL,
+	    interface, method, handler, user_data);
+}
+
+int
+dbus_dispatcher_register_signal(DBusDispatcher *dispatcher,
+    const char *interface, const char *member, dbus_signal_handler handler,
+    void *user_data)
+{
+	return dispatch_register(dispatcher, DBUS_MESSAGE_TYPE_SIGNAL, interface,
+	    member, handler, user_data);
+}
+
+void
+dbus_dispatcher_unregister_method(
+    DBusDispatcher *dispatcher, const char *interface, const char *method)
+{
+	dispatch_unregister(
+	    dispatcher, DBUS_MESSAGE_TYPE_METHOD_CALL, interface, method);
 }
 
 void
 dbus_dispatcher_unregister_signal(
     DBusDispatcher *dispatcher, const char *interface, const char *member)
 {
-	SignalHandler *sh, *prev = NULL;
-
-	if (!dispatcher || !interface || !member)
-		return;
-
-	for (sh = dispatcher->signals; sh; prev = sh, sh = sh->next) {
-		if (strcmp(sh->interface, interface) == 0 &&
-		    strcmp(sh->member, member) == 0) {
-			if (prev)
-				prev->next = sh->next;
-			else
-				dispatcher->signals = sh->next;
-
-			free(sh->interface);
-			free(sh->member);
-			free(sh);
-			return;
-		}
-	}
+	dispatch_unregister(
+	    dispatcher, DBUS_MESSAGE_TYPE_SIGNAL, interface, member);
 }
 
 DBusHandlerResult
@@ -900,39 +951,25 @@ dbus_dispatcher_dispatch(
 {
 	const char *interface, *member;
 	int         msg_type;
+	Handler    *h;
 
 	if (!dispatcher || !conn || !msg)
 		return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
 
+	msg_type = dbus_message_get_type(msg);
+	if (msg_type != DBUS_MESSAGE_TYPE_METHOD_CALL &&
+	    msg_type != DBUS_MESSAGE_TYPE_SIGNAL)
+		return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+
 	interface = dbus_message_get_interface(msg);
 	member    = dbus_message_get_member(msg);
-	msg_type  = dbus_message_get_type(msg);
-
 	if (!interface || !member)
 		return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
 
-	/* Try method handlers */
-	if (msg_type == DBUS_MESSAGE_TYPE_METHOD_CALL) {
-		MethodHandler *mh;
-		for (mh = dispatcher->methods; mh; mh = mh->next) {
-			if (strcmp(mh->interface, interface) == 0 &&
-			    strcmp(mh->method, member) == 0) {
-				return mh->handler(conn, msg, mh->user_data);
-			}
-		}
-	}
-	/* Try signal handlers */
-	else if (msg_type == DBUS_MESSAGE_TYPE_SIGNAL) {
-		SignalHandler *sh;
-		for (sh = dispatcher->signals; sh; sh = sh->next) {
-			if (strcmp(sh->interface, interface) == 0 &&
-			    strcmp(sh->member, member) == 0) {
-				return sh->handler(conn, msg, sh->user_data);
-			}
-		}
-	}
-
-	return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+	h = dispatch_lookup(dispatcher, msg_type, interface, member, NULL);
+	if (!h)
+		return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+	return h->handler(conn, msg, h->user_data);
 }
 
 DBusHandlerResult
@@ -29,6 +29,13 @@ int dbus_helper_call_method_async(DBusConnection *conn,
 				  dbus_async_reply_callback callback,
 				  void *user_data);
 
+/* Send a prepared method call (e.g. one with arguments) with a reply
+ * callback.  msg is not consumed. */
+int dbus_helper_send_async(DBusConnection *conn,
+			   DBusMessage *msg,
+			   dbus_async_reply_callback callback,
+			   void *user_data);
+
 /* Get string property via org.freedesktop.DBus.Properties (BLOCKING) */
 int dbus_helper_get_property_string(DBusConnection *conn,
 				    const char *service,
@@ -37,6 +44,15 @@ int dbus_helper_get_property_string(DBusConnection *conn,
 				    const char *property,
 				    char **value);
 
+/* Get any property async - the reply is a single variant */
+int dbus_helper_get_property_async(DBusConnection *conn,
+				   const char *service,
+				   const char *path,
+				   const char *interface,
+				   const char *property,
+				   dbus_async_reply_callback callback,
+				   void *user_data);
+
 /* Get string property async */
 int dbus_helper_get_property_string_async(DBusConnection *conn,
 					  const char *service,
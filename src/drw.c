@@ -303,6 +303,13 @@ drw_setscheme(Drw *drw, Clr *scm)
 		drw->scheme = scm;
 }
 
+void
+drw_set_graph_fetch(Drw *drw, DrwGraphFetch fetch)
+{
+	if (drw)
+		drw->graph_fetch = fetch;
+}
+
 void
 drw_rect(Drw *drw, int x, int y, unsigned int w, unsigned int h, int filled,
     int invert)
@@ -26,6 +26,15 @@ typedef struct {
 	unsigned short r, g, b, a; /* 16-bit channels — used by clr_to_argb() */
 } Clr;
 
+/* Sample source for the ^g^ status2d escape: stores the newest-last
+ * samples of metric @id in *v / *n and returns a sequence number that
+ * changes whenever a sample is added (0 = no data). */
+typedef unsigned long (*DrwGraphFetch)(
+    unsigned int id, const float **v, unsigned int *n);
+
+/* Compiled status2d string; opaque, see drw_status_compile(). */
+typedef struct DrwStatus DrwStatus;
+
 typedef struct {
 	unsigned int      w, h;
 	xcb_connection_t *xc; /* main XCB connection (shared, not owned) */
@@ -35,9 +44,12 @@ typedef struct {
 	xcb_gcontext_t    gc;
 	Clr              *scheme;
 	Fnt              *fonts;
+	unsigned int      font_gen; /* bumped whenever fonts is replaced */
 	xcb_visualtype_t *xcb_visual; /* matches root visual for screen */
 	cairo_surface_t
 	    *cairo_surface; /* cached surface for text/icon rendering */
+	DrwGraphFetch graph_fetch; /* ^g^ sample source; NULL = no graphs */
+	DrwStatus    *status;      /* compiled bar status; owned */
 } Drw;
 
 /* Drawable abstraction */
@@ -64,6 +76,7 @@ void drw_cur_free(Drw *drw, Cur *cursor);
 /* Drawing context manipulation */
 void drw_setfontset(Drw *drw, Fnt *set);
 void drw_setscheme(Drw *drw, Clr *scm);
+void drw_set_graph_fetch(Drw *drw, DrwGraphFetch fetch);
 
 /* Drawing functions */
 void drw_rect(Drw *drw, int x, int y, unsigned int w, unsigned int h,
@@ -72,11 +85,24 @@ int  drw_text(Drw *drw, int x, int y, unsigned int w, unsigned int h,
      unsigned int lpad, const char *text, int invert);
 void drw_pic(Drw *drw, int x, int y, unsigned int w, unsigned int h,
     cairo_surface_t *surface);
+/*
+ * drw_status_compile — parse a status2d string once into drw's cached op
+ * list (text layouts and widths included).  Call when the status changes;
+ * drw_status_width() is then a cached value and drw_status_draw() replays
+ * the ops without re-parsing.  NULL clears the cached status.
+ */
+void drw_status_compile(Drw *drw, const char *text);
+int  drw_status_width(Drw *drw);
+int  drw_status_draw(Drw *drw, int x, int y, unsigned int w, unsigned int h);
+/* Nonzero if a ^g^ graph in the cached status has samples it was not last
+ * drawn with, i.e. the bars need a redraw although the text is unchanged. */
+int  drw_status_graphs_stale(Drw *drw);
 /*
  * drw_draw_statusd — render a status2d-encoded status string.
  * Returns the total pixel width consumed by the rendered content.
  * When x==0 && y==0 && w==0 && h==0, performs measurement only (no draw).
  * Supported escapes: ^cRRGGBB^ ^bRRGGBB^ ^rx,y,w,h^ ^fN^ ^d^
+ *                    ^gID,W,H,MAX^ (sparkline of sample history ID)
  */
 int drw_draw_statusd(
     Drw *drw, int x, int y, unsigned int w, unsigned int h, const char *text);
@@ -40,6 +40,22 @@
 __attribute__((weak)) double ui_dpi = 96.0;
 __attribute__((weak)) int    lrpad  = 4;
 
+/* Cached ^g^ sparkline paths, keyed by (id, w, h, max).  A path is rebuilt
+ * only when its history's seq changes, so bar redraws for unrelated
+ * reasons (focus, titles) just replay it. */
+#define GRAPH_CACHE_SIZE 16
+
+typedef struct {
+	unsigned int  id;
+	int           w, h;
+	double        max;
+	unsigned long seq;
+	cairo_path_t *path;
+} GraphCache;
+
+static GraphCache   graph_cache[GRAPH_CACHE_SIZE];
+static unsigned int graph_cache_next; /* round-robin eviction */
+
 /* ── internal helpers (identical to drw.c) ─────────────────────────────── */
 
 static xcb_visualtype_t *
@@ -157,6 +173,12 @@ void
 drw_free(Drw *drw)
 {
 	assert(drw != NULL);
+	drw_status_compile(drw, NULL);
+	for (int i = 0; i < GRAPH_CACHE_SIZE; i++) {
+		if (graph_cache[i].path)
+			cairo_path_destroy(graph_cache[i].path);
+		graph_cache[i].path = NULL;
+	}
 	if (drw->cairo_surface)
 		cairo_surface_destroy(drw->cairo_surface);
 	xcb_free_pixmap(drw->xc, drw->drawable);
@@ -242,6 +264,7 @@ drw_fontset_create(Drw *drw, const char *fonts[], size_t fontcount)
 			ret       = cur;
 		}
 	}
+	drw->font_gen++;
 	return (drw->fonts = ret);
 }
 
@@ -317,8 +340,10 @@ drw_scm_create(Drw *drw, char *clrnames[], size_t clrcount)
 void
 drw_setfontset(Drw *drw, Fnt *set)
 {
-	if (drw)
+	if (drw) {
 		drw->fonts = set;
+		drw->font_gen++;
+	}
 }
 
 void
@@ -328,6 +353,13 @@ drw_setscheme(Drw *drw, Clr *scm)
 		drw->scheme = scm;
 }
 
+void
+drw_set_graph_fetch(Drw *drw, DrwGraphFetch fetch)
+{
+	if (drw)
+		drw->graph_fetch = fetch;
+}
+
 /* ── drawing ────────────────────────────────────────────────────────────── */
 
 void
@@ -473,8 +505,93 @@ drw_pic(Drw *drw, int x, int y, unsigned int w, unsigned int h,
 
 /* ── status2d escape-code renderer ─────────────────────────────────────── */
 
+static GraphCache *
+graph_cache_find(unsigned int id, int w, int h, double max)
+{
+	for (int i = 0; i < GRAPH_CACHE_SIZE; i++) {
+		GraphCache *e = &graph_cache[i];
+		if (e->path && e->id == id && e->w == w && e->h == h &&
+		    e->max == max)
+			return e;
+	}
+	return NULL;
+}
+
 /*
- * drw_draw_statusd — render a status2d-encoded string into the bar pixmap.
+ * graph_path — return the cached w×h area path for history @id, rebuilding
+ * it first if a sample arrived since it was built.  One pixel per sample,
+ * newest at the right edge; @max is full scale, or 0 to autoscale to the
+ * visible peak.  The path is in graph-local coordinates (origin top-left).
+ */
+static cairo_path_t *
+graph_path(Drw *drw, cairo_t *cr, unsigned int id, int w, int h, double max)
+{
+	const float  *v = NULL;
+	unsigned int  n, first, i;
+	unsigned long seq;
+	GraphCache   *gc = NULL;
+	double        peak, x0, val;
+
+	if (!drw->graph_fetch || w <= 0 || h <= 0)
+		return NULL;
+	seq = drw->graph_fetch(id, &v, &n);
+	if (!seq || !n)
+		return NULL;
+
+	gc = graph_cache_find(id, w, h, max);
+	if (gc && gc->seq == seq)
+		return gc->path;
+	if (!gc) {
+		gc               = &graph_cache[graph_cache_next];
+		graph_cache_next = (graph_cache_next + 1) % GRAPH_CACHE_SIZE;
+	}
+	if (gc->path)
+		cairo_path_destroy(gc->path);
+
+	first = n > (unsigned int) w + 1 ? n - ((unsigned int) w + 1) : 0;
+	peak  = max;
+	if (peak <= 0.0) {
+		for (i = first; i < n; i++)
+			if (v[i] > peak)
+				peak = v[i];
+		if (peak <= 0.0)
+			peak = 1.0;
+	}
+
+	cairo_save(cr);
+	cairo_identity_matrix(cr);
+	cairo_new_path(cr);
+	x0 = w - (double) (n - first - 1);
+	cairo_move_to(cr, x0, h);
+	for (i = first; i < n; i++) {
+		val = v[i] / peak;
+		if (val < 0.0)
+			val = 0.0;
+		if (val > 1.0)
+			val = 1.0;
+		cairo_line_to(cr, x0 + (i - first), h - val * h);
+	}
+	cairo_line_to(cr, w, h);
+	cairo_close_path(cr);
+	gc->path = cairo_copy_path(cr);
+	cairo_new_path(cr);
+	cairo_restore(cr);
+
+	gc->id  = id;
+	gc->w   = w;
+	gc->h   = h;
+	gc->max = max;
+	gc->seq = seq;
+	return gc->path;
+}
+
+/*
+ * Compiled status2d strings.
+ *
+ * A status string is parsed once into a flat list of operations: colour
+ * changes, rects, cursor advances, graphs and text runs whose PangoLayout
+ * and pixel size are built at compile time.  Measuring is then a cached
+ * value and drawing replays the list without touching the escape syntax.
  *
  * Supported escape sequences (all delimited by '^'):
  *   ^cRRGGBB^   set foreground colour (#RRGGBB hex, leading '#' optional)
@@ -482,55 +599,118 @@ drw_pic(Drw *drw, int x, int y, unsigned int w, unsigned int h,
  *   ^r x,y,w,h^ draw a filled rectangle relative to current draw cursor X
  *   ^f N^        advance draw cursor forward by N pixels
  *   ^d^          reset fg/bg to current drw->scheme (SchemeNorm)
- *
- * Measurement-only mode: when x==0 && y==0 && w==0 && h==0, no drawing is
- * performed and the function returns the pixel width the string would consume.
- * This mirrors the drw_text() convention.
- *
- * Returns the total pixel width consumed.
- *
- * @drw  : draw context (scheme must be set by caller before calling)
- * @x    : left edge of the status area in the bar pixmap (0 = measure only)
- * @y    : top edge (0 = measure only)
- * @w    : total available width / clipping budget (0 = measure only)
- * @h    : bar height (0 = measure only)
- * @text : status string, may be NULL (draws nothing, returns 0)
+ *   ^g id,w,h,max^ sparkline of sample history @id in fg over bg, w×h,
+ *                vertically centred; advances the cursor by w.  max is the
+ *                full-scale value (0 or omitted = autoscale)
+ *   ^^           literal '^'
  */
-int
-drw_draw_statusd(
-    Drw *drw, int x, int y, unsigned int w, unsigned int h, const char *text)
+typedef enum {
+	S2dFg,
+	S2dBg,
+	S2dReset,
+	S2dRect,
+	S2dAdvance,
+	S2dGraph,
+	S2dText,
+} S2dOpType;
+
+typedef struct {
+	S2dOpType    type;
+	double       r, g, b;    /* S2dFg, S2dBg */
+	int          x, y, w, h; /* S2dRect; w = advance for S2dAdvance,
+	                          * S2dGraph and S2dText (text pixel width) */
+	unsigned int id;         /* S2dGraph history id */
+	double       max;        /* S2dGraph full scale */
+	PangoLayout *layout;     /* S2dText */
+} S2dOp;
+
+struct DrwStatus {
+	S2dOp       *ops;
+	int          nops, cap;
+	int          width;    /* total pixel advance, i.e. the measured width */
+	char        *text;     /* source, kept to recompile on font/DPI change */
+	unsigned int font_gen; /* drw->font_gen the layouts were built with */
+	double       dpi;      /* ui_dpi likewise */
+	int          exact;    /* measured against drw->cairo_surface */
+};
+
+static S2dOp *
+s2d_push(DrwStatus *st, S2dOpType type)
 {
-	int render = x || y || w || h;
-	/* Working colours — start at SchemeNorm values. */
-	double      cfg_r, cfg_g, cfg_b; /* current fg rgb (0-1) */
-	double      cbg_r, cbg_g, cbg_b; /* current bg rgb (0-1) */
-	int         cx;                  /* current X cursor */
-	const char *p, *seg;
-	char        buf[256];
-	int         seg_len;
-	cairo_t    *cr       = NULL;
-	int         consumed = 0;
+	S2dOp *op;
 
-	if (!drw || !drw->scheme || !text)
-		return 0;
-	if (render && !drw->cairo_surface)
-		return 0;
+	if (st->nops == st->cap) {
+		st->cap = st->cap ? st->cap * 2 : 16;
+		st->ops = erealloc(st->ops, (size_t) st->cap * sizeof(S2dOp));
+	}
+	op = &st->ops[st->nops++];
+	memset(op, 0, sizeof(*op));
+	op->type = type;
+	return op;
+}
 
-	/* Seed working colours from current scheme. */
-	cfg_r = drw->scheme[ColFg].r / 65535.0;
-	cfg_g = drw->scheme[ColFg].g / 65535.0;
-	cfg_b = drw->scheme[ColFg].b / 65535.0;
-	cbg_r = drw->scheme[ColBg].r / 65535.0;
-	cbg_g = drw->scheme[ColBg].g / 65535.0;
-	cbg_b = drw->scheme[ColBg].b / 65535.0;
+static void
+s2d_push_text(
+    Drw *drw, DrwStatus *st, PangoContext *pc, const char *s, int len)
+{
+	S2dOp *op;
+	int    th;
 
-	cx  = x;
-	p   = text;
-	seg = text;
+	if (len <= 0)
+		return;
 
-	if (render)
-		cr = cairo_create(drw->cairo_surface);
+	op         = s2d_push(st, S2dText);
+	op->layout = pango_layout_new(pc);
+	if (drw->fonts && drw->fonts->desc)
+		pango_layout_set_font_description(op->layout, drw->fonts->desc);
+	pango_layout_set_text(op->layout, s, len);
+	pango_layout_get_pixel_size(op->layout, &op->w, &th);
+	op->h = th;
+	st->width += op->w + lrpad / 2;
+}
+
+static void
+s2d_free(DrwStatus *st)
+{
+	if (!st)
+		return;
+	for (int i = 0; i < st->nops; i++)
+		if (st->ops[i].layout)
+			g_object_unref(st->ops[i].layout);
+	free(st->ops);
+	free(st->text);
+	free(st);
+}
 
+static DrwStatus *
+s2d_compile(Drw *drw, const char *text)
+{
+	DrwStatus    *st = ecalloc(1, sizeof(DrwStatus));
+	PangoContext *pc;
+	const char   *p, *seg;
+	S2dOp        *op;
+
+	st->text     = strdup(text);
+	st->font_gen = drw->font_gen;
+	st->dpi      = ui_dpi;
+
+	/* Layouts share one Pango context, taken from the surface so they
+	 * pick up its font options.  Without a surface (not created yet, or
+	 * the visual has none) the default font map still measures text;
+	 * s2d_validate() recompiles once a surface exists. */
+	if (drw->cairo_surface) {
+		cairo_t *cr = cairo_create(drw->cairo_surface);
+		pc          = pango_cairo_create_context(cr);
+		cairo_destroy(cr);
+		st->exact = 1;
+	} else {
+		pc = pango_font_map_create_context(pango_cairo_font_map_get_default());
+	}
+	if (ui_dpi > 0.0)
+		pango_cairo_context_set_resolution(pc, ui_dpi);
+
+	p   = text;
+	seg = text;
 	while (*p) {
 		if (*p != '^') {
 			p++;
@@ -538,112 +718,45 @@ drw_draw_statusd(
 		}
 
 		/* Flush plain-text segment preceding this escape. */
-		seg_len = (int) (p - seg);
-		if (seg_len > 0 && (!render || (unsigned int) (cx - x) < w)) {
-			if (seg_len >= (int) sizeof(buf))
-				seg_len = (int) sizeof(buf) - 1;
-			memcpy(buf, seg, (size_t) seg_len);
-			buf[seg_len] = '\0';
-			{
-				PangoLayout          *layout;
-				PangoFontDescription *desc;
-				int                   tw, th;
-				cairo_t              *tmp_cr;
-
-				/* Need a cairo context for Pango even in measure-only mode. */
-				if (render) {
-					tmp_cr = cr;
-				} else {
-					tmp_cr = cairo_create(drw->cairo_surface);
-				}
-
-				layout = pango_cairo_create_layout(tmp_cr);
-				if (ui_dpi > 0.0)
-					pango_cairo_context_set_resolution(
-					    pango_layout_get_context(layout), ui_dpi);
-				desc = drw->fonts ? drw->fonts->desc : NULL;
-				if (desc)
-					pango_layout_set_font_description(layout, desc);
-				pango_layout_set_text(layout, buf, -1);
-				pango_layout_get_pixel_size(layout, &tw, &th);
-
-				if (render) {
-					/* Fill only the text's own width — do not blot out rects
-					 * that were drawn earlier in the same widget. */
-					cairo_set_source_rgb(cr, cbg_r, cbg_g, cbg_b);
-					cairo_rectangle(
-					    cr, cx, y, (double) (tw + lrpad / 2), (double) h);
-					cairo_fill(cr);
-					cairo_set_source_rgb(cr, cfg_r, cfg_g, cfg_b);
-					cairo_move_to(cr, cx + lrpad / 2, y + ((int) h - th) / 2);
-					pango_cairo_show_layout(cr, layout);
-				} else {
-					cairo_destroy(tmp_cr);
-				}
-				g_object_unref(layout);
-
-				cx += tw + lrpad / 2;
-				consumed += tw + lrpad / 2;
-			}
-		}
+		s2d_push_text(drw, st, pc, seg, (int) (p - seg));
 
 		/* Skip the opening '^'. */
 		p++;
 
 		if (*p == '^') {
-			/* Escaped '^' — treat as literal. */
+			/* Escaped '^' — literal, starts the next text segment. */
 			seg = p;
 			p++;
 			continue;
 		}
 
-		/* Parse escape command. */
 		if ((*p == 'c' || *p == 'b') && p[1] != '^') {
 			/* ^cRRGGBB^ or ^bRRGGBB^ — colour change. */
-			char         cmd   = *p++;
-			int          ishex = (*p == '#');
+			char         cmd = *p++;
 			unsigned int rv = 0, gv = 0, bv = 0;
-			const char  *q = p + ishex;
+			const char  *q = p + (*p == '#');
 
 			/* Accept 6 hex digits. */
 			if (sscanf(q, "%2x%2x%2x", &rv, &gv, &bv) == 3) {
-				double dr = rv / 255.0;
-				double dg = gv / 255.0;
-				double db = bv / 255.0;
-				if (cmd == 'c') {
-					cfg_r = dr;
-					cfg_g = dg;
-					cfg_b = db;
-				} else {
-					cbg_r = dr;
-					cbg_g = dg;
-					cbg_b = db;
-				}
+				op    = s2d_push(st, cmd == 'c' ? S2dFg : S2dBg);
+				op->r = rv / 255.0;
+				op->g = gv / 255.0;
+				op->b = bv / 255.0;
 			}
-			/* Skip to closing '^'. */
-			while (*p && *p != '^')
-				p++;
-			if (*p == '^')
-				p++;
 		} else if (*p == 'r') {
 			/* ^r rx,ry,rw,rh^ — filled rectangle relative to cursor.
-			 * cx is NOT advanced by ^r^; use ^f^ to reserve widget width. */
+			 * The cursor is NOT advanced; use ^f^ to reserve width. */
 			int rx = 0, ry = 0, rw = 0, rh = 0;
 			p++;
-			/* skip optional space */
 			while (*p == ' ')
 				p++;
 			sscanf(p, "%d,%d,%d,%d", &rx, &ry, &rw, &rh);
-			while (*p && *p != '^')
-				p++;
-			if (*p == '^')
-				p++;
-			/* Draw filled rect at (cx+rx, y+ry). cx unchanged — caller
-			 * uses ^f^ to advance past the widget. */
-			if (render && rw > 0 && rh > 0) {
-				cairo_set_source_rgb(cr, cfg_r, cfg_g, cfg_b);
-				cairo_rectangle(cr, cx + rx, y + ry, (double) rw, (double) rh);
-				cairo_fill(cr);
+			if (rw > 0 && rh > 0) {
+				op    = s2d_push(st, S2dRect);
+				op->x = rx;
+				op->y = ry;
+				op->w = rw;
+				op->h = rh;
 			}
 		} else if (*p == 'f') {
 			/* ^f N^ — advance cursor by N pixels. */
@@ -651,89 +764,240 @@ drw_draw_statusd(
 			p++;
 			while (*p == ' ')
 				p++;
-			if (*p >= '0' && *p <= '9') {
+			if (*p >= '0' && *p <= '9')
 				fwd = atoi(p);
-				while (*p >= '0' && *p <= '9')
-					p++;
+			if (fwd > 0) {
+				op    = s2d_push(st, S2dAdvance);
+				op->w = fwd;
+				st->width += fwd;
 			}
-			while (*p && *p != '^')
-				p++;
-			if (*p == '^')
+		} else if (*p == 'g') {
+			/* ^g id,w,h,max^ — sparkline from the graph sample source. */
+			unsigned int gid = 0;
+			int          gw = 0, gh = 0;
+			double       gmax = 0.0;
+			p++;
+			while (*p == ' ')
 				p++;
-			cx += fwd;
-			consumed += fwd;
+			if (sscanf(p, "%u,%d,%d,%lf", &gid, &gw, &gh, &gmax) >= 3 &&
+			    gw > 0 && gh > 0) {
+				op      = s2d_push(st, S2dGraph);
+				op->id  = gid;
+				op->w   = gw;
+				op->h   = gh;
+				op->max = gmax;
+				st->width += gw;
+			}
 		} else if (*p == 'd') {
-			/* ^d^ — reset to SchemeNorm. */
-			while (*p && *p != '^')
-				p++;
-			if (*p == '^')
-				p++;
+			/* ^d^ — reset to SchemeNorm at draw time. */
+			s2d_push(st, S2dReset);
+		}
+		/* Skip to closing '^' (also skips unknown escapes). */
+		while (*p && *p != '^')
+			p++;
+		if (*p == '^')
+			p++;
+		seg = p;
+	}
+
+	/* Flush any trailing plain-text segment. */
+	s2d_push_text(drw, st, pc, seg, (int) (p - seg));
+
+	g_object_unref(pc);
+	return st;
+}
+
+/* Rebuild @drw->status if the font or DPI changed since it was compiled,
+ * or if it was measured before drw had a surface. */
+static void
+s2d_validate(Drw *drw)
+{
+	DrwStatus *st = drw->status;
+
+	if (!st || (st->font_gen == drw->font_gen && st->dpi == ui_dpi &&
+	               (st->exact || !drw->cairo_surface)))
+		return;
+	drw->status = s2d_compile(drw, st->text);
+	s2d_free(st);
+}
+
+/* Replay @st at (x, y) within a w×h budget.  Text runs starting past the
+ * budget are skipped.  Returns the pixel width consumed. */
+static int
+s2d_replay(Drw *drw, const DrwStatus *st, int x, int y, unsigned int w,
+    unsigned int h)
+{
+	double   cfg_r, cfg_g, cfg_b; /* current fg rgb (0-1) */
+	double   cbg_r, cbg_g, cbg_b; /* current bg rgb (0-1) */
+	int      cx = x;
+	cairo_t *cr;
+
+	cr = cairo_create(drw->cairo_surface);
+
+	/* Seed working colours from current scheme. */
+	cfg_r = drw->scheme[ColFg].r / 65535.0;
+	cfg_g = drw->scheme[ColFg].g / 65535.0;
+	cfg_b = drw->scheme[ColFg].b / 65535.0;
+	cbg_r = drw->scheme[ColBg].r / 65535.0;
+	cbg_g = drw->scheme[ColBg].g / 65535.0;
+	cbg_b = drw->scheme[ColBg].b / 65535.0;
+
+	for (int i = 0; i < st->nops; i++) {
+		const S2dOp *op = &st->ops[i];
+
+		switch (op->type) {
+		case S2dFg:
+			cfg_r = op->r;
+			cfg_g = op->g;
+			cfg_b = op->b;
+			break;
+		case S2dBg:
+			cbg_r = op->r;
+			cbg_g = op->g;
+			cbg_b = op->b;
+			break;
+		case S2dReset:
 			cfg_r = drw->scheme[ColFg].r / 65535.0;
 			cfg_g = drw->scheme[ColFg].g / 65535.0;
 			cfg_b = drw->scheme[ColFg].b / 65535.0;
 			cbg_r = drw->scheme[ColBg].r / 65535.0;
 			cbg_g = drw->scheme[ColBg].g / 65535.0;
 			cbg_b = drw->scheme[ColBg].b / 65535.0;
-		} else {
-			/* Unknown escape — skip to closing '^'. */
-			while (*p && *p != '^')
-				p++;
-			if (*p == '^')
-				p++;
+			break;
+		case S2dRect:
+			cairo_set_source_rgb(cr, cfg_r, cfg_g, cfg_b);
+			cairo_rectangle(
+			    cr, cx + op->x, y + op->y, (double) op->w, (double) op->h);
+			cairo_fill(cr);
+			break;
+		case S2dAdvance:
+			cx += op->w;
+			break;
+		case S2dGraph: {
+			int           gy   = y + ((int) h - op->h) / 2;
+			cairo_path_t *path = graph_path(drw, cr, op->id, op->w, op->h,
+			    op->max);
+
+			cairo_set_source_rgb(cr, cbg_r, cbg_g, cbg_b);
+			cairo_rectangle(cr, cx, gy, (double) op->w, (double) op->h);
+			cairo_fill(cr);
+			if (path) {
+				cairo_save(cr);
+				cairo_translate(cr, cx, gy);
+				cairo_append_path(cr, path);
+				cairo_set_source_rgb(cr, cfg_r, cfg_g, cfg_b);
+				cairo_fill(cr);
+				cairo_restore(cr);
+			}
+			cx += op->w;
+			break;
+		}
+		case S2dText:
+			if ((unsigned int) (cx - x) >= w)
+				break;
+			/* Fill only the text's own width — do not blot out rects
+			 * that were drawn earlier in the same widget. */
+			cairo_set_source_rgb(cr, cbg_r, cbg_g, cbg_b);
+			cairo_rectangle(
+			    cr, cx, y, (double) (op->w + lrpad / 2), (double) h);
+			cairo_fill(cr);
+			cairo_set_source_rgb(cr, cfg_r, cfg_g, cfg_b);
+			cairo_move_to(cr, cx + lrpad / 2, y + ((int) h - op->h) / 2);
+			pango_cairo_show_layout(cr, op->layout);
+			cx += op->w + lrpad / 2;
+			break;
 		}
-		seg = p;
 	}
 
-	/* Flush any trailing plain-text segment. */
-	seg_len = (int) (p - seg);
-	if (seg_len > 0 && (!render || (unsigned int) (cx - x) < w)) {
-		if (seg_len >= (int) sizeof(buf))
-			seg_len = (int) sizeof(buf) - 1;
-		memcpy(buf, seg, (size_t) seg_len);
-		buf[seg_len] = '\0';
-		{
-			PangoLayout          *layout;
-			PangoFontDescription *desc;
-			int                   tw, th;
-			cairo_t              *tmp_cr;
-
-			if (render) {
-				tmp_cr = cr;
-			} else {
-				tmp_cr = cairo_create(drw->cairo_surface);
-			}
+	cairo_destroy(cr);
+	return cx - x;
+}
 
-			layout = pango_cairo_create_layout(tmp_cr);
-			if (ui_dpi > 0.0)
-				pango_cairo_context_set_resolution(
-				    pango_layout_get_context(layout), ui_dpi);
-			desc = drw->fonts ? drw->fonts->desc : NULL;
-			if (desc)
-				pango_layout_set_font_description(layout, desc);
-			pango_layout_set_text(layout, buf, -1);
-			pango_layout_get_pixel_size(layout, &tw, &th);
-
-			if (render) {
-				/* Same: fill only the text's own width. */
-				cairo_set_source_rgb(cr, cbg_r, cbg_g, cbg_b);
-				cairo_rectangle(
-				    cr, cx, y, (double) (tw + lrpad / 2), (double) h);
-				cairo_fill(cr);
-				cairo_set_source_rgb(cr, cfg_r, cfg_g, cfg_b);
-				cairo_move_to(cr, cx + lrpad / 2, y + ((int) h - th) / 2);
-				pango_cairo_show_layout(cr, layout);
-			} else {
-				cairo_destroy(tmp_cr);
-			}
-			g_object_unref(layout);
+void
+drw_status_compile(Drw *drw, const char *text)
+{
+	if (!drw)
+		return;
+	s2d_free(drw->status);
+	drw->status = text ? s2d_compile(drw, text) : NULL;
+}
 
-			cx += tw + lrpad / 2;
-			consumed += tw + lrpad / 2;
-		}
+int
+drw_status_width(Drw *drw)
+{
+	if (!drw || !drw->status)
+		return 0;
+	s2d_validate(drw);
+	return drw->status->width;
+}
+
+int
+drw_status_graphs_stale(Drw *drw)
+{
+	const float  *v;
+	unsigned int  n;
+	unsigned long seq;
+	GraphCache   *gc;
+
+	if (!drw || !drw->status || !drw->graph_fetch)
+		return 0;
+	for (int i = 0; i < drw->status->nops; i++) {
+		const S2dOp *op = &drw->status->ops[i];
+
+		if (op->type != S2dGraph)
+			continue;
+		seq = drw->graph_fetch(op->id, &v, &n);
+		gc  = graph_cache_find(op->id, op->w, op->h, op->max);
+		if (gc ? gc->seq != seq : seq != 0)
+			return 1;
 	}
+	return 0;
+}
 
-	if (render)
-		cairo_destroy(cr);
+int
+drw_status_draw(Drw *drw, int x, int y, unsigned int w, unsigned int h)
+{
+	if (!drw || !drw->scheme || !drw->status || !drw->cairo_surface)
+		return 0;
+	s2d_validate(drw);
+	return s2d_replay(drw, drw->status, x, y, w, h);
+}
+
+/*
+ * drw_draw_statusd — render an arbitrary status2d-encoded string.
+ *
+ * One-shot form of drw_status_compile() + drw_status_draw() for strings
+ * that are not the cached bar status.
+ *
+ * Measurement-only mode: when x==0 && y==0 && w==0 && h==0, no drawing is
+ * performed and the function returns the pixel width the string would consume.
+ * This mirrors the drw_text() convention.
+ *
+ * Returns the total pixel width consumed.
+ *
+ * @drw  : draw context (scheme must be set by caller before calling)
+ * @x    : left edge of the status area in the bar pixmap (0 = measure only)
+ * @y    : top edge (0 = measure only)
+ * @w    : total available width / clipping budget (0 = measure only)
+ * @h    : bar height (0 = measure only)
+ * @text : status string, may be NULL (draws nothing, returns 0)
+ */
+int
+drw_draw_statusd(
+    Drw *drw, int x, int y, unsigned int w, unsigned int h, const char *text)
+{
+	int        render = x || y || w || h;
+	DrwStatus *st;
+	int        consumed;
+
+	if (!drw || !drw->scheme || !text)
+		return 0;
+	if (render && !drw->cairo_surface)
+		return 0;
+
+	st       = s2d_compile(drw, text);
+	consumed = render ? s2d_replay(drw, st, x, y, w, h) : st->width;
+	s2d_free(st);
 	return consumed;
 }
 
@@ -11,6 +11,7 @@
 #include "drw.h"
 #include "monitor.h"
 #include "spawn.h"
+#include "startup.h"
 #include "switcher.h"
 #include "systray.h"
 #include "wmstate.h"
@@ -60,8 +61,8 @@ buttonpress(xcb_generic_event_t *e)
 		if (i >= LENGTH(tags) &&
 		    ev->event_x < x + TEXTW(g_awm_selmon->ltsymbol))
 			click = ClkLtSymbol;
-		else if (ev->event_x > g_awm_selmon->ww -
-		        drw_draw_statusd(drw, 0, 0, 0, 0, stext) - getsystraywidth())
+		else if (ev->event_x >
+		    g_awm_selmon->ww - drw_status_width(drw) - getsystraywidth())
 			click = ClkStatusText;
 		else if (i >= LENGTH(tags)) {
 			/* Awesomebar - find which window was clicked */
@@ -77,7 +78,7 @@ buttonpress(xcb_generic_event_t *e)
 					n++;
 
 			if (n > 0) {
-				int tw        = drw_draw_statusd(drw, 0, 0, 0, 0, stext);
+				int tw        = drw_status_width(drw);
 				int stw       = getsystraywidth();
 				int remainder = m->ww - tw - stw - x;
 				int tabw      = remainder / n;
@@ -236,6 +237,12 @@ clientmessage(xcb_generic_event_t *e)
 		return;
 	}
 
+	if (cme->type == netatom[NetStartupInfoBegin] ||
+	    cme->type == netatom[NetStartupInfo]) {
+		startup_info_message(cme);
+		return;
+	}
+
 	if (!c)
 		return;
 	if (cme->type == netatom[NetWMState]) {
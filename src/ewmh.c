@@ -116,25 +116,120 @@ setviewport(void)
 	    netatom[NetDesktopViewport], XCB_ATOM_CARDINAL, 32, 2, data);
 }
 
+/*
+ * _NET_CLIENT_LIST / _NET_CLIENT_LIST_STACKING publishing.
+ *
+ * updateclientlist() only marks the lists dirty; restack() calls it on
+ * every focus change, and several calls commonly land in one event batch.
+ * ewmh_flush() rebuilds both arrays from the client lists, compares them
+ * with the copy last written to the root window, and issues one REPLACE
+ * per property that actually changed.  It runs at the end of each X event
+ * batch and from an idle source for changes made outside X dispatch, so
+ * pagers see at most one PropertyNotify per list per main-loop iteration.
+ */
+typedef struct {
+	uint32_t *win;
+	uint32_t  n, cap;
+} WinList;
+
+static WinList pub_list, pub_stack; /* as last published */
+static WinList scratch;
+static int     clientlist_dirty;
+static int     clientlist_published; /* pub_* hold real root contents */
+static guint   clientlist_idle_id;
+
+static void
+winlist_reserve(WinList *l, uint32_t n)
+{
+	if (n <= l->cap)
+		return;
+	l->cap = n < 64 ? 64 : n * 2;
+	l->win = erealloc(l->win, l->cap * sizeof(*l->win));
+}
+
+/* Write scratch to prop if it differs from *pub; scratch and *pub are
+ * swapped so the published copy is kept without another allocation. */
+static void
+publish_winlist(xcb_atom_t prop, WinList *pub)
+{
+	WinList t;
+
+	if (clientlist_published && scratch.n == pub->n &&
+	    (scratch.n == 0 ||
+	        memcmp(scratch.win, pub->win, scratch.n * sizeof(uint32_t)) == 0))
+		return;
+	xcb_change_property(xc, XCB_PROP_MODE_REPLACE, root, prop,
+	    XCB_ATOM_WINDOW, 32, scratch.n, scratch.win);
+	t        = *pub;
+	*pub     = scratch;
+	scratch  = t;
+}
+
+static gboolean
+clientlist_idle_cb(gpointer data)
+{
+	(void) data;
+	clientlist_idle_id = 0;
+	if (clientlist_dirty) {
+		ewmh_flush();
+		xflush();
+	}
+	return G_SOURCE_REMOVE;
+}
+
 void
 updateclientlist(void)
 {
-	Client *c;
+	clientlist_dirty = 1;
+	if (!clientlist_idle_id)
+		clientlist_idle_id = g_idle_add_full(
+		    G_PRIORITY_HIGH_IDLE, clientlist_idle_cb, NULL, NULL);
+}
 
-	xcb_delete_property(xc, root, netatom[NetClientList]);
-	for (c = g_awm.clients_head; c; c = c->next) {
-		uint32_t win32 = (uint32_t) c->win;
-		xcb_change_property(xc, XCB_PROP_MODE_APPEND, root,
-		    netatom[NetClientList], XCB_ATOM_WINDOW, 32, 1, &win32);
-	}
+void
+ewmh_flush(void)
+{
+	Client  *c;
+	uint32_t n = 0;
 
-	/* Update _NET_CLIENT_LIST_STACKING in bottom-to-top order */
-	xcb_delete_property(xc, root, netatom[NetClientListStacking]);
-	for (c = g_awm.stack_head; c; c = c->snext) {
-		uint32_t win32 = (uint32_t) c->win;
-		xcb_change_property(xc, XCB_PROP_MODE_APPEND, root,
-		    netatom[NetClientListStacking], XCB_ATOM_WINDOW, 32, 1, &win32);
+	if (!clientlist_dirty)
+		return;
+	clientlist_dirty = 0;
+
+	for (c = g_awm.clients_head; c; c = c->next)
+		n++;
+	winlist_reserve(&scratch, n);
+
+	scratch.n = 0;
+	for (c = g_awm.clients_head; c; c = c->next)
+		scratch.win[scratch.n++] = (uint32_t) c->win;
+	publish_winlist(netatom[NetClientList], &pub_list);
+
+	/* scratch may have been swapped with the old pub_list buffer */
+	winlist_reserve(&scratch, n);
+	scratch.n = 0;
+	for (c = g_awm.stack_head; c; c = c->snext)
+		scratch.win[scratch.n++] = (uint32_t) c->win;
+	publish_winlist(netatom[NetClientListStacking], &pub_stack);
+
+	clientlist_published = 1;
+}
+
+void
+ewmh_cleanup(void)
+{
+	if (clientlist_idle_id) {
+		g_source_remove(clientlist_idle_id);
+		clientlist_idle_id = 0;
 	}
+	free(pub_list.win);
+	free(pub_stack.win);
+	free(scratch.win);
+	memset(&pub_list, 0, sizeof(pub_list));
+	memset(&pub_stack, 0, sizeof(pub_stack));
+	memset(&scratch, 0, sizeof(scratch));
+	clientlist_dirty     = 0;
+	clientlist_published = 0;
 }
 
 void
@@ -14,9 +14,11 @@ void setviewport(void);
 void setfocus(Client *c);
 void setwmstate(Client *c);
 void setewmhdesktop(Client *c);
-void updateclientlist(void);
+void updateclientlist(void); /* mark dirty; published by ewmh_flush() */
 void updatecurrentdesktop(void);
 void updateworkarea(Monitor *m);
+void ewmh_flush(void);
+void ewmh_cleanup(void);
 
 /* ICCCM helpers */
 int sendevent(xcb_window_t w, xcb_atom_t proto, int mask, long d0, long d1,
@@ -23,33 +23,46 @@
 #endif
 
 #include "log.h"
+#include "pixel.h"
 #include "util.h"
 
 /* Configuration from awm config.h */
-extern const unsigned int iconcachesize;
-extern const unsigned int iconcachemaxentries;
+extern const unsigned int iconcachebytes;
 
-/* Icon cache - hash table with LRU eviction */
+/* Icon cache
+ *
+ * Keyed by (name or path, size, scale).  An entry holds the rendered
+ * surface, or no surface for a name that did not resolve or load: a
+ * negative entry, so a failed lookup (common for SNI items and games that
+ * name icons no theme has) is not repeated.  Negative entries lapse when
+ * the icon theme changes.  The surfaces plus bookkeeping are kept under
+ * iconcachebytes by evicting the least recently used entries.  cache_lock
+ * guards all of it, so worker threads may add entries. */
 typedef struct CacheEntry {
 	char              *key;
 	int                size;
-	cairo_surface_t   *surface;
-	struct CacheEntry *next;     /* hash chain */
+	int                scale;
+	cairo_surface_t   *surface; /* NULL: negative entry */
+	size_t             cost;    /* bytes charged against iconcachebytes */
 	struct CacheEntry *lru_prev; /* LRU list */
 	struct CacheEntry *lru_next; /* LRU list */
 } CacheEntry;
 
-static CacheEntry **icon_cache  = NULL;
-static CacheEntry  *lru_head    = NULL; /* most recently used */
-static CacheEntry  *lru_tail    = NULL; /* least recently used */
-static int          cache_count = 0;
+static GMutex      cache_lock;
+static GHashTable *icon_cache  = NULL; /* CacheEntry set */
+static CacheEntry *lru_head    = NULL; /* most recently used */
+static CacheEntry *lru_tail    = NULL; /* least recently used */
+static size_t      cache_bytes = 0;
+static unsigned    cache_count = 0, cache_negative = 0;
+static unsigned    theme_gen   = 0; /* bumped on icon theme change */
+static unsigned long cache_hits, cache_neg_hits, cache_misses,
+    cache_evictions;
 
 /* Forward declarations for internal functions */
 static cairo_surface_t *icon_load_svg(const char *path, int size);
-static cairo_surface_t *icon_load_theme(const char *name, int size);
-static unsigned int     hash_string(const char *str);
-static cairo_surface_t *cache_get(const char *key, int size);
-static void cache_put(const char *key, int size, cairo_surface_t *surface);
+static cairo_surface_t *icon_load_file(const char *path, int size);
+static cairo_surface_t *icon_load_theme(
+    const char *name, int size, int scale);
 static void icon_loaded_callback(
     GObject *source_object, GAsyncResult *res, gpointer user_data);
 static void file_read_callback(
@@ -58,25 +71,28 @@ static void file_read_callback(
 /* LRU list helpers */
 static void lru_remove(CacheEntry *entry);
 static void lru_push_front(CacheEntry *entry);
-static void cache_evict_lru(void);
 
 /* ============================================================================
  * Icon Cache
  * ============================================================================
  */
 
-static unsigned int
-hash_string(const char *str)
+static guint
+cache_hash(gconstpointer p)
 {
-	unsigned int hash = 5381;
-	int          c;
+	const CacheEntry *e = p;
 
-	while ((c = *str++))
-		hash = ((hash << 5) + hash) + c;
+	return g_str_hash(e->key) ^ ((guint) e->size * 31u) ^
+	    ((guint) e->scale << 24);
+}
 
-	if (!iconcachesize)
-		return 0;
-	return hash % iconcachesize;
+static gboolean
+cache_equal(gconstpointer a, gconstpointer b)
+{
+	const CacheEntry *x = a, *y = b;
+
+	return x->size == y->size && x->scale == y->scale &&
+	    strcmp(x->key, y->key) == 0;
 }
 
 static void
@@ -110,139 +126,197 @@ lru_push_front(CacheEntry *entry)
 		lru_tail = entry;
 }
 
+/* Unlink and free entry.  cache_lock held. */
 static void
-cache_evict_lru(void)
+cache_drop(CacheEntry *entry)
 {
-	CacheEntry  *entry = lru_tail;
-	unsigned int hash;
-	CacheEntry **pp;
-
-	if (!entry)
-		return;
-
 	lru_remove(entry);
-
-	hash = hash_string(entry->key);
-	pp   = &icon_cache[hash];
-	while (*pp) {
-		if (*pp == entry) {
-			*pp = entry->next;
-			cache_count--;
-			break;
-		}
-		pp = &(*pp)->next;
-	}
-
+	g_hash_table_remove(icon_cache, entry);
+	cache_bytes -= entry->cost;
+	cache_count--;
+	if (!entry->surface)
+		cache_negative--;
 	free(entry->key);
-	cairo_surface_destroy(entry->surface);
+	if (entry->surface)
+		cairo_surface_destroy(entry->surface);
 	free(entry);
 }
 
+/* Bytes an entry with this surface costs: its pixels plus bookkeeping. */
+static size_t
+cache_cost(const char *key, cairo_surface_t *surface)
+{
+	size_t cost = sizeof(CacheEntry) + strlen(key) + 1;
+
+	if (surface && cairo_surface_get_type(surface) == CAIRO_SURFACE_TYPE_IMAGE)
+		cost += (size_t) cairo_image_surface_get_stride(surface) *
+		    (size_t) cairo_image_surface_get_height(surface);
+	return cost;
+}
+
 static void
 cache_print_stats(void)
 {
-	awm_debug("icon cache: %d/%u entries", cache_count, iconcachemaxentries);
+	g_mutex_lock(&cache_lock);
+	awm_debug("icon cache: %u entries (%u negative), %zu/%u KiB, "
+	          "%lu hits, %lu negative hits, %lu misses, %lu evictions",
+	    cache_count, cache_negative, cache_bytes / 1024,
+	    iconcachebytes / 1024, cache_hits, cache_neg_hits, cache_misses,
+	    cache_evictions);
+	g_mutex_unlock(&cache_lock);
 }
 
+/* Icons may have been added or the theme switched: forget every name that
+ * failed to resolve.  Found icons stay; they still render correctly. */
 static void
-cache_init(void)
+cache_theme_changed(GtkIconTheme *theme, gpointer data)
 {
-	if (!iconcachesize || icon_cache)
-		return;
-	icon_cache = calloc(iconcachesize, sizeof(CacheEntry *));
+	CacheEntry *e, *next;
+	unsigned    n = 0;
+	(void) theme;
+	(void) data;
+
+	g_mutex_lock(&cache_lock);
+	theme_gen++;
+	for (e = lru_head; e; e = next) {
+		next = e->lru_next;
+		if (!e->surface) {
+			cache_drop(e);
+			n++;
+		}
+	}
+	g_mutex_unlock(&cache_lock);
+	awm_debug("icon cache: icon theme changed, %u negative entries dropped",
+	    n);
 }
 
+/* Connect cache_theme_changed once.  Main thread only. */
 static void
-cache_cleanup(void)
+cache_watch_theme(void)
+{
+	static int watching;
+
+	if (!watching) {
+		watching = 1;
+		g_signal_connect(gtk_icon_theme_get_default(), "changed",
+		    G_CALLBACK(cache_theme_changed), NULL);
+	}
+}
+
+/* Current theme generation, to pass to a later cache_put of a negative
+ * result. */
+static unsigned
+cache_generation(void)
 {
-	int         i;
-	CacheEntry *entry, *next;
+	unsigned gen;
 
+	g_mutex_lock(&cache_lock);
+	gen = theme_gen;
+	g_mutex_unlock(&cache_lock);
+	return gen;
+}
+
+static void
+cache_cleanup(void)
+{
 	if (!icon_cache)
 		return;
 
 	cache_print_stats();
 
-	for (i = 0; i < iconcachesize; i++) {
-		for (entry = icon_cache[i]; entry; entry = next) {
-			next = entry->next;
-			free(entry->key);
-			if (entry->surface)
-				cairo_surface_destroy(entry->surface);
-			free(entry);
-		}
-		icon_cache[i] = NULL;
-	}
-
-	free(icon_cache);
-	icon_cache  = NULL;
-	lru_head    = NULL;
-	lru_tail    = NULL;
-	cache_count = 0;
+	g_mutex_lock(&cache_lock);
+	while (lru_head)
+		cache_drop(lru_head);
+	g_hash_table_destroy(icon_cache);
+	icon_cache = NULL;
+	g_mutex_unlock(&cache_lock);
 }
 
-static cairo_surface_t *
-cache_get(const char *key, int size)
+/* Look up (key, size, scale).  Returns 1 and a new reference in *out on a
+ * hit, -1 if the key is known not to load, 0 if it is not cached. */
+static int
+cache_get(const char *key, int size, int scale, cairo_surface_t **out)
 {
-	unsigned int hash;
-	CacheEntry  *entry;
-
-	if (!key || !icon_cache || !iconcachesize)
-		return NULL;
+	CacheEntry  probe = { .key = (char *) key, .size = size, .scale = scale };
+	CacheEntry *entry;
+	int         ret = 0;
 
-	hash = hash_string(key);
+	*out = NULL;
+	if (!key || !iconcachebytes)
+		return 0;
 
-	for (entry = icon_cache[hash]; entry; entry = entry->next) {
-		if (entry->size == size && strcmp(entry->key, key) == 0) {
-			lru_remove(entry);
-			lru_push_front(entry);
-			cairo_surface_reference(entry->surface);
-			return entry->surface;
+	g_mutex_lock(&cache_lock);
+	if (icon_cache && (entry = g_hash_table_lookup(icon_cache, &probe))) {
+		lru_remove(entry);
+		lru_push_front(entry);
+		if (entry->surface) {
+			*out = cairo_surface_reference(entry->surface);
+			cache_hits++;
+			ret = 1;
+		} else {
+			cache_neg_hits++;
+			ret = -1;
 		}
+	} else {
+		cache_misses++;
 	}
-
-	return NULL;
+	g_mutex_unlock(&cache_lock);
+	return ret;
 }
 
+/* Remember surface (a new reference is taken) for (key, size, scale), or
+ * with surface NULL that the key does not load.  A negative result is
+ * dropped if the theme changed since gen was read, as it may be stale.
+ * Safe from any thread. */
 static void
-cache_put(const char *key, int size, cairo_surface_t *surface)
+cache_put(const char *key, int size, int scale, cairo_surface_t *surface,
+    unsigned gen)
 {
-	unsigned int hash;
-	CacheEntry  *entry;
+	CacheEntry  probe = { .key = (char *) key, .size = size, .scale = scale };
+	CacheEntry *entry;
+	size_t      cost;
 
-	if (!key || !surface || !icon_cache || !iconcachesize)
+	if (!key || !iconcachebytes)
+		return;
+	cost = cache_cost(key, surface);
+	if (cost > iconcachebytes)
 		return;
 
-	hash = hash_string(key);
-
-	for (entry = icon_cache[hash]; entry; entry = entry->next) {
-		if (entry->size == size && strcmp(entry->key, key) == 0)
-			return;
+	g_mutex_lock(&cache_lock);
+	if (!surface && gen != theme_gen)
+		goto out;
+	if (!icon_cache)
+		icon_cache = g_hash_table_new(cache_hash, cache_equal);
+	if ((entry = g_hash_table_lookup(icon_cache, &probe))) {
+		/* a load racing another: keep the first, but let a real
+		 * surface replace a negative entry */
+		if (entry->surface || !surface)
+			goto out;
+		cache_drop(entry);
 	}
 
-	while (
-	    iconcachemaxentries > 0 && cache_count >= (int) iconcachemaxentries) {
-		cache_evict_lru();
+	while (lru_tail && cache_bytes + cost > iconcachebytes) {
+		cache_drop(lru_tail);
+		cache_evictions++;
 	}
 
 	entry = calloc(1, sizeof(CacheEntry));
-	if (!entry)
-		return;
-
-	entry->key = strdup(key);
-	if (!entry->key) {
+	if (!entry || !(entry->key = strdup(key))) {
 		free(entry);
-		return;
+		goto out;
 	}
 	entry->size    = size;
-	entry->surface = surface;
-	cairo_surface_reference(surface);
-
-	entry->next      = icon_cache[hash];
-	icon_cache[hash] = entry;
-
+	entry->scale   = scale;
+	entry->surface = surface ? cairo_surface_reference(surface) : NULL;
+	entry->cost    = cost;
+	g_hash_table_add(icon_cache, entry);
 	lru_push_front(entry);
+	cache_bytes += cost;
 	cache_count++;
+	if (!surface)
+		cache_negative++;
+out:
+	g_mutex_unlock(&cache_lock);
 }
 
 /* ============================================================================
@@ -336,47 +410,16 @@ icon_pixbuf_to_surface(GdkPixbuf *orig_pixbuf, int size)
 
 	/* Draw pixbuf to surface - manual pixel copy since
 	 * gdk_cairo_set_source_pixbuf may not be available */
-	{
-		unsigned char *pixels       = gdk_pixbuf_get_pixels(pixbuf);
-		int            rowstride    = gdk_pixbuf_get_rowstride(pixbuf);
-		int            n_channels   = gdk_pixbuf_get_n_channels(pixbuf);
-		gboolean       has_alpha    = gdk_pixbuf_get_has_alpha(pixbuf);
-		unsigned char *surface_data = cairo_image_surface_get_data(surface);
-		int surface_stride          = cairo_image_surface_get_stride(surface);
-		int x, y;
-
-		cairo_surface_flush(surface);
-
-		for (y = 0; y < height; y++) {
-			for (x = 0; x < width; x++) {
-				unsigned char  r, g, b, a;
-				unsigned char *p = pixels + y * rowstride + x * n_channels;
-				unsigned char *q = surface_data + y * surface_stride + x * 4;
-
-				r = p[0];
-				g = p[1];
-				b = p[2];
-				a = has_alpha ? p[3] : 255;
-
-				/* Cairo uses pre-multiplied alpha in ARGB32 format */
-				if (a == 0) {
-					q[0] = q[1] = q[2] = q[3] = 0;
-				} else if (a == 255) {
-					q[0] = b;
-					q[1] = g;
-					q[2] = r;
-					q[3] = a;
-				} else {
-					q[0] = (b * a) / 255;
-					q[1] = (g * a) / 255;
-					q[2] = (r * a) / 255;
-					q[3] = a;
-				}
-			}
-		}
-
-		cairo_surface_mark_dirty(surface);
-	}
+	cairo_surface_flush(surface);
+	pixel_to_argb32(cairo_image_surface_get_data(surface),
+	    (size_t) cairo_image_surface_get_stride(surface),
+	    gdk_pixbuf_get_pixels(pixbuf),
+	    (size_t) gdk_pixbuf_get_rowstride(pixbuf), width, height,
+	    gdk_pixbuf_get_has_alpha(pixbuf) &&
+	            gdk_pixbuf_get_n_channels(pixbuf) == 4
+	        ? PIXEL_RGBA
+	        : PIXEL_RGB);
+	cairo_surface_mark_dirty(surface);
 
 	cairo_destroy(cr);
 	g_object_unref(pixbuf);
@@ -389,8 +432,78 @@ icon_pixbuf_to_surface(GdkPixbuf *orig_pixbuf, int size)
  * ============================================================================
  */
 
+/* Load and rasterise an image file.  Touches no GTK state, so it is also
+ * run on the worker pool by icon_load_threaded(). */
 static cairo_surface_t *
-icon_load_theme(const char *name, int size)
+icon_load_file(const char *path, int size)
+{
+	cairo_surface_t *surface;
+	GdkPixbuf       *pixbuf;
+	GError          *error = NULL;
+
+	/* Check if file exists */
+	if (access(path, R_OK) != 0)
+		return NULL;
+
+	/* Try SVG first (better quality at different sizes) */
+	if (strstr(path, ".svg") || strstr(path, ".SVG"))
+		return icon_load_svg(path, size);
+
+	/* Use gdk-pixbuf for all other formats (.ico, .png, .jpg, .bmp, etc.) */
+	pixbuf = gdk_pixbuf_new_from_file(path, &error);
+	if (!pixbuf) {
+		if (error) {
+			awm_error("Failed to load icon '%s': %s", path, error->message);
+			g_error_free(error);
+		}
+		return NULL;
+	}
+
+	surface = icon_pixbuf_to_surface(pixbuf, size);
+	g_object_unref(pixbuf);
+
+	if (surface && cairo_surface_status(surface) == CAIRO_STATUS_SUCCESS)
+		return surface;
+	if (surface)
+		cairo_surface_destroy(surface);
+
+	awm_error("Failed to load icon from file: %s", path);
+	return NULL;
+}
+
+/* Render at size * scale pixels but draw at size user units. */
+static cairo_surface_t *
+icon_set_scale(cairo_surface_t *surface, int scale)
+{
+	if (surface && scale > 1)
+		cairo_surface_set_device_scale(surface, scale, scale);
+	return surface;
+}
+
+/* Resolve a theme name or absolute path to a readable file.  Theme lookups
+ * use the default GtkIconTheme and must run on the main thread.  Returns a
+ * g_malloc'd path, or NULL if there is no such icon (or it is builtin). */
+static char *
+icon_resolve(const char *name, int size, int scale)
+{
+	GtkIconInfo *icon_info;
+	char        *path;
+
+	if (name[0] == '/')
+		return access(name, R_OK) == 0 ? g_strdup(name) : NULL;
+
+	icon_info = gtk_icon_theme_lookup_icon_for_scale(
+	    gtk_icon_theme_get_default(), name, size, scale,
+	    GTK_ICON_LOOKUP_USE_BUILTIN | GTK_ICON_LOOKUP_GENERIC_FALLBACK);
+	if (!icon_info)
+		return NULL;
+	path = g_strdup(gtk_icon_info_get_filename(icon_info));
+	g_object_unref(icon_info);
+	return path;
+}
+
+static cairo_surface_t *
+icon_load_theme(const char *name, int size, int scale)
 {
 	cairo_surface_t *surface = NULL;
 	GtkIconTheme    *icon_theme;
@@ -402,52 +515,14 @@ icon_load_theme(const char *name, int size)
 		return NULL;
 
 	/* If name is an absolute path, try to load directly */
-	if (name[0] == '/') {
-		/* Check if file exists */
-		if (access(name, R_OK) != 0)
-			return NULL;
-
-		/* Try SVG first (better quality at different sizes) */
-		if (strstr(name, ".svg") || strstr(name, ".SVG"))
-			return icon_load_svg(name, size);
-
-		/* Use gdk-pixbuf for all other formats (.ico, .png, .jpg, .bmp, etc.)
-		 */
-		{
-			GdkPixbuf *pixbuf;
-			GError    *error = NULL;
-
-			pixbuf = gdk_pixbuf_new_from_file(name, &error);
-			if (!pixbuf) {
-				if (error) {
-					awm_error(
-					    "Failed to load icon '%s': %s", name, error->message);
-					g_error_free(error);
-				}
-				return NULL;
-			}
-
-			surface = icon_pixbuf_to_surface(pixbuf, size);
-			g_object_unref(pixbuf);
-
-			if (surface &&
-			    cairo_surface_status(surface) == CAIRO_STATUS_SUCCESS)
-				return surface;
-			if (surface) {
-				cairo_surface_destroy(surface);
-				surface = NULL;
-			}
-
-			awm_error("Failed to load icon from file: %s", name);
-			return NULL;
-		}
-	}
+	if (name[0] == '/')
+		return icon_set_scale(icon_load_file(name, size * scale), scale);
 
 	/* Use GTK's icon theme to look up icon by name */
 	icon_theme = gtk_icon_theme_get_default();
 
-	icon_info = gtk_icon_theme_lookup_icon(icon_theme, name, size,
-	    GTK_ICON_LOOKUP_USE_BUILTIN | GTK_ICON_LOOKUP_GENERIC_FALLBACK);
+	icon_info = gtk_icon_theme_lookup_icon_for_scale(icon_theme, name, size,
+	    scale, GTK_ICON_LOOKUP_USE_BUILTIN | GTK_ICON_LOOKUP_GENERIC_FALLBACK);
 
 	if (!icon_info)
 		return NULL;
@@ -465,10 +540,10 @@ icon_load_theme(const char *name, int size)
 	}
 
 	/* Convert GdkPixbuf to Cairo surface using our existing function */
-	surface = icon_pixbuf_to_surface(pixbuf, size);
+	surface = icon_pixbuf_to_surface(pixbuf, size * scale);
 	g_object_unref(pixbuf);
 
-	return surface;
+	return icon_set_scale(surface, scale);
 }
 
 /* ============================================================================
@@ -507,66 +582,41 @@ icon_pixmap_to_surface(Icon *icons, int count, int size)
 		return NULL;
 	}
 
-	cr = cairo_create(surface);
-
-	/* Scale icon if necessary */
-	if (best_icon->width != size || best_icon->height != size) {
-		double scale_x = (double) size / best_icon->width;
-		double scale_y = (double) size / best_icon->height;
-		cairo_scale(cr, scale_x, scale_y);
-	}
-
 	/* Create source surface with converted pixel data.
 	 *
 	 * The SNI D-Bus protocol delivers icon pixels in network (big-endian)
-	 * byte order: bytes are [A][R][G][B] per pixel in memory.
-	 * Cairo ARGB32 on a little-endian host stores pixels as the native
-	 * 32-bit word 0xAARRGGBB, i.e. bytes [B][G][R][A] in memory.
-	 * A raw memcpy would swap R and B, producing wrong colours.
-	 *
-	 * We must also convert to premultiplied alpha as Cairo requires. */
+	 * byte order: bytes are [A][R][G][B] per pixel in memory, straight
+	 * alpha.  Cairo wants native 0xAARRGGBB words, premultiplied. */
 	cairo_surface_t *src = cairo_image_surface_create(
 	    CAIRO_FORMAT_ARGB32, best_icon->width, best_icon->height);
-	if (cairo_surface_status(src) == CAIRO_STATUS_SUCCESS) {
-		int            stride   = cairo_image_surface_get_stride(src);
-		unsigned char *dst_data = cairo_image_surface_get_data(src);
-		int            w        = best_icon->width;
-		int            h        = best_icon->height;
-
-		for (int row = 0; row < h; row++) {
-			const unsigned char *sp = best_icon->pixels + row * (w * 4);
-			unsigned char       *dp = dst_data + row * stride;
-			for (int col = 0; col < w; col++, sp += 4, dp += 4) {
-				unsigned char a = sp[0]; /* D-Bus wire: A first */
-				unsigned char r = sp[1]; /* then R */
-				unsigned char g = sp[2]; /* then G */
-				unsigned char b = sp[3]; /* then B */
-				/* Cairo ARGB32 little-endian memory: [B][G][R][A]
-				 * with premultiplied alpha. */
-				if (a == 0) {
-					dp[0] = dp[1] = dp[2] = dp[3] = 0;
-				} else if (a == 255) {
-					dp[0] = b;
-					dp[1] = g;
-					dp[2] = r;
-					dp[3] = 255;
-				} else {
-					dp[0] = (unsigned char) ((b * a) / 255);
-					dp[1] = (unsigned char) ((g * a) / 255);
-					dp[2] = (unsigned char) ((r * a) / 255);
-					dp[3] = a;
-				}
-			}
-		}
-		cairo_surface_mark_dirty(src);
+	if (cairo_surface_status(src) != CAIRO_STATUS_SUCCESS) {
+		cairo_surface_destroy(src);
+		return surface;
+	}
+	pixel_to_argb32(cairo_image_surface_get_data(src),
+	    (size_t) cairo_image_surface_get_stride(src), best_icon->pixels,
+	    (size_t) best_icon->width * 4, best_icon->width, best_icon->height,
+	    PIXEL_ARGB_BE);
+	cairo_surface_mark_dirty(src);
+
+	/* Shrink with a box filter; enlarge (or copy) with cairo */
+	cairo_surface_flush(surface);
+	if (best_icon->width >= size && best_icon->height >= size &&
+	    pixel_downscale_box(cairo_image_surface_get_data(surface),
+	        (size_t) cairo_image_surface_get_stride(surface), size, size,
+	        cairo_image_surface_get_data(src),
+	        (size_t) cairo_image_surface_get_stride(src), best_icon->width,
+	        best_icon->height) == 0) {
+		cairo_surface_mark_dirty(surface);
+	} else {
+		cr = cairo_create(surface);
+		cairo_scale(cr, (double) size / best_icon->width,
+		    (double) size / best_icon->height);
+		cairo_set_source_surface(cr, src, 0, 0);
+		cairo_paint(cr);
+		cairo_destroy(cr);
 	}
-
-	/* Paint the icon */
-	cairo_set_source_surface(cr, src, 0, 0);
-	cairo_paint(cr);
-
 	cairo_surface_destroy(src);
-	cairo_destroy(cr);
 
 	return surface;
 }
@@ -642,6 +692,217 @@ file_read_callback(
 	g_object_unref(stream);
 }
 
+/* ============================================================================
+ * Threaded Loading
+ * ============================================================================
+ */
+
+/* Icons are decoded by a small shared pool rather than a thread per
+ * request.  A job is keyed like the cache; a request for a key already
+ * queued or running joins that job as another waiter instead of decoding
+ * it again.  Queued jobs run highest priority first, then oldest first.
+ * Each waiter gets the result on the main context it asked from. */
+
+#define ICON_WORKERS_MAX 4
+
+typedef struct IconWaiter {
+	GMainContext      *context;
+	GCancellable      *cancellable; /* may be NULL */
+	void (*callback)(cairo_surface_t *surface, void *user_data);
+	void              *user_data;
+	struct IconWaiter *next;
+} IconWaiter;
+
+typedef struct {
+	char            *key;  /* name_or_path as requested: the cache key */
+	char            *path; /* resolved file */
+	int              size;
+	int              scale;
+	unsigned         gen;  /* theme generation when resolved */
+	IconPriority     prio; /* main thread only, like every pool sort */
+	guint64          seq;
+	IconWaiter      *waiters;
+} IconJob;
+
+typedef struct {
+	IconWaiter      *waiter;
+	cairo_surface_t *surface;
+} IconDelivery;
+
+static GMutex       jobs_lock; /* guards jobs and every job's waiters */
+static GHashTable  *jobs;      /* IconJob set, queued or running */
+static GThreadPool *pool;
+static guint64      job_seq;
+
+static guint
+job_hash(gconstpointer p)
+{
+	const IconJob *j = p;
+
+	return g_str_hash(j->key) ^ ((guint) j->size * 31u) ^
+	    ((guint) j->scale << 24);
+}
+
+static gboolean
+job_equal(gconstpointer a, gconstpointer b)
+{
+	const IconJob *x = a, *y = b;
+
+	return x->size == y->size && x->scale == y->scale &&
+	    strcmp(x->key, y->key) == 0;
+}
+
+static gint
+job_compare(gconstpointer a, gconstpointer b, gpointer data)
+{
+	const IconJob *x = a, *y = b;
+	(void) data;
+
+	if (x->prio != y->prio)
+		return x->prio > y->prio ? -1 : 1;
+	return x->seq < y->seq ? -1 : x->seq > y->seq;
+}
+
+static void
+waiter_free(IconWaiter *w)
+{
+	g_main_context_unref(w->context);
+	if (w->cancellable)
+		g_object_unref(w->cancellable);
+	free(w);
+}
+
+static void
+job_free(IconJob *job)
+{
+	IconWaiter *w, *next;
+
+	for (w = job->waiters; w; w = next) {
+		next = w->next;
+		waiter_free(w);
+	}
+	g_free(job->key);
+	g_free(job->path);
+	free(job);
+}
+
+/* Does anyone still want job?  jobs_lock held. */
+static int
+job_wanted(const IconJob *job)
+{
+	for (const IconWaiter *w = job->waiters; w; w = w->next)
+		if (!g_cancellable_is_cancelled(w->cancellable))
+			return 1;
+	return 0;
+}
+
+/* On the waiter's main context */
+static gboolean
+job_deliver(gpointer data)
+{
+	IconDelivery *d = data;
+	IconWaiter   *w = d->waiter;
+
+	if (g_cancellable_is_cancelled(w->cancellable)) {
+		if (d->surface)
+			cairo_surface_destroy(d->surface);
+	} else {
+		w->callback(d->surface, w->user_data);
+	}
+	waiter_free(w);
+	free(d);
+	return G_SOURCE_REMOVE;
+}
+
+/* Pool worker: decode, rasterise and cache the result, then hand each
+ * waiter its own reference */
+static void
+job_run(gpointer data, gpointer pool_data)
+{
+	IconJob         *job     = data;
+	cairo_surface_t *surface = NULL;
+	IconWaiter      *w, *next;
+	int              wanted;
+	(void) pool_data;
+
+	/* An unwanted job leaves the table under the same lock as the check,
+	 * so nobody can join it in between and be answered without a decode.
+	 * No waiter can join once the job is out of the table. */
+	g_mutex_lock(&jobs_lock);
+	wanted = job_wanted(job);
+	if (!wanted)
+		g_hash_table_remove(jobs, job);
+	g_mutex_unlock(&jobs_lock);
+	if (wanted) {
+		surface = icon_set_scale(
+		    icon_load_file(job->path, job->size * job->scale), job->scale);
+		cache_put(job->key, job->size, job->scale, surface, job->gen);
+	}
+
+	g_mutex_lock(&jobs_lock);
+	if (wanted)
+		g_hash_table_remove(jobs, job);
+	w            = job->waiters;
+	job->waiters = NULL;
+	g_mutex_unlock(&jobs_lock);
+
+	for (; w; w = next) {
+		IconDelivery *d = ecalloc(1, sizeof(*d));
+
+		next       = w->next;
+		w->next    = NULL;
+		d->waiter  = w;
+		d->surface = surface ? cairo_surface_reference(surface) : NULL;
+		g_main_context_invoke(w->context, job_deliver, d);
+	}
+	if (surface)
+		cairo_surface_destroy(surface);
+	job_free(job);
+}
+
+/* Start the pool on first use.  Main thread only. */
+static int
+pool_start(void)
+{
+	GError *error = NULL;
+	int     n;
+
+	if (pool)
+		return 0;
+	n = (int) g_get_num_processors() - 1;
+	n = n < 1 ? 1 : n > ICON_WORKERS_MAX ? ICON_WORKERS_MAX : n;
+	if (!(pool = g_thread_pool_new(job_run, NULL, n, FALSE, &error))) {
+		awm_error("icon: cannot start worker pool: %s", error->message);
+		g_error_free(error);
+		return -1;
+	}
+	g_thread_pool_set_sort_function(pool, job_compare, NULL);
+	g_mutex_lock(&jobs_lock);
+	jobs = g_hash_table_new(job_hash, job_equal);
+	g_mutex_unlock(&jobs_lock);
+	return 0;
+}
+
+static void
+pool_stop(void)
+{
+	GHashTableIter it;
+	gpointer       job;
+
+	if (!pool)
+		return;
+	/* drop queued jobs, wait for running ones */
+	g_thread_pool_free(pool, TRUE, TRUE);
+	pool = NULL;
+	g_mutex_lock(&jobs_lock);
+	g_hash_table_iter_init(&it, jobs);
+	while (g_hash_table_iter_next(&it, &job, NULL))
+		job_free(job);
+	g_hash_table_destroy(jobs);
+	jobs = NULL;
+	g_mutex_unlock(&jobs_lock);
+}
+
 /* ============================================================================
  * Public API
  * ============================================================================
@@ -666,37 +927,41 @@ icon_init(void)
 		    "Failed to initialize GTK, icon theme support may be limited");
 	}
 
-	/* Initialize icon cache */
-	cache_init();
+	cache_watch_theme();
 }
 
 void
 icon_cleanup(void)
 {
+	pool_stop();
 	cache_cleanup();
 }
 
 cairo_surface_t *
 icon_load(const char *name_or_path, int size)
+{
+	return icon_load_scaled(name_or_path, size, 1);
+}
+
+cairo_surface_t *
+icon_load_scaled(const char *name_or_path, int size, int scale)
 {
 	cairo_surface_t *surface;
+	unsigned         gen;
 
 	if (!name_or_path)
 		return NULL;
+	if (scale < 1)
+		scale = 1;
 
-	/* Check cache first */
-	surface = cache_get(name_or_path, size);
-	if (surface)
+	/* Check cache first; a known failure is not retried */
+	if (cache_get(name_or_path, size, scale, &surface))
 		return surface;
 
-	/* Load icon */
-	surface = icon_load_theme(name_or_path, size);
-	if (!surface)
-		return NULL;
-
-	/* Cache it */
-	cache_put(name_or_path, size, surface);
-
+	cache_watch_theme();
+	gen     = cache_generation();
+	surface = icon_load_theme(name_or_path, size, scale);
+	cache_put(name_or_path, size, scale, surface, gen);
 	return surface;
 }
 
@@ -730,6 +995,80 @@ icon_load_async(const char *path, int size,
 	    file, G_PRIORITY_DEFAULT, NULL, file_read_callback, data);
 }
 
+int
+icon_load_threaded(const char *name_or_path, int size, IconPriority prio,
+    GCancellable *cancellable,
+    void (*callback)(cairo_surface_t *surface, void *user_data),
+    void *user_data)
+{
+	IconJob          probe = { .key = (char *) name_or_path, .size = size,
+		         .scale = 1 };
+	cairo_surface_t *surface;
+	IconWaiter      *w;
+	IconJob         *job;
+	char            *path;
+	unsigned         gen;
+
+	if (!name_or_path || !*name_or_path || !callback)
+		return -1;
+
+	switch (cache_get(name_or_path, size, 1, &surface)) {
+	case 1:
+		callback(surface, user_data);
+		return 0;
+	case -1:
+		return -1;
+	}
+	if (pool_start() < 0)
+		return -1;
+
+	w              = ecalloc(1, sizeof(*w));
+	w->context     = g_main_context_ref_thread_default();
+	w->cancellable = cancellable ? g_object_ref(cancellable) : NULL;
+	w->callback    = callback;
+	w->user_data   = user_data;
+
+	/* join a job already queued or running for this key */
+	g_mutex_lock(&jobs_lock);
+	if ((job = g_hash_table_lookup(jobs, &probe))) {
+		w->next      = job->waiters;
+		job->waiters = w;
+		if (prio > job->prio) {
+			/* Re-sort the queue on the raised priority; a running
+			 * job is not in it and is unaffected */
+			job->prio = prio;
+			g_thread_pool_set_sort_function(pool, job_compare, NULL);
+		}
+		g_mutex_unlock(&jobs_lock);
+		return 0;
+	}
+	g_mutex_unlock(&jobs_lock);
+
+	/* theme lookups use GtkIconTheme, which is main thread only */
+	cache_watch_theme();
+	gen = cache_generation();
+	if (!(path = icon_resolve(name_or_path, size, 1))) {
+		cache_put(name_or_path, size, 1, NULL, gen);
+		waiter_free(w);
+		return -1;
+	}
+
+	job          = ecalloc(1, sizeof(*job));
+	job->key     = g_strdup(name_or_path);
+	job->path    = path;
+	job->size    = size;
+	job->scale   = 1;
+	job->gen     = gen;
+	job->prio    = prio;
+	job->seq     = ++job_seq;
+	job->waiters = w;
+	g_mutex_lock(&jobs_lock);
+	g_hash_table_add(jobs, job);
+	g_mutex_unlock(&jobs_lock);
+	g_thread_pool_push(pool, job, NULL);
+	return 0;
+}
+
 void
 icon_free(Icon *icon)
 {
@@ -24,6 +24,13 @@ typedef struct {
 	void (*callback)(cairo_surface_t *surface, void *user_data);
 } IconLoadData;
 
+/* Order of queued icon_load_threaded() jobs: highest first */
+typedef enum {
+	ICON_PRIO_BACKGROUND, /* prefetch */
+	ICON_PRIO_NORMAL,
+	ICON_PRIO_VISIBLE, /* on screen now, e.g. bar and tray icons */
+} IconPriority;
+
 /* Initialization - call before using icon functions */
 void icon_init(void);
 
@@ -37,6 +44,11 @@ void icon_cleanup(void);
  */
 cairo_surface_t *icon_load(const char *name_or_path, int size);
 
+/* As icon_load(), for a display scale factor: the surface is rendered at
+ * size * scale pixels with a matching cairo device scale */
+cairo_surface_t *icon_load_scaled(
+    const char *name_or_path, int size, int scale);
+
 /* Asynchronous icon loading from file path
  * Calls callback(surface, user_data) when complete
  * Returns immediately, performs I/O and decoding in background
@@ -45,6 +57,21 @@ void icon_load_async(const char *path, int size,
     void (*callback)(cairo_surface_t *surface, void *user_data),
     void *user_data);
 
+/* Threaded icon loading from theme name or file path
+ * Resolves the name on the calling (main) thread, then reads and rasterises
+ * the file on a bounded worker pool, prio deciding the order of queued
+ * work.  Requests for an icon already being loaded share that load.
+ * callback(surface, user_data) runs on the caller's main context with a
+ * new reference (NULL if decoding failed); on a cache hit it runs before
+ * this returns.  Nothing is called once cancellable (may be NULL) is
+ * cancelled.
+ * Returns -1, without calling back, if the name does not resolve to a file
+ */
+int icon_load_threaded(const char *name_or_path, int size, IconPriority prio,
+    GCancellable *cancellable,
+    void (*callback)(cairo_surface_t *surface, void *user_data),
+    void *user_data);
+
 /* Convert ARGB pixmap data to cairo surface
  * icons: array of Icon structs (different sizes)
  * count: number of icons in array
@@ -3,7 +3,7 @@
  *
  * rofi-style launcher that reads .desktop files and falls back to PATH.
  * GTK backend: GtkWindow (undecorated, POPUP_MENU) + GtkSearchEntry +
- * GtkScrolledWindow + GtkListBox.
+ * GtkScrolledWindow + GtkListBox with a fixed pool of rows.
  *
  * Everything related to item discovery, icon loading, history, and launching
  * is identical to the original implementation.  Only the UI layer has
@@ -21,17 +21,18 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
 
 #include <gtk/gtk.h>
+#include <glib-unix.h>
 #include <gdk/gdkx.h>
 
-#ifndef MSG_NOSIGNAL
-#define MSG_NOSIGNAL 0
-#endif
-
 #include "icon.h"
 #include "launcher.h"
 #include "log.h"
+#include "startup_util.h"
 #include "ui_proto.h"
 #include "util.h"
 
@@ -164,77 +165,6 @@ icon_alias_lookup(const char *short_name)
 	return NULL;
 }
 
-static cairo_surface_t *
-launcher_load_icon(const char *icon_name, int size)
-{
-	cairo_surface_t *surface;
-	const char      *resolved;
-
-	if (!icon_name || !*icon_name)
-		return NULL;
-
-	surface = icon_load(icon_name, size);
-	if (surface)
-		return surface;
-
-	icon_alias_build();
-	resolved = icon_alias_lookup(icon_name);
-	if (!resolved)
-		return NULL;
-
-	return icon_load(resolved, size);
-}
-
-/* -------------------------------------------------------------------------
- * Item matching / sorting (unchanged)
- * ---------------------------------------------------------------------- */
-
-static int
-launcher_item_matches(LauncherItem *item, const char *input)
-{
-	char name_lower[256];
-	char input_lower[256];
-
-	if (!input || !*input)
-		return 1;
-
-	strncpy(name_lower, item->name, sizeof(name_lower) - 1);
-	name_lower[sizeof(name_lower) - 1] = '\0';
-	strncpy(input_lower, input, sizeof(input_lower) - 1);
-	input_lower[sizeof(input_lower) - 1] = '\0';
-
-	char *p = name_lower;
-	while (*p) {
-		*p = (char) tolower((unsigned char) *p);
-		p++;
-	}
-	p = input_lower;
-	while (*p) {
-		*p = (char) tolower((unsigned char) *p);
-		p++;
-	}
-
-	return strstr(name_lower, input_lower) != NULL;
-}
-
-static int
-launcher_item_cmp(const void *a, const void *b)
-{
-	const LauncherItem *ia = *(const LauncherItem *const *) a;
-	const LauncherItem *ib = *(const LauncherItem *const *) b;
-	int                 ca = ia->launch_count > 0 ? ia->launch_count : 0;
-	int                 cb = ib->launch_count > 0 ? ib->launch_count : 0;
-
-	if (ca > 0 && cb > 0)
-		return (cb > ca) - (ca > cb);
-	if (ca > 0)
-		return -1;
-	if (cb > 0)
-		return 1;
-
-	return strcasecmp(ia->name, ib->name);
-}
-
 /* -------------------------------------------------------------------------
  * Desktop file parsing helpers (unchanged)
  * ---------------------------------------------------------------------- */
@@ -243,7 +173,8 @@ static int
 launcher_is_executable(const char *path)
 {
 	struct stat st;
-	return stat(path, &st) == 0 && S_ISREG(st.st_mode) && (st.st_mode & 0111);
+	return stat(path, &st) == 0 && S_ISREG(st.st_mode) &&
+	    access(path, X_OK) == 0;
 }
 
 static int
@@ -324,6 +255,8 @@ launcher_parse_desktop_file(const char *path)
 	char         *name       = NULL;
 	char         *exec_cmd   = NULL;
 	char         *icon       = NULL;
+	char         *generic    = NULL;
+	char         *keywords   = NULL;
 	int           no_display = 0;
 	int           terminal   = 0;
 	LauncherItem *item       = NULL;
@@ -357,6 +290,16 @@ launcher_parse_desktop_file(const char *path)
 			if (v)
 				icon = strdup(v);
 		}
+		if (!generic) {
+			char *v = launcher_get_value(line, "GenericName");
+			if (v)
+				generic = strdup(v);
+		}
+		if (!keywords) {
+			char *v = launcher_get_value(line, "Keywords");
+			if (v)
+				keywords = strdup(v);
+		}
 		char *v = launcher_get_value(line, "NoDisplay");
 		if (v && strcmp(v, "true") == 0)
 			no_display = 1;
@@ -375,6 +318,8 @@ launcher_parse_desktop_file(const char *path)
 		free(name);
 		free(exec_cmd);
 		free(icon);
+		free(generic);
+		free(keywords);
 		return NULL;
 	}
 
@@ -382,11 +327,8 @@ launcher_parse_desktop_file(const char *path)
 	item->name      = name;
 	item->exec      = exec_cmd;
 	item->icon_name = icon;
-	item->icon      = icon
-	         ? launcher_load_icon(icon, LAUNCHER_SCALE(LAUNCHER_ICON_SIZE))
-	         : NULL;
-	if (icon && !item->icon)
-		awm_debug("Launcher: failed to load icon '%s'", icon);
+	item->generic   = generic;
+	item->keywords  = keywords;
 	item->is_desktop = 1;
 	item->terminal   = terminal;
 
@@ -394,7 +336,7 @@ launcher_parse_desktop_file(const char *path)
 }
 
 static LauncherItem *
-launcher_load_desktop_files(const char *base_path)
+launcher_load_desktop_files(const char *base_path, int src)
 {
 	DIR           *dir;
 	struct dirent *entry;
@@ -414,6 +356,8 @@ launcher_load_desktop_files(const char *base_path)
 		LauncherItem *item = launcher_parse_desktop_file(path);
 		if (!item)
 			continue;
+		item->file = strdup(entry->d_name);
+		item->src  = src;
 
 		if (!items)
 			items = item;
@@ -426,73 +370,52 @@ launcher_load_desktop_files(const char *base_path)
 	return items;
 }
 
+/* Scan every $PATH directory (in parallel, see launcher_scan_dirs()) and
+ * return items for the executables not already named in launcher->names.
+ * The merge runs in $PATH order, so the first directory providing a name
+ * wins, as it would for execvp(). */
 static LauncherItem *
-launcher_find_duplicates(LauncherItem *items, const char *name)
+launcher_scan_path(Launcher *launcher)
 {
-	LauncherItem *item;
-	for (item = items; item; item = item->next) {
-		if (strcmp(item->name, name) == 0)
-			return item;
-	}
-	return NULL;
-}
+	LauncherItem    *items = NULL, **tail = &items;
+	LauncherNameMap  seen  = { 0 };
+	LauncherDirScan *scans;
+	const char     **dirs;
+	int              ndirs = launcher->nsrc - launcher->ndesktop_src;
+	int              i, j;
+
+	if (ndirs <= 0)
+		return NULL;
+	dirs  = ecalloc((size_t) ndirs, sizeof(*dirs));
+	scans = ecalloc((size_t) ndirs, sizeof(*scans));
+	for (i = 0; i < ndirs; i++)
+		dirs[i] = launcher->srcs[launcher->ndesktop_src + i].path;
 
-static LauncherItem *
-launcher_scan_path(LauncherItem *existing)
-{
-	DIR           *dir;
-	struct dirent *entry;
-	LauncherItem  *items = NULL;
-	LauncherItem  *last  = NULL;
-	char          *path_env;
-	char          *path_copy;
-	char          *dir_path;
-	char           full_path[1024];
+	if (launcher_scan_dirs(dirs, ndirs, 0, scans) < 0)
+		awm_warn("launcher: PATH scan ran out of memory");
 
-	path_env = getenv("PATH");
-	if (!path_env)
-		return items;
+	for (i = 0; i < ndirs; i++) {
+		for (j = 0; j < scans[i].n; j++) {
+			const char *name = scans[i].names[j];
 
-	path_copy = strdup(path_env);
-	if (!path_copy)
-		return items;
+			if (launcher_namemap_get(&launcher->names, name) ||
+			    launcher_namemap_add(&seen, name, (void *) name) > 0)
+				continue;
 
-	dir_path = strtok(path_copy, ":");
-	while (dir_path) {
-		dir = opendir(dir_path);
-		if (dir) {
-			while ((entry = readdir(dir)) != NULL) {
-				if (entry->d_name[0] == '.')
-					continue;
-
-				snprintf(full_path, sizeof(full_path), "%s/%s", dir_path,
-				    entry->d_name);
-
-				if (!launcher_is_executable(full_path))
-					continue;
-
-				if (launcher_find_duplicates(existing, entry->d_name))
-					continue;
-				if (launcher_find_duplicates(items, entry->d_name))
-					continue;
-
-				LauncherItem *item = ecalloc(1, sizeof(LauncherItem));
-				item->name         = strdup(entry->d_name);
-				item->exec         = strdup(entry->d_name);
-				item->is_desktop   = 0;
-
-				if (!items)
-					items = item;
-				else
-					last->next = item;
-				last = item;
-			}
-			closedir(dir);
+			LauncherItem *item = ecalloc(1, sizeof(LauncherItem));
+			item->name         = strdup(name);
+			item->exec         = strdup(name);
+			item->is_desktop   = 0;
+			item->src          = launcher->ndesktop_src + i;
+			*tail              = item;
+			tail               = &item->next;
 		}
-		dir_path = strtok(NULL, ":");
 	}
 
-	free(path_copy);
+	launcher_namemap_clear(&seen);
+	launcher_dirscan_free(scans, ndirs);
+	free(scans);
+	free(dirs);
 	return items;
 }
 
@@ -539,12 +462,8 @@ launcher_history_load(Launcher *launcher)
 		if (count <= 0)
 			continue;
 
-		for (item = launcher->items; item; item = item->next) {
-			if (strcmp(item->name, line) == 0) {
-				item->launch_count = count;
-				break;
-			}
-		}
+		if ((item = launcher_namemap_get(&launcher->names, line)))
+			item->launch_count = count;
 	}
 	fclose(f);
 }
@@ -583,6 +502,40 @@ launcher_history_save(Launcher *launcher)
 	fclose(f);
 }
 
+static int
+stat_cmp(const void *a, const void *b)
+{
+	return strcmp(((const StartupStat *) a)->name,
+	    ((const StartupStat *) b)->name);
+}
+
+/* Give every item its mean launch-to-map time from awm's launch statistics,
+ * which are keyed by executable basename (a terminal item starts, and is
+ * timed as, the terminal).  Updates the search index if it exists. */
+static void
+launcher_stats_load(Launcher *launcher)
+{
+	StartupStat  *v, key, *st;
+	LauncherItem *item;
+	struct stat   sb;
+	int           n;
+
+	launcher->stats_mtime =
+	    stat(launcher->stats_path, &sb) == 0 ? sb.st_mtime : 0;
+	v = startup_stats_load(launcher->stats_path, &n);
+	if (n > 1)
+		qsort(v, (size_t) n, sizeof(*v), stat_cmp);
+	for (item = launcher->items; item; item = item->next) {
+		startup_cmd_key(item->terminal ? launcher->terminal : item->exec,
+		    key.name, sizeof(key.name));
+		st = n ? bsearch(&key, v, (size_t) n, sizeof(*v), stat_cmp) : NULL;
+		item->launch_ms = st ? st->avg_ms : 0;
+		launcher_search_set_launch_ms(
+		    launcher->matcher, item->idx, item->launch_ms);
+	}
+	free(v);
+}
+
 /* -------------------------------------------------------------------------
  * Append items helper (unchanged)
  * ---------------------------------------------------------------------- */
@@ -595,11 +548,10 @@ launcher_append_items(Launcher *launcher, LauncherItem *new_items)
 	if (!new_items)
 		return;
 
-	launcher->item_count = 0;
-	for (LauncherItem *i = launcher->items; i; i = i->next)
-		launcher->item_count++;
-	for (LauncherItem *i = new_items; i; i = i->next)
+	for (LauncherItem *i = new_items; i; i = i->next) {
+		launcher_namemap_add(&launcher->names, i->name, i);
 		launcher->item_count++;
+	}
 
 	last = launcher->items;
 	if (!last) {
@@ -612,125 +564,705 @@ launcher_append_items(Launcher *launcher, LauncherItem *new_items)
 }
 
 /* -------------------------------------------------------------------------
- * GTK UI helpers
+ * Sources and the on-disk index
  * ---------------------------------------------------------------------- */
 
-/* Retrieve the LauncherItem* stored on a GtkListBoxRow */
-static LauncherItem *
-row_get_item(GtkListBoxRow *row)
+static void
+launcher_add_src(Launcher *launcher, const char *path)
 {
-	return (LauncherItem *) g_object_get_data(G_OBJECT(row), "launcher-item");
+	launcher->srcs = erealloc(
+	    launcher->srcs, (size_t) (launcher->nsrc + 1) * sizeof(*launcher->srcs));
+	launcher->srcs[launcher->nsrc].path     = strdup(path);
+	launcher->srcs[launcher->nsrc].mtime_ns = -1;
+	launcher->nsrc++;
 }
 
-static GtkListBoxRow *
-launcher_first_visible_row(GtkListBox *lb)
+/* Desktop-file directories first (fixed order), then every $PATH entry. */
+static void
+launcher_sources_init(Launcher *launcher)
 {
-	GtkListBoxRow *row;
-	int            i = 0;
+	const char *home = getenv("HOME");
+	const char *path_env;
+	char        path[512];
+	char       *path_copy, *dir, *save;
+	int         i;
 
-	while ((row = gtk_list_box_get_row_at_index(lb, i++))) {
-		if (gtk_widget_get_child_visible(GTK_WIDGET(row)))
-			return row;
+	if (!home)
+		home = "/root";
+
+	for (i = 0; i < (int) (sizeof(desktop_paths) / sizeof(desktop_paths[0]));
+	     i++) {
+		if (desktop_paths[i] == NULL) {
+			if (i == 2)
+				snprintf(
+				    path, sizeof(path), "%s/.local/share/applications", home);
+			else if (i == 3)
+				snprintf(path, sizeof(path),
+				    "%s/.local/share/flatpak/exports/share/applications",
+				    home);
+			else
+				continue;
+		} else {
+			snprintf(path, sizeof(path), "%s", desktop_paths[i]);
+		}
+		launcher_add_src(launcher, path);
 	}
-	return NULL;
+	launcher->ndesktop_src = launcher->nsrc;
+
+	path_env = getenv("PATH");
+	if (!path_env || !(path_copy = strdup(path_env)))
+		return;
+	for (dir = strtok_r(path_copy, ":", &save); dir;
+	     dir = strtok_r(NULL, ":", &save))
+		launcher_add_src(launcher, dir);
+	free(path_copy);
+}
+
+static void
+launcher_sources_stat(Launcher *launcher)
+{
+	for (int i = 0; i < launcher->nsrc; i++)
+		launcher->srcs[i].mtime_ns =
+		    launcher_index_dir_mtime(launcher->srcs[i].path);
+}
+
+static void
+launcher_item_free(LauncherItem *item)
+{
+	free(item->name);
+	free(item->exec);
+	free(item->icon_name);
+	free(item->file);
+	free(item->generic);
+	free(item->keywords);
+	free(item);
+}
+
+static void
+launcher_items_free(Launcher *launcher)
+{
+	LauncherItem *item, *next;
+
+	for (item = launcher->items; item; item = next) {
+		next = item->next;
+		launcher_item_free(item);
+	}
+	launcher->items      = NULL;
+	launcher->item_count = 0;
+	launcher_namemap_clear(&launcher->names);
+}
+
+/* Full scan: parse every .desktop file, then walk $PATH. */
+static void
+launcher_scan_all(Launcher *launcher)
+{
+	for (int i = 0; i < launcher->ndesktop_src; i++)
+		launcher_append_items(launcher,
+		    launcher_load_desktop_files(launcher->srcs[i].path, i));
+	launcher_append_items(launcher, launcher_scan_path(launcher));
 }
 
-/* Build all rows for the listbox from the full item list.
- * Sorting: build a temporary pointer array, qsort it with launcher_item_cmp,
- * then append rows in that order.  Filtering is done via
- * gtk_list_box_set_filter_func — GTK calls it on every row automatically. */
 static void
-launcher_populate_listbox(Launcher *launcher)
+launcher_load_index(Launcher *launcher, const LauncherIndex *idx)
+{
+	LauncherItem    *head = NULL, **tail = &head;
+	LauncherIndexEnt e;
+	int              n = launcher_index_count(idx);
+
+	for (int i = 0; i < n; i++) {
+		LauncherItem *item;
+
+		launcher_index_get(idx, i, &e);
+		item             = ecalloc(1, sizeof(LauncherItem));
+		item->name       = strdup(e.name);
+		item->exec       = strdup(e.exec);
+		item->icon_name  = e.icon_name ? strdup(e.icon_name) : NULL;
+		item->file       = e.file ? strdup(e.file) : NULL;
+		item->generic    = e.generic ? strdup(e.generic) : NULL;
+		item->keywords   = e.keywords ? strdup(e.keywords) : NULL;
+		item->src        = e.src;
+		item->is_desktop = e.is_desktop;
+		item->terminal   = e.terminal;
+		*tail = item;
+		tail  = &item->next;
+	}
+	launcher_append_items(launcher, head);
+}
+
+/* Rewrite the index from the current item list.  The source mtimes saved
+ * are the ones the caller read before scanning: a directory changed while
+ * the scan ran then looks newer than the index and is scanned again. */
+static void
+launcher_index_save(Launcher *launcher)
+{
+	LauncherIndexEnt *ents;
+	LauncherItem     *item;
+	int               n = 0;
+
+	ents = ecalloc((size_t) launcher->item_count + 1, sizeof(*ents));
+	for (item = launcher->items; item && n < launcher->item_count;
+	     item = item->next) {
+		ents[n].name       = item->name;
+		ents[n].exec       = item->exec;
+		ents[n].icon_name  = item->icon_name;
+		ents[n].file       = item->file;
+		ents[n].generic    = item->generic;
+		ents[n].keywords   = item->keywords;
+		ents[n].src        = item->src;
+		ents[n].is_desktop = item->is_desktop;
+		ents[n].terminal   = item->terminal;
+		n++;
+	}
+	if (launcher_index_write(
+	        launcher->index_path, launcher->srcs, launcher->nsrc, ents, n) < 0)
+		awm_warn("launcher: cannot write index %s: %s", launcher->index_path,
+		    strerror(errno));
+	free(ents);
+}
+
+/* -------------------------------------------------------------------------
+ * Search
+ * ---------------------------------------------------------------------- */
+
+/* Results shown for a non-empty query; the empty query lists everything */
+#define LAUNCHER_MAX_RESULTS 512
+
+/* Rank items for text into launcher->results */
+static void
+launcher_run_query(Launcher *launcher, const char *text)
+{
+	launcher->nresults = launcher_search_query(launcher->matcher, text,
+	    launcher->results,
+	    text && *text ? LAUNCHER_MAX_RESULTS : launcher->item_count);
+}
+
+/* (Re)build the search index from the item list and re-run the query
+ * currently in the search entry.  Assigns each item its ->idx. */
+static void
+launcher_search_rebuild(Launcher *launcher)
+{
+	LauncherSearchDoc *docs;
+	LauncherItem      *it;
+	int                n = launcher->item_count, i = 0;
+
+	launcher_search_free(launcher->matcher);
+	free(launcher->results);
+	free(launcher->byidx);
+
+	docs            = ecalloc((size_t) n + 1, sizeof(*docs));
+	launcher->byidx = ecalloc((size_t) n + 1, sizeof(*launcher->byidx));
+	for (it = launcher->items; it && i < n; it = it->next, i++) {
+		it->idx              = i;
+		launcher->byidx[i]   = it;
+		docs[i].name         = it->name;
+		docs[i].exec         = it->exec;
+		docs[i].generic      = it->generic;
+		docs[i].keywords     = it->keywords;
+		docs[i].launch_count = it->launch_count;
+		docs[i].launch_ms    = it->launch_ms;
+	}
+	launcher->matcher = launcher_search_build(docs, i);
+	free(docs);
+	if (!launcher->matcher)
+		die("launcher: cannot build search index:");
+
+	launcher->results  = ecalloc((size_t) n + 1, sizeof(int));
+	launcher->nresults = 0;
+	launcher_run_query(launcher,
+	    launcher->search ? gtk_entry_get_text(GTK_ENTRY(launcher->search))
+	                     : "");
+}
+
+/* -------------------------------------------------------------------------
+ * Icons
+ *
+ * Nothing is loaded up front.  Rows ask launcher_icon_get() when they are
+ * bound; the first request for an Icon= name is answered from the
+ * rasterised icon cache when it has it, otherwise the name is resolved and
+ * rasterised on a worker thread while the rows show a placeholder.  Icons
+ * loaded that way are written back to the cache a little later.
+ * ---------------------------------------------------------------------- */
+
+#define LAUNCHER_ICON_SAVE_DELAY_MS 2000
+
+static void launcher_row_set_icon(Launcher *launcher, LauncherRow *r);
+
+/* Neutral rounded square shown while an icon is being rasterised */
+static cairo_surface_t *
+launcher_placeholder_new(int px)
 {
-	/* Count items */
-	int           count = 0;
-	LauncherItem *it;
+	cairo_surface_t *s;
+	cairo_t         *cr;
+	double           m = px / 8.0, w = px - 2 * m, r = px / 5.0;
+
+	s  = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, px, px);
+	cr = cairo_create(s);
+	cairo_new_sub_path(cr);
+	cairo_arc(cr, m + w - r, m + r, r, -G_PI / 2, 0);
+	cairo_arc(cr, m + w - r, m + w - r, r, 0, G_PI / 2);
+	cairo_arc(cr, m + r, m + w - r, r, G_PI / 2, G_PI);
+	cairo_arc(cr, m + r, m + r, r, G_PI, 3 * G_PI / 2);
+	cairo_close_path(cr);
+	cairo_set_source_rgba(cr, 0.5, 0.5, 0.5, 0.35);
+	cairo_fill(cr);
+	cairo_destroy(cr);
+	return s;
+}
 
-	for (it = launcher->items; it; it = it->next)
-		count++;
+/* Copy px * px cached pixels into a new image surface */
+static cairo_surface_t *
+launcher_surface_from_pixels(const uint32_t *pixels, int px)
+{
+	cairo_surface_t *s;
+	unsigned char   *data;
+	int              stride;
 
-	if (count == 0)
+	s = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, px, px);
+	if (cairo_surface_status(s) != CAIRO_STATUS_SUCCESS) {
+		cairo_surface_destroy(s);
+		return NULL;
+	}
+	cairo_surface_flush(s);
+	data   = cairo_image_surface_get_data(s);
+	stride = cairo_image_surface_get_stride(s);
+	for (int y = 0; y < px; y++)
+		memcpy(data + (size_t) y * stride, pixels + (size_t) y * px,
+		    (size_t) px * 4);
+	cairo_surface_mark_dirty(s);
+	return s;
+}
+
+/* Pixels of s in the cache layout, or NULL if s is not a packed px * px
+ * ARGB32 image */
+static const uint32_t *
+launcher_surface_pixels(cairo_surface_t *s, int px)
+{
+	if (cairo_surface_get_type(s) != CAIRO_SURFACE_TYPE_IMAGE ||
+	    cairo_image_surface_get_format(s) != CAIRO_FORMAT_ARGB32 ||
+	    cairo_image_surface_get_width(s) != px ||
+	    cairo_image_surface_get_height(s) != px ||
+	    cairo_image_surface_get_stride(s) != px * 4)
+		return NULL;
+	cairo_surface_flush(s);
+	return (const uint32_t *) cairo_image_surface_get_data(s);
+}
+
+/* Write every icon the current items use to the rasterised icon cache:
+ * loaded this session, or carried over from the old cache file. */
+static void
+launcher_icons_save(Launcher *launcher)
+{
+	LauncherNameMap  seen = { 0 };
+	LauncherIconEnt *ents;
+	LauncherItem    *it;
+	LauncherIcon    *ic;
+	const uint32_t  *pixels;
+	int              n = 0;
+
+	ents = ecalloc((size_t) launcher->item_count + 1, sizeof(*ents));
+	for (it = launcher->items; it; it = it->next) {
+		if (!it->icon_name ||
+		    launcher_namemap_add(&seen, it->icon_name, it) > 0)
+			continue;
+		ic = launcher_namemap_get(&launcher->icons, it->icon_name);
+		if (ic && ic->surface)
+			pixels = launcher_surface_pixels(ic->surface, launcher->icon_px);
+		else
+			pixels = launcher_iconcache_get(launcher->iconcache, it->icon_name);
+		if (pixels) {
+			ents[n].name   = it->icon_name;
+			ents[n].pixels = pixels;
+			n++;
+		}
+	}
+	if (launcher_iconcache_write(launcher->iconcache_path, launcher->icon_theme,
+	        launcher->icon_px, ents, n) < 0)
+		awm_warn("launcher: cannot write %s: %s", launcher->iconcache_path,
+		    strerror(errno));
+	else
+		awm_debug("launcher: %d icons cached", n);
+	launcher_namemap_clear(&seen);
+	free(ents);
+	launcher->icons_dirty = 0;
+}
+
+static gboolean
+launcher_icons_save_cb(gpointer user_data)
+{
+	Launcher *launcher = (Launcher *) user_data;
+
+	launcher->icon_save_id = 0;
+	launcher_icons_save(launcher);
+	return G_SOURCE_REMOVE;
+}
+
+/* An icon was rasterised: show it on the rows using it, save it later */
+static void
+launcher_icon_loaded(cairo_surface_t *surface, void *user_data)
+{
+	LauncherIcon *ic       = (LauncherIcon *) user_data;
+	Launcher     *launcher = ic->launcher;
+
+	ic->surface = surface;
+	ic->loading = 0;
+	if (surface) {
+		launcher->icons_dirty = 1;
+		if (!launcher->icon_save_id)
+			launcher->icon_save_id = g_timeout_add(
+			    LAUNCHER_ICON_SAVE_DELAY_MS, launcher_icons_save_cb, launcher);
+	}
+	for (int i = 0; i < LAUNCHER_ROWS; i++) {
+		LauncherRow *r = &launcher->rows[i];
+		if (r->item && r->item->icon_name &&
+		    strcmp(r->item->icon_name, ic->name) == 0)
+			launcher_row_set_icon(launcher, r);
+	}
+}
+
+static void
+launcher_icon_request(Launcher *launcher, LauncherIcon *ic)
+{
+	int             px = launcher->icon_px;
+	const uint32_t *pixels;
+	const char     *alias;
+
+	pixels = launcher_iconcache_get(launcher->iconcache, ic->name);
+	if (pixels) {
+		ic->surface = launcher_surface_from_pixels(pixels, px);
 		return;
+	}
 
-	/* Build sorted pointer array */
-	LauncherItem **arr = ecalloc(count, sizeof(LauncherItem *));
-	int            idx = 0;
-	for (it = launcher->items; it; it = it->next)
-		arr[idx++] = it;
-	qsort(arr, count, sizeof(LauncherItem *), launcher_item_cmp);
+	/* launcher_icon_loaded() may run before icon_load_threaded() returns */
+	ic->loading = 1;
+	if (icon_load_threaded(ic->name, px, ICON_PRIO_VISIBLE,
+	        launcher->icon_cancel, launcher_icon_loaded, ic) == 0)
+		return;
+	/* Reverse-DNS alias, e.g. Icon=Alacritty -> com.alacritty.Alacritty */
+	icon_alias_build();
+	alias = icon_alias_lookup(ic->name);
+	if (alias &&
+	    icon_load_threaded(alias, px, ICON_PRIO_VISIBLE, launcher->icon_cancel,
+	        launcher_icon_loaded, ic) == 0)
+		return;
+	ic->loading = 0;
+	awm_debug("launcher: no icon '%s'", ic->name);
+}
+
+/* Surface to show for Icon= name: the icon, the placeholder while it is
+ * loading, or NULL if there is none.  Starts loading on first use. */
+static cairo_surface_t *
+launcher_icon_get(Launcher *launcher, const char *name)
+{
+	LauncherIcon *ic = launcher_namemap_get(&launcher->icons, name);
+
+	if (!ic) {
+		ic           = ecalloc(1, sizeof(*ic));
+		ic->name     = strdup(name);
+		ic->launcher = launcher;
+		if (launcher_namemap_add(&launcher->icons, ic->name, ic) < 0) {
+			free(ic->name);
+			free(ic);
+			return NULL;
+		}
+		launcher_icon_request(launcher, ic);
+	}
+	return ic->loading ? launcher->icon_placeholder : ic->surface;
+}
 
-	/* Add rows */
-	for (int i = 0; i < count; i++) {
-		LauncherItem *item = arr[i];
+/* Open the rasterised icon cache for the current icon size and theme */
+static void
+launcher_icons_open(Launcher *launcher)
+{
+	GtkSettings *settings = gtk_settings_get_default();
+	char        *theme    = NULL;
+
+	if (settings)
+		g_object_get(settings, "gtk-icon-theme-name", &theme, NULL);
+	snprintf(launcher->icon_theme, sizeof(launcher->icon_theme), "%s",
+	    theme ? theme : "");
+	g_free(theme);
+
+	launcher->icon_px          = LAUNCHER_SCALE(LAUNCHER_ICON_SIZE);
+	launcher->icon_cancel      = g_cancellable_new();
+	launcher->icon_placeholder = launcher_placeholder_new(launcher->icon_px);
+	launcher->iconcache        = launcher_iconcache_open(
+        launcher->iconcache_path, launcher->icon_theme, launcher->icon_px);
+}
+
+/* Drop every loaded icon (cancelling loads in flight) and the cache
+ * mapping, saving first if anything new was loaded. */
+static void
+launcher_icons_close(Launcher *launcher)
+{
+	LauncherNameMap *m = &launcher->icons;
 
-		GtkWidget *row_box =
+	if (launcher->icon_save_id) {
+		g_source_remove(launcher->icon_save_id);
+		launcher->icon_save_id = 0;
+	}
+	if (launcher->icons_dirty)
+		launcher_icons_save(launcher);
+
+	g_cancellable_cancel(launcher->icon_cancel);
+	g_object_unref(launcher->icon_cancel);
+	launcher->icon_cancel = NULL;
+	for (uint32_t i = 0; i < m->cap; i++) {
+		LauncherIcon *ic = m->slots[i].val;
+		if (!m->slots[i].key)
+			continue;
+		if (ic->surface)
+			cairo_surface_destroy(ic->surface);
+		free(ic->name);
+		free(ic);
+	}
+	launcher_namemap_clear(m);
+	launcher_iconcache_close(launcher->iconcache);
+	launcher->iconcache = NULL;
+	cairo_surface_destroy(launcher->icon_placeholder);
+	launcher->icon_placeholder = NULL;
+}
+
+/* -------------------------------------------------------------------------
+ * Result list
+ *
+ * The GtkListBox holds a fixed pool of LAUNCHER_ROWS rows that is bound to
+ * the window results[top .. top + LAUNCHER_ROWS).  Scrolling, selection and
+ * a new query only rebind labels and icons; no widget is created per item.
+ * launcher->vadj is the scrollbar model in result units (value = top,
+ * page_size = rows that fit), and launcher->sel the selected result.
+ * ---------------------------------------------------------------------- */
+
+static void
+launcher_rows_init(Launcher *launcher)
+{
+	int icon_px = LAUNCHER_SCALE(LAUNCHER_ICON_SIZE);
+
+	for (int i = 0; i < LAUNCHER_ROWS; i++) {
+		LauncherRow *r   = &launcher->rows[i];
+		GtkWidget   *box =
 		    gtk_box_new(GTK_ORIENTATION_HORIZONTAL, LAUNCHER_SCALE(4));
 
-		/* Icon */
-		if (item->icon) {
-			int        icon_px = LAUNCHER_SCALE(LAUNCHER_ICON_SIZE);
-			GdkPixbuf *pb      = gdk_pixbuf_get_from_surface(
-                item->icon, 0, 0, icon_px, icon_px);
-			if (pb) {
-				GtkWidget *img = gtk_image_new_from_pixbuf(pb);
-				g_object_unref(pb);
-				gtk_box_pack_start(
-				    GTK_BOX(row_box), img, FALSE, FALSE, LAUNCHER_SCALE(2));
-			}
-		}
+		r->icon = gtk_image_new();
+		gtk_widget_set_size_request(r->icon, icon_px, icon_px);
+		gtk_box_pack_start(
+		    GTK_BOX(box), r->icon, FALSE, FALSE, LAUNCHER_SCALE(2));
+
+		r->label = gtk_label_new(NULL);
+		gtk_label_set_xalign(GTK_LABEL(r->label), 0.0f);
+		gtk_label_set_ellipsize(GTK_LABEL(r->label), PANGO_ELLIPSIZE_END);
+		gtk_box_pack_start(GTK_BOX(box), r->label, TRUE, TRUE, 0);
+
+		/* Keyboard focus stays in the search entry; visibility is owned
+		 * by launcher_list_bind(), not gtk_widget_show_all() */
+		r->row = gtk_list_box_row_new();
+		gtk_widget_set_can_focus(r->row, FALSE);
+		gtk_container_add(GTK_CONTAINER(r->row), box);
+		gtk_list_box_insert(GTK_LIST_BOX(launcher->listbox), r->row, -1);
+		gtk_widget_show_all(r->row);
+		gtk_widget_set_no_show_all(r->row, TRUE);
+		r->item = NULL;
+	}
+}
 
-		/* Label */
-		GtkWidget *lbl = gtk_label_new(item->name);
-		gtk_label_set_xalign(GTK_LABEL(lbl), 0.0f);
-		gtk_box_pack_start(GTK_BOX(row_box), lbl, TRUE, TRUE, 0);
+static void
+launcher_row_set_icon(Launcher *launcher, LauncherRow *r)
+{
+	cairo_surface_t *icon = r->item->icon_name
+	    ? launcher_icon_get(launcher, r->item->icon_name)
+	    : NULL;
 
-		GtkWidget *row = gtk_list_box_row_new();
-		gtk_container_add(GTK_CONTAINER(row), row_box);
-		g_object_set_data(G_OBJECT(row), "launcher-item", item);
+	if (icon)
+		gtk_image_set_from_surface(GTK_IMAGE(r->icon), icon);
+	else
+		gtk_image_clear(GTK_IMAGE(r->icon));
+}
 
-		gtk_list_box_insert(GTK_LIST_BOX(launcher->listbox), row, -1);
+/* Copy results[top ..] into the row pool, select the row showing sel and
+ * sync the scrollbar. */
+static void
+launcher_list_bind(Launcher *launcher)
+{
+	GtkListBox *lb      = GTK_LIST_BOX(launcher->listbox);
+	int         icon_px = LAUNCHER_SCALE(LAUNCHER_ICON_SIZE);
+	int         i;
+
+	launcher->binding = 1;
+	for (i = 0; i < LAUNCHER_ROWS; i++) {
+		LauncherRow  *r  = &launcher->rows[i];
+		int           k  = launcher->top + i;
+		LauncherItem *it = k < launcher->nresults
+		    ? launcher->byidx[launcher->results[k]]
+		    : NULL;
+
+		gtk_widget_set_visible(r->row, it != NULL);
+		if (it == r->item)
+			continue;
+		r->item = it;
+		if (!it)
+			continue;
+		gtk_label_set_text(GTK_LABEL(r->label), it->name);
+		gtk_widget_set_size_request(r->icon, icon_px, icon_px);
+		launcher_row_set_icon(launcher, r);
 	}
 
-	free(arr);
-	gtk_widget_show_all(launcher->listbox);
+	i = launcher->sel - launcher->top;
+	if (i >= 0 && i < LAUNCHER_ROWS && launcher->sel < launcher->nresults)
+		gtk_list_box_select_row(lb, GTK_LIST_BOX_ROW(launcher->rows[i].row));
+	else
+		gtk_list_box_unselect_all(lb);
+
+	gtk_adjustment_configure(launcher->vadj, launcher->top, 0,
+	    launcher->nresults, 1, launcher->page, launcher->page);
+	launcher->binding = 0;
+}
+
+/* Scroll so that result top is the first row shown */
+static void
+launcher_list_scroll(Launcher *launcher, int top)
+{
+	int max = launcher->nresults - launcher->page;
+
+	if (top > max)
+		top = max;
+	if (top < 0)
+		top = 0;
+	launcher->top = top;
+	launcher_list_bind(launcher);
+}
+
+/* Select result sel (clamped) and scroll it into view */
+static void
+launcher_list_select(Launcher *launcher, int sel)
+{
+	int top = launcher->top;
+
+	if (sel >= launcher->nresults)
+		sel = launcher->nresults - 1;
+	if (sel < 0)
+		sel = 0;
+	launcher->sel = sel;
+	if (sel < top)
+		top = sel;
+	else if (sel >= top + launcher->page)
+		top = sel - launcher->page + 1;
+	launcher_list_scroll(launcher, top);
+}
+
+/* Re-run the query in the search entry and show its results from the top */
+static void
+launcher_list_refilter(Launcher *launcher)
+{
+	launcher_run_query(
+	    launcher, gtk_entry_get_text(GTK_ENTRY(launcher->search)));
+	launcher->sel = 0;
+	launcher->top = 0;
+	launcher_list_bind(launcher);
+}
+
+/* Rebuild the search index from the item list and rebind the rows; called
+ * at startup and whenever the items change. */
+static void
+launcher_list_reload(Launcher *launcher)
+{
+	for (int i = 0; i < LAUNCHER_ROWS; i++)
+		launcher->rows[i].item = NULL;
+	launcher_search_rebuild(launcher);
+	launcher_list_select(launcher, launcher->sel);
+}
+
+static LauncherItem *
+launcher_selected_item(Launcher *launcher)
+{
+	if (launcher->sel < 0 || launcher->sel >= launcher->nresults)
+		return NULL;
+	return launcher->byidx[launcher->results[launcher->sel]];
 }
 
-/* GtkListBoxFilterFunc — called by GTK for every row on invalidation */
 static gboolean
-launcher_filter_func(GtkListBoxRow *row, gpointer user_data)
+launcher_list_rebind_idle(gpointer user_data)
 {
-	Launcher     *launcher = (Launcher *) user_data;
-	LauncherItem *item     = row_get_item(row);
-	const char   *text     = gtk_entry_get_text(GTK_ENTRY(launcher->search));
+	Launcher *launcher = (Launcher *) user_data;
 
-	if (!item)
-		return FALSE;
-	return launcher_item_matches(item, text);
+	launcher->bind_id = 0;
+	launcher_list_select(launcher, launcher->sel);
+	return G_SOURCE_REMOVE;
+}
+
+/* Signal: scroll allocation changed — recompute how many rows fit */
+static void
+on_list_size_allocate(
+    GtkWidget *widget, GdkRectangle *alloc, gpointer user_data)
+{
+	Launcher *launcher = (Launcher *) user_data;
+	int       row_h, page;
+	(void) widget;
+
+	gtk_widget_get_preferred_height(launcher->rows[0].row, NULL, &row_h);
+	page = row_h > 0 ? alloc->height / row_h : LAUNCHER_ROWS;
+	if (page < 1)
+		page = 1;
+	if (page > LAUNCHER_ROWS)
+		page = LAUNCHER_ROWS;
+	if (page == launcher->page)
+		return;
+	/* Adjusting the scrollbar during allocation would queue another one */
+	launcher->page = page;
+	if (!launcher->bind_id)
+		launcher->bind_id = g_idle_add(launcher_list_rebind_idle, launcher);
 }
 
-/* GtkListBoxSortFunc */
-static gint
-launcher_sort_func(GtkListBoxRow *a, GtkListBoxRow *b, gpointer user_data)
+/* Signal: scrollbar moved */
+static void
+on_vadj_value_changed(GtkAdjustment *adj, gpointer user_data)
 {
-	(void) user_data;
-	LauncherItem *ia = row_get_item(a);
-	LauncherItem *ib = row_get_item(b);
+	Launcher *launcher = (Launcher *) user_data;
+
+	if (!launcher->binding)
+		launcher_list_scroll(launcher, (int) gtk_adjustment_get_value(adj));
+}
 
-	if (!ia || !ib)
-		return 0;
+/* Signal: mouse wheel over the rows */
+static gboolean
+on_list_scroll(GtkWidget *widget, GdkEventScroll *event, gpointer user_data)
+{
+	Launcher *launcher = (Launcher *) user_data;
+	double    dx, dy;
+	(void) widget;
 
-	/* Wrap in pointer so we can reuse launcher_item_cmp */
-	const LauncherItem *pa = ia;
-	const LauncherItem *pb = ib;
-	return launcher_item_cmp(&pa, &pb);
+	switch (event->direction) {
+	case GDK_SCROLL_UP:
+		launcher_list_scroll(launcher, launcher->top - 3);
+		break;
+	case GDK_SCROLL_DOWN:
+		launcher_list_scroll(launcher, launcher->top + 3);
+		break;
+	case GDK_SCROLL_SMOOTH:
+		if (gdk_event_get_scroll_deltas((GdkEvent *) event, &dx, &dy) &&
+		    dy != 0.0)
+			launcher_list_scroll(
+			    launcher, launcher->top + (dy > 0 ? 1 : -1));
+		break;
+	default:
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/* Signal: a row was clicked */
+static void
+on_row_selected(GtkListBox *listbox, GtkListBoxRow *row, gpointer user_data)
+{
+	Launcher *launcher = (Launcher *) user_data;
+	(void) listbox;
+
+	if (!launcher->binding && row)
+		launcher->sel = launcher->top + gtk_list_box_row_get_index(row);
 }
 
 /* Launch the currently selected row — sends UI_MSG_LAUNCHER_EXEC to awm */
 static void
 launcher_launch_row(Launcher *launcher, LauncherItem *item)
 {
-	ssize_t n;
-
 	if (!item || !item->exec)
 		return;
 
@@ -746,34 +1278,25 @@ launcher_launch_row(Launcher *launcher, LauncherItem *item)
 		snprintf(cmd, sizeof(cmd), "%s", item->exec);
 	}
 
-	/* Send command to awm */
-	size_t       len = strlen(cmd) + 1; /* include NUL */
-	uint8_t      buf[sizeof(UiMsgHeader) + 2048];
-	UiMsgHeader *hdr = (UiMsgHeader *) buf;
-	hdr->type        = (uint32_t) UI_MSG_LAUNCHER_EXEC;
-	hdr->payload_len = (uint32_t) len;
-	memcpy(buf + sizeof(UiMsgHeader), cmd, len);
+	/* Send command to awm, followed by the item name, which labels the
+	 * launch in awm's log messages (the statistics are keyed by the
+	 * executable's basename) */
+	char name[64];
+	snprintf(name, sizeof(name), "%s", item->name);
+	const char *strs[] = { cmd, name };
 
 	awm_debug("launcher: sending exec command: %s", cmd);
-	do {
-		n = send(launcher->ui_fd, buf, sizeof(UiMsgHeader) + len,
-		    MSG_NOSIGNAL);
-	} while (n < 0 && errno == EINTR);
-	if (n < 0) {
+	if (ui_msg_send_launcher_exec(launcher->ui_fd, strs, 2) < 0) {
 		awm_error("launcher: send EXEC failed: %s", strerror(errno));
 		return;
 	}
-	if ((size_t) n != sizeof(UiMsgHeader) + len) {
-		awm_warn("launcher: partial send (%zd/%zu bytes)", n,
-		    sizeof(UiMsgHeader) + len);
-		return;
-	}
 
 	/* On successful EXEC send, update launcher state locally and hide without
 	 * emitting LAUNCHER_DISMISSED.  EXEC already implies dismissal on the awm
 	 * side, and avoiding a second packet prevents EXEC from being stranded if
 	 * only one queued packet is drained in a loop iteration. */
 	item->launch_count++;
+	launcher_search_set_count(launcher->matcher, item->idx, item->launch_count);
 	launcher_history_save(launcher);
 	if (launcher->visible) {
 		gtk_widget_hide(launcher->window);
@@ -781,47 +1304,23 @@ launcher_launch_row(Launcher *launcher, LauncherItem *item)
 	}
 }
 
-/* Signal: row activated (double-click or Enter on a row) */
+/* Signal: row activated (double-click on a row) */
 static void
 on_row_activated(GtkListBox *listbox, GtkListBoxRow *row, gpointer user_data)
 {
-	Launcher     *launcher = (Launcher *) user_data;
-	LauncherItem *item     = row_get_item(row);
+	Launcher *launcher = (Launcher *) user_data;
 	(void) listbox;
 
-	launcher_launch_row(launcher, item);
+	launcher->sel = launcher->top + gtk_list_box_row_get_index(row);
+	launcher_launch_row(launcher, launcher_selected_item(launcher));
 }
 
-/* Idle callback: select the first visible row after the filter has been
- * applied by GTK.  gtk_list_box_invalidate_filter schedules a relayout;
- * row visibility is not updated synchronously, so we must defer the
- * selection until the next idle pass when GTK has re-run the filter. */
-static gboolean
-select_first_visible_idle(gpointer user_data)
-{
-	Launcher      *launcher = (Launcher *) user_data;
-	GtkListBox    *lb       = GTK_LIST_BOX(launcher->listbox);
-	GtkListBoxRow *row      = launcher_first_visible_row(lb);
-
-	if (row)
-		gtk_list_box_select_row(lb, row);
-	return G_SOURCE_REMOVE; /* one-shot */
-}
-
-/* Signal: search text changed — re-filter and re-sort rows */
+/* Signal: search text changed — re-rank and show the new results */
 static void
 on_search_changed(GtkSearchEntry *entry, gpointer user_data)
 {
-	Launcher *launcher = (Launcher *) user_data;
 	(void) entry;
-
-	gtk_list_box_invalidate_filter(GTK_LIST_BOX(launcher->listbox));
-	gtk_list_box_invalidate_sort(GTK_LIST_BOX(launcher->listbox));
-
-	/* Defer selection until GTK has re-run the filter function and updated
-	 * row visibility.  Checking gtk_widget_get_visible immediately after
-	 * invalidate_filter reads stale state (filter runs asynchronously). */
-	g_idle_add(select_first_visible_idle, launcher);
+	launcher_list_refilter((Launcher *) user_data);
 }
 
 /* Signal: realize — notify awm of our X window ID.  The window is managed
@@ -845,16 +1344,11 @@ on_window_realize(GtkWidget *widget, gpointer user_data)
 
 	if (launcher) {
 		/* Tell awm our X window ID so it can focus us directly. */
-		struct {
-			UiMsgHeader            hdr;
-			UiLauncherReadyPayload pay;
-		} msg;
-		msg.hdr.type        = (uint32_t) UI_MSG_LAUNCHER_READY;
-		msg.hdr.payload_len = sizeof(msg.pay);
-		msg.pay.xwin        = (uint32_t) gdk_x11_window_get_xid(gdk_win);
+		UiLauncherReadyPayload pay;
+		pay.xwin = (uint32_t) gdk_x11_window_get_xid(gdk_win);
 		awm_debug("launcher: realize xwin=0x%x, sending LAUNCHER_READY",
-		    msg.pay.xwin);
-		send(launcher->ui_fd, &msg, sizeof(msg), MSG_NOSIGNAL);
+		    pay.xwin);
+		ui_msg_send_launcher_ready(launcher->ui_fd, &pay);
 	}
 }
 
@@ -870,24 +1364,26 @@ on_delete_event(GtkWidget *widget, GdkEvent *event, gpointer user_data)
 	return TRUE; /* prevent GTK from destroying the window */
 }
 
+/* Launch the selected result, or complain if there is none */
+static void
+launcher_launch_selected(Launcher *launcher, const char *why)
+{
+	LauncherItem *item = launcher_selected_item(launcher);
+
+	if (item)
+		launcher_launch_row(launcher, item);
+	else
+		awm_warn("launcher: %s with no visible selection", why);
+}
+
 /* Signal: search entry activate (Enter pressed while typing in search box).
  * GtkSearchEntry can consume Return before it reaches the toplevel key-press
  * handler, so launch explicitly here. */
 static void
 on_search_activate(GtkEntry *entry, gpointer user_data)
 {
-	Launcher      *launcher = (Launcher *) user_data;
-	GtkListBox    *lb       = GTK_LIST_BOX(launcher->listbox);
-	GtkListBoxRow *sel;
 	(void) entry;
-
-	sel = gtk_list_box_get_selected_row(lb);
-	if (!sel)
-		sel = launcher_first_visible_row(lb);
-	if (sel)
-		launcher_launch_row(launcher, row_get_item(sel));
-	else
-		awm_warn("launcher: activate with no visible selection");
+	launcher_launch_selected((Launcher *) user_data, "activate");
 }
 
 /* Signal: key press on search entry.
@@ -896,128 +1392,305 @@ on_search_activate(GtkEntry *entry, gpointer user_data)
 static gboolean
 on_search_key_press(GtkWidget *widget, GdkEventKey *event, gpointer user_data)
 {
-	Launcher      *launcher = (Launcher *) user_data;
-	GtkListBox    *lb       = GTK_LIST_BOX(launcher->listbox);
-	GtkListBoxRow *sel;
 	(void) widget;
 
 	if (event->keyval != GDK_KEY_Return && event->keyval != GDK_KEY_KP_Enter)
 		return FALSE;
-
-	sel = gtk_list_box_get_selected_row(lb);
-	if (!sel)
-		sel = launcher_first_visible_row(lb);
-	if (sel)
-		launcher_launch_row(launcher, row_get_item(sel));
-	else
-		awm_warn("launcher: Return with no visible selection");
-
+	launcher_launch_selected((Launcher *) user_data, "Return");
 	return TRUE;
 }
 
-/* Signal: key press on the window */
+/* Signal: key press on the window.  Navigation only moves launcher->sel;
+ * the row pool is rebound around it. */
 static gboolean
 on_key_press(GtkWidget *widget, GdkEventKey *event, gpointer user_data)
 {
-	Launcher      *launcher = (Launcher *) user_data;
-	GtkListBox    *lb       = GTK_LIST_BOX(launcher->listbox);
-	GtkListBoxRow *sel;
-	int            new_idx;
+	Launcher *launcher = (Launcher *) user_data;
 	(void) widget;
 
 	switch (event->keyval) {
 	case GDK_KEY_Escape:
 		launcher_hide(launcher);
 		return TRUE;
-
 	case GDK_KEY_Return:
-	case GDK_KEY_KP_Enter: {
-		sel = gtk_list_box_get_selected_row(lb);
-		if (!sel)
-			sel = launcher_first_visible_row(lb);
-		if (sel)
-			launcher_launch_row(launcher, row_get_item(sel));
-		else
-			awm_warn("launcher: Enter pressed with no visible selection");
+	case GDK_KEY_KP_Enter:
+		launcher_launch_selected(launcher, "Enter pressed");
+		return TRUE;
+	case GDK_KEY_Up:
+		launcher_list_select(launcher, launcher->sel - 1);
+		return TRUE;
+	case GDK_KEY_Down:
+		launcher_list_select(launcher, launcher->sel + 1);
+		return TRUE;
+	case GDK_KEY_Page_Up:
+		launcher_list_select(launcher, launcher->sel - launcher->page);
 		return TRUE;
+	case GDK_KEY_Page_Down:
+		launcher_list_select(launcher, launcher->sel + launcher->page);
+		return TRUE;
+	/* plain Home and End move the cursor in the search entry */
+	case GDK_KEY_Home:
+		if (!(event->state & GDK_CONTROL_MASK))
+			return FALSE;
+		launcher_list_select(launcher, 0);
+		return TRUE;
+	case GDK_KEY_End:
+		if (!(event->state & GDK_CONTROL_MASK))
+			return FALSE;
+		launcher_list_select(launcher, launcher->nresults - 1);
+		return TRUE;
+	default:
+		break;
 	}
 
-	case GDK_KEY_Up: {
-		sel = gtk_list_box_get_selected_row(lb);
-		if (!sel) {
-			/* select last visible */
-			int            i = 0;
-			GtkListBoxRow *r, *last_vis = NULL;
-			while ((r = gtk_list_box_get_row_at_index(lb, i++))) {
-				if (gtk_widget_get_visible(GTK_WIDGET(r)))
-					last_vis = r;
-			}
-			if (last_vis)
-				gtk_list_box_select_row(lb, last_vis);
-		} else {
-			new_idx = gtk_list_box_row_get_index(sel) - 1;
-			while (new_idx >= 0) {
-				GtkListBoxRow *r = gtk_list_box_get_row_at_index(lb, new_idx);
-				if (r && gtk_widget_get_visible(GTK_WIDGET(r))) {
-					gtk_list_box_select_row(lb, r);
-					GtkWidget *sw = gtk_widget_get_parent(
-					    gtk_widget_get_parent(launcher->listbox));
-					/* scroll into view */
-					GtkAdjustment *adj = gtk_scrolled_window_get_vadjustment(
-					    GTK_SCROLLED_WINDOW(sw));
-					GtkAllocation alloc;
-					gtk_widget_get_allocation(GTK_WIDGET(r), &alloc);
-					gtk_adjustment_clamp_page(
-					    adj, alloc.y, alloc.y + alloc.height);
-					break;
-				}
-				new_idx--;
+	return FALSE;
+}
+
+/* -------------------------------------------------------------------------
+ * Live updates
+ *
+ * Every source directory is watched with inotify.  Events only queue a
+ * LauncherChange; a short timer then applies the whole batch, rebuilds the
+ * rows once and rewrites the index, so a package upgrade touching hundreds
+ * of files costs one refresh.  Rows hold LauncherItem pointers, which is
+ * why items are never freed outside that timer.
+ * ---------------------------------------------------------------------- */
+
+#define LAUNCHER_REFRESH_DELAY_MS 250
+
+typedef struct {
+	int   src;
+	char *name; /* file name within srcs[src] */
+} LauncherChange;
+
+static LauncherItem *
+launcher_find_file(Launcher *launcher, int src, const char *file)
+{
+	for (LauncherItem *it = launcher->items; it; it = it->next)
+		if (it->src == src && it->file && strcmp(it->file, file) == 0)
+			return it;
+	return NULL;
+}
+
+static void
+launcher_remove_item(Launcher *launcher, LauncherItem *item)
+{
+	LauncherItem **pp;
+
+	for (pp = &launcher->items; *pp; pp = &(*pp)->next) {
+		if (*pp == item)
+			break;
+	}
+	if (!*pp)
+		return;
+	*pp = item->next;
+	launcher->item_count--;
+
+	/* Another .desktop file may carry the same Name; it takes over */
+	if (launcher_namemap_get(&launcher->names, item->name) == item) {
+		LauncherItem *it;
+
+		launcher_namemap_del(&launcher->names, item->name);
+		for (it = launcher->items; it; it = it->next)
+			if (strcmp(it->name, item->name) == 0) {
+				launcher_namemap_add(&launcher->names, it->name, it);
+				break;
 			}
+	}
+	launcher_item_free(item);
+}
+
+/* A .desktop file was created, rewritten or removed: drop the old entry
+ * and re-parse the file if it still exists. */
+static void
+launcher_apply_desktop_change(Launcher *launcher, int src, const char *file)
+{
+	LauncherItem *item;
+	char          path[1024];
+
+	if ((item = launcher_find_file(launcher, src, file)))
+		launcher_remove_item(launcher, item);
+	if (!launcher_is_desktop_entry(file))
+		return;
+	snprintf(path, sizeof(path), "%s/%s", launcher->srcs[src].path, file);
+	if (!(item = launcher_parse_desktop_file(path)))
+		return;
+	item->file = strdup(file);
+	item->src  = src;
+	launcher_append_items(launcher, item);
+}
+
+/* A PATH entry appeared or disappeared.  PATH items exec by bare name, so
+ * only existence matters; ->src records the first directory providing it
+ * so that removal from a later, shadowed directory is a no-op. */
+static void
+launcher_apply_path_change(Launcher *launcher, int src, const char *name)
+{
+	LauncherItem *item;
+	char          path[1024];
+	int           i;
+
+	if (name[0] == '.')
+		return;
+	item = launcher_namemap_get(&launcher->names, name);
+	snprintf(path, sizeof(path), "%s/%s", launcher->srcs[src].path, name);
+
+	if (launcher_is_executable(path)) {
+		if (!item) {
+			item       = ecalloc(1, sizeof(LauncherItem));
+			item->name = strdup(name);
+			item->exec = strdup(name);
+			item->src  = src;
+			launcher_append_items(launcher, item);
+		} else if (!item->is_desktop && src < item->src) {
+			item->src = src;
 		}
-		return TRUE;
+		return;
 	}
 
-	case GDK_KEY_Down: {
-		sel = gtk_list_box_get_selected_row(lb);
-		if (!sel) {
-			/* select first visible */
-			int            i = 0;
-			GtkListBoxRow *r;
-			while ((r = gtk_list_box_get_row_at_index(lb, i++))) {
-				if (gtk_widget_get_visible(GTK_WIDGET(r))) {
-					gtk_list_box_select_row(lb, r);
-					break;
-				}
+	if (!item || item->is_desktop || item->src != src)
+		return;
+	for (i = launcher->ndesktop_src; i < launcher->nsrc; i++) {
+		if (i == src)
+			continue;
+		snprintf(path, sizeof(path), "%s/%s", launcher->srcs[i].path, name);
+		if (launcher_is_executable(path)) {
+			item->src = i;
+			return;
+		}
+	}
+	launcher_remove_item(launcher, item);
+}
+
+static gboolean
+launcher_refresh_cb(gpointer user_data)
+{
+	Launcher *launcher = user_data;
+	guint     i;
+
+	launcher->refresh_id = 0;
+
+	/* Before applying anything; launcher_index_save() records these */
+	launcher_sources_stat(launcher);
+	if (launcher->pending_rescan) {
+		launcher->pending_rescan = 0;
+		launcher_items_free(launcher);
+		launcher_scan_all(launcher);
+	} else {
+		for (i = 0; i < launcher->pending->len; i++) {
+			LauncherChange *c =
+			    &g_array_index(launcher->pending, LauncherChange, i);
+			if (c->src < launcher->ndesktop_src)
+				launcher_apply_desktop_change(launcher, c->src, c->name);
+			else
+				launcher_apply_path_change(launcher, c->src, c->name);
+		}
+	}
+	for (i = 0; i < launcher->pending->len; i++)
+		free(g_array_index(launcher->pending, LauncherChange, i).name);
+	g_array_set_size(launcher->pending, 0);
+
+	launcher_history_load(launcher);
+	launcher_stats_load(launcher);
+	launcher_index_save(launcher);
+
+	launcher_list_reload(launcher);
+
+	awm_debug("launcher: index refreshed, %d items", launcher->item_count);
+	return G_SOURCE_REMOVE;
+}
+
+static void
+launcher_schedule_refresh(Launcher *launcher)
+{
+	if (!launcher->refresh_id)
+		launcher->refresh_id = g_timeout_add(
+		    LAUNCHER_REFRESH_DELAY_MS, launcher_refresh_cb, launcher);
+}
+
+#ifdef __linux__
+static gboolean
+launcher_inotify_cb(gint fd, GIOCondition cond, gpointer user_data)
+{
+	Launcher *launcher = user_data;
+	ssize_t   len;
+	char     *p;
+	int       i;
+	_Alignas(struct inotify_event) char buf[4096];
+
+	if (cond & (G_IO_HUP | G_IO_ERR)) {
+		launcher->inotify_id = 0;
+		return G_SOURCE_REMOVE;
+	}
+
+	while ((len = read(fd, buf, sizeof(buf))) > 0) {
+		for (p = buf; p < buf + len;) {
+			struct inotify_event *ev = (struct inotify_event *) p;
+			p += sizeof(*ev) + ev->len;
+
+			if (ev->mask & IN_Q_OVERFLOW) {
+				launcher->pending_rescan = 1;
+				continue;
 			}
-		} else {
-			new_idx = gtk_list_box_row_get_index(sel) + 1;
-			while (TRUE) {
-				GtkListBoxRow *r = gtk_list_box_get_row_at_index(lb, new_idx);
-				if (!r)
-					break;
-				if (gtk_widget_get_visible(GTK_WIDGET(r))) {
-					gtk_list_box_select_row(lb, r);
-					GtkWidget *sw = gtk_widget_get_parent(
-					    gtk_widget_get_parent(launcher->listbox));
-					GtkAdjustment *adj = gtk_scrolled_window_get_vadjustment(
-					    GTK_SCROLLED_WINDOW(sw));
-					GtkAllocation alloc;
-					gtk_widget_get_allocation(GTK_WIDGET(r), &alloc);
-					gtk_adjustment_clamp_page(
-					    adj, alloc.y, alloc.y + alloc.height);
+			if (!ev->len)
+				continue;
+			for (i = 0; i < launcher->nsrc; i++)
+				if (launcher->wd[i] == ev->wd)
 					break;
-				}
-				new_idx++;
-			}
+			if (i == launcher->nsrc)
+				continue;
+
+			LauncherChange c = { i, strdup(ev->name) };
+			if (c.name)
+				g_array_append_val(launcher->pending, c);
 		}
-		return TRUE;
 	}
+	launcher_schedule_refresh(launcher);
+	return G_SOURCE_CONTINUE;
+}
 
-	default:
-		break;
+static void
+launcher_watch_init(Launcher *launcher)
+{
+	const uint32_t mask = IN_CREATE | IN_DELETE | IN_MOVED_FROM |
+	    IN_MOVED_TO | IN_CLOSE_WRITE | IN_ATTRIB | IN_ONLYDIR;
+
+	launcher->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (launcher->inotify_fd < 0) {
+		awm_warn("launcher: inotify_init1: %s", strerror(errno));
+		return;
 	}
+	for (int i = 0; i < launcher->nsrc; i++)
+		launcher->wd[i] = inotify_add_watch(
+		    launcher->inotify_fd, launcher->srcs[i].path, mask);
+	launcher->inotify_id = g_unix_fd_add(launcher->inotify_fd,
+	    G_IO_IN | G_IO_HUP | G_IO_ERR, launcher_inotify_cb, launcher);
+}
+#else
+static void
+launcher_watch_init(Launcher *launcher)
+{
+	(void) launcher;
+}
+#endif
 
-	return FALSE;
+static void
+launcher_watch_free(Launcher *launcher)
+{
+	if (launcher->refresh_id)
+		g_source_remove(launcher->refresh_id);
+	if (launcher->inotify_id)
+		g_source_remove(launcher->inotify_id);
+	if (launcher->inotify_fd >= 0)
+		close(launcher->inotify_fd);
+	launcher->refresh_id = launcher->inotify_id = 0;
+	launcher->inotify_fd = -1;
+	if (launcher->pending) {
+		for (guint i = 0; i < launcher->pending->len; i++)
+			free(g_array_index(launcher->pending, LauncherChange, i).name);
+		g_array_free(launcher->pending, TRUE);
+		launcher->pending = NULL;
+	}
 }
 
 /* -------------------------------------------------------------------------
@@ -1027,10 +1700,8 @@ on_key_press(GtkWidget *widget, GdkEventKey *event, gpointer user_data)
 Launcher *
 launcher_create(int ui_fd, const char *term)
 {
-	Launcher *launcher;
-	char     *home;
-	char      path[512];
-	int       i;
+	Launcher      *launcher;
+	LauncherIndex *idx;
 
 	launcher           = ecalloc(1, sizeof(Launcher));
 	launcher->ui_fd    = ui_fd;
@@ -1040,35 +1711,37 @@ launcher_create(int ui_fd, const char *term)
 	launcher_history_path(
 	    launcher->history_path, sizeof(launcher->history_path));
 
-	/* Scan desktop files */
-	home = getenv("HOME");
-	if (!home)
-		home = "/root";
-
-	for (i = 0; i < (int) (sizeof(desktop_paths) / sizeof(desktop_paths[0]));
-	     i++) {
-		if (desktop_paths[i] == NULL) {
-			if (i == 2)
-				snprintf(
-				    path, sizeof(path), "%s/.local/share/applications", home);
-			else if (i == 3)
-				snprintf(path, sizeof(path),
-				    "%s/.local/share/flatpak/exports/share/applications",
-				    home);
-			else
-				continue;
-		} else {
-			snprintf(path, sizeof(path), "%s", desktop_paths[i]);
-		}
-
-		LauncherItem *items = launcher_load_desktop_files(path);
-		launcher_append_items(launcher, items);
+	/* Items: from the index when every source directory is unchanged since
+	 * it was written, otherwise from a full scan (which rewrites it). */
+	launcher_index_path(launcher->index_path, sizeof(launcher->index_path));
+	launcher_sources_init(launcher);
+	launcher_sources_stat(launcher);
+	idx = launcher_index_open(
+	    launcher->index_path, launcher->srcs, launcher->nsrc);
+	if (idx) {
+		launcher_load_index(launcher, idx);
+		launcher_index_close(idx);
+	} else {
+		launcher_scan_all(launcher);
+		launcher_index_save(launcher);
 	}
+	awm_debug("launcher: %d items (%s)", launcher->item_count,
+	    idx ? "index" : "scan");
 
-	LauncherItem *path_items = launcher_scan_path(launcher->items);
-	launcher_append_items(launcher, path_items);
+	launcher->pending    = g_array_new(FALSE, FALSE, sizeof(LauncherChange));
+	launcher->inotify_fd = -1;
+	launcher->wd         = ecalloc((size_t) launcher->nsrc + 1, sizeof(int));
+	for (int j = 0; j < launcher->nsrc; j++)
+		launcher->wd[j] = -1;
+	launcher_watch_init(launcher);
 
 	launcher_history_load(launcher);
+	startup_stats_path(launcher->stats_path, sizeof(launcher->stats_path));
+	launcher_stats_load(launcher);
+
+	launcher_iconcache_path(
+	    launcher->iconcache_path, sizeof(launcher->iconcache_path));
+	launcher_icons_open(launcher);
 
 	/* ----- Build GTK widget tree ----- */
 	launcher->window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
@@ -1092,23 +1765,32 @@ launcher_create(int ui_fd, const char *term)
 	gtk_box_pack_start(
 	    GTK_BOX(vbox), launcher->search, FALSE, FALSE, LAUNCHER_SCALE(4));
 
-	GtkWidget *sw = gtk_scrolled_window_new(NULL, NULL);
-	gtk_scrolled_window_set_policy(
-	    GTK_SCROLLED_WINDOW(sw), GTK_POLICY_NEVER, GTK_POLICY_AUTOMATIC);
-	gtk_widget_set_size_request(sw, -1, LAUNCHER_SCALE(360));
-	gtk_box_pack_start(GTK_BOX(vbox), sw, TRUE, TRUE, 0);
+	/* The scrolled window only clips the row pool; scrolling is done by
+	 * rebinding rows, driven by vadj and the scrollbar next to it. */
+	GtkWidget *hbox = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 0);
+	gtk_box_pack_start(GTK_BOX(vbox), hbox, TRUE, TRUE, 0);
+
+	launcher->scroller = gtk_scrolled_window_new(NULL, NULL);
+	gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(launcher->scroller),
+	    GTK_POLICY_NEVER, GTK_POLICY_EXTERNAL);
+	gtk_widget_set_size_request(launcher->scroller, -1, LAUNCHER_SCALE(360));
+	gtk_box_pack_start(GTK_BOX(hbox), launcher->scroller, TRUE, TRUE, 0);
+
+	launcher->vadj = gtk_adjustment_new(0, 0, 0, 1, 1, 1);
+	gtk_box_pack_start(GTK_BOX(hbox),
+	    gtk_scrollbar_new(GTK_ORIENTATION_VERTICAL, launcher->vadj), FALSE,
+	    FALSE, 0);
 
 	launcher->listbox = gtk_list_box_new();
 	gtk_list_box_set_selection_mode(
 	    GTK_LIST_BOX(launcher->listbox), GTK_SELECTION_SINGLE);
-	gtk_list_box_set_filter_func(
-	    GTK_LIST_BOX(launcher->listbox), launcher_filter_func, launcher, NULL);
-	gtk_list_box_set_sort_func(
-	    GTK_LIST_BOX(launcher->listbox), launcher_sort_func, NULL, NULL);
-	gtk_container_add(GTK_CONTAINER(sw), launcher->listbox);
+	gtk_container_add(GTK_CONTAINER(launcher->scroller), launcher->listbox);
+	gtk_widget_add_events(
+	    launcher->listbox, GDK_SCROLL_MASK | GDK_SMOOTH_SCROLL_MASK);
 
-	/* Populate rows once at startup */
-	launcher_populate_listbox(launcher);
+	launcher->page = LAUNCHER_ROWS;
+	launcher_rows_init(launcher);
+	launcher_list_reload(launcher);
 
 	/* Signals */
 	g_signal_connect(launcher->search, "search-changed",
@@ -1119,6 +1801,14 @@ launcher_create(int ui_fd, const char *term)
 	    G_CALLBACK(on_search_key_press), launcher);
 	g_signal_connect(launcher->listbox, "row-activated",
 	    G_CALLBACK(on_row_activated), launcher);
+	g_signal_connect(launcher->listbox, "row-selected",
+	    G_CALLBACK(on_row_selected), launcher);
+	g_signal_connect(launcher->listbox, "scroll-event",
+	    G_CALLBACK(on_list_scroll), launcher);
+	g_signal_connect(launcher->scroller, "size-allocate",
+	    G_CALLBACK(on_list_size_allocate), launcher);
+	g_signal_connect(launcher->vadj, "value-changed",
+	    G_CALLBACK(on_vadj_value_changed), launcher);
 	g_signal_connect(
 	    launcher->window, "realize", G_CALLBACK(on_window_realize), launcher);
 	g_signal_connect(launcher->window, "key-press-event",
@@ -1143,30 +1833,32 @@ launcher_create(int ui_fd, const char *term)
 void
 launcher_free(Launcher *launcher)
 {
-	LauncherItem *item, *next;
-
 	if (!launcher)
 		return;
 
 	if (launcher->visible)
 		launcher_hide(launcher);
 
+	if (launcher->bind_id)
+		g_source_remove(launcher->bind_id);
 	if (launcher->window) {
 		gtk_widget_destroy(launcher->window);
-		launcher->window  = NULL;
-		launcher->search  = NULL;
-		launcher->listbox = NULL;
+		launcher->window   = NULL;
+		launcher->search   = NULL;
+		launcher->scroller = NULL;
+		launcher->listbox  = NULL;
 	}
 
-	for (item = launcher->items; item; item = next) {
-		next = item->next;
-		free(item->name);
-		free(item->exec);
-		free(item->icon_name);
-		if (item->icon)
-			cairo_surface_destroy(item->icon);
-		free(item);
-	}
+	launcher_watch_free(launcher);
+	launcher_icons_close(launcher);
+	launcher_items_free(launcher);
+	launcher_search_free(launcher->matcher);
+	free(launcher->results);
+	free(launcher->byidx);
+	for (int i = 0; i < launcher->nsrc; i++)
+		free((char *) launcher->srcs[i].path);
+	free(launcher->srcs);
+	free(launcher->wd);
 
 	free(launcher);
 	icon_alias_free();
@@ -1175,6 +1867,8 @@ launcher_free(Launcher *launcher)
 void
 launcher_show(Launcher *launcher, int wx, int wy, int ww, int wh)
 {
+	struct stat sb;
+
 	(void) wx;
 	(void) wy;
 	(void) ww;
@@ -1183,18 +1877,15 @@ launcher_show(Launcher *launcher, int wx, int wy, int ww, int wh)
 	if (!launcher)
 		return;
 
-	/* Clear search text — triggers on_search_changed which re-filters */
+	/* Clear the search text and show the empty-query results from the top.
+	 * set_text does not emit search-changed if the entry was already empty,
+	 * so refilter explicitly.  awm rewrites its launch statistics as
+	 * launches complete; pick up any change first. */
 	gtk_entry_set_text(GTK_ENTRY(launcher->search), "");
-
-	/* Select first visible row */
-	GtkListBoxRow *first =
-	    gtk_list_box_get_row_at_index(GTK_LIST_BOX(launcher->listbox), 0);
-	int fi = 0;
-	while (first && !gtk_widget_get_visible(GTK_WIDGET(first)))
-		first = gtk_list_box_get_row_at_index(
-		    GTK_LIST_BOX(launcher->listbox), ++fi);
-	if (first)
-		gtk_list_box_select_row(GTK_LIST_BOX(launcher->listbox), first);
+	if (stat(launcher->stats_path, &sb) == 0 &&
+	    sb.st_mtime != launcher->stats_mtime)
+		launcher_stats_load(launcher);
+	launcher_list_refilter(launcher);
 
 	/* Map the window.  awm has already pre-positioned launcher_xwin via
 	 * xcb_configure_window + a synchronous round-trip before sending
@@ -1210,23 +1901,12 @@ launcher_show(Launcher *launcher, int wx, int wy, int ww, int wh)
 
 	launcher->visible = 1;
 
-	/* Notify awm: window is now mapped; awm will set X input focus. */
+	/* Notify awm: window is now mapped; awm will set X input focus.
+	 * x/y are no longer used by awm (pre-positioned before map) but the
+	 * payload struct is kept for protocol compatibility. */
 	{
-		UiMsgHeader hdr;
-		hdr.type        = (uint32_t) UI_MSG_LAUNCHER_SHOWN;
-		hdr.payload_len = sizeof(UiLauncherShownPayload);
-		/* x/y fields are no longer used by awm (pre-positioned before map)
-		 * but the payload struct is kept for protocol compatibility. */
-		{
-			struct {
-				UiMsgHeader            h;
-				UiLauncherShownPayload p;
-			} msg;
-			msg.h   = hdr;
-			msg.p.x = 0;
-			msg.p.y = 0;
-			send(launcher->ui_fd, &msg, sizeof(msg), MSG_NOSIGNAL);
-		}
+		UiLauncherShownPayload p = { 0, 0 };
+		ui_msg_send_launcher_shown(launcher->ui_fd, &p);
 	}
 }
 
@@ -1241,21 +1921,13 @@ launcher_hide(Launcher *launcher)
 
 	/* Notify awm so it can clear the launcher-visible flag and resume
 	 * normal focus-follows-mouse behaviour. */
-	{
-		UiMsgHeader hdr;
-		hdr.type        = (uint32_t) UI_MSG_LAUNCHER_DISMISSED;
-		hdr.payload_len = 0;
-		send(launcher->ui_fd, &hdr, sizeof(hdr), MSG_NOSIGNAL);
-	}
+	ui_msg_send_launcher_dismissed(launcher->ui_fd);
 }
 
 void
 launcher_update_theme(Launcher *launcher, const UiThemePayload *t)
 {
-	GdkScreen    *gscreen;
-	LauncherItem *item;
-	int           icon_px;
-	GtkWidget    *sw;
+	GdkScreen *gscreen;
 
 	if (!launcher || !t)
 		return;
@@ -1264,6 +1936,10 @@ launcher_update_theme(Launcher *launcher, const UiThemePayload *t)
 		return;
 
 	launcher_dpi = t->dpi;
+	if (launcher->icon_px != LAUNCHER_SCALE(LAUNCHER_ICON_SIZE)) {
+		launcher_icons_close(launcher);
+		launcher_icons_open(launcher);
+	}
 
 	/* Tell GDK the real screen DPI so that all GTK Pango-backed widgets
 	 * (GtkLabel, GtkSearchEntry) render text at the correct physical size.
@@ -1274,46 +1950,16 @@ launcher_update_theme(Launcher *launcher, const UiThemePayload *t)
 	if (gscreen)
 		gdk_screen_set_resolution(gscreen, t->dpi);
 
-	icon_px = LAUNCHER_SCALE(LAUNCHER_ICON_SIZE);
-
 	/* Resize the window and scrolled-window to match new DPI */
 	gtk_window_resize(GTK_WINDOW(launcher->window), LAUNCHER_SCALE(420),
 	    LAUNCHER_SCALE(400));
 	gtk_window_set_default_size(GTK_WINDOW(launcher->window),
 	    LAUNCHER_SCALE(420), LAUNCHER_SCALE(400));
 
-	/* scrolled-window is vbox child 1 — walk the children list */
-	sw = NULL;
-	{
-		GList *children = gtk_container_get_children(
-		    GTK_CONTAINER(gtk_bin_get_child(GTK_BIN(launcher->window))));
-		GList *l;
-		int    idx = 0;
-		for (l = children; l; l = l->next, idx++) {
-			if (idx == 1) {
-				sw = GTK_WIDGET(l->data);
-				break;
-			}
-		}
-		g_list_free(children);
-	}
-	if (sw)
-		gtk_widget_set_size_request(sw, -1, LAUNCHER_SCALE(360));
-
-	/* Reload icons for every item at the new size */
-	for (item = launcher->items; item; item = item->next) {
-		if (item->icon) {
-			cairo_surface_destroy(item->icon);
-			item->icon = NULL;
-		}
-		if (item->icon_name && *item->icon_name)
-			item->icon = launcher_load_icon(item->icon_name, icon_px);
-	}
+	gtk_widget_set_size_request(launcher->scroller, -1, LAUNCHER_SCALE(360));
 
-	/* Rebuild listbox rows with new icon size */
-	gtk_container_foreach(GTK_CONTAINER(launcher->listbox),
-	    (GtkCallback) gtk_widget_destroy, NULL);
-	launcher_populate_listbox(launcher);
+	/* Rebind the row pool; icons load again at the new size */
+	launcher_list_reload(launcher);
 }
 
 /* end of launcher.c */
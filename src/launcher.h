@@ -2,7 +2,8 @@
  * See LICENSE file for copyright and license details.
  *
  * rofi-style launcher that reads .desktop files and falls back to PATH.
- * GTK backend: GtkWindow + GtkSearchEntry + GtkListBox.
+ * GTK backend: GtkWindow + GtkSearchEntry + a GtkListBox with a fixed pool
+ * of rows bound to the visible slice of the ranked results.
  *
  * In the IPC architecture this module runs inside awm-ui.  It sends the
  * selected command back to awm via a Unix SOCK_SEQPACKET socket (ui_fd)
@@ -15,36 +16,111 @@
 #include <gtk/gtk.h>
 #include <cairo/cairo.h>
 #include <stddef.h>
+#include <time.h>
 
+#include "launcher_index.h"
+#include "launcher_search.h"
 #include "ui_proto.h"
 
 #define LAUNCHER_ICON_SIZE 20
+#define LAUNCHER_ROWS 20 /* row widgets in the pool; more than ever fit */
 
 typedef struct LauncherItem {
 	char            *name;       /* Display name */
 	char            *exec;       /* Command to execute */
 	char            *icon_name;  /* Icon name from .desktop */
-	cairo_surface_t *icon;       /* Loaded icon surface */
 	int              is_desktop; /* 1 if from .desktop file, 0 if from PATH */
 	int              terminal;   /* 1 if Terminal=true in .desktop */
+	char            *file;       /* .desktop basename; NULL for PATH items */
+	char            *generic;    /* GenericName from .desktop, or NULL */
+	char            *keywords;   /* Keywords from .desktop, or NULL */
+	int              src;        /* Index into Launcher.srcs */
+	int              idx;        /* Position in Launcher.matcher */
 	int launch_count;            /* Number of times launched (from history) */
+	double launch_ms; /* Mean launch-to-map time (awm's stats), 0 = unknown */
 	struct LauncherItem *next;
 } LauncherItem;
 
+/* Icon for one Icon= name, shared by every item that uses it */
 typedef struct {
+	char            *name;
+	cairo_surface_t *surface; /* NULL while loading or if there is none */
+	int              loading;
+	struct Launcher *launcher;
+} LauncherIcon;
+
+/* One pooled GtkListBoxRow and the item it currently shows */
+typedef struct {
+	GtkWidget    *row;
+	GtkWidget    *icon;  /* GtkImage */
+	GtkWidget    *label; /* GtkLabel */
+	LauncherItem *item;
+} LauncherRow;
+
+typedef struct Launcher {
 	int         ui_fd;    /* socket fd back to awm — used to send EXEC */
 	const char *terminal; /* Terminal emulator binary (from config) */
 
-	LauncherItem *items;      /* All available items (linked list) */
-	int           item_count; /* Total items */
+	LauncherItem   *items;      /* All available items (linked list) */
+	int             item_count; /* Total items */
+	LauncherNameMap names;      /* name -> first LauncherItem with it */
+
+	/* Search index over items, rebuilt whenever the items change.
+	 * results[] holds ->idx values, byidx maps them back to items. */
+	LauncherSearch *matcher;
+	LauncherItem  **byidx;
+	int            *results;
+	int             nresults;
+
+	/* Virtualised result list: rows[] shows results[top ..], page rows
+	 * fit in the scroller, sel is the selected result. */
+	LauncherRow    rows[LAUNCHER_ROWS];
+	GtkAdjustment *vadj;
+	int            top;
+	int            sel;
+	int            page;
+	int            binding; /* launcher_list_bind() is running */
+	guint          bind_id; /* rebind after a size change */
+
+	/* Icons by Icon= name, loaded when first shown: from the rasterised
+	 * icon cache if it has them, otherwise on a worker thread through
+	 * icon_load_threaded().  New ones are written back after a delay. */
+	LauncherNameMap    icons;
+	LauncherIconCache *iconcache;
+	char               iconcache_path[512];
+	char               icon_theme[128]; /* theme iconcache was opened for */
+	int                icon_px;         /* size icons are loaded at */
+	GCancellable      *icon_cancel;
+	cairo_surface_t   *icon_placeholder;
+	int                icons_dirty;
+	guint              icon_save_id;
 
 	int  visible;
 	char history_path[512]; /* Path to launch-history file */
+	char stats_path[512];   /* awm's launch-statistics file */
+	time_t stats_mtime;     /* its mtime when last read */
+	char index_path[512];   /* Path to the on-disk item index */
+
+	/* Source directories: desktop-file dirs first, then $PATH in order.
+	 * Item ->src indexes this array. */
+	LauncherIndexSrc *srcs;
+	int               nsrc;
+	int               ndesktop_src;
+
+	/* inotify on every source dir (Linux).  Changes are queued and applied
+	 * in one batch by a short debounce timer. */
+	int    inotify_fd;
+	guint  inotify_id;
+	int   *wd; /* per-source watch descriptor, -1 if none */
+	GArray *pending;       /* LauncherChange queued since the last refresh */
+	int     pending_rescan; /* event queue overflowed: rescan everything */
+	guint   refresh_id;
 
 	/* GTK widgets */
 	GtkWidget *window;  /* GtkWindow (POPUP_MENU hint, undecorated) */
-	GtkWidget *search;  /* GtkSearchEntry */
-	GtkWidget *listbox; /* GtkListBox */
+	GtkWidget *search;   /* GtkSearchEntry */
+	GtkWidget *scroller; /* GtkScrolledWindow clipping the row pool */
+	GtkWidget *listbox;  /* GtkListBox holding rows[] */
 } Launcher;
 
 /* ui_fd  — socket fd to awm (for UI_MSG_LAUNCHER_EXEC replies)
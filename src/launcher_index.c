@@ -0,0 +1,821 @@
+/* AndrathWM - launcher item index
+ * See LICENSE file for copyright and license details. */
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "launcher_index.h"
+
+/* -------------------------------------------------------------------------
+ * File format
+ *
+ *   IdxHeader
+ *   IdxSrc[nsrc]
+ *   IdxEnt[nent]
+ *   char strtab[strsz]      NUL-terminated strings, referenced by offset
+ *
+ * Host byte order; the file is a per-user cache, never shared between
+ * machines.  Bump IDX_VERSION on any layout change.
+ * ---------------------------------------------------------------------- */
+
+#define IDX_MAGIC "AWMLIDX"
+#define IDX_VERSION 2
+#define IDX_NONE UINT32_MAX
+
+#define IDX_F_DESKTOP 0x01
+#define IDX_F_TERMINAL 0x02
+
+typedef struct {
+	char     magic[8];
+	uint32_t version;
+	uint32_t nsrc;
+	uint32_t nent;
+	uint32_t strsz;
+} IdxHeader;
+
+typedef struct {
+	int64_t  mtime_ns;
+	uint32_t path;
+	uint32_t pad;
+} IdxSrc;
+
+typedef struct {
+	uint32_t name, exec, icon, file, generic, keywords;
+	uint16_t src;
+	uint8_t  flags;
+	uint8_t  pad;
+} IdxEnt;
+
+struct LauncherIndex {
+	void          *map;
+	size_t         size;
+	const IdxEnt  *ents;
+	uint32_t       nent;
+	const char    *strtab;
+};
+
+/* -------------------------------------------------------------------------
+ * Paths
+ * ---------------------------------------------------------------------- */
+
+/* $XDG_CACHE_HOME/awm/<name>, falling back to ~/.cache and /tmp */
+static void
+cache_file(char *out, size_t sz, const char *name)
+{
+	const char *cache = getenv("XDG_CACHE_HOME");
+	const char *home  = getenv("HOME");
+
+	if (cache && *cache)
+		snprintf(out, sz, "%s/awm/%s", cache, name);
+	else if (home && *home)
+		snprintf(out, sz, "%s/.cache/awm/%s", home, name);
+	else
+		snprintf(out, sz, "/tmp/awm_%s", name);
+}
+
+void
+launcher_index_path(char *out, size_t sz)
+{
+	cache_file(out, sz, "launcher.idx");
+}
+
+int64_t
+launcher_index_dir_mtime(const char *dir)
+{
+	struct stat st;
+
+	if (stat(dir, &st) < 0)
+		return -1;
+	return (int64_t) st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+}
+
+/* mkdir -p of the directory part of path */
+static void
+mkparents(const char *path)
+{
+	char   tmp[1024];
+	size_t i, n;
+
+	n = strlen(path);
+	if (n >= sizeof(tmp))
+		return;
+	memcpy(tmp, path, n + 1);
+	for (i = 1; i < n; i++) {
+		if (tmp[i] != '/')
+			continue;
+		tmp[i] = '\0';
+		mkdir(tmp, 0700);
+		tmp[i] = '/';
+	}
+}
+
+/* -------------------------------------------------------------------------
+ * Reading
+ * ---------------------------------------------------------------------- */
+
+static const char *
+idx_str(const LauncherIndex *idx, uint32_t off)
+{
+	return off == IDX_NONE ? NULL : idx->strtab + off;
+}
+
+LauncherIndex *
+launcher_index_open(const char *path, const LauncherIndexSrc *srcs, int nsrc)
+{
+	LauncherIndex   *idx;
+	const IdxHeader *h;
+	const IdxSrc    *s;
+	const IdxEnt    *e;
+	const char      *strtab;
+	struct stat      st;
+	void            *map;
+	size_t           need;
+	uint32_t         i;
+	int              fd;
+
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return NULL;
+	if (fstat(fd, &st) < 0 || (size_t) st.st_size < sizeof(IdxHeader)) {
+		close(fd);
+		return NULL;
+	}
+	map = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		return NULL;
+
+	h = map;
+	if (memcmp(h->magic, IDX_MAGIC, sizeof(IDX_MAGIC)) != 0 ||
+	    h->version != IDX_VERSION || h->nsrc != (uint32_t) nsrc ||
+	    h->strsz == 0)
+		goto bad;
+	need = sizeof(*h) + (size_t) h->nsrc * sizeof(IdxSrc) +
+	    (size_t) h->nent * sizeof(IdxEnt) + h->strsz;
+	if (need != (size_t) st.st_size)
+		goto bad;
+
+	s      = (const IdxSrc *) (h + 1);
+	e      = (const IdxEnt *) (s + h->nsrc);
+	strtab = (const char *) (e + h->nent);
+	if (strtab[h->strsz - 1] != '\0')
+		goto bad;
+
+	/* Stale if any source directory moved or changed since the write */
+	for (i = 0; i < h->nsrc; i++) {
+		if (s[i].path >= h->strsz ||
+		    strcmp(strtab + s[i].path, srcs[i].path) != 0 ||
+		    s[i].mtime_ns != srcs[i].mtime_ns)
+			goto bad;
+	}
+	for (i = 0; i < h->nent; i++) {
+		if (e[i].name >= h->strsz || e[i].exec >= h->strsz ||
+		    (e[i].icon != IDX_NONE && e[i].icon >= h->strsz) ||
+		    (e[i].file != IDX_NONE && e[i].file >= h->strsz) ||
+		    (e[i].generic != IDX_NONE && e[i].generic >= h->strsz) ||
+		    (e[i].keywords != IDX_NONE && e[i].keywords >= h->strsz) ||
+		    e[i].src >= h->nsrc)
+			goto bad;
+	}
+
+	idx = calloc(1, sizeof(*idx));
+	if (!idx)
+		goto bad;
+	idx->map    = map;
+	idx->size   = (size_t) st.st_size;
+	idx->ents   = e;
+	idx->nent   = h->nent;
+	idx->strtab = strtab;
+	return idx;
+
+bad:
+	munmap(map, (size_t) st.st_size);
+	return NULL;
+}
+
+int
+launcher_index_count(const LauncherIndex *idx)
+{
+	return idx ? (int) idx->nent : 0;
+}
+
+void
+launcher_index_get(const LauncherIndex *idx, int i, LauncherIndexEnt *out)
+{
+	const IdxEnt *e = &idx->ents[i];
+
+	out->name       = idx_str(idx, e->name);
+	out->exec       = idx_str(idx, e->exec);
+	out->icon_name  = idx_str(idx, e->icon);
+	out->file       = idx_str(idx, e->file);
+	out->generic    = idx_str(idx, e->generic);
+	out->keywords   = idx_str(idx, e->keywords);
+	out->src        = e->src;
+	out->is_desktop = !!(e->flags & IDX_F_DESKTOP);
+	out->terminal   = !!(e->flags & IDX_F_TERMINAL);
+}
+
+void
+launcher_index_close(LauncherIndex *idx)
+{
+	if (!idx)
+		return;
+	munmap(idx->map, idx->size);
+	free(idx);
+}
+
+/* -------------------------------------------------------------------------
+ * Writing
+ * ---------------------------------------------------------------------- */
+
+typedef struct {
+	char  *buf;
+	size_t len, cap;
+	int    oom;
+} StrTab;
+
+static uint32_t
+strtab_add(StrTab *t, const char *s)
+{
+	size_t n;
+	char  *nb;
+
+	if (!s)
+		return IDX_NONE;
+	n = strlen(s) + 1;
+	if (t->len + n > t->cap) {
+		size_t cap = t->cap ? t->cap * 2 : 4096;
+		while (cap < t->len + n)
+			cap *= 2;
+		if (!(nb = realloc(t->buf, cap))) {
+			t->oom = 1;
+			return 0;
+		}
+		t->buf = nb;
+		t->cap = cap;
+	}
+	memcpy(t->buf + t->len, s, n);
+	t->len += n;
+	return (uint32_t) (t->len - n);
+}
+
+static int
+write_all(int fd, const void *p, size_t n)
+{
+	const char *c = p;
+	ssize_t     w;
+
+	while (n > 0) {
+		w = write(fd, c, n);
+		if (w < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		c += w;
+		n -= (size_t) w;
+	}
+	return 0;
+}
+
+/* Write the n buffers to a temporary file and rename it over path,
+ * creating parent directories as needed.  The temporary name is made
+ * unique by mkstemp(): with the /tmp fallback a predictable name would
+ * let another user plant a symlink there. */
+static int
+replace_file(const char *path, const void *const *bufs, const size_t *lens,
+    int n)
+{
+	char tmp[1024];
+	int  fd, i;
+
+	if (snprintf(tmp, sizeof(tmp), "%s.XXXXXX", path) >= (int) sizeof(tmp))
+		return -1;
+	mkparents(path);
+	fd = mkstemp(tmp); /* O_EXCL, mode 0600 */
+	if (fd < 0)
+		return -1;
+	fcntl(fd, F_SETFD, FD_CLOEXEC);
+	for (i = 0; i < n; i++) {
+		if (write_all(fd, bufs[i], lens[i]) < 0) {
+			close(fd);
+			unlink(tmp);
+			return -1;
+		}
+	}
+	close(fd);
+	if (rename(tmp, path) < 0) {
+		unlink(tmp);
+		return -1;
+	}
+	return 0;
+}
+
+int
+launcher_index_write(const char *path, const LauncherIndexSrc *srcs,
+    int nsrc, const LauncherIndexEnt *ents, int nent)
+{
+	IdxHeader h;
+	IdxSrc   *s = NULL;
+	IdxEnt   *e = NULL;
+	StrTab    t = { 0 };
+	int       i, ret = -1;
+
+	if (nsrc > UINT16_MAX)
+		return -1;
+
+	s = calloc((size_t) nsrc + 1, sizeof(*s));
+	e = calloc((size_t) nent + 1, sizeof(*e));
+	if (!s || !e)
+		goto out;
+	for (i = 0; i < nsrc; i++) {
+		s[i].mtime_ns = srcs[i].mtime_ns;
+		s[i].path     = strtab_add(&t, srcs[i].path);
+	}
+	for (i = 0; i < nent; i++) {
+		e[i].name     = strtab_add(&t, ents[i].name);
+		e[i].exec     = strtab_add(&t, ents[i].exec);
+		e[i].icon     = strtab_add(&t, ents[i].icon_name);
+		e[i].file     = strtab_add(&t, ents[i].file);
+		e[i].generic  = strtab_add(&t, ents[i].generic);
+		e[i].keywords = strtab_add(&t, ents[i].keywords);
+		e[i].src      = (uint16_t) ents[i].src;
+		e[i].flags    = (uint8_t) ((ents[i].is_desktop ? IDX_F_DESKTOP : 0) |
+		    (ents[i].terminal ? IDX_F_TERMINAL : 0));
+	}
+	if (t.len == 0)
+		strtab_add(&t, "");
+	if (t.oom)
+		goto out;
+
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, IDX_MAGIC, sizeof(IDX_MAGIC));
+	h.version = IDX_VERSION;
+	h.nsrc    = (uint32_t) nsrc;
+	h.nent    = (uint32_t) nent;
+	h.strsz   = (uint32_t) t.len;
+
+	{
+		const void *bufs[] = { &h, s, e, t.buf };
+		size_t      lens[] = { sizeof(h), (size_t) nsrc * sizeof(*s),
+		         (size_t) nent * sizeof(*e), t.len };
+
+		ret = replace_file(path, bufs, lens, 4);
+	}
+
+out:
+	free(s);
+	free(e);
+	free(t.buf);
+	return ret;
+}
+
+/* -------------------------------------------------------------------------
+ * Rasterised icon cache
+ *
+ *   IcoHeader
+ *   IcoEnt[nent]            sorted by name (strcmp) for bsearch
+ *   char strtab[strsz]      theme name and icon names; padded to 4 bytes
+ *   uint32_t pix[nent][size * size]   in IcoEnt order
+ * ---------------------------------------------------------------------- */
+
+#define ICO_MAGIC "AWMLICO"
+#define ICO_VERSION 1
+#define ICO_MAX_SIZE 512
+
+typedef struct {
+	char     magic[8];
+	uint32_t version;
+	uint32_t size;
+	uint32_t nent;
+	uint32_t strsz;
+	uint32_t theme;
+} IcoHeader;
+
+typedef struct {
+	uint32_t name;
+} IcoEnt;
+
+struct LauncherIconCache {
+	void           *map;
+	size_t          size;
+	const IcoEnt   *ents;
+	uint32_t        nent;
+	const char     *strtab;
+	const uint32_t *pix;
+	uint32_t        px; /* icon edge in pixels */
+};
+
+void
+launcher_iconcache_path(char *out, size_t sz)
+{
+	cache_file(out, sz, "launcher-icons.bin");
+}
+
+LauncherIconCache *
+launcher_iconcache_open(const char *path, const char *theme, int size)
+{
+	LauncherIconCache *c;
+	const IcoHeader   *h;
+	const IcoEnt      *e;
+	const char        *strtab;
+	struct stat        st;
+	void              *map;
+	size_t             need;
+	uint32_t           i;
+	int                fd;
+
+	if (size <= 0 || size > ICO_MAX_SIZE)
+		return NULL;
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return NULL;
+	if (fstat(fd, &st) < 0 || (size_t) st.st_size < sizeof(IcoHeader)) {
+		close(fd);
+		return NULL;
+	}
+	map = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		return NULL;
+
+	h = map;
+	if (memcmp(h->magic, ICO_MAGIC, sizeof(ICO_MAGIC)) != 0 ||
+	    h->version != ICO_VERSION || h->size != (uint32_t) size ||
+	    h->strsz == 0 || h->strsz % 4 || h->theme >= h->strsz)
+		goto bad;
+	need = sizeof(*h) + (size_t) h->nent * sizeof(IcoEnt) + h->strsz +
+	    (size_t) h->nent * h->size * h->size * sizeof(uint32_t);
+	if (need != (size_t) st.st_size)
+		goto bad;
+
+	e      = (const IcoEnt *) (h + 1);
+	strtab = (const char *) (e + h->nent);
+	if (strtab[h->strsz - 1] != '\0' ||
+	    strcmp(strtab + h->theme, theme ? theme : "") != 0)
+		goto bad;
+	for (i = 0; i < h->nent; i++) {
+		if (e[i].name >= h->strsz)
+			goto bad;
+	}
+
+	c = calloc(1, sizeof(*c));
+	if (!c)
+		goto bad;
+	c->map    = map;
+	c->size   = (size_t) st.st_size;
+	c->ents   = e;
+	c->nent   = h->nent;
+	c->strtab = strtab;
+	c->pix    = (const uint32_t *) (strtab + h->strsz);
+	c->px     = h->size;
+	return c;
+
+bad:
+	munmap(map, (size_t) st.st_size);
+	return NULL;
+}
+
+const uint32_t *
+launcher_iconcache_get(const LauncherIconCache *c, const char *name)
+{
+	uint32_t lo = 0, hi, mid;
+	int      r;
+
+	if (!c || !name)
+		return NULL;
+	hi = c->nent;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		r   = strcmp(name, c->strtab + c->ents[mid].name);
+		if (r == 0)
+			return c->pix + (size_t) mid * c->px * c->px;
+		if (r < 0)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+	return NULL;
+}
+
+void
+launcher_iconcache_close(LauncherIconCache *c)
+{
+	if (!c)
+		return;
+	munmap(c->map, c->size);
+	free(c);
+}
+
+static int
+icon_ent_cmp(const void *a, const void *b)
+{
+	return strcmp(((const LauncherIconEnt *) a)->name,
+	    ((const LauncherIconEnt *) b)->name);
+}
+
+int
+launcher_iconcache_write(const char *path, const char *theme, int size,
+    const LauncherIconEnt *ents, int nent)
+{
+	static const char zero[4];
+	LauncherIconEnt  *sorted = NULL;
+	IcoHeader         h;
+	IcoEnt           *e   = NULL;
+	uint32_t         *pix = NULL;
+	StrTab            t   = { 0 };
+	size_t            edge, pad;
+	int               i, ret = -1;
+
+	if (size <= 0 || size > ICO_MAX_SIZE)
+		return -1;
+	edge   = (size_t) size * (size_t) size;
+	sorted = calloc((size_t) nent + 1, sizeof(*sorted));
+	e      = calloc((size_t) nent + 1, sizeof(*e));
+	pix    = calloc((size_t) nent * edge + 1, sizeof(*pix));
+	if (!sorted || !e || !pix)
+		goto out;
+	memcpy(sorted, ents, (size_t) nent * sizeof(*ents));
+	qsort(sorted, (size_t) nent, sizeof(*sorted), icon_ent_cmp);
+
+	h.theme = strtab_add(&t, theme ? theme : "");
+	for (i = 0; i < nent; i++) {
+		e[i].name = strtab_add(&t, sorted[i].name);
+		memcpy(pix + (size_t) i * edge, sorted[i].pixels, edge * sizeof(*pix));
+	}
+	if (t.oom)
+		goto out;
+	pad = (4 - t.len % 4) % 4;
+
+	memcpy(h.magic, ICO_MAGIC, sizeof(ICO_MAGIC));
+	h.version = ICO_VERSION;
+	h.size    = (uint32_t) size;
+	h.nent    = (uint32_t) nent;
+	h.strsz   = (uint32_t) (t.len + pad);
+	{
+		const void *bufs[] = { &h, e, t.buf, zero, pix };
+		size_t      lens[] = { sizeof(h), (size_t) nent * sizeof(*e), t.len,
+		         pad, (size_t) nent * edge * sizeof(*pix) };
+
+		ret = replace_file(path, bufs, lens, 5);
+	}
+
+out:
+	free(sorted);
+	free(e);
+	free(pix);
+	free(t.buf);
+	return ret;
+}
+
+/* -------------------------------------------------------------------------
+ * Name map
+ * ---------------------------------------------------------------------- */
+
+static uint32_t
+name_hash(const char *s)
+{
+	uint32_t h = 2166136261u; /* FNV-1a */
+
+	while (*s)
+		h = (h ^ (unsigned char) *s++) * 16777619u;
+	return h;
+}
+
+/* Slot holding key, or the empty slot where it would go */
+static uint32_t
+namemap_find(const LauncherNameMap *m, const char *key, uint32_t h)
+{
+	uint32_t mask = m->cap - 1, i = h & mask;
+
+	while (m->slots[i].key &&
+	    (m->slots[i].hash != h || strcmp(m->slots[i].key, key) != 0))
+		i = (i + 1) & mask;
+	return i;
+}
+
+static int
+namemap_grow(LauncherNameMap *m)
+{
+	LauncherNameMap nm;
+	uint32_t        i;
+
+	nm.cap   = m->cap ? m->cap * 2 : 256;
+	nm.n     = m->n;
+	nm.slots = calloc(nm.cap, sizeof(*nm.slots));
+	if (!nm.slots)
+		return -1;
+	for (i = 0; i < m->cap; i++)
+		if (m->slots[i].key)
+			nm.slots[namemap_find(&nm, m->slots[i].key, m->slots[i].hash)] =
+			    m->slots[i];
+	free(m->slots);
+	*m = nm;
+	return 0;
+}
+
+void *
+launcher_namemap_get(const LauncherNameMap *m, const char *key)
+{
+	if (!m->n)
+		return NULL;
+	return m->slots[namemap_find(m, key, name_hash(key))].val;
+}
+
+int
+launcher_namemap_add(LauncherNameMap *m, const char *key, void *val)
+{
+	uint32_t h = name_hash(key), i;
+
+	/* keep the load factor at or below 1/2 */
+	if ((m->n + 1) * 2 > m->cap && namemap_grow(m) < 0)
+		return -1;
+	i = namemap_find(m, key, h);
+	if (m->slots[i].key)
+		return 1;
+	m->slots[i].key  = key;
+	m->slots[i].val  = val;
+	m->slots[i].hash = h;
+	m->n++;
+	return 0;
+}
+
+/* Backward-shift deletion: no tombstones, so lookups stay short after many
+ * add/remove cycles from inotify updates. */
+void
+launcher_namemap_del(LauncherNameMap *m, const char *key)
+{
+	uint32_t mask, i, j, k;
+
+	if (!m->n)
+		return;
+	mask = m->cap - 1;
+	i    = namemap_find(m, key, name_hash(key));
+	if (!m->slots[i].key)
+		return;
+	for (j = i;;) {
+		j = (j + 1) & mask;
+		if (!m->slots[j].key)
+			break;
+		k = m->slots[j].hash & mask;
+		/* move j back into the hole at i unless its home lies in (i, j] */
+		if (i <= j ? (k <= i || k > j) : (k <= i && k > j)) {
+			m->slots[i] = m->slots[j];
+			i           = j;
+		}
+	}
+	m->slots[i].key = NULL;
+	m->slots[i].val = NULL;
+	m->n--;
+}
+
+void
+launcher_namemap_clear(LauncherNameMap *m)
+{
+	free(m->slots);
+	m->slots = NULL;
+	m->cap = m->n = 0;
+}
+
+/* -------------------------------------------------------------------------
+ * $PATH scan
+ * ---------------------------------------------------------------------- */
+
+#define SCAN_MAX_THREADS 8
+
+typedef struct {
+	const char *const *dirs;
+	LauncherDirScan   *out;
+	int                ndirs;
+	atomic_int         next; /* next directory to claim */
+	atomic_int         oom;
+} ScanJob;
+
+static int
+dirscan_push(LauncherDirScan *s, const char *name)
+{
+	char **nn;
+
+	if (s->n == s->cap) {
+		int cap = s->cap ? s->cap * 2 : 256;
+		if (!(nn = realloc(s->names, (size_t) cap * sizeof(*nn))))
+			return -1;
+		s->names = nn;
+		s->cap   = cap;
+	}
+	if (!(s->names[s->n] = strdup(name)))
+		return -1;
+	s->n++;
+	return 0;
+}
+
+static void
+scan_one(const char *dir, LauncherDirScan *out, atomic_int *oom)
+{
+	DIR           *d;
+	struct dirent *e;
+	struct stat    st;
+	int            dfd;
+
+	dfd = open(dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (dfd < 0)
+		return;
+	if (!(d = fdopendir(dfd))) {
+		close(dfd);
+		return;
+	}
+	while ((e = readdir(d))) {
+		if (e->d_name[0] == '.')
+			continue;
+#ifdef DT_DIR
+		/* Directories, devices, sockets: no stat needed.  DT_REG still
+		 * needs the mode bits; DT_LNK and DT_UNKNOWN need the target. */
+		if (e->d_type != DT_REG && e->d_type != DT_LNK &&
+		    e->d_type != DT_UNKNOWN)
+			continue;
+#endif
+		/* the mode bits rule most files out without a second call */
+		if (fstatat(dfd, e->d_name, &st, 0) < 0 || !S_ISREG(st.st_mode) ||
+		    !(st.st_mode & 0111) || faccessat(dfd, e->d_name, X_OK, 0) < 0)
+			continue;
+		if (dirscan_push(out, e->d_name) < 0) {
+			atomic_store(oom, 1);
+			break;
+		}
+	}
+	closedir(d);
+}
+
+static void *
+scan_worker(void *arg)
+{
+	ScanJob *job = arg;
+	int      i;
+
+	while ((i = atomic_fetch_add(&job->next, 1)) < job->ndirs &&
+	    !atomic_load(&job->oom))
+		scan_one(job->dirs[i], &job->out[i], &job->oom);
+	return NULL;
+}
+
+int
+launcher_scan_dirs(const char *const *dirs, int ndirs, int nthreads,
+    LauncherDirScan *out)
+{
+	pthread_t tid[SCAN_MAX_THREADS];
+	ScanJob   job;
+	int       i, started = 0;
+
+	memset(out, 0, (size_t) ndirs * sizeof(*out));
+	if (ndirs <= 0)
+		return 0;
+	if (nthreads <= 0) {
+		long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+		nthreads  = ncpu > 0 ? (int) ncpu : 1;
+	}
+	if (nthreads > SCAN_MAX_THREADS)
+		nthreads = SCAN_MAX_THREADS;
+	if (nthreads > ndirs)
+		nthreads = ndirs;
+
+	job.dirs  = dirs;
+	job.out   = out;
+	job.ndirs = ndirs;
+	atomic_init(&job.next, 0);
+	atomic_init(&job.oom, 0);
+
+	/* The calling thread is worker 0; if a thread cannot be created the
+	 * remaining directories are simply picked up by those that were. */
+	for (i = 1; i < nthreads; i++)
+		if (pthread_create(&tid[started], NULL, scan_worker, &job) == 0)
+			started++;
+	scan_worker(&job);
+	for (i = 0; i < started; i++)
+		pthread_join(tid[i], NULL);
+
+	if (atomic_load(&job.oom)) {
+		launcher_dirscan_free(out, ndirs);
+		return -1;
+	}
+	return 0;
+}
+
+void
+launcher_dirscan_free(LauncherDirScan *scans, int n)
+{
+	for (int i = 0; i < n; i++) {
+		for (int j = 0; j < scans[i].n; j++)
+			free(scans[i].names[j]);
+		free(scans[i].names);
+		memset(&scans[i], 0, sizeof(scans[i]));
+	}
+}
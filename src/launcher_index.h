@@ -0,0 +1,145 @@
+/* AndrathWM - launcher item index
+ * See LICENSE file for copyright and license details.
+ *
+ * Pure-C half of the launcher: the persistent on-disk item index, the
+ * name map used for de-duplication, and the parallel $PATH scanner.  No
+ * GTK or cairo here, so it is linked into the unit tests as-is.
+ *
+ * The index is a single file under $XDG_CACHE_HOME/awm/ holding every
+ * launcher entry (name, exec, icon, search fields, source) plus the list of source
+ * directories and their mtimes at the time it was written.  awm-ui mmaps
+ * it at startup; if every source directory still has the recorded mtime
+ * the entries are used as-is and no .desktop file is opened and no PATH
+ * directory is read.
+ */
+
+#ifndef LAUNCHER_INDEX_H
+#define LAUNCHER_INDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* A directory the index was built from (desktop-file dir or PATH entry). */
+typedef struct {
+	const char *path;
+	int64_t     mtime_ns; /* st_mtim of the directory, -1 if missing */
+} LauncherIndexSrc;
+
+/* One launcher entry.  When returned by launcher_index_get() the strings
+ * point into the mapping and stay valid until launcher_index_close(). */
+typedef struct {
+	const char *name;      /* display name */
+	const char *exec;      /* command line */
+	const char *icon_name; /* may be NULL */
+	const char *file;      /* .desktop basename, NULL for PATH entries */
+	int         src;       /* index into the LauncherIndexSrc array */
+	int         is_desktop;
+	int         terminal;
+	const char *generic;  /* GenericName, may be NULL */
+	const char *keywords; /* Keywords, may be NULL */
+} LauncherIndexEnt;
+
+typedef struct LauncherIndex LauncherIndex;
+
+/* Fill *out with the index location ($XDG_CACHE_HOME/awm/launcher.idx,
+ * falling back to ~/.cache). */
+void launcher_index_path(char *out, size_t sz);
+
+/* Current mtime of dir in nanoseconds, or -1 if it cannot be stat'ed. */
+int64_t launcher_index_dir_mtime(const char *dir);
+
+/* Map the index at path.  Returns NULL if it is missing, malformed, or was
+ * built from a different source list or an older state of any source
+ * directory (path or mtime mismatch against srcs). */
+LauncherIndex *launcher_index_open(
+    const char *path, const LauncherIndexSrc *srcs, int nsrc);
+int  launcher_index_count(const LauncherIndex *idx);
+void launcher_index_get(const LauncherIndex *idx, int i, LauncherIndexEnt *out);
+void launcher_index_close(LauncherIndex *idx);
+
+/* Atomically (write + rename) replace the index at path, creating parent
+ * directories as needed.  Returns 0 on success, -1 on error. */
+int launcher_index_write(const char *path, const LauncherIndexSrc *srcs,
+    int nsrc, const LauncherIndexEnt *ents, int nent);
+
+/* -------------------------------------------------------------------------
+ * Rasterised icon cache: a second file next to the index holding every
+ * launcher icon already rendered at one size for one icon theme, so icons
+ * of rows shown in a previous session appear without touching the theme.
+ * Pixels are premultiplied ARGB32 (cairo's format), size * size per icon,
+ * rows packed.
+ * ---------------------------------------------------------------------- */
+
+typedef struct {
+	const char     *name;   /* Icon= value as written in the .desktop file */
+	const uint32_t *pixels; /* size * size pixels */
+} LauncherIconEnt;
+
+typedef struct LauncherIconCache LauncherIconCache;
+
+/* $XDG_CACHE_HOME/awm/launcher-icons.bin (or ~/.cache, like the index) */
+void launcher_iconcache_path(char *out, size_t sz);
+
+/* Map the cache at path.  Returns NULL if it is missing, malformed, or
+ * was written for another icon size or theme. */
+LauncherIconCache *launcher_iconcache_open(
+    const char *path, const char *theme, int size);
+/* Pixels of name, valid until launcher_iconcache_close(), or NULL if name
+ * is not cached (c may be NULL). */
+const uint32_t *launcher_iconcache_get(
+    const LauncherIconCache *c, const char *name);
+void launcher_iconcache_close(LauncherIconCache *c);
+
+/* Atomically replace the cache at path.  Names must be unique. */
+int launcher_iconcache_write(const char *path, const char *theme, int size,
+    const LauncherIconEnt *ents, int nent);
+
+/* -------------------------------------------------------------------------
+ * Name map: string key -> pointer, open addressing with linear probing.
+ * Keys are borrowed (typically LauncherItem.name) and must outlive their
+ * entry.  Zero-initialise before first use.
+ * ---------------------------------------------------------------------- */
+
+typedef struct {
+	const char *key;
+	void       *val;
+	uint32_t    hash;
+} LauncherNameSlot;
+
+typedef struct {
+	LauncherNameSlot *slots;
+	uint32_t          cap; /* power of two, or 0 */
+	uint32_t          n;
+} LauncherNameMap;
+
+void *launcher_namemap_get(const LauncherNameMap *m, const char *key);
+/* Insert key -> val unless key is present, in which case the existing
+ * value stays.  Returns 0 if val was inserted, 1 if key was present, -1 if
+ * out of memory. */
+int  launcher_namemap_add(LauncherNameMap *m, const char *key, void *val);
+void launcher_namemap_del(LauncherNameMap *m, const char *key);
+void launcher_namemap_clear(LauncherNameMap *m);
+
+/* -------------------------------------------------------------------------
+ * $PATH scan
+ *
+ * Lists the executables (regular files we may execute, symlinks followed)
+ * in each directory.  Directories are handed out to up to nthreads worker
+ * threads; each worker reads with an open dirfd, trusts d_type to skip
+ * directories and uses fstatat() relative to the dirfd for everything
+ * else, so no path strings are built.  out[i] receives the names found in
+ * dirs[i], unsorted.
+ * ---------------------------------------------------------------------- */
+
+typedef struct {
+	char **names;
+	int    n, cap;
+} LauncherDirScan;
+
+/* nthreads <= 0 picks one per online CPU (capped at 8).  Returns 0, or -1
+ * if out of memory (out is then left empty). */
+int launcher_scan_dirs(const char *const *dirs, int ndirs, int nthreads,
+    LauncherDirScan *out);
+void launcher_dirscan_free(LauncherDirScan *scans, int n);
+
+#endif /* LAUNCHER_INDEX_H */
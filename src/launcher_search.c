@@ -0,0 +1,630 @@
+/* AndrathWM - launcher search engine
+ * See LICENSE file for copyright and license details. */
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "launcher_search.h"
+
+/* -------------------------------------------------------------------------
+ * Scoring constants (fzf v1 scheme)
+ * ---------------------------------------------------------------------- */
+
+#define SCORE_MATCH 16
+#define SCORE_GAP_START (-3)
+#define SCORE_GAP_EXT (-1)
+#define BONUS_WHITE 10    /* start of field, after space or ';' */
+#define BONUS_BOUNDARY 8  /* after / - _ . , : */
+#define BONUS_CAMEL 7     /* aB, a1 */
+#define BONUS_CONSECUTIVE 4
+#define FIRST_CHAR_MULT 2
+
+/* Launch-count bonus: FRECENCY_STEP per doubling, capped. */
+#define FRECENCY_STEP 8
+#define FRECENCY_MAX 64
+
+/* Launch-speed tie-breaker: one step per SPEED_STEP_MS of mean
+ * launch-to-map time, 255 steps down to the slowest known. */
+#define SPEED_STEP_MS 40
+
+#define MAX_TERMS 8
+
+enum { F_NAME, F_EXEC, F_GENERIC, F_KEYWORDS, F_LAST };
+
+/* Field weights in quarters: a name hit outranks the same hit elsewhere */
+static const int field_weight[F_LAST] = { 4, 3, 3, 2 };
+
+typedef struct {
+	uint64_t key; /* packed score / tie-breakers, higher is better */
+	int      idx;
+} Hit;
+
+struct LauncherSearch {
+	int       n;
+	char     *arena; /* folded text, every field NUL-terminated */
+	uint8_t  *bonus; /* boundary bonus per arena byte */
+	uint32_t *off;   /* n * F_LAST field offsets into arena */
+	uint16_t *len;   /* n * F_LAST field lengths */
+	uint64_t *mask;  /* per-item character-presence mask (all fields) */
+	uint64_t *fmask; /* n * F_LAST per-field masks */
+	int      *count; /* launch counts */
+	uint8_t  *speed; /* launch speed, higher is faster, 0 = unknown */
+	int      *order; /* empty-query order */
+	int       order_dirty;
+	Hit      *hits;  /* query scratch, n entries */
+
+	/* Every item matching the previous query.  Typing only ever extends
+	 * the query, and a longer query matches a subset, so the next query
+	 * rescores just these. */
+	int  *matched;
+	int   nmatched;
+	char  last[256]; /* previous folded query, terms NUL-separated */
+	int   last_len;  /* -1: no previous query */
+};
+
+/* -------------------------------------------------------------------------
+ * Folding and masks
+ * ---------------------------------------------------------------------- */
+
+static inline char
+fold(char c)
+{
+	return (c >= 'A' && c <= 'Z') ? (char) (c - 'A' + 'a') : c;
+}
+
+static inline uint64_t
+char_bit(unsigned char c)
+{
+	if (c >= 'a' && c <= 'z')
+		return 1ULL << (c - 'a');
+	if (c >= '0' && c <= '9')
+		return 1ULL << (26 + c - '0');
+	if (c >= 0x80)
+		return 1ULL << 63;
+	return 1ULL << (36 + c % 27);
+}
+
+static inline int
+is_white(char c)
+{
+	return c == ' ' || c == '\t' || c == ';';
+}
+
+static inline int
+is_sep(char c)
+{
+	return c == '/' || c == '-' || c == '_' || c == '.' || c == ',' ||
+	    c == ':';
+}
+
+static inline int
+is_lower(char c)
+{
+	return c >= 'a' && c <= 'z';
+}
+
+static inline int
+is_upper(char c)
+{
+	return c >= 'A' && c <= 'Z';
+}
+
+static inline int
+is_digit(char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+static uint8_t
+bonus_at(const char *s, size_t i)
+{
+	char prev, cur;
+
+	if (i == 0)
+		return BONUS_WHITE;
+	prev = s[i - 1];
+	cur  = s[i];
+	if (is_white(prev))
+		return BONUS_WHITE;
+	if (is_sep(prev))
+		return BONUS_BOUNDARY;
+	if ((is_lower(prev) && is_upper(cur)) ||
+	    (!is_digit(prev) && !is_white(prev) && is_digit(cur)))
+		return BONUS_CAMEL;
+	return 0;
+}
+
+/* Program basename of an Exec line: first word, skipping "env" and its
+ * VAR=value assignments, with any directory stripped.  Writes at most
+ * sz-1 bytes. */
+static void
+exec_basename(const char *exec, char *out, size_t sz)
+{
+	const char *p = exec, *w, *e, *slash;
+	size_t      n;
+
+	out[0] = '\0';
+	if (!p)
+		return;
+	for (;;) {
+		while (*p == ' ' || *p == '\t' || *p == '"' || *p == '\'')
+			p++;
+		w = p;
+		while (*p && *p != ' ' && *p != '\t' && *p != '"' && *p != '\'')
+			p++;
+		e = p;
+		if (w == e)
+			return;
+		if ((e - w == 3 && strncmp(w, "env", 3) == 0) ||
+		    memchr(w, '=', (size_t) (e - w)))
+			continue;
+		break;
+	}
+	for (slash = w; slash < e; slash++)
+		if (*slash == '/')
+			w = slash + 1;
+	n = (size_t) (e - w);
+	if (n >= sz)
+		n = sz - 1;
+	memcpy(out, w, n);
+	out[n] = '\0';
+}
+
+/* -------------------------------------------------------------------------
+ * Build
+ * ---------------------------------------------------------------------- */
+
+static size_t
+field_len(const char *s)
+{
+	size_t n = s ? strlen(s) : 0;
+	return n > UINT16_MAX ? UINT16_MAX : n;
+}
+
+/* 255 for an instant start, down to 1 for the slowest; 0 if unknown */
+static uint8_t
+speed_of(double ms)
+{
+	double steps;
+
+	if (!(ms > 0))
+		return 0;
+	steps = ms / SPEED_STEP_MS;
+	return steps >= 254 ? 1 : (uint8_t) (255 - (int) steps);
+}
+
+/* qsort has no context argument in C11; cmp_default reads this */
+static const LauncherSearch *sort_ctx;
+
+/* Empty-query order: launched items by count, then faster-starting items
+ * first, then everything by name */
+static int
+cmp_default(const void *a, const void *b)
+{
+	const LauncherSearch *s  = sort_ctx;
+	int                   ia = *(const int *) a, ib = *(const int *) b;
+	int                   ca = s->count[ia] > 0 ? s->count[ia] : 0;
+	int                   cb = s->count[ib] > 0 ? s->count[ib] : 0;
+	int                   r;
+
+	if (ca != cb)
+		return ca > cb ? -1 : 1;
+	if (s->speed[ia] != s->speed[ib])
+		return s->speed[ia] > s->speed[ib] ? -1 : 1;
+	r = strcmp(s->arena + s->off[ia * F_LAST], s->arena + s->off[ib * F_LAST]);
+	return r ? r : (ia > ib) - (ia < ib);
+}
+
+static void
+update_order(LauncherSearch *s)
+{
+	if (!s->order_dirty)
+		return;
+	for (int i = 0; i < s->n; i++)
+		s->order[i] = i;
+	sort_ctx = s;
+	qsort(s->order, (size_t) s->n, sizeof(int), cmp_default);
+	sort_ctx       = NULL;
+	s->order_dirty = 0;
+}
+
+LauncherSearch *
+launcher_search_build(const LauncherSearchDoc *docs, int n)
+{
+	LauncherSearch *s;
+	char            base[256];
+	size_t          total = 0, pos = 0;
+	int             i, f;
+
+	if (n < 0)
+		return NULL;
+	if (!(s = calloc(1, sizeof(*s))))
+		return NULL;
+	s->n = n;
+
+	for (i = 0; i < n; i++) {
+		exec_basename(docs[i].exec, base, sizeof(base));
+		total += field_len(docs[i].name) + field_len(base) +
+		    field_len(docs[i].generic) + field_len(docs[i].keywords) + F_LAST;
+	}
+
+	s->arena = malloc(total + 1);
+	s->bonus = malloc(total + 1);
+	s->off   = malloc(((size_t) n * F_LAST + 1) * sizeof(*s->off));
+	s->len   = malloc(((size_t) n * F_LAST + 1) * sizeof(*s->len));
+	s->mask  = calloc((size_t) n + 1, sizeof(*s->mask));
+	s->fmask = calloc((size_t) n * F_LAST + 1, sizeof(*s->fmask));
+	s->count = calloc((size_t) n + 1, sizeof(*s->count));
+	s->speed = calloc((size_t) n + 1, sizeof(*s->speed));
+	s->order = malloc(((size_t) n + 1) * sizeof(*s->order));
+	s->hits  = malloc(((size_t) n + 1) * sizeof(*s->hits));
+	s->matched = malloc(((size_t) n + 1) * sizeof(*s->matched));
+	if (!s->arena || !s->bonus || !s->off || !s->len || !s->mask ||
+	    !s->fmask || !s->count || !s->speed || !s->order || !s->hits ||
+	    !s->matched) {
+		launcher_search_free(s);
+		return NULL;
+	}
+
+	for (i = 0; i < n; i++) {
+		const char *field[F_LAST];
+
+		exec_basename(docs[i].exec, base, sizeof(base));
+		field[F_NAME] = docs[i].name;
+		/* PATH items have exec == name; a duplicate field adds nothing */
+		field[F_EXEC]     = strcasecmp(base, docs[i].name) ? base : NULL;
+		field[F_GENERIC]  = docs[i].generic;
+		field[F_KEYWORDS] = docs[i].keywords;
+
+		for (f = 0; f < F_LAST; f++) {
+			size_t l = field_len(field[f]);
+
+			s->off[i * F_LAST + f] = (uint32_t) pos;
+			s->len[i * F_LAST + f] = (uint16_t) l;
+			for (size_t j = 0; j < l; j++) {
+				char c            = fold(field[f][j]);
+				s->arena[pos + j] = c;
+				s->bonus[pos + j] = bonus_at(field[f], j);
+				s->fmask[i * F_LAST + f] |= char_bit((unsigned char) c);
+			}
+			s->mask[i] |= s->fmask[i * F_LAST + f];
+			pos += l;
+			s->arena[pos] = '\0';
+			s->bonus[pos] = 0;
+			pos++;
+		}
+		s->count[i] = docs[i].launch_count;
+		s->speed[i] = speed_of(docs[i].launch_ms);
+	}
+	s->order_dirty = 1;
+	s->last_len    = -1;
+	return s;
+}
+
+void
+launcher_search_free(LauncherSearch *s)
+{
+	if (!s)
+		return;
+	free(s->arena);
+	free(s->bonus);
+	free(s->off);
+	free(s->len);
+	free(s->mask);
+	free(s->fmask);
+	free(s->count);
+	free(s->speed);
+	free(s->order);
+	free(s->hits);
+	free(s->matched);
+	free(s);
+}
+
+void
+launcher_search_set_count(LauncherSearch *s, int i, int launch_count)
+{
+	if (!s || i < 0 || i >= s->n || s->count[i] == launch_count)
+		return;
+	s->count[i]    = launch_count;
+	s->order_dirty = 1;
+}
+
+void
+launcher_search_set_launch_ms(LauncherSearch *s, int i, double ms)
+{
+	if (!s || i < 0 || i >= s->n || s->speed[i] == speed_of(ms))
+		return;
+	s->speed[i]    = speed_of(ms);
+	s->order_dirty = 1;
+}
+
+/* -------------------------------------------------------------------------
+ * Matching
+ * ---------------------------------------------------------------------- */
+
+/* Score q (folded, length k) against one field, -1 if not a subsequence;
+ * a match never scores below 0.  Greedy forward pass finds the earliest
+ * end, a backward pass from there finds the tightest start, then the
+ * window is scored. */
+static int
+score_field(const char *t, const uint8_t *b, int m, const char *q, int k)
+{
+	int i, qi, start, end, score, consecutive, in_gap, first_bonus;
+
+	const char *p = t;
+
+	if (k > m)
+		return -1;
+	/* forward: earliest end of a subsequence match, memchr per char */
+	for (qi = 0; qi < k; qi++) {
+		p = memchr(p, q[qi], (size_t) (t + m - p));
+		if (!p)
+			return -1;
+		p++;
+	}
+	end = (int) (p - t) - 1;
+	for (i = end, qi = k - 1; qi >= 0; i--)
+		if (t[i] == q[qi])
+			qi--;
+	start = i + 1;
+
+	score = consecutive = in_gap = first_bonus = 0;
+	for (i = start, qi = 0; i <= end && qi < k; i++) {
+		if (t[i] == q[qi]) {
+			int bonus = b[i];
+
+			if (consecutive == 0) {
+				first_bonus = bonus;
+			} else {
+				if (bonus >= BONUS_BOUNDARY && bonus > first_bonus)
+					first_bonus = bonus;
+				if (first_bonus > bonus)
+					bonus = first_bonus;
+				if (BONUS_CONSECUTIVE > bonus)
+					bonus = BONUS_CONSECUTIVE;
+			}
+			score += SCORE_MATCH +
+			    (qi == 0 ? bonus * FIRST_CHAR_MULT : bonus);
+			consecutive++;
+			in_gap = 0;
+			qi++;
+		} else {
+			score += in_gap ? SCORE_GAP_EXT : SCORE_GAP_START;
+			in_gap      = 1;
+			consecutive = 0;
+			first_bonus = 0;
+		}
+	}
+	/* gap penalties can outweigh the matches; a match is still a match */
+	return score < 0 ? 0 : score;
+}
+
+typedef struct {
+	char     buf[256]; /* folded terms, NUL-separated */
+	int      off[MAX_TERMS], len[MAX_TERMS];
+	uint64_t tmask[MAX_TERMS];
+	int      n;
+	int      used; /* bytes of buf in use, excluding the last NUL */
+	uint64_t mask; /* union of tmask */
+} Query;
+
+static void
+query_parse(Query *q, const char *text)
+{
+	int pos = 0;
+
+	q->n    = 0;
+	q->mask = 0;
+	while (text && *text && q->n < MAX_TERMS) {
+		while (*text == ' ' || *text == '\t')
+			text++;
+		if (!*text)
+			break;
+		q->off[q->n]   = pos;
+		q->tmask[q->n] = 0;
+		while (*text && *text != ' ' && *text != '\t' &&
+		    pos < (int) sizeof(q->buf) - 1) {
+			char c        = fold(*text++);
+			q->buf[pos++] = c;
+			q->tmask[q->n] |= char_bit((unsigned char) c);
+		}
+		q->mask |= q->tmask[q->n];
+		q->len[q->n] = pos - q->off[q->n];
+		q->buf[pos++] = '\0';
+		q->n++;
+		if (pos >= (int) sizeof(q->buf) - 1)
+			break;
+	}
+	q->used = pos > 0 ? pos - 1 : 0;
+}
+
+static int
+frecency(int count)
+{
+	int b = 0;
+
+	if (count <= 0)
+		return 0;
+	while (count) {
+		b += FRECENCY_STEP;
+		count >>= 1;
+	}
+	return b > FRECENCY_MAX ? FRECENCY_MAX : b;
+}
+
+/* Every term must match some field; the item scores the sum of each
+ * term's best weighted field score, plus the launch-count bonus. */
+static int
+score_item(const LauncherSearch *s, int i, const Query *q)
+{
+	int total = 0, t, f;
+
+	for (t = 0; t < q->n; t++) {
+		int best = -1;
+
+		for (f = 0; f < F_LAST; f++) {
+			uint32_t o = s->off[i * F_LAST + f];
+			int      sc;
+
+			if (q->tmask[t] & ~s->fmask[i * F_LAST + f])
+				continue;
+			sc = score_field(s->arena + o, s->bonus + o,
+			    s->len[i * F_LAST + f], q->buf + q->off[t], q->len[t]);
+			if (sc < 0)
+				continue;
+			sc = sc * field_weight[f] / 4;
+			if (sc > best)
+				best = sc;
+		}
+		if (best < 0)
+			return -1;
+		total += best;
+	}
+	return total + frecency(s->count[i]);
+}
+
+int
+launcher_search_score(LauncherSearch *s, int i, const char *query)
+{
+	Query q;
+
+	if (!s || i < 0 || i >= s->n)
+		return -1;
+	query_parse(&q, query);
+	return score_item(s, i, &q);
+}
+
+/* -------------------------------------------------------------------------
+ * Ranking
+ * ---------------------------------------------------------------------- */
+
+/* Higher score, then more launches, then faster to start, then shorter
+ * name. */
+static uint64_t
+hit_key(const LauncherSearch *s, int i, int score)
+{
+	uint64_t sc  = (uint64_t) (score > 0xFFFFFF ? 0xFFFFFF : score);
+	uint64_t cnt = (uint64_t) (s->count[i] > 0xFFFF ? 0xFFFF
+	                              : s->count[i] < 0 ? 0 : s->count[i]);
+	uint64_t len = 0xFFFF - s->len[i * F_LAST + F_NAME];
+
+	return (sc << 40) | (cnt << 24) | ((uint64_t) s->speed[i] << 16) | len;
+}
+
+/* a ranks below b */
+static inline int
+hit_worse(const Hit *a, const Hit *b)
+{
+	return a->key < b->key || (a->key == b->key && a->idx > b->idx);
+}
+
+static int
+hit_cmp(const void *a, const void *b)
+{
+	const Hit *x = a, *y = b;
+
+	if (hit_worse(x, y))
+		return 1;
+	if (hit_worse(y, x))
+		return -1;
+	return 0;
+}
+
+/* Min-heap (worst hit at the root) of at most k hits */
+static void
+heap_sift_down(Hit *h, int n, int i)
+{
+	for (;;) {
+		int l = 2 * i + 1, r = l + 1, w = i;
+		Hit t;
+
+		if (l < n && hit_worse(&h[l], &h[w]))
+			w = l;
+		if (r < n && hit_worse(&h[r], &h[w]))
+			w = r;
+		if (w == i)
+			return;
+		t    = h[i];
+		h[i] = h[w];
+		h[w] = t;
+		i    = w;
+	}
+}
+
+static void
+heap_sift_up(Hit *h, int i)
+{
+	while (i > 0) {
+		int p = (i - 1) / 2;
+		Hit t;
+
+		if (!hit_worse(&h[i], &h[p]))
+			return;
+		t    = h[i];
+		h[i] = h[p];
+		h[p] = t;
+		i    = p;
+	}
+}
+
+int
+launcher_search_query(
+    LauncherSearch *s, const char *query, int *out, int max)
+{
+	Query q;
+	int   i, c, nc, nm, nh = 0;
+
+	if (!s || max <= 0)
+		return 0;
+	query_parse(&q, query);
+
+	if (q.n == 0) {
+		int n = s->n < max ? s->n : max;
+
+		s->last_len = -1;
+		update_order(s);
+		memcpy(out, s->order, (size_t) n * sizeof(int));
+		return n;
+	}
+
+	/* Candidates: the previous matches if this query extends the last
+	 * one, else every item passing the character-mask test. */
+	if (s->last_len >= 0 && q.used >= s->last_len &&
+	    memcmp(q.buf, s->last, (size_t) s->last_len) == 0) {
+		nc = s->nmatched;
+	} else {
+		for (i = 0, nc = 0; i < s->n; i++)
+			if (!(q.mask & ~s->mask[i]))
+				s->matched[nc++] = i;
+	}
+
+	/* Score them, keeping the matches (in place) for the next query and
+	 * the best max in a bounded heap */
+	for (c = 0, nm = 0; c < nc; c++) {
+		int idx = s->matched[c];
+		int sc  = score_item(s, idx, &q);
+		Hit h;
+
+		if (sc < 0)
+			continue;
+		s->matched[nm++] = idx;
+		h.key            = hit_key(s, idx, sc);
+		h.idx            = idx;
+		if (nh < max) {
+			s->hits[nh] = h;
+			heap_sift_up(s->hits, nh++);
+		} else if (hit_worse(&s->hits[0], &h)) {
+			s->hits[0] = h;
+			heap_sift_down(s->hits, nh, 0);
+		}
+	}
+	s->nmatched = nm;
+	memcpy(s->last, q.buf, (size_t) q.used);
+	s->last_len = q.used;
+
+	qsort(s->hits, (size_t) nh, sizeof(Hit), hit_cmp);
+	for (i = 0; i < nh; i++)
+		out[i] = s->hits[i].idx;
+	return nh;
+}
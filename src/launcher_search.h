@@ -0,0 +1,55 @@
+/* AndrathWM - launcher search engine
+ * See LICENSE file for copyright and license details.
+ *
+ * Ranked fuzzy matching for the launcher.  Pure C (no GTK), linked into
+ * the unit tests and benchmarks as-is.
+ *
+ * launcher_search_build() folds every searchable field of every item
+ * (display name, exec basename, GenericName, Keywords) to lower case once,
+ * into one contiguous arena, alongside a per-byte word-boundary bonus and a
+ * per-item 64-bit character-presence mask.  A query is folded once; items
+ * whose mask lacks any query character are rejected with a single AND, the
+ * rest are scored fzf-style (subsequence match, boundary and run bonuses,
+ * gap penalties) plus a launch-count bonus, and the best K are returned.
+ * Equal scores go to the more-launched item, then to the one that maps its
+ * first window sooner (awm's launch statistics), then to the shorter name.
+ */
+
+#ifndef LAUNCHER_SEARCH_H
+#define LAUNCHER_SEARCH_H
+
+#include <stdint.h>
+
+/* One searchable item.  Strings are copied by launcher_search_build(). */
+typedef struct {
+	const char *name;     /* display name (required) */
+	const char *exec;     /* command line; only the program basename is used */
+	const char *generic;  /* GenericName, may be NULL */
+	const char *keywords; /* Keywords (';'-separated), may be NULL */
+	int         launch_count;
+	double      launch_ms; /* mean launch-to-map time; 0 if unknown */
+} LauncherSearchDoc;
+
+typedef struct LauncherSearch LauncherSearch;
+
+LauncherSearch *launcher_search_build(const LauncherSearchDoc *docs, int n);
+void            launcher_search_free(LauncherSearch *s);
+
+/* Update item i's launch count (re-ranks the empty-query order lazily). */
+void launcher_search_set_count(LauncherSearch *s, int i, int launch_count);
+
+/* Update item i's mean launch-to-map time (0: unknown). */
+void launcher_search_set_launch_ms(LauncherSearch *s, int i, double ms);
+
+/* Rank items against query and write up to max item indices to out, best
+ * first.  An empty or NULL query returns every item ordered by launch
+ * count, then launch speed, then name.  Returns the number of indices
+ * written. */
+int launcher_search_query(
+    LauncherSearch *s, const char *query, int *out, int max);
+
+/* Score of item i for query (higher is better), or -1 if it does not
+ * match.  Exposed for the tests. */
+int launcher_search_score(LauncherSearch *s, int i, const char *query);
+
+#endif /* LAUNCHER_SEARCH_H */
@@ -241,13 +241,13 @@ drawbar(Monitor *m)
 		 * then render it right-aligned against the bar edge.
 		 * tw is used below to size the title-tab area.                   */
 		drw_setscheme(drw, scheme[SchemeNorm]);
-		tw = drw_draw_statusd(drw, 0, 0, 0, 0, stext);
+		tw = drw_status_width(drw);
 		/* Pre-clear the status region with SchemeNorm bg so there is no
 		 * stale content visible between or around the s2d widgets.      */
 		drw_rect(drw, m->ww - stw - tw, 0, (unsigned int) tw,
 		    (unsigned int) bh, 1, 1);
-		drw_draw_statusd(drw, m->ww - stw - tw, 0, (unsigned int) tw,
-		    (unsigned int) bh, stext);
+		drw_status_draw(
+		    drw, m->ww - stw - tw, 0, (unsigned int) tw, (unsigned int) bh);
 	}
 
 	resizebarwin(m);
@@ -877,8 +877,10 @@ geom_done:
 void
 updatestatus(void)
 {
-	if (stext[0] == '\0')
+	if (stext[0] == '\0') {
 		snprintf(stext, sizeof(stext), "awm-" VERSION);
+		drw_status_compile(drw, stext);
+	}
 	drawbar(g_awm_selmon);
 	updatesystray();
 	wmstate_update();
@@ -29,6 +29,8 @@
  *   NOTIF_WIDTH        popup width in pixels
  *   NOTIF_DEFAULT_TIMEOUT  ms; used when dbus timeout == -1 or 0
  *   NOTIF_MAX_VISIBLE  maximum simultaneous popups
+ *   NOTIF_RATE         new popups per second an app may open...
+ *   NOTIF_BURST        ...after a burst of this many (see notif_engine.h)
  *   NOTIF_MARGIN_X     horizontal distance from screen edge
  *   NOTIF_MARGIN_Y     vertical distance from screen edge
  *   NOTIF_GAP          gap between stacked popups
@@ -42,12 +44,15 @@
 
 #include <cairo/cairo.h>
 #include <dbus/dbus.h>
+#include <glib-unix.h>
 #include <gtk/gtk.h>
 #include <pango/pangocairo.h>
 
 #include "icon.h"
 #include "log.h"
 #include "notif.h"
+#include "notif_engine.h"
+#include "pixel.h"
 
 /* -------------------------------------------------------------------------
  * Markup helpers
@@ -94,6 +99,12 @@ layout_set_markup_safe(PangoLayout *lay, const char *text)
 #ifndef NOTIF_MAX_VISIBLE
 #define NOTIF_MAX_VISIBLE 5
 #endif
+#ifndef NOTIF_RATE
+#define NOTIF_RATE 1.0
+#endif
+#ifndef NOTIF_BURST
+#define NOTIF_BURST 5
+#endif
 #ifndef NOTIF_MARGIN_X
 #define NOTIF_MARGIN_X 12
 #endif
@@ -138,7 +149,15 @@ struct NotifItem {
 	GtkWidget       *win;        /* toplevel GTK window */
 	GtkWidget       *da;         /* GtkDrawingArea inside window */
 	guint            timer_id;   /* GLib timeout source id */
+	unsigned         count;      /* notifications coalesced into this */
 	int              h;          /* current popup height in pixels */
+	int              x, y;       /* position last given to win */
+	/* Prepared once in notif_item_prepare() (again on theme change), so
+	 * measuring and exposing never re-parse markup or re-shape text */
+	PangoLayout     *sum_lay;  /* summary */
+	PangoLayout     *body_lay; /* body, or NULL when empty */
+	cairo_surface_t *surf;     /* whole popup, painted on first expose */
+	int              surf_w, surf_h;
 	NotifItem       *next;
 };
 
@@ -146,10 +165,9 @@ struct NotifItem {
  * Module state
  * ---------------------------------------------------------------------- */
 
-static DBusConnection *notif_conn  = NULL;
-static uint32_t        notif_seq   = 1;    /* next notification id */
-static NotifItem      *notif_list  = NULL; /* head of visible list */
-static int             notif_count = 0;
+static DBusConnection *notif_conn   = NULL;
+static NotifItem      *notif_list   = NULL; /* head of visible list */
+static NotifEngine    *notif_engine = NULL; /* ids, coalescing, limits */
 
 /* Monitor workarea — updated by notif_update_geom() */
 static int notif_mon_wx   = 0;
@@ -163,9 +181,19 @@ static UiThemePayload notif_theme;
 static int            notif_theme_set = 0;
 static double         notif_dpi       = 96.0; /* from theme payload */
 
+/* Pango context every popup layout is built in; resolution = notif_dpi */
+static PangoContext *notif_pctx = NULL;
+
 /* Scale a 96-DPI pixel constant to the actual screen DPI. */
 #define NOTIF_SCALE(px) ((int) ((px) * notif_dpi / 96.0 + 0.5))
 
+/* Popup metrics: stripe(4) + pad(12) + icon(32) + gap(8) left of the text,
+ * pad(8) right of it */
+#define NOTIF_TEXT_X                                                    \
+	(NOTIF_SCALE(4) + NOTIF_SCALE(12) + NOTIF_SCALE(32) + NOTIF_SCALE(8))
+#define NOTIF_TEXT_W                                                    \
+	(NOTIF_SCALE(NOTIF_WIDTH) - NOTIF_TEXT_X - NOTIF_SCALE(8))
+
 /* Forward declarations */
 static void notif_item_close(NotifItem *it, uint32_t reason);
 static void notif_restack(void);
@@ -174,104 +202,110 @@ static void notif_restack(void);
  * Popup geometry helpers
  * ---------------------------------------------------------------------- */
 
-/* Compute the desired popup height given its content.
+/* Context for measuring and laying out popup text.
  *
- * We measure text via a 1×1 Cairo image surface so that the Pango context
- * picks up the same DPI/resolution as the real drawing context in
- * on_popup_draw().  Using pango_font_map_create_context() directly produces
- * a context with no surface attached and therefore a hard-coded 96 DPI,
- * which causes height underestimates on HiDPI screens. */
-static int
-popup_height(NotifItem *it)
+ * A font-map context has no surface behind it and would assume 96 DPI and
+ * default hinting and antialiasing, so the real screen DPI and the
+ * screen's font options are set on it explicitly; text then measures and
+ * renders here exactly as GTK draws it on screen. */
+static PangoContext *
+notif_pango_context(void)
 {
-	cairo_surface_t      *probe_surf;
-	cairo_t              *probe_cr;
-	PangoLayout          *lay;
-	PangoFontDescription *fdesc;
-	int                   text_h = 0;
-	int                   bh     = 0;
+	if (!notif_pctx) {
+		GdkScreen *screen = gdk_screen_get_default();
+
+		notif_pctx = pango_font_map_create_context(
+		    pango_cairo_font_map_get_default());
+		if (screen)
+			pango_cairo_context_set_font_options(
+			    notif_pctx, gdk_screen_get_font_options(screen));
+	}
+	pango_cairo_context_set_resolution(notif_pctx, notif_dpi);
+	return notif_pctx;
+}
 
-	/* 1×1 surface is enough — we only need a context with correct DPI. */
-	probe_surf = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 1, 1);
-	probe_cr   = cairo_create(probe_surf);
-	lay        = pango_cairo_create_layout(probe_cr);
+static PangoLayout *
+notif_layout_new(const char *text, const char *fallback_font)
+{
+	PangoLayout          *lay = pango_layout_new(notif_pango_context());
+	PangoFontDescription *fdesc;
+	int                   tw = NOTIF_TEXT_W;
+
+	fdesc = pango_font_description_from_string(
+	    notif_theme_set && notif_theme.font[0] ? notif_theme.font
+	                                           : fallback_font);
+	pango_layout_set_font_description(lay, fdesc);
+	pango_font_description_free(fdesc);
+	pango_layout_set_width(lay, (tw > 0 ? tw : 1) * PANGO_SCALE);
+	layout_set_markup_safe(lay, text);
+	return lay;
+}
 
-	/* Apply the real screen DPI so point-size fonts produce the correct
-	 * pixel height.  cairo_image_surface defaults to 72 DPI internally,
-	 * so without this call we underestimate heights on HiDPI screens. */
-	{
-		PangoContext *pctx = pango_layout_get_context(lay);
-		pango_cairo_context_set_resolution(pctx, notif_dpi);
+/* Drop the pre-rendered popup; the next expose paints a new one */
+static void
+notif_item_invalidate(NotifItem *it)
+{
+	if (it->surf) {
+		cairo_surface_destroy(it->surf);
+		it->surf = NULL;
 	}
+	if (it->da)
+		gtk_widget_queue_draw(it->da);
+}
 
-	/* Summary line */
-	if (notif_theme_set && notif_theme.font[0]) {
-		fdesc = pango_font_description_from_string(notif_theme.font);
-		pango_layout_set_font_description(lay, fdesc);
-		pango_font_description_free(fdesc);
-	}
-	pango_layout_set_width(lay, NOTIF_SCALE(NOTIF_WIDTH - 56) * PANGO_SCALE);
-	layout_set_markup_safe(lay, it->summary ? it->summary : "");
+/* Build the item's layouts (markup is parsed here, once) and derive the
+ * popup height from them.  Called when the notification arrives and
+ * whenever the theme (font, DPI) changes. */
+static void
+notif_item_prepare(NotifItem *it)
+{
+	int text_h = 0, pw, ph;
+
+	if (it->sum_lay)
+		g_object_unref(it->sum_lay);
+	if (it->body_lay)
+		g_object_unref(it->body_lay);
+	it->body_lay = NULL;
+
+	/* Summary — bold, one ellipsized line, led by the coalesced count */
 	{
-		int pw = 0, ph = 0;
-		pango_layout_get_pixel_size(lay, &pw, &ph);
-		text_h += ph + 4;
-		(void) pw;
+		char *sum = it->count > 1
+		    ? g_strdup_printf("(%u) %s", it->count, it->summary)
+		    : NULL;
+		it->sum_lay = notif_layout_new(sum ? sum : it->summary, "Sans Bold 10");
+		g_free(sum);
 	}
+	pango_layout_set_ellipsize(it->sum_lay, PANGO_ELLIPSIZE_END);
+	pango_layout_set_single_paragraph_mode(it->sum_lay, TRUE);
+	pango_layout_get_pixel_size(it->sum_lay, &pw, &ph);
+	text_h += ph + 4;
 
-	/* Body */
+	/* Body — word-wrapped */
 	if (it->body && it->body[0]) {
-		if (notif_theme_set && notif_theme.font[0]) {
-			fdesc = pango_font_description_from_string(notif_theme.font);
-			pango_layout_set_font_description(lay, fdesc);
-			pango_font_description_free(fdesc);
-		}
-		pango_layout_set_width(
-		    lay, NOTIF_SCALE(NOTIF_WIDTH - 56) * PANGO_SCALE);
-		layout_set_markup_safe(lay, it->body);
-		pango_layout_set_wrap(lay, PANGO_WRAP_WORD_CHAR);
-		{
-			int pw = 0, ph = 0;
-			pango_layout_get_pixel_size(lay, &pw, &ph);
-			bh = ph;
-			(void) pw;
-		}
+		it->body_lay = notif_layout_new(it->body, "Sans 9");
+		pango_layout_set_wrap(it->body_lay, PANGO_WRAP_WORD_CHAR);
+		pango_layout_get_pixel_size(it->body_lay, &pw, &ph);
+		text_h += ph;
 	}
 
-	g_object_unref(lay);
-	cairo_destroy(probe_cr);
-	cairo_surface_destroy(probe_surf);
-
 	{
 		int pad = NOTIF_SCALE(12);
 		int min = NOTIF_SCALE(56); /* icon(32) + 2*pad(12) */
-		int h   = pad + text_h + bh + pad;
-		if (h < min)
-			h = min;
-		return h;
+		it->h   = pad + text_h + pad;
+		if (it->h < min)
+			it->h = min;
 	}
+	notif_item_invalidate(it);
 }
 
-/* Compute the top-left screen position for popup slot idx (0 = closest to
- * the anchor corner). */
+/* Compute the top-left screen position of a popup pop_h pixels high whose
+ * stack_off pixels of earlier popups sit between it and the anchor. */
 static void
-popup_position(int idx, int pop_h, int *out_x, int *out_y)
+popup_position(int stack_off, int pop_h, int *out_x, int *out_y)
 {
 	NotifAnchor anchor = (NotifAnchor) NOTIF_ANCHOR;
 	int         x, y;
 
-	/* Accumulate height of all previous popups in the stack */
-	int stack_off = 0;
-	{
-		int        slot = 0;
-		NotifItem *it   = notif_list;
-		while (it && slot < idx) {
-			stack_off += it->h + NOTIF_SCALE(NOTIF_GAP);
-			slot++;
-			it = it->next;
-		}
-	}
-
 	switch (anchor) {
 	case TopRight:
 	default:
@@ -304,13 +338,10 @@ popup_position(int idx, int pop_h, int *out_x, int *out_y)
  * GTK popup rendering
  * ---------------------------------------------------------------------- */
 
-static gboolean
-on_popup_draw(GtkWidget *widget, cairo_t *cr, gpointer data)
+/* Paint the whole popup; done once per item into it->surf */
+static void
+notif_item_paint(NotifItem *it, cairo_t *cr, int w, int h)
 {
-	NotifItem *it = (NotifItem *) data;
-	int        w  = gtk_widget_get_allocated_width(widget);
-	int        h  = gtk_widget_get_allocated_height(widget);
-
 	/* Background — use theme norm_bg if available, else dark fallback */
 	if (notif_theme_set) {
 		cairo_set_source_rgba(cr, notif_theme.norm_bg[0] / 65535.0,
@@ -371,37 +402,14 @@ on_popup_draw(GtkWidget *widget, cairo_t *cr, gpointer data)
 		}
 	}
 
-	/* Text */
+	/* Text — from the layouts prepared in notif_item_prepare() */
 	{
-		/* stripe(4) + pad(12) + icon(32) + gap(8) — all scaled */
-		int tx = NOTIF_SCALE(4) + NOTIF_SCALE(12) + NOTIF_SCALE(32) +
-		    NOTIF_SCALE(8);
+		int tx = NOTIF_TEXT_X;
 		int ty = NOTIF_SCALE(12);
-		int tw = w - tx - NOTIF_SCALE(8);
-
-		PangoLayout *lay = pango_cairo_create_layout(cr);
-
-		/* Set DPI on the Pango context so font point sizes map to the
-		 * correct device pixels.  GTK/Cairo may already do this via GDK
-		 * screen DPI, but we set it explicitly to match popup_height(). */
-		{
-			PangoContext *pctx = pango_layout_get_context(lay);
-			pango_cairo_context_set_resolution(pctx, notif_dpi);
-		}
+		int pw = 0, ph = 0;
 
-		/* Summary — bold, use sel_fg if theme available */
-		if (tw > 0 && it->summary) {
-			const char *font_str = (notif_theme_set && notif_theme.font[0])
-			    ? notif_theme.font
-			    : "Sans Bold 10";
-			PangoFontDescription *fdesc =
-			    pango_font_description_from_string(font_str);
-			pango_layout_set_font_description(lay, fdesc);
-			pango_font_description_free(fdesc);
-			pango_layout_set_width(lay, tw * PANGO_SCALE);
-			pango_layout_set_ellipsize(lay, PANGO_ELLIPSIZE_END);
-			pango_layout_set_single_paragraph_mode(lay, TRUE);
-			layout_set_markup_safe(lay, it->summary);
+		if (NOTIF_TEXT_W > 0 && it->sum_lay) {
+			/* Summary — use sel_fg if theme available */
 			if (notif_theme_set) {
 				cairo_set_source_rgba(cr, notif_theme.sel_fg[0] / 65535.0,
 				    notif_theme.sel_fg[1] / 65535.0,
@@ -410,28 +418,13 @@ on_popup_draw(GtkWidget *widget, cairo_t *cr, gpointer data)
 				cairo_set_source_rgba(cr, 0.92, 0.92, 0.92, 1.0);
 			}
 			cairo_move_to(cr, tx, ty);
-			pango_cairo_show_layout(cr, lay);
-
-			int pw = 0, ph = 0;
-			pango_layout_get_pixel_size(lay, &pw, &ph);
+			pango_cairo_show_layout(cr, it->sum_lay);
+			pango_layout_get_pixel_size(it->sum_lay, &pw, &ph);
 			ty += ph + 4;
-			(void) pw;
 		}
 
-		/* Body — use norm_fg if theme available */
-		if (tw > 0 && it->body && it->body[0]) {
-			const char *font_str = (notif_theme_set && notif_theme.font[0])
-			    ? notif_theme.font
-			    : "Sans 9";
-			PangoFontDescription *fdesc =
-			    pango_font_description_from_string(font_str);
-			pango_layout_set_font_description(lay, fdesc);
-			pango_font_description_free(fdesc);
-			pango_layout_set_width(lay, tw * PANGO_SCALE);
-			pango_layout_set_ellipsize(lay, PANGO_ELLIPSIZE_NONE);
-			pango_layout_set_single_paragraph_mode(lay, FALSE);
-			pango_layout_set_wrap(lay, PANGO_WRAP_WORD_CHAR);
-			layout_set_markup_safe(lay, it->body);
+		if (NOTIF_TEXT_W > 0 && it->body_lay) {
+			/* Body — use norm_fg if theme available */
 			if (notif_theme_set) {
 				cairo_set_source_rgba(cr, notif_theme.norm_fg[0] / 65535.0,
 				    notif_theme.norm_fg[1] / 65535.0,
@@ -440,10 +433,8 @@ on_popup_draw(GtkWidget *widget, cairo_t *cr, gpointer data)
 				cairo_set_source_rgba(cr, 0.7, 0.7, 0.7, 1.0);
 			}
 			cairo_move_to(cr, tx, ty);
-			pango_cairo_show_layout(cr, lay);
+			pango_cairo_show_layout(cr, it->body_lay);
 		}
-
-		g_object_unref(lay);
 	}
 
 	/* Border — use theme norm_bd if available */
@@ -457,7 +448,40 @@ on_popup_draw(GtkWidget *widget, cairo_t *cr, gpointer data)
 	cairo_set_line_width(cr, 1.0);
 	cairo_rectangle(cr, 0.5, 0.5, w - 1, h - 1);
 	cairo_stroke(cr);
+}
+
+/* Expose: blit the pre-rendered popup, painting it first if needed */
+static gboolean
+on_popup_draw(GtkWidget *widget, cairo_t *cr, gpointer data)
+{
+	NotifItem *it = (NotifItem *) data;
+	int        w  = gtk_widget_get_allocated_width(widget);
+	int        h  = gtk_widget_get_allocated_height(widget);
+
+	if (it->surf && (it->surf_w != w || it->surf_h != h)) {
+		cairo_surface_destroy(it->surf);
+		it->surf = NULL;
+	}
+	if (!it->surf) {
+		GdkWindow *gwin = gtk_widget_get_window(widget);
+		cairo_t   *pcr;
+
+		/* Server-side where possible, so each blit is a copy on the
+		 * X server rather than an upload */
+		it->surf = gwin ? gdk_window_create_similar_surface(
+		                      gwin, CAIRO_CONTENT_COLOR_ALPHA, w, h)
+		                : cairo_image_surface_create(
+		                      CAIRO_FORMAT_ARGB32, w, h);
+		it->surf_w = w;
+		it->surf_h = h;
+		pcr        = cairo_create(it->surf);
+		notif_item_paint(it, pcr, w, h);
+		cairo_destroy(pcr);
+	}
 
+	cairo_set_source_surface(cr, it->surf, 0, 0);
+	cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+	cairo_paint(cr);
 	return FALSE;
 }
 
@@ -485,8 +509,21 @@ notif_expire_cb(gpointer data)
 	return G_SOURCE_REMOVE;
 }
 
-/* Create and show the GTK popup window for a notification item.
- * Does not position it — call notif_restack() afterwards. */
+/* (Re)start the auto-expire timer; critical popups never expire */
+static void
+notif_item_arm(NotifItem *it)
+{
+	if (it->timer_id) {
+		g_source_remove(it->timer_id);
+		it->timer_id = 0;
+	}
+	if (it->timeout_ms > 0 && it->urgency != 2)
+		it->timer_id =
+		    g_timeout_add((guint) it->timeout_ms, notif_expire_cb, it);
+}
+
+/* Create the GTK popup window for a prepared notification item.
+ * Neither positions nor maps it — notif_restack() does both. */
 static void
 notif_item_show(NotifItem *it)
 {
@@ -494,8 +531,6 @@ notif_item_show(NotifItem *it)
 	if (!notif_geom_set)
 		return;
 
-	it->h = popup_height(it);
-
 	it->win = gtk_window_new(GTK_WINDOW_TOPLEVEL);
 	gtk_window_set_decorated(GTK_WINDOW(it->win), FALSE);
 	gtk_window_set_skip_taskbar_hint(GTK_WINDOW(it->win), TRUE);
@@ -532,13 +567,17 @@ notif_item_show(NotifItem *it)
 	g_signal_connect(
 	    it->win, "button-press-event", G_CALLBACK(on_popup_button_press), it);
 
-	gtk_widget_show_all(it->win);
+	notif_item_arm(it);
+}
 
-	/* Schedule auto-expire */
-	if (it->timeout_ms > 0 && it->urgency != 2) {
-		it->timer_id =
-		    g_timeout_add((guint) it->timeout_ms, notif_expire_cb, it);
-	}
+/* Match the window to a re-prepared item whose height was old_h */
+static void
+notif_item_fit(NotifItem *it, int old_h)
+{
+	if (!it->win || it->h == old_h)
+		return;
+	gtk_widget_set_size_request(it->da, NOTIF_SCALE(NOTIF_WIDTH), it->h);
+	gtk_window_resize(GTK_WINDOW(it->win), NOTIF_SCALE(NOTIF_WIDTH), it->h);
 }
 
 /* Emit NotificationClosed signal on D-Bus. */
@@ -562,12 +601,40 @@ notif_emit_closed(uint32_t id, uint32_t reason)
 	dbus_connection_flush(notif_conn);
 }
 
-/* Remove a notification item from the list and destroy its window. */
+/* Free the content a Notify supplied, ready for new content */
 static void
-notif_item_close(NotifItem *it, uint32_t reason)
+notif_item_clear(NotifItem *it)
+{
+	free(it->app_name);
+	free(it->summary);
+	free(it->body);
+	free(it->icon_name);
+	it->app_name = it->summary = it->body = it->icon_name = NULL;
+	if (it->icon_surf) {
+		cairo_surface_destroy(it->icon_surf);
+		it->icon_surf = NULL;
+	}
+}
+
+static void
+notif_item_free(NotifItem *it)
+{
+	notif_item_clear(it);
+	if (it->sum_lay)
+		g_object_unref(it->sum_lay);
+	if (it->body_lay)
+		g_object_unref(it->body_lay);
+	if (it->surf)
+		cairo_surface_destroy(it->surf);
+	free(it);
+}
+
+/* Remove a notification item from the list, destroy its window and free
+ * it.  Emits nothing and leaves the stack for the caller to restack. */
+static void
+notif_item_destroy(NotifItem *it)
 {
 	NotifItem **pp;
-	uint32_t    id = it->id;
 
 	/* Cancel timer */
 	if (it->timer_id) {
@@ -586,39 +653,61 @@ notif_item_close(NotifItem *it, uint32_t reason)
 	for (pp = &notif_list; *pp; pp = &(*pp)->next) {
 		if (*pp == it) {
 			*pp = it->next;
-			notif_count--;
 			break;
 		}
 	}
 
-	/* Free resources */
-	free(it->app_name);
-	free(it->summary);
-	free(it->body);
-	free(it->icon_name);
-	if (it->icon_surf) {
-		cairo_surface_destroy(it->icon_surf);
-		it->icon_surf = NULL;
-	}
-	free(it);
+	notif_engine_close(notif_engine, it->id);
+	notif_item_free(it);
+}
+
+static NotifItem *
+notif_item_find(uint32_t id)
+{
+	NotifItem *it;
+
+	for (it = notif_list; it && it->id != id; it = it->next)
+		;
+	return it;
+}
+
+/* Close a notification: destroy it, report why, close the gap. */
+static void
+notif_item_close(NotifItem *it, uint32_t reason)
+{
+	uint32_t id = it->id;
 
+	notif_item_destroy(it);
 	notif_emit_closed(id, reason);
 	notif_restack();
 }
 
-/* Recompute and update on-screen positions of all visible popups. */
+/* Lay out the whole stack in one pass: each popup's offset is the running
+ * sum of the ones before it.  Only windows whose slot changed are moved,
+ * and new windows are moved before they are mapped, so a burst of
+ * arrivals and closes costs one geometry update per popup at most. */
 static void
 notif_restack(void)
 {
-	int        idx = 0;
+	int        stack_off = 0;
 	NotifItem *it;
 
-	for (it = notif_list; it; it = it->next, idx++) {
+	for (it = notif_list; it; it = it->next) {
+		int x, y;
+
+		popup_position(stack_off, it->h, &x, &y);
+		stack_off += it->h + NOTIF_SCALE(NOTIF_GAP);
 		if (!it->win)
 			continue;
-		int x, y;
-		popup_position(idx, it->h, &x, &y);
-		gtk_window_move(GTK_WINDOW(it->win), x, y);
+
+		if (!gtk_widget_get_visible(it->win)) {
+			gtk_window_move(GTK_WINDOW(it->win), x, y);
+			gtk_widget_show_all(it->win);
+		} else if (x != it->x || y != it->y) {
+			gtk_window_move(GTK_WINDOW(it->win), x, y);
+		}
+		it->x = x;
+		it->y = y;
 	}
 }
 
@@ -631,6 +720,7 @@ notif_image_data_to_surface(DBusMessageIter *iter_v)
 	DBusMessageIter iter_s, iter_a;
 	int             w, h, rowstride;
 	int             has_alpha, bps, channels;
+	PixelFormat     fmt;
 
 	if (dbus_message_iter_get_arg_type(iter_v) != DBUS_TYPE_STRUCT)
 		return NULL;
@@ -673,6 +763,12 @@ notif_image_data_to_surface(DBusMessageIter *iter_v)
 
 	if (!src_data || src_len <= 0 || w <= 0 || h <= 0 || bps != 8)
 		return NULL;
+	fmt = channels >= 4 && has_alpha ? PIXEL_RGBA : PIXEL_RGB;
+	/* the last row need not be padded out to rowstride */
+	if ((int64_t) rowstride < (int64_t) w * pixel_format_bpp(fmt) ||
+	    (int64_t) rowstride * (h - 1) + (int64_t) w * pixel_format_bpp(fmt) >
+	        src_len)
+		return NULL;
 
 	cairo_surface_t *surf =
 	    cairo_image_surface_create(CAIRO_FORMAT_ARGB32, w, h);
@@ -681,33 +777,11 @@ notif_image_data_to_surface(DBusMessageIter *iter_v)
 		return NULL;
 	}
 
-	uint32_t *dst     = (uint32_t *) cairo_image_surface_get_data(surf);
-	int       dstride = cairo_image_surface_get_stride(surf) / 4;
-
+	/* Cairo ARGB32 is premultiplied */
 	cairo_surface_flush(surf);
-	for (int row = 0; row < h; row++) {
-		const uint8_t *srow = src_data + row * rowstride;
-		uint32_t      *drow = dst + row * dstride;
-		for (int col = 0; col < w; col++) {
-			uint8_t r, g, b, a;
-			if (channels >= 4 && has_alpha) {
-				r = srow[col * 4 + 0];
-				g = srow[col * 4 + 1];
-				b = srow[col * 4 + 2];
-				a = srow[col * 4 + 3];
-			} else {
-				r = srow[col * 3 + 0];
-				g = srow[col * 3 + 1];
-				b = srow[col * 3 + 2];
-				a = 0xff;
-			}
-			/* Cairo ARGB32 is premultiplied */
-			drow[col] = ((uint32_t) a << 24) |
-			    ((uint32_t) ((r * a + 127) / 255) << 16) |
-			    ((uint32_t) ((g * a + 127) / 255) << 8) |
-			    ((uint32_t) ((b * a + 127) / 255));
-		}
-	}
+	pixel_to_argb32(cairo_image_surface_get_data(surf),
+	    (size_t) cairo_image_surface_get_stride(surf), src_data,
+	    (size_t) rowstride, w, h, fmt);
 	cairo_surface_mark_dirty(surf);
 
 	return surf;
@@ -717,6 +791,21 @@ notif_image_data_to_surface(DBusMessageIter *iter_v)
  * D-Bus method handlers
  * ---------------------------------------------------------------------- */
 
+/* Reply to Notify with the notification id */
+static void
+notif_reply_id(DBusConnection *conn, DBusMessage *msg, uint32_t id)
+{
+	DBusMessage *reply = dbus_message_new_method_return(msg);
+
+	if (reply) {
+		dbus_message_append_args(
+		    reply, DBUS_TYPE_UINT32, &id, DBUS_TYPE_INVALID);
+		dbus_connection_send(conn, reply, NULL);
+		dbus_message_unref(reply);
+	}
+	dbus_connection_flush(conn);
+}
+
 static DBusHandlerResult
 handle_notify(DBusConnection *conn, DBusMessage *msg)
 {
@@ -730,6 +819,9 @@ handle_notify(DBusConnection *conn, DBusMessage *msg)
 	int              timeout_ms;
 	int              urgency  = 1;
 	cairo_surface_t *img_surf = NULL;
+	NotifVerdict     v;
+	NotifItem       *it;
+	int              old_h = 0;
 
 	dbus_message_iter_init(msg, &iter);
 
@@ -813,58 +905,50 @@ handle_notify(DBusConnection *conn, DBusMessage *msg)
 			timeout_ms = NOTIF_DEFAULT_TIMEOUT;
 	}
 
-	/* If replaces_id > 0 and we have that notification, close it first */
-	if (replaces_id > 0) {
-		NotifItem *it;
-		for (it = notif_list; it; it = it->next) {
-			if (it->id == replaces_id) {
-				/* Close silently: don't emit NotificationClosed */
-				if (it->timer_id) {
-					g_source_remove(it->timer_id);
-					it->timer_id = 0;
-				}
-				if (it->win) {
-					gtk_widget_destroy(it->win);
-					it->win = NULL;
-					it->da  = NULL;
-				}
-				{
-					NotifItem **pp;
-					for (pp = &notif_list; *pp; pp = &(*pp)->next) {
-						if (*pp == it) {
-							*pp = it->next;
-							notif_count--;
-							break;
-						}
-					}
-				}
-				free(it->app_name);
-				free(it->summary);
-				free(it->body);
-				free(it->icon_name);
-				if (it->icon_surf)
-					cairo_surface_destroy(it->icon_surf);
-				free(it);
-				break;
-			}
-		}
-	}
+	/* The engine decides: new popup, update of a live one (replacement,
+	 * same summary, or over the app's rate), or drop */
+	v = notif_engine_submit(notif_engine, app_name, summary, replaces_id,
+	    urgency == 2, g_get_monotonic_time() / 1000);
 
-	/* Enforce maximum visible — drop oldest if needed */
-	while (notif_count >= NOTIF_MAX_VISIBLE && notif_list)
-		notif_item_close(notif_list, 3); /* reason 3 = forced close */
-
-	/* Build new notification */
-	NotifItem *it = (NotifItem *) calloc(1, sizeof(NotifItem));
-	if (!it) {
+	if (v.action == NOTIF_DROP) {
 		if (img_surf)
 			cairo_surface_destroy(img_surf);
-		return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+		notif_reply_id(conn, msg, v.id);
+		notif_emit_closed(v.id, 3); /* never shown: closed at once */
+		return DBUS_HANDLER_RESULT_HANDLED;
+	}
+
+	if (v.evict) {
+		NotifItem *old = notif_item_find(v.evict);
+		if (old)
+			notif_item_destroy(old);
+		notif_emit_closed(v.evict, 3); /* reason 3 = forced close */
+	}
+
+	it = v.action == NOTIF_UPDATE ? notif_item_find(v.id) : NULL;
+	if (it) {
+		/* Update in place: same window, same slot */
+		old_h = it->h;
+		notif_item_clear(it);
+	} else {
+		it = (NotifItem *) calloc(1, sizeof(NotifItem));
+		if (!it) {
+			notif_engine_close(notif_engine, v.id);
+			if (img_surf)
+				cairo_surface_destroy(img_surf);
+			return DBUS_HANDLER_RESULT_NEED_MEMORY;
+		}
+		it->id = v.id;
+
+		/* Append to end of list */
+		{
+			NotifItem **pp = &notif_list;
+			while (*pp)
+				pp = &(*pp)->next;
+			*pp = it;
+		}
 	}
 
-	it->id = notif_seq++;
-	if (notif_seq == 0)
-		notif_seq = 1; /* wrap, skip 0 */
 	it->app_name   = strdup(app_name ? app_name : "");
 	it->summary    = strdup(summary ? summary : "");
 	it->body       = strdup(body ? body : "");
@@ -872,30 +956,20 @@ handle_notify(DBusConnection *conn, DBusMessage *msg)
 	it->icon_surf  = img_surf;
 	it->urgency    = urgency;
 	it->timeout_ms = timeout_ms;
-	it->next       = NULL;
+	it->count      = v.count;
 
-	/* Append to end of list */
-	{
-		NotifItem **pp = &notif_list;
-		while (*pp)
-			pp = &(*pp)->next;
-		*pp = it;
+	/* Parse and measure once; exposes then only blit */
+	notif_item_prepare(it);
+	if (it->win) {
+		notif_item_fit(it, old_h);
+		notif_item_arm(it);
+	} else {
+		notif_item_show(it);
 	}
-	notif_count++;
-
-	notif_item_show(it);
+	/* One restack for the eviction above and this popup */
 	notif_restack();
 
-	/* Reply with notification id */
-	DBusMessage *reply = dbus_message_new_method_return(msg);
-	if (reply) {
-		uint32_t rid = it->id;
-		dbus_message_append_args(
-		    reply, DBUS_TYPE_UINT32, &rid, DBUS_TYPE_INVALID);
-		dbus_connection_send(conn, reply, NULL);
-		dbus_message_unref(reply);
-	}
-	dbus_connection_flush(conn);
+	notif_reply_id(conn, msg, it->id);
 	return DBUS_HANDLER_RESULT_HANDLED;
 }
 
@@ -1008,24 +1082,180 @@ notif_message_filter(DBusConnection *conn, DBusMessage *msg, void *user_data)
 }
 
 /* -------------------------------------------------------------------------
- * GLib integration — pump D-Bus on a GLib idle source
+ * GLib integration — libdbus watches and timeouts as GLib sources
+ *
+ * libdbus reports the fds it needs polled (watches) and the timers it
+ * needs run (pending-call timeouts); each enabled one becomes a GLib
+ * source, so the daemon sleeps until the socket is readable or a timer is
+ * due.  Incoming messages are dispatched from a one-shot source raised by
+ * the dispatch-status callback, never from inside libdbus itself.
  * ---------------------------------------------------------------------- */
 
-static guint notif_idle_id = 0;
+static guint notif_dispatch_id = 0;
 
 static gboolean
-notif_idle_cb(gpointer data)
+notif_dispatch_cb(gpointer data)
 {
 	(void) data;
+	notif_dispatch_id = 0;
 	if (notif_conn) {
-		dbus_connection_read_write(notif_conn, 0);
 		while (
 		    dbus_connection_dispatch(notif_conn) == DBUS_DISPATCH_DATA_REMAINS)
 			;
 	}
+	return G_SOURCE_REMOVE;
+}
+
+static void
+notif_dispatch_status_cb(
+    DBusConnection *conn, DBusDispatchStatus status, void *data)
+{
+	(void) conn;
+	(void) data;
+	if (status == DBUS_DISPATCH_DATA_REMAINS && !notif_dispatch_id)
+		notif_dispatch_id = g_idle_add_full(
+		    G_PRIORITY_DEFAULT, notif_dispatch_cb, NULL, NULL);
+}
+
+static gboolean
+notif_watch_cb(gint fd, GIOCondition cond, gpointer data)
+{
+	unsigned int flags = 0;
+
+	(void) fd;
+	if (cond & G_IO_IN)
+		flags |= DBUS_WATCH_READABLE;
+	if (cond & G_IO_OUT)
+		flags |= DBUS_WATCH_WRITABLE;
+	if (cond & G_IO_HUP)
+		flags |= DBUS_WATCH_HANGUP;
+	if (cond & G_IO_ERR)
+		flags |= DBUS_WATCH_ERROR;
+	/* May toggle or remove this very source; GLib copes with that */
+	dbus_watch_handle((DBusWatch *) data, flags);
 	return G_SOURCE_CONTINUE;
 }
 
+/* (Re)create the watch's fd source to match its enabled state and flags.
+ * The source id is kept as the watch's data. */
+static void
+notif_watch_toggled(DBusWatch *watch, void *data)
+{
+	guint id = GPOINTER_TO_UINT(dbus_watch_get_data(watch));
+
+	(void) data;
+	if (id)
+		g_source_remove(id);
+	id = 0;
+
+	if (dbus_watch_get_enabled(watch)) {
+		unsigned int flags = dbus_watch_get_flags(watch);
+		GIOCondition cond  = G_IO_HUP | G_IO_ERR;
+		GSource     *src;
+
+		if (flags & DBUS_WATCH_READABLE)
+			cond |= G_IO_IN;
+		if (flags & DBUS_WATCH_WRITABLE)
+			cond |= G_IO_OUT;
+		src = g_unix_fd_source_new(dbus_watch_get_unix_fd(watch), cond);
+		g_source_set_callback(src, (GSourceFunc) notif_watch_cb, watch, NULL);
+		id = g_source_attach(src, NULL);
+		g_source_unref(src);
+	}
+	dbus_watch_set_data(watch, GUINT_TO_POINTER(id), NULL);
+}
+
+static dbus_bool_t
+notif_watch_add(DBusWatch *watch, void *data)
+{
+	notif_watch_toggled(watch, data);
+	return TRUE;
+}
+
+static void
+notif_watch_remove(DBusWatch *watch, void *data)
+{
+	guint id = GPOINTER_TO_UINT(dbus_watch_get_data(watch));
+
+	(void) data;
+	if (id)
+		g_source_remove(id);
+	dbus_watch_set_data(watch, NULL, NULL);
+}
+
+static gboolean
+notif_timeout_cb(gpointer data)
+{
+	/* libdbus timeouts repeat until it disables or removes them */
+	dbus_timeout_handle((DBusTimeout *) data);
+	return G_SOURCE_CONTINUE;
+}
+
+static void
+notif_timeout_toggled(DBusTimeout *timeout, void *data)
+{
+	guint id = GPOINTER_TO_UINT(dbus_timeout_get_data(timeout));
+
+	(void) data;
+	if (id)
+		g_source_remove(id);
+	id = 0;
+
+	if (dbus_timeout_get_enabled(timeout))
+		id = g_timeout_add((guint) dbus_timeout_get_interval(timeout),
+		    notif_timeout_cb, timeout);
+	dbus_timeout_set_data(timeout, GUINT_TO_POINTER(id), NULL);
+}
+
+static dbus_bool_t
+notif_timeout_add(DBusTimeout *timeout, void *data)
+{
+	notif_timeout_toggled(timeout, data);
+	return TRUE;
+}
+
+static void
+notif_timeout_remove(DBusTimeout *timeout, void *data)
+{
+	guint id = GPOINTER_TO_UINT(dbus_timeout_get_data(timeout));
+
+	(void) data;
+	if (id)
+		g_source_remove(id);
+	dbus_timeout_set_data(timeout, NULL, NULL);
+}
+
+static int
+notif_attach_dbus(DBusConnection *conn)
+{
+	if (!dbus_connection_set_watch_functions(conn, notif_watch_add,
+	        notif_watch_remove, notif_watch_toggled, NULL, NULL) ||
+	    !dbus_connection_set_timeout_functions(conn, notif_timeout_add,
+	        notif_timeout_remove, notif_timeout_toggled, NULL, NULL))
+		return -1;
+	dbus_connection_set_dispatch_status_function(
+	    conn, notif_dispatch_status_cb, NULL, NULL);
+
+	/* Messages queued during the blocking name request raised no status
+	 * change; pick them up now. */
+	notif_dispatch_status_cb(
+	    conn, dbus_connection_get_dispatch_status(conn), NULL);
+	return 0;
+}
+
+/* Detach from the main loop: the remove callbacks drop every source */
+static void
+notif_detach_dbus(DBusConnection *conn)
+{
+	dbus_connection_set_dispatch_status_function(conn, NULL, NULL, NULL);
+	dbus_connection_set_watch_functions(conn, NULL, NULL, NULL, NULL, NULL);
+	dbus_connection_set_timeout_functions(conn, NULL, NULL, NULL, NULL, NULL);
+	if (notif_dispatch_id) {
+		g_source_remove(notif_dispatch_id);
+		notif_dispatch_id = 0;
+	}
+}
+
 /* -------------------------------------------------------------------------
  * Public API
  * ---------------------------------------------------------------------- */
@@ -1040,6 +1270,15 @@ notif_init(int mon_wx, int mon_wy, int mon_ww, int mon_wh)
 	notif_mon_ww = mon_ww;
 	notif_mon_wh = mon_wh;
 
+	{
+		NotifLimits lim = { NOTIF_MAX_VISIBLE, NOTIF_RATE, NOTIF_BURST };
+		notif_engine    = notif_engine_new(&lim);
+	}
+	if (!notif_engine) {
+		awm_error("notif: bad NOTIF_MAX_VISIBLE/NOTIF_RATE/NOTIF_BURST");
+		return -1;
+	}
+
 	dbus_error_init(&err);
 	notif_conn = dbus_bus_get(DBUS_BUS_SESSION, &err);
 	if (!notif_conn) {
@@ -1065,8 +1304,15 @@ notif_init(int mon_wx, int mon_wy, int mon_ww, int mon_wh)
 
 	dbus_connection_add_filter(notif_conn, notif_message_filter, NULL, NULL);
 
-	/* Pump D-Bus every ~50 ms via a GLib timeout (low priority) */
-	notif_idle_id = g_timeout_add(50, notif_idle_cb, NULL);
+	if (notif_attach_dbus(notif_conn) < 0) {
+		awm_error("notif: cannot attach D-Bus to the main loop");
+		dbus_connection_remove_filter(
+		    notif_conn, notif_message_filter, NULL);
+		dbus_bus_release_name(notif_conn, NOTIF_BUS_NAME, NULL);
+		dbus_connection_unref(notif_conn);
+		notif_conn = NULL;
+		return -1;
+	}
 
 	awm_info("notif: registered %s on session bus", NOTIF_BUS_NAME);
 	return 0;
@@ -1104,11 +1350,15 @@ notif_update_theme(const UiThemePayload *t)
 	if (t->dpi > 0.0)
 		notif_dpi = t->dpi;
 
-	/* Force a redraw of every visible popup */
+	/* Fonts or DPI may have changed: re-prepare (which also drops the
+	 * pre-rendered popups), resize where the height moved, restack once */
 	for (it = notif_list; it; it = it->next) {
-		if (it->da)
-			gtk_widget_queue_draw(it->da);
+		int old_h = it->h;
+
+		notif_item_prepare(it);
+		notif_item_fit(it, old_h);
 	}
+	notif_restack();
 }
 
 void
@@ -1124,33 +1374,21 @@ notif_dispatch(void)
 void
 notif_cleanup(void)
 {
-	if (notif_idle_id) {
-		g_source_remove(notif_idle_id);
-		notif_idle_id = 0;
-	}
+	if (notif_conn)
+		notif_detach_dbus(notif_conn);
 
 	/* Close all open notifications silently */
-	while (notif_list) {
-		NotifItem *it = notif_list;
-		notif_list    = it->next;
-		notif_count--;
-		if (it->timer_id) {
-			g_source_remove(it->timer_id);
-			it->timer_id = 0;
-		}
-		if (it->win) {
-			gtk_widget_destroy(it->win);
-			it->win = NULL;
-		}
-		free(it->app_name);
-		free(it->summary);
-		free(it->body);
-		free(it->icon_name);
-		if (it->icon_surf)
-			cairo_surface_destroy(it->icon_surf);
-		free(it);
+	while (notif_list)
+		notif_item_destroy(notif_list);
+
+	if (notif_pctx) {
+		g_object_unref(notif_pctx);
+		notif_pctx = NULL;
 	}
 
+	notif_engine_free(notif_engine);
+	notif_engine = NULL;
+
 	if (notif_conn) {
 		dbus_connection_unref(notif_conn);
 		notif_conn = NULL;
@@ -26,9 +26,9 @@ void notif_update_geom(int mon_wx, int mon_wy, int mon_ww, int mon_wh);
  * Call whenever a UI_MSG_THEME message is received. */
 void notif_update_theme(const UiThemePayload *t);
 
-/* Pump D-Bus dispatching.
- * Must be called periodically (e.g. from a GLib idle/timer source, or
- * from the GMainLoop if dbus_connection_setup_with_g_main was used). */
+/* Read and dispatch pending D-Bus messages now.
+ * notif_init() already hooks the connection into the default GLib main
+ * context, so this is only needed when that context is not being run. */
 void notif_dispatch(void);
 
 /* Tear down: close popups, release the D-Bus name, free all state. */
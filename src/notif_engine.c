@@ -0,0 +1,278 @@
+/* AndrathWM - notification admission engine
+ * See LICENSE file for copyright and license details.
+ *
+ * Live popups are few (max_visible), so they sit in an array, oldest
+ * first, and are searched linearly.  Token buckets live in a fixed table
+ * of NOTIF_ENGINE_APPS entries; when it is full the least recently used
+ * bucket is recycled, which at worst hands that app a fresh full bucket.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "notif_engine.h"
+
+#define NOTIF_ENGINE_APPS 64
+
+typedef struct {
+	uint32_t id;
+	char    *app;
+	char    *summary;
+	unsigned count;
+} Popup;
+
+typedef struct {
+	char   *app;
+	double  tokens[2]; /* normal, critical */
+	int64_t last_ms;
+} Bucket;
+
+struct NotifEngine {
+	NotifLimits lim;
+	Popup      *live; /* oldest first */
+	int         nlive;
+	Bucket      apps[NOTIF_ENGINE_APPS];
+	int         napps;
+	uint32_t    seq; /* last id handed out */
+};
+
+NotifEngine *
+notif_engine_new(const NotifLimits *lim)
+{
+	NotifEngine *e;
+
+	if (!lim || lim->max_visible < 1 || lim->rate < 0 || lim->burst < 1)
+		return NULL;
+	e = calloc(1, sizeof(*e));
+	if (!e)
+		return NULL;
+	e->live = calloc((size_t) lim->max_visible, sizeof(Popup));
+	if (!e->live) {
+		free(e);
+		return NULL;
+	}
+	e->lim = *lim;
+	return e;
+}
+
+void
+notif_engine_free(NotifEngine *e)
+{
+	int i;
+
+	if (!e)
+		return;
+	for (i = 0; i < e->nlive; i++) {
+		free(e->live[i].app);
+		free(e->live[i].summary);
+	}
+	for (i = 0; i < e->napps; i++)
+		free(e->apps[i].app);
+	free(e->live);
+	free(e);
+}
+
+static uint32_t
+next_id(NotifEngine *e)
+{
+	if (++e->seq == 0)
+		e->seq = 1; /* wrap, skip 0 */
+	return e->seq;
+}
+
+static int
+find_id(const NotifEngine *e, uint32_t id)
+{
+	int i;
+
+	for (i = 0; i < e->nlive; i++)
+		if (e->live[i].id == id)
+			return i;
+	return -1;
+}
+
+/* Newest live popup of app, and with summary too when it is non-NULL */
+static int
+find_newest(const NotifEngine *e, const char *app, const char *summary)
+{
+	int i;
+
+	for (i = e->nlive - 1; i >= 0; i--)
+		if (strcmp(e->live[i].app, app) == 0 &&
+		    (!summary || strcmp(e->live[i].summary, summary) == 0))
+			return i;
+	return -1;
+}
+
+static void
+remove_at(NotifEngine *e, int i)
+{
+	free(e->live[i].app);
+	free(e->live[i].summary);
+	memmove(&e->live[i], &e->live[i + 1],
+	    (size_t) (e->nlive - i - 1) * sizeof(Popup));
+	e->nlive--;
+}
+
+/* Point popup p at a new summary; keeps the old one if out of memory */
+static void
+set_summary(Popup *p, const char *summary)
+{
+	char *s;
+
+	if (strcmp(p->summary, summary) == 0)
+		return;
+	s = strdup(summary);
+	if (!s)
+		return;
+	free(p->summary);
+	p->summary = s;
+}
+
+static Bucket *
+bucket_for(NotifEngine *e, const char *app, int64_t now_ms)
+{
+	Bucket *b = NULL;
+	char   *name;
+	int     i;
+
+	for (i = 0; i < e->napps; i++)
+		if (strcmp(e->apps[i].app, app) == 0)
+			return &e->apps[i];
+
+	name = strdup(app);
+	if (!name)
+		return NULL;
+	if (e->napps < NOTIF_ENGINE_APPS) {
+		b = &e->apps[e->napps++];
+	} else {
+		b = &e->apps[0];
+		for (i = 1; i < e->napps; i++)
+			if (e->apps[i].last_ms < b->last_ms)
+				b = &e->apps[i];
+		free(b->app);
+	}
+	b->app       = name;
+	b->tokens[0] = b->tokens[1] = e->lim.burst;
+	b->last_ms   = now_ms;
+	return b;
+}
+
+/* Take one token from app's normal or critical bucket after refilling
+ * both for the time that passed.  Returns 0 if the app is over its rate. */
+static int
+bucket_take(NotifEngine *e, const char *app, int critical, int64_t now_ms)
+{
+	Bucket *b = bucket_for(e, app, now_ms);
+	double *t;
+	int     k;
+
+	if (!b)
+		return 1; /* no memory to track it: do not limit */
+	if (now_ms > b->last_ms) {
+		for (k = 0; k < 2; k++) {
+			b->tokens[k] +=
+			    (double) (now_ms - b->last_ms) * e->lim.rate / 1000.0;
+			if (b->tokens[k] > e->lim.burst)
+				b->tokens[k] = e->lim.burst;
+		}
+	}
+	b->last_ms = now_ms;
+	t          = &b->tokens[critical ? 1 : 0];
+	if (*t < 1.0)
+		return 0;
+	*t -= 1.0;
+	return 1;
+}
+
+NotifVerdict
+notif_engine_submit(NotifEngine *e, const char *app, const char *summary,
+    uint32_t replaces_id, int critical, int64_t now_ms)
+{
+	NotifVerdict v = { NOTIF_DROP, 0, 0, 0 };
+	Popup       *p;
+	int          i;
+
+	if (!app)
+		app = "";
+	if (!summary)
+		summary = "";
+
+	/* 1. Explicit replacement of a live popup */
+	if (replaces_id && (i = find_id(e, replaces_id)) >= 0) {
+		p = &e->live[i];
+		set_summary(p, summary);
+		v.action = NOTIF_UPDATE;
+		v.id     = p->id;
+		v.count  = p->count;
+		return v;
+	}
+
+	/* 2. Same app and summary as a live popup: absorb */
+	if ((i = find_newest(e, app, summary)) >= 0) {
+		p = &e->live[i];
+		p->count++;
+		v.action = NOTIF_UPDATE;
+		v.id     = p->id;
+		v.count  = p->count;
+		return v;
+	}
+
+	/* 3. Over the app's rate: fold into its newest popup, or drop.  A
+	 * critical one with nowhere to fold is shown all the same; the next
+	 * then has a popup to fold into, so windows stay bounded. */
+	if (!bucket_take(e, app, critical, now_ms)) {
+		if ((i = find_newest(e, app, NULL)) >= 0) {
+			p = &e->live[i];
+			p->count++;
+			set_summary(p, summary);
+			v.action = NOTIF_UPDATE;
+			v.id     = p->id;
+			v.count  = p->count;
+			return v;
+		}
+		if (!critical) {
+			v.id = next_id(e);
+			return v;
+		}
+	}
+
+	/* 4. New popup, evicting the oldest if the stack is full */
+	v.id = next_id(e);
+	{
+		char *a = strdup(app), *s = strdup(summary);
+
+		if (!a || !s) {
+			free(a);
+			free(s);
+			return v; /* NOTIF_DROP */
+		}
+		if (e->nlive >= e->lim.max_visible) {
+			v.evict = e->live[0].id;
+			remove_at(e, 0);
+		}
+		p          = &e->live[e->nlive++];
+		p->id      = v.id;
+		p->app     = a;
+		p->summary = s;
+		p->count   = 1;
+	}
+	v.action = NOTIF_SHOW;
+	v.count  = 1;
+	return v;
+}
+
+void
+notif_engine_close(NotifEngine *e, uint32_t id)
+{
+	int i;
+
+	if (e && id && (i = find_id(e, id)) >= 0)
+		remove_at(e, i);
+}
+
+int
+notif_engine_live(const NotifEngine *e)
+{
+	return e ? e->nlive : 0;
+}
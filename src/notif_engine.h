@@ -0,0 +1,63 @@
+/* AndrathWM - notification admission engine
+ * See LICENSE file for copyright and license details.
+ *
+ * Decides what each incoming Notify does to the popup stack, so that the
+ * number of popups (X windows) and redraws stays bounded whatever rate
+ * notifications arrive at.  Pure C (no GTK, no D-Bus), so it is linked into
+ * awm-ui, the unit tests and the stress test alike.
+ *
+ * Rules, first match wins:
+ *   1. replaces_id naming a live popup updates that popup in place.
+ *   2. A live popup with the same (app_name, summary) absorbs the
+ *      notification: the popup shows the newest body and a count.
+ *   3. New popups are paid for from a per-app token bucket (rate per
+ *      second, burst capacity); critical notifications have a bucket of
+ *      their own.  An app out of tokens has the notification folded into
+ *      its newest live popup, or dropped when it has none; critical ones
+ *      are shown then instead.
+ *   4. A new popup beyond max_visible evicts the oldest one.
+ */
+
+#ifndef NOTIF_ENGINE_H
+#define NOTIF_ENGINE_H
+
+#include <stdint.h>
+
+typedef struct {
+	int    max_visible; /* live popups at most */
+	double rate;        /* new popups per second, per app */
+	double burst;       /* token bucket capacity, per app */
+} NotifLimits;
+
+typedef enum {
+	NOTIF_SHOW,   /* create popup id, after closing evict if non-zero */
+	NOTIF_UPDATE, /* replace popup id's content; count is its new count */
+	NOTIF_DROP,   /* rate-limited with nowhere to fold; id is spent */
+} NotifAction;
+
+typedef struct {
+	NotifAction action;
+	uint32_t    id;    /* popup to create or update; reply with it */
+	uint32_t    evict; /* NOTIF_SHOW: popup to close first, or 0 */
+	unsigned    count; /* notifications the popup now stands for */
+} NotifVerdict;
+
+typedef struct NotifEngine NotifEngine;
+
+/* Returns NULL on bad limits or no memory. */
+NotifEngine *notif_engine_new(const NotifLimits *lim);
+void         notif_engine_free(NotifEngine *e);
+
+/* Admit one notification.  app and summary may be NULL (treated as "").
+ * now_ms is any monotonic clock in milliseconds. */
+NotifVerdict notif_engine_submit(NotifEngine *e, const char *app,
+    const char *summary, uint32_t replaces_id, int critical, int64_t now_ms);
+
+/* Popup id is gone (expired, dismissed or closed by its sender).
+ * Unknown ids are ignored. */
+void notif_engine_close(NotifEngine *e, uint32_t id);
+
+/* Number of live popups */
+int notif_engine_live(const NotifEngine *e);
+
+#endif /* NOTIF_ENGINE_H */
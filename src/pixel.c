@@ -0,0 +1,417 @@
+/* AndrathWM - pixel format conversion
+ * See LICENSE file for copyright and license details. */
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pixel.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PIXEL_X86 1
+#include <immintrin.h>
+#define TARGET(isa) __attribute__((target(isa)))
+#endif
+
+/* Largest image pixel_downscale_box() takes: keeps its 32-bit channel sums
+ * (pixels * 255) from overflowing */
+#define PIXEL_BOX_MAX_AREA (1u << 24)
+
+typedef struct {
+	const char *name;
+	/* n pixels of a 4-byte fmt to premultiplied ARGB32 */
+	void (*convert)(
+	    uint32_t *dst, const uint8_t *src, size_t n, PixelFormat fmt);
+	/* acc[4 * i + c] += byte c (in memory order) of src[i], i < n */
+	void (*vsum)(uint32_t *acc, const uint32_t *src, size_t n);
+} PixelImpl;
+
+/* -------------------------------------------------------------------------
+ * Scalar reference
+ * ---------------------------------------------------------------------- */
+
+/* round(c * a / 255) for the three colour channels at once, no division */
+static inline uint32_t
+premultiply(uint32_t p)
+{
+	uint32_t a  = p >> 24;
+	uint32_t rb = (p & 0xff00ff) * a + 0x800080;
+	uint32_t g  = (p & 0x00ff00) * a + 0x008000;
+
+	rb = ((rb + ((rb >> 8) & 0xff00ff)) >> 8) & 0xff00ff;
+	g  = ((g + ((g >> 8) & 0x00ff00)) >> 8) & 0x00ff00;
+	return (a << 24) | rb | g;
+}
+
+static inline uint32_t
+load_argb32(const uint8_t *s)
+{
+	uint32_t p;
+
+	memcpy(&p, s, sizeof(p));
+	return p;
+}
+
+static inline uint32_t
+load_argb_be(const uint8_t *s)
+{
+	return (uint32_t) s[0] << 24 | (uint32_t) s[1] << 16 |
+	    (uint32_t) s[2] << 8 | s[3];
+}
+
+static inline uint32_t
+load_rgba(const uint8_t *s)
+{
+	return (uint32_t) s[3] << 24 | (uint32_t) s[0] << 16 |
+	    (uint32_t) s[1] << 8 | s[2];
+}
+
+static inline uint32_t
+load_rgb(const uint8_t *s)
+{
+	return 0xff000000u | (uint32_t) s[0] << 16 | (uint32_t) s[1] << 8 |
+	    s[2];
+}
+
+static void
+convert_scalar(uint32_t *dst, const uint8_t *src, size_t n, PixelFormat fmt)
+{
+	size_t i;
+
+	switch (fmt) {
+	case PIXEL_ARGB32:
+		for (i = 0; i < n; i++)
+			dst[i] = premultiply(load_argb32(src + 4 * i));
+		break;
+	case PIXEL_ARGB_BE:
+		for (i = 0; i < n; i++)
+			dst[i] = premultiply(load_argb_be(src + 4 * i));
+		break;
+	case PIXEL_RGBA:
+		for (i = 0; i < n; i++)
+			dst[i] = premultiply(load_rgba(src + 4 * i));
+		break;
+	case PIXEL_RGB:
+		for (i = 0; i < n; i++)
+			dst[i] = load_rgb(src + 3 * i);
+		break;
+	}
+}
+
+static void
+vsum_scalar(uint32_t *acc, const uint32_t *src, size_t n)
+{
+	const uint8_t *s = (const uint8_t *) src;
+
+	for (size_t i = 0; i < 4 * n; i++)
+		acc[i] += s[i];
+}
+
+static const PixelImpl impl_scalar = { "scalar", convert_scalar,
+	vsum_scalar };
+
+/* -------------------------------------------------------------------------
+ * SSE2
+ * ---------------------------------------------------------------------- */
+
+#ifdef PIXEL_X86
+
+/* round(c * a / 255) in each 16-bit lane */
+TARGET("sse2")
+static inline __m128i
+mul255_sse2(__m128i c, __m128i a)
+{
+	__m128i t = _mm_add_epi16(_mm_mullo_epi16(c, a), _mm_set1_epi16(128));
+
+	return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+/* premultiply four straight-alpha ARGB32 words */
+TARGET("sse2")
+static inline __m128i
+premultiply_sse2(__m128i x)
+{
+	const __m128i zero  = _mm_setzero_si128();
+	const __m128i amask = _mm_set1_epi32((int) 0xff000000u);
+	__m128i       lo    = _mm_unpacklo_epi8(x, zero);
+	__m128i       hi    = _mm_unpackhi_epi8(x, zero);
+	__m128i       alo, ahi;
+
+	alo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(lo, 0xff), 0xff);
+	ahi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(hi, 0xff), 0xff);
+	lo  = _mm_packus_epi16(mul255_sse2(lo, alo), mul255_sse2(hi, ahi));
+	/* alpha itself is kept, not multiplied by itself */
+	return _mm_or_si128(_mm_andnot_si128(amask, lo), _mm_and_si128(amask, x));
+}
+
+/* reorder four loaded words to ARGB32: SSE2 has no byte shuffle */
+TARGET("sse2")
+static inline __m128i
+swizzle_sse2(__m128i x, PixelFormat fmt)
+{
+	const __m128i m00ff = _mm_set1_epi32(0x000000ff);
+	const __m128i mff00 = _mm_set1_epi32((int) 0xff00ff00u);
+	const __m128i m0ff0 = _mm_set1_epi32(0x00ff0000);
+	const __m128i m00f0 = _mm_set1_epi32(0x0000ff00);
+
+	switch (fmt) {
+	case PIXEL_ARGB_BE: /* byte swap */
+		return _mm_or_si128(
+		    _mm_or_si128(_mm_srli_epi32(x, 24), _mm_slli_epi32(x, 24)),
+		    _mm_or_si128(_mm_and_si128(_mm_srli_epi32(x, 8), m00f0),
+		        _mm_and_si128(_mm_slli_epi32(x, 8), m0ff0)));
+	case PIXEL_RGBA: /* swap bytes 0 and 2 */
+		return _mm_or_si128(_mm_and_si128(x, mff00),
+		    _mm_or_si128(_mm_and_si128(_mm_srli_epi32(x, 16), m00ff),
+		        _mm_and_si128(_mm_slli_epi32(x, 16), m0ff0)));
+	default:
+		return x;
+	}
+}
+
+TARGET("sse2")
+static void
+convert_sse2(uint32_t *dst, const uint8_t *src, size_t n, PixelFormat fmt)
+{
+	size_t i = 0;
+
+	for (; i + 4 <= n; i += 4) {
+		__m128i x = _mm_loadu_si128((const __m128i *) (src + 4 * i));
+		_mm_storeu_si128(
+		    (__m128i *) (dst + i), premultiply_sse2(swizzle_sse2(x, fmt)));
+	}
+	convert_scalar(dst + i, src + 4 * i, n - i, fmt);
+}
+
+TARGET("sse2")
+static void
+vsum_sse2(uint32_t *acc, const uint32_t *src, size_t n)
+{
+	const __m128i zero = _mm_setzero_si128();
+	size_t        i    = 0;
+
+	for (; i + 4 <= n; i += 4) {
+		__m128i  x  = _mm_loadu_si128((const __m128i *) (src + i));
+		__m128i  lo = _mm_unpacklo_epi8(x, zero);
+		__m128i  hi = _mm_unpackhi_epi8(x, zero);
+		__m128i *a  = (__m128i *) (acc + 4 * i);
+		_mm_storeu_si128(a + 0, _mm_add_epi32(_mm_loadu_si128(a + 0),
+		                            _mm_unpacklo_epi16(lo, zero)));
+		_mm_storeu_si128(a + 1, _mm_add_epi32(_mm_loadu_si128(a + 1),
+		                            _mm_unpackhi_epi16(lo, zero)));
+		_mm_storeu_si128(a + 2, _mm_add_epi32(_mm_loadu_si128(a + 2),
+		                            _mm_unpacklo_epi16(hi, zero)));
+		_mm_storeu_si128(a + 3, _mm_add_epi32(_mm_loadu_si128(a + 3),
+		                            _mm_unpackhi_epi16(hi, zero)));
+	}
+	vsum_scalar(acc + 4 * i, src + i, n - i);
+}
+
+static const PixelImpl impl_sse2 = { "sse2", convert_sse2, vsum_sse2 };
+
+/* -------------------------------------------------------------------------
+ * AVX2
+ * ---------------------------------------------------------------------- */
+
+TARGET("avx2")
+static inline __m256i
+mul255_avx2(__m256i c, __m256i a)
+{
+	__m256i t =
+	    _mm256_add_epi16(_mm256_mullo_epi16(c, a), _mm256_set1_epi16(128));
+
+	return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+
+/* as premultiply_sse2(), eight words; unpack and pack stay within each
+ * 128-bit lane, so pixel order is kept */
+TARGET("avx2")
+static inline __m256i
+premultiply_avx2(__m256i x)
+{
+	const __m256i zero  = _mm256_setzero_si256();
+	const __m256i amask = _mm256_set1_epi32((int) 0xff000000u);
+	__m256i       lo    = _mm256_unpacklo_epi8(x, zero);
+	__m256i       hi    = _mm256_unpackhi_epi8(x, zero);
+	__m256i       alo, ahi;
+
+	alo = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(lo, 0xff), 0xff);
+	ahi = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(hi, 0xff), 0xff);
+	lo  = _mm256_packus_epi16(mul255_avx2(lo, alo), mul255_avx2(hi, ahi));
+	return _mm256_or_si256(
+	    _mm256_andnot_si256(amask, lo), _mm256_and_si256(amask, x));
+}
+
+TARGET("avx2")
+static void
+convert_avx2(uint32_t *dst, const uint8_t *src, size_t n, PixelFormat fmt)
+{
+	const __m256i be = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9,
+	    8, 15, 14, 13, 12, 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13,
+	    12);
+	const __m256i rgba = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8,
+	    11, 14, 13, 12, 15, 2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12,
+	    15);
+	size_t i = 0;
+
+	for (; i + 8 <= n; i += 8) {
+		__m256i x = _mm256_loadu_si256((const __m256i *) (src + 4 * i));
+		if (fmt == PIXEL_ARGB_BE)
+			x = _mm256_shuffle_epi8(x, be);
+		else if (fmt == PIXEL_RGBA)
+			x = _mm256_shuffle_epi8(x, rgba);
+		_mm256_storeu_si256((__m256i *) (dst + i), premultiply_avx2(x));
+	}
+	convert_sse2(dst + i, src + 4 * i, n - i, fmt);
+}
+
+TARGET("avx2")
+static void
+vsum_avx2(uint32_t *acc, const uint32_t *src, size_t n)
+{
+	size_t i = 0;
+
+	/* two pixels, eight channels, per step */
+	for (; i + 2 <= n; i += 2) {
+		__m256i *a = (__m256i *) (acc + 4 * i);
+		__m256i  x = _mm256_cvtepu8_epi32(
+		     _mm_loadl_epi64((const __m128i *) (src + i)));
+		_mm256_storeu_si256(a, _mm256_add_epi32(_mm256_loadu_si256(a), x));
+	}
+	vsum_scalar(acc + 4 * i, src + i, n - i);
+}
+
+static const PixelImpl impl_avx2 = { "avx2", convert_avx2, vsum_avx2 };
+
+#endif /* PIXEL_X86 */
+
+/* -------------------------------------------------------------------------
+ * Dispatch
+ * ---------------------------------------------------------------------- */
+
+/* best first */
+static const PixelImpl *const impls[] = {
+#ifdef PIXEL_X86
+	&impl_avx2,
+	&impl_sse2,
+#endif
+	&impl_scalar,
+};
+
+/* chosen on first use; worker threads may race to set the same value */
+static const PixelImpl *_Atomic impl;
+
+static int
+impl_supported(const PixelImpl *p)
+{
+#ifdef PIXEL_X86
+	__builtin_cpu_init();
+	if (p == &impl_avx2)
+		return __builtin_cpu_supports("avx2");
+	if (p == &impl_sse2)
+		return __builtin_cpu_supports("sse2");
+#endif
+	return p == &impl_scalar;
+}
+
+static const PixelImpl *
+impl_get(void)
+{
+	const PixelImpl *p = impl;
+
+	if (!p) {
+		for (size_t i = 0; i < sizeof(impls) / sizeof(impls[0]); i++) {
+			if (impl_supported(impls[i])) {
+				p = impls[i];
+				break;
+			}
+		}
+		impl = p;
+	}
+	return p;
+}
+
+const char *
+pixel_impl(void)
+{
+	return impl_get()->name;
+}
+
+int
+pixel_use(const char *name)
+{
+	for (size_t i = 0; i < sizeof(impls) / sizeof(impls[0]); i++) {
+		if (strcmp(impls[i]->name, name) == 0 && impl_supported(impls[i])) {
+			impl = impls[i];
+			return 0;
+		}
+	}
+	return -1;
+}
+
+/* -------------------------------------------------------------------------
+ * Conversion and scaling
+ * ---------------------------------------------------------------------- */
+
+int
+pixel_format_bpp(PixelFormat fmt)
+{
+	return fmt == PIXEL_RGB ? 3 : 4;
+}
+
+void
+pixel_to_argb32(void *dst, size_t dst_stride, const void *src,
+    size_t src_stride, int w, int h, PixelFormat fmt)
+{
+	const PixelImpl *p = fmt == PIXEL_RGB ? &impl_scalar : impl_get();
+
+	for (int y = 0; y < h; y++)
+		p->convert((uint32_t *) ((uint8_t *) dst + (size_t) y * dst_stride),
+		    (const uint8_t *) src + (size_t) y * src_stride, (size_t) w, fmt);
+}
+
+int
+pixel_downscale_box(void *dst, size_t dst_stride, int dw, int dh,
+    const void *src, size_t src_stride, int sw, int sh)
+{
+	const PixelImpl *p = impl_get();
+	uint32_t        *acc;
+
+	if (dw <= 0 || dh <= 0 || dw > sw || dh > sh ||
+	    (uint64_t) sw * (uint64_t) sh > PIXEL_BOX_MAX_AREA)
+		return -1;
+	/* per source column, per channel: the sum down the current band */
+	if (!(acc = malloc((size_t) sw * 4 * sizeof(*acc))))
+		return -1;
+
+	for (int y = 0; y < dh; y++) {
+		int       y0  = (int) ((int64_t) y * sh / dh);
+		int       y1  = (int) ((int64_t) (y + 1) * sh / dh);
+		uint32_t *out =
+		    (uint32_t *) ((uint8_t *) dst + (size_t) y * dst_stride);
+
+		memset(acc, 0, (size_t) sw * 4 * sizeof(*acc));
+		for (int sy = y0; sy < y1; sy++)
+			p->vsum(acc,
+			    (const uint32_t *) ((const uint8_t *) src +
+			        (size_t) sy * src_stride),
+			    (size_t) sw);
+
+		for (int x = 0; x < dw; x++) {
+			int      x0 = (int) ((int64_t) x * sw / dw);
+			int      x1 = (int) ((int64_t) (x + 1) * sw / dw);
+			uint32_t n  = (uint32_t) ((y1 - y0) * (x1 - x0));
+			uint32_t s[4] = { 0, 0, 0, 0 };
+			uint8_t  px[4];
+
+			for (int sx = x0; sx < x1; sx++)
+				for (int c = 0; c < 4; c++)
+					s[c] += acc[4 * sx + c];
+			for (int c = 0; c < 4; c++)
+				px[c] = (uint8_t) ((s[c] + n / 2) / n);
+			memcpy(&out[x], px, sizeof(px));
+		}
+	}
+	free(acc);
+	return 0;
+}
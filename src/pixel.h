@@ -0,0 +1,49 @@
+/* AndrathWM - pixel format conversion
+ * See LICENSE file for copyright and license details.
+ *
+ * Conversion of the pixel layouts icons arrive in (_NET_WM_ICON, SNI
+ * IconPixmap, GdkPixbuf, notification image-data) to cairo's
+ * CAIRO_FORMAT_ARGB32: native-endian 0xAARRGGBB words with premultiplied
+ * alpha.  Colour channels become round(c * a / 255) on every path.
+ *
+ * The hot loops have SSE2 and AVX2 versions chosen at first use by CPU
+ * features, and a portable scalar version that is also the reference the
+ * tests check them against.  Pure C (no cairo, no GLib), so it is linked
+ * into awm, awm-ui and the unit tests alike.
+ */
+
+#ifndef PIXEL_H
+#define PIXEL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum {
+	PIXEL_ARGB32, /* native-endian 0xAARRGGBB words (_NET_WM_ICON) */
+	PIXEL_ARGB_BE, /* bytes A, R, G, B (SNI IconPixmap) */
+	PIXEL_RGBA,    /* bytes R, G, B, A (GdkPixbuf, image-data) */
+	PIXEL_RGB,     /* bytes R, G, B, opaque */
+} PixelFormat;
+
+/* Bytes per pixel of fmt */
+int pixel_format_bpp(PixelFormat fmt);
+
+/* Convert a w x h image of straight-alpha fmt pixels, src_stride bytes
+ * per row, to premultiplied ARGB32 at dst, dst_stride bytes per row. */
+void pixel_to_argb32(void *dst, size_t dst_stride, const void *src,
+    size_t src_stride, int w, int h, PixelFormat fmt);
+
+/* Shrink a premultiplied ARGB32 sw x sh image to dw x dh (dw <= sw and
+ * dh <= sh) by averaging the source pixels under each destination pixel.
+ * Strides are in bytes.  Returns 0, or -1 on bad sizes or no memory. */
+int pixel_downscale_box(void *dst, size_t dst_stride, int dw, int dh,
+    const void *src, size_t src_stride, int sw, int sh);
+
+/* Name of the implementation in use: "avx2", "sse2" or "scalar" */
+const char *pixel_impl(void);
+
+/* Use the named implementation from now on (tests and benchmarks).
+ * Returns 0, or -1 if it is unknown or this CPU cannot run it. */
+int pixel_use(const char *name);
+
+#endif /* PIXEL_H */
@@ -38,10 +38,6 @@
 #include <gtk/gtk.h>
 #include <gdk/gdkx.h>
 
-#ifndef MSG_NOSIGNAL
-#define MSG_NOSIGNAL 0
-#endif
-
 #include "log.h"
 #include "preview.h"
 #include "ui_proto.h"
@@ -483,18 +479,12 @@ on_card_click(GtkWidget *widget, GdkEventButton *ev, gpointer data)
 {
 	PreviewCard          *c = (PreviewCard *) data;
 	UiPreviewFocusPayload fp;
-	uint8_t      buf[sizeof(UiMsgHeader) + sizeof(UiPreviewFocusPayload)];
-	UiMsgHeader *hdr = (UiMsgHeader *) buf;
 	(void) widget;
 	(void) ev;
 
-	fp.xwin          = c->xwin;
-	hdr->type        = (uint32_t) UI_MSG_PREVIEW_FOCUS;
-	hdr->payload_len = sizeof(fp);
-	memcpy(buf + sizeof(UiMsgHeader), &fp, sizeof(fp));
-
+	fp.xwin = c->xwin;
 	if (pv_ui_fd >= 0)
-		send(pv_ui_fd, buf, sizeof(buf), MSG_NOSIGNAL);
+		ui_msg_send_preview_focus(pv_ui_fd, &fp);
 
 	preview_hide();
 	return TRUE;
@@ -507,27 +497,31 @@ on_card_click(GtkWidget *widget, GdkEventButton *ev, gpointer data)
 static void
 pv_send_done(void)
 {
-	UiPreviewDonePayload dp;
-	uint8_t              buf[sizeof(UiMsgHeader) + sizeof(dp)];
-	UiMsgHeader         *hdr = (UiMsgHeader *) buf;
+	UiPreviewDonePayload dp = { 0 };
+	uint32_t             xids[256];
+	uint32_t             n = 0, max;
 	unsigned int         i;
 
 	if (pv_ui_fd < 0)
 		return;
 
-	memset(&dp, 0, sizeof(dp));
-	dp.count = 0;
+	/* as many messages as it takes: an XID not returned is a pixmap awm
+	 * never frees */
+	max = ui_msg_max_elems(UI_MSG_PREVIEW_DONE);
+	if (max > sizeof(xids) / sizeof(xids[0]))
+		max = sizeof(xids) / sizeof(xids[0]);
 	for (i = 0; i < pv_ncard; i++) {
-		if (pv_cards[i].pixmap_xid && dp.count < 32) {
-			dp.xids[dp.count++]    = pv_cards[i].pixmap_xid;
-			pv_cards[i].pixmap_xid = 0;
+		if (!pv_cards[i].pixmap_xid)
+			continue;
+		xids[n++]              = pv_cards[i].pixmap_xid;
+		pv_cards[i].pixmap_xid = 0;
+		if (n == max) {
+			ui_msg_send_preview_done(pv_ui_fd, &dp, xids, n);
+			n = 0;
 		}
 	}
-
-	hdr->type        = (uint32_t) UI_MSG_PREVIEW_DONE;
-	hdr->payload_len = sizeof(dp);
-	memcpy(buf + sizeof(UiMsgHeader), &dp, sizeof(dp));
-	send(pv_ui_fd, buf, sizeof(buf), MSG_NOSIGNAL);
+	if (n)
+		ui_msg_send_preview_done(pv_ui_fd, &dp, xids, n);
 }
 
 /* -------------------------------------------------------------------------
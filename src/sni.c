@@ -55,6 +55,33 @@ extern void sni_schedule_reconnect(void);
 /* Maximum SNI items to prevent memory exhaustion from malicious apps */
 #define SNI_MAX_ITEMS 64
 
+/* Property groups a signal can make stale.  Each is refreshed with targeted
+ * Properties.Get calls rather than a GetAll of the whole item. */
+#define SNI_DIRTY_ICON (1 << 0)   /* IconName, IconPixmap */
+#define SNI_DIRTY_STATUS (1 << 1) /* Status */
+#define SNI_DIRTY_MENU (1 << 2)   /* Menu, ItemIsMenu */
+#define SNI_DIRTY_ALL (SNI_DIRTY_ICON | SNI_DIRTY_STATUS | SNI_DIRTY_MENU)
+/* Icon data changed in place (PropertiesChanged values); re-check the hash */
+#define SNI_DIRTY_RENDER (1 << 3)
+
+/* Signals for one item arriving within this window share a single refresh.
+ * Apps commonly fire NewIcon + NewStatus + PropertiesChanged back to back. */
+#define SNI_REFRESH_DELAY_MS 50
+/* Windows a refresh waits for an in-flight GetAll before giving up on it */
+#define SNI_REFRESH_MAX_WAITS 20
+
+/* Which group each property we consume belongs to */
+static const struct {
+	const char *name;
+	int         group;
+} sni_props[] = {
+	{ "IconName", SNI_DIRTY_ICON },
+	{ "IconPixmap", SNI_DIRTY_ICON },
+	{ "Status", SNI_DIRTY_STATUS },
+	{ "Menu", SNI_DIRTY_MENU },
+	{ "ItemIsMenu", SNI_DIRTY_MENU },
+};
+
 /* Context struct for async GetAll calls — guards against use-after-free when
  * an SNIItem is removed while a GetAll reply is still in flight. */
 typedef struct {
@@ -62,6 +89,14 @@ typedef struct {
 	uint32_t generation;
 } SNIGetAllCtx;
 
+/* Context for a targeted Properties.Get during a refresh */
+typedef struct {
+	SNIItem    *item;
+	uint32_t    generation;
+	const char *property; /* entry of sni_props[] */
+	int         group;
+} SNIGetCtx;
+
 /* Global state */
 SNIWatcher            *sni_watcher    = NULL;
 static DBusDispatcher *sni_dispatcher = NULL;
@@ -96,6 +131,14 @@ static SNIItem *sni_current_menu_item = NULL;
  * (e.g. in launcher_show) to return GDK_GRAB_STATUS_INVALID_TIME. */
 static int sni_menu_pending = 0;
 
+/* Right-click on an item whose layout is not cached yet: where to pop the
+ * menu up once GetLayout answers.  item is NULL when nothing waits. */
+static struct {
+	SNIItem        *item;
+	int             x, y;
+	xcb_timestamp_t event_time;
+} sni_menu_wait;
+
 /* Forward declarations for internal functions */
 static void sni_menu_item_activated(int item_id, SNIItem *item);
 
@@ -136,8 +179,18 @@ static DBusHandlerResult sni_handle_item_signal(
     DBusConnection *conn, DBusMessage *msg, void *data);
 static DBusHandlerResult sni_handle_name_owner_changed(
     DBusConnection *conn, DBusMessage *msg, void *data);
+static DBusHandlerResult sni_handle_layout_updated(
+    DBusConnection *conn, DBusMessage *msg, void *data);
+static DBusHandlerResult sni_handle_menu_props_updated(
+    DBusConnection *conn, DBusMessage *msg, void *data);
 
-static void sni_fetch_item_properties(SNIItem *item);
+static SNIItem *sni_find_item_for_signal(DBusMessage *msg);
+static void     sni_fetch_item_properties(SNIItem *item);
+static int      sni_apply_property(
+         SNIItem *item, const char *key, DBusMessageIter *variant);
+static int      sni_property_group(const char *key);
+static void     sni_mark_dirty(SNIItem *item, int groups);
+static void     sni_menu_invalidate(SNIItem *item);
 
 /* ============================================================================
  * Initialization and Cleanup
@@ -200,6 +253,10 @@ sni_init(xcb_connection_t *xc_in, xcb_connection_t *cairo_xcb,
 	    "NewToolTip", sni_handle_item_signal, NULL);
 	dbus_dispatcher_register_signal(sni_dispatcher, "org.freedesktop.DBus",
 	    "NameOwnerChanged", sni_handle_name_owner_changed, NULL);
+	dbus_dispatcher_register_signal(sni_dispatcher, DBUSMENU_INTERFACE,
+	    "LayoutUpdated", sni_handle_layout_updated, NULL);
+	dbus_dispatcher_register_signal(sni_dispatcher, DBUSMENU_INTERFACE,
+	    "ItemsPropertiesUpdated", sni_handle_menu_props_updated, NULL);
 
 	/* Connect to session bus and register as StatusNotifierWatcher */
 	sni_watcher->conn = dbus_helper_session_connect_dispatcher(
@@ -212,6 +269,11 @@ sni_init(xcb_connection_t *xc_in, xcb_connection_t *cairo_xcb,
 		return 0;
 	}
 
+	/* Item indexes: by registered service name, and by the (sender, object
+	 * path) pair every item signal carries.  Keys are owned by the items. */
+	sni_watcher->by_service = g_hash_table_new(g_str_hash, g_str_equal);
+	sni_watcher->by_route   = g_hash_table_new(g_str_hash, g_str_equal);
+
 	/* Subscribe to NameOwnerChanged signals to detect when apps exit */
 	dbus_error_init(&err);
 	dbus_bus_add_match(sni_watcher->conn,
@@ -311,6 +373,11 @@ sni_cleanup(void)
 		sni_dispatcher = NULL;
 	}
 
+	if (sni_watcher->by_service)
+		g_hash_table_destroy(sni_watcher->by_service);
+	if (sni_watcher->by_route)
+		g_hash_table_destroy(sni_watcher->by_route);
+
 	free(sni_watcher->unique_name);
 	free(sni_watcher);
 	sni_watcher = NULL;
@@ -446,7 +513,7 @@ sni_handle_register_item(DBusConnection *conn, DBusMessage *msg, void *data)
 		dbus_helper_send_reply(conn, msg);
 
 		/* Now add the item (which will make D-Bus calls) */
-		sni_add_item(service, item_path);
+		sni_add_item(service, dbus_message_get_sender(msg), item_path);
 
 		/* Emit signal */
 		DBusMessage *signal = dbus_helper_create_signal(WATCHER_OBJECT_PATH,
@@ -541,32 +608,82 @@ sni_handle_properties_get(DBusConnection *conn, DBusMessage *msg, void *data)
 	return DBUS_HANDLER_RESULT_HANDLED;
 }
 
+/* PropertiesChanged carries the new values of changed properties: apply
+ * them in place.  Invalidated ones are only named, so their group is marked
+ * for a targeted Get.  Either way the render waits for the refresh timer. */
 static DBusHandlerResult
 sni_handle_properties_changed(
     DBusConnection *conn, DBusMessage *msg, void *data)
 {
-	const char *sender = dbus_message_get_sender(msg);
-	SNIItem    *item   = sni_find_item(sender);
+	SNIItem        *item = sni_find_item_for_signal(msg);
+	DBusMessageIter args, dict, entry, variant;
+	const char     *iface, *key;
+	int             dirty = 0;
 
-	if (item) {
-		/* Properties changed, update the item */
-		sni_update_item(item);
+	if (!item)
+		return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+
+	if (!dbus_message_iter_init(msg, &args) ||
+	    dbus_message_iter_get_arg_type(&args) != DBUS_TYPE_STRING)
 		return DBUS_HANDLER_RESULT_HANDLED;
+	dbus_message_iter_get_basic(&args, &iface);
+	if (strcmp(iface, ITEM_INTERFACE) != 0)
+		return DBUS_HANDLER_RESULT_HANDLED;
+
+	/* changed_properties: a{sv} */
+	if (dbus_message_iter_next(&args) &&
+	    dbus_message_iter_get_arg_type(&args) == DBUS_TYPE_ARRAY) {
+		dbus_message_iter_recurse(&args, &dict);
+		while (dbus_message_iter_get_arg_type(&dict) ==
+		    DBUS_TYPE_DICT_ENTRY) {
+			dbus_message_iter_recurse(&dict, &entry);
+			if (dbus_message_iter_get_arg_type(&entry) == DBUS_TYPE_STRING) {
+				dbus_message_iter_get_basic(&entry, &key);
+				dbus_message_iter_next(&entry);
+				if (dbus_message_iter_get_arg_type(&entry) ==
+				    DBUS_TYPE_VARIANT) {
+					dbus_message_iter_recurse(&entry, &variant);
+					if (sni_apply_property(item, key, &variant) ==
+					    SNI_DIRTY_ICON)
+						dirty |= SNI_DIRTY_RENDER;
+				}
+			}
+			dbus_message_iter_next(&dict);
+		}
 	}
-	return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+
+	/* invalidated_properties: as */
+	if (dbus_message_iter_next(&args) &&
+	    dbus_message_iter_get_arg_type(&args) == DBUS_TYPE_ARRAY) {
+		dbus_message_iter_recurse(&args, &dict);
+		while (dbus_message_iter_get_arg_type(&dict) == DBUS_TYPE_STRING) {
+			dbus_message_iter_get_basic(&dict, &key);
+			dirty |= sni_property_group(key);
+			dbus_message_iter_next(&dict);
+		}
+	}
+
+	sni_mark_dirty(item, dirty);
+	return DBUS_HANDLER_RESULT_HANDLED;
 }
 
+/* NewIcon / NewAttentionIcon / NewStatus / NewToolTip carry no data */
 static DBusHandlerResult
 sni_handle_item_signal(DBusConnection *conn, DBusMessage *msg, void *data)
 {
-	const char *sender = dbus_message_get_sender(msg);
-	SNIItem    *item   = sni_find_item(sender);
+	const char *member = dbus_message_get_member(msg);
+	SNIItem    *item   = sni_find_item_for_signal(msg);
 
-	if (item) {
-		sni_update_item(item);
-		return DBUS_HANDLER_RESULT_HANDLED;
-	}
-	return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+	if (!item)
+		return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+
+	if (strcmp(member, "NewIcon") == 0 ||
+	    strcmp(member, "NewAttentionIcon") == 0)
+		sni_mark_dirty(item, SNI_DIRTY_ICON);
+	else if (strcmp(member, "NewStatus") == 0)
+		sni_mark_dirty(item, SNI_DIRTY_STATUS);
+	/* NewToolTip: tooltips are not shown, nothing to refresh */
+	return DBUS_HANDLER_RESULT_HANDLED;
 }
 
 static DBusHandlerResult
@@ -624,21 +741,47 @@ sni_handle_name_owner_changed(
 SNIItem *
 sni_find_item(const char *service)
 {
-	SNIItem *item;
+	if (!sni_watcher || !sni_watcher->by_service || !service)
+		return NULL;
 
-	if (!sni_watcher || !service)
+	return g_hash_table_lookup(sni_watcher->by_service, service);
+}
+
+/* Look up by the sender's unique bus name and the object path.  Signals
+ * always come from the unique name, even for items registered under a
+ * well-known one, so this is what item signals are routed with. */
+SNIItem *
+sni_find_item_by_route(const char *owner, const char *path)
+{
+	char key[256];
+	int  n;
+
+	if (!sni_watcher || !sni_watcher->by_route || !owner || !path)
 		return NULL;
 
-	for (item = sni_watcher->items; item; item = item->next) {
-		if (item->service && strcmp(item->service, service) == 0)
-			return item;
+	n = snprintf(key, sizeof(key), "%s%s", owner, path);
+	if (n < 0 || (size_t) n >= sizeof(key)) {
+		char    *k = g_strconcat(owner, path, NULL);
+		SNIItem *item = g_hash_table_lookup(sni_watcher->by_route, k);
+		g_free(k);
+		return item;
 	}
+	return g_hash_table_lookup(sni_watcher->by_route, key);
+}
 
-	return NULL;
+/* Item a signal is about: by (sender, path), else by sender as service */
+static SNIItem *
+sni_find_item_for_signal(DBusMessage *msg)
+{
+	const char *sender = dbus_message_get_sender(msg);
+	SNIItem    *item;
+
+	item = sni_find_item_by_route(sender, dbus_message_get_path(msg));
+	return item ? item : sni_find_item(sender);
 }
 
 void
-sni_add_item(const char *service, const char *path)
+sni_add_item(const char *service, const char *owner, const char *path)
 {
 	SNIItem *item;
 
@@ -659,9 +802,14 @@ sni_add_item(const char *service, const char *path)
 		return;
 
 	item->service = strdup(service);
+	item->owner   = strdup(owner ? owner : service);
 	item->path    = strdup(path ? path : "/StatusNotifierItem");
+	item->route   = g_strconcat(item->owner, item->path, NULL);
 	item->status  = SNI_STATUS_PASSIVE;
 
+	g_hash_table_replace(sni_watcher->by_service, item->service, item);
+	g_hash_table_replace(sni_watcher->by_route, item->route, item);
+
 	item->next         = sni_watcher->items;
 	sni_watcher->items = item;
 	sni_watcher->item_count++;
@@ -688,9 +836,20 @@ sni_remove_item(SNIItem *item)
 		}
 	}
 
+	/* Drop index entries that still point here (a later registration of
+	 * the same route may have taken the slot over) */
+	if (sni_watcher->by_service &&
+	    g_hash_table_lookup(sni_watcher->by_service, item->service) == item)
+		g_hash_table_remove(sni_watcher->by_service, item->service);
+	if (sni_watcher->by_route &&
+	    g_hash_table_lookup(sni_watcher->by_route, item->route) == item)
+		g_hash_table_remove(sni_watcher->by_route, item->route);
+
 	/* Clean up item */
 	free(item->service);
+	free(item->owner);
 	free(item->path);
+	g_free(item->route);
 	free(item->icon_name);
 	free(item->menu_path);
 
@@ -705,6 +864,9 @@ sni_remove_item(SNIItem *item)
 		xcb_destroy_window(sni_xc, item->win);
 	}
 
+	if (item->refresh_id)
+		g_source_remove(item->refresh_id);
+
 	item->generation++; /* invalidate any in-flight async ctx */
 
 	/* If a menu was open for this item, clear the global pointer and the
@@ -713,6 +875,10 @@ sni_remove_item(SNIItem *item)
 		sni_current_menu_item = NULL;
 		sni_menu_pending      = 0;
 	}
+	if (sni_menu_wait.item == item) {
+		sni_menu_wait.item = NULL;
+		sni_menu_pending   = 0;
+	}
 
 	free(item);
 }
@@ -758,6 +924,207 @@ sni_get_property_int(const char *service, const char *path,
 	    sni_watcher->conn, service, path, interface, property, value);
 }
 
+/* Check an async ctx against the live item list before touching the item:
+ * the pointer may already be freed, so it is compared, not dereferenced,
+ * until it is found. */
+static int
+sni_item_alive(SNIItem *item, uint32_t generation)
+{
+	SNIItem *p;
+
+	if (!item || !sni_watcher)
+		return 0;
+	for (p = sni_watcher->items; p; p = p->next)
+		if (p == item)
+			return p->generation == generation;
+	return 0;
+}
+
+static int
+sni_property_group(const char *key)
+{
+	size_t i;
+
+	for (i = 0; i < sizeof(sni_props) / sizeof(sni_props[0]); i++)
+		if (strcmp(key, sni_props[i].name) == 0)
+			return sni_props[i].group;
+	return 0;
+}
+
+/* Parse IconPixmap: array of (int32, int32, array of bytes).  Returns the
+ * icons (NULL if there are none) and their number in *count. */
+static SNIIcon *
+sni_parse_icon_pixmap(DBusMessageIter *variant, int *count)
+{
+	DBusMessageIter array_iter, struct_iter, data_iter;
+	int             icon_count = 0;
+	SNIIcon        *icons      = NULL;
+	int             i          = 0;
+
+	*count = 0;
+	if (dbus_message_iter_get_arg_type(variant) != DBUS_TYPE_ARRAY)
+		return NULL;
+
+	/* Count icons first */
+	dbus_message_iter_recurse(variant, &struct_iter);
+	while (dbus_message_iter_get_arg_type(&struct_iter) == DBUS_TYPE_STRUCT) {
+		icon_count++;
+		dbus_message_iter_next(&struct_iter);
+	}
+	if (icon_count == 0)
+		return NULL;
+
+	icons = calloc(icon_count, sizeof(SNIIcon));
+	if (!icons)
+		return NULL;
+
+	dbus_message_iter_recurse(variant, &array_iter);
+	while (dbus_message_iter_get_arg_type(&array_iter) == DBUS_TYPE_STRUCT &&
+	    i < icon_count) {
+		DBusMessageIter inner;
+		dbus_int32_t    width, height;
+
+		dbus_message_iter_recurse(&array_iter, &inner);
+
+		/* Get width */
+		if (dbus_message_iter_get_arg_type(&inner) != DBUS_TYPE_INT32)
+			break;
+		dbus_message_iter_get_basic(&inner, &width);
+		dbus_message_iter_next(&inner);
+
+		/* Get height */
+		if (dbus_message_iter_get_arg_type(&inner) != DBUS_TYPE_INT32)
+			break;
+		dbus_message_iter_get_basic(&inner, &height);
+		dbus_message_iter_next(&inner);
+
+		icons[i].width  = width;
+		icons[i].height = height;
+
+		/* Get pixel data */
+		if (dbus_message_iter_get_arg_type(&inner) == DBUS_TYPE_ARRAY) {
+			int            n_elements = 0;
+			unsigned char *data;
+
+			dbus_message_iter_recurse(&inner, &data_iter);
+			dbus_message_iter_get_fixed_array(&data_iter, &data, &n_elements);
+
+			if (n_elements == width * height * 4) {
+				icons[i].pixels = malloc(n_elements);
+				if (icons[i].pixels)
+					memcpy(icons[i].pixels, data, n_elements);
+			}
+		}
+
+		i++;
+		dbus_message_iter_next(&array_iter);
+	}
+
+	*count = i;
+	return icons;
+}
+
+/* Store one property value (from GetAll, Get or PropertiesChanged) on the
+ * item.  Returns the SNI_DIRTY_* group it belongs to, or 0 if unknown. */
+static int
+sni_apply_property(SNIItem *item, const char *key, DBusMessageIter *variant)
+{
+	if (strcmp(key, "IconName") == 0) {
+		char *val = dbus_iter_get_variant_string(variant);
+		if (val) {
+			free(item->icon_name);
+			item->icon_name = val;
+		}
+	} else if (strcmp(key, "Menu") == 0) {
+		/* Menu can be STRING or OBJECT_PATH */
+		char *val = dbus_iter_get_variant_string(variant);
+		if (val) {
+			int moved = !item->menu_path || strcmp(item->menu_path, val);
+
+			free(item->menu_path);
+			item->menu_path = val;
+			if (moved)
+				sni_menu_invalidate(item);
+		}
+	} else if (strcmp(key, "ItemIsMenu") == 0) {
+		if (dbus_message_iter_get_arg_type(variant) == DBUS_TYPE_BOOLEAN) {
+			dbus_bool_t val;
+			dbus_message_iter_get_basic(variant, &val);
+			item->item_is_menu = val ? 1 : 0;
+		}
+	} else if (strcmp(key, "Status") == 0) {
+		char *val = dbus_iter_get_variant_string(variant);
+		if (val) {
+			if (strcmp(val, "Passive") == 0)
+				item->status = SNI_STATUS_PASSIVE;
+			else if (strcmp(val, "Active") == 0)
+				item->status = SNI_STATUS_ACTIVE;
+			else if (strcmp(val, "NeedsAttention") == 0)
+				item->status = SNI_STATUS_NEEDSATTENTION;
+			free(val);
+		}
+	} else if (strcmp(key, "IconPixmap") == 0) {
+		int      count;
+		SNIIcon *icons = sni_parse_icon_pixmap(variant, &count);
+
+		if (item->icon_pixmap)
+			sni_free_icons(item->icon_pixmap, item->icon_pixmap_count);
+		item->icon_pixmap       = icons;
+		item->icon_pixmap_count = icons ? count : 0;
+		if (icons)
+			awm_debug("SNI: Parsed %d IconPixmap icons for %s", count,
+			    item->service);
+	}
+	return sni_property_group(key);
+}
+
+/* FNV-1a over everything sni_queue_icon_load() draws from, so a refresh
+ * that delivers the same icon again can skip the render. */
+static uint64_t
+sni_icon_hash(const SNIItem *item)
+{
+	uint64_t h = 0xcbf29ce484222325ull;
+	int      i;
+
+#define SNI_HASH(p, n)                                                      \
+	do {                                                                    \
+		const unsigned char *b_ = (const unsigned char *) (p);              \
+		for (size_t k_ = 0; k_ < (size_t) (n); k_++)                        \
+			h = (h ^ b_[k_]) * 0x100000001b3ull;                            \
+	} while (0)
+
+	if (item->icon_name)
+		SNI_HASH(item->icon_name, strlen(item->icon_name) + 1);
+	for (i = 0; i < item->icon_pixmap_count; i++) {
+		const SNIIcon *ic = &item->icon_pixmap[i];
+
+		SNI_HASH(&ic->width, sizeof(ic->width));
+		SNI_HASH(&ic->height, sizeof(ic->height));
+		if (ic->pixels)
+			SNI_HASH(ic->pixels, (size_t) ic->width * ic->height * 4);
+	}
+#undef SNI_HASH
+	return h;
+}
+
+/* Icon data may have changed: redraw only if it actually did */
+static void
+sni_icon_refreshed(SNIItem *item)
+{
+	uint64_t h = sni_icon_hash(item);
+
+	if (item->win && h == item->icon_hash) {
+		awm_debug("SNI: Icon of %s unchanged, not re-rendering",
+		    item->service);
+		return;
+	}
+	item->icon_hash = h;
+	if (item->win)
+		sni_queue_icon_load(item);
+	else
+		sni_render_item(item);
+}
+
 /* Callback for async GetAll properties */
 static void
 sni_properties_received(DBusMessage *reply, void *user_data)
@@ -767,21 +1134,27 @@ sni_properties_received(DBusMessage *reply, void *user_data)
 	DBusMessageIter args, dict_iter, entry, variant;
 	const char     *key;
 
-	/* Always free the context regardless of outcome */
-	if (!ctx) {
+	if (!ctx)
 		return;
-	}
 	item = ctx->item;
 
 	/* Validate: if the item was removed while GetAll was in flight, its
 	 * generation will have been incremented and the pointer is now freed. */
-	if (!item || !reply || item->generation != ctx->generation) {
+	if (!sni_item_alive(item, ctx->generation)) {
 		free(ctx);
 		return;
 	}
 	free(ctx);
 	ctx = NULL; /* prevent accidental use */
 
+	/* Whatever the outcome, this GetAll is over: on failure
+	 * properties_fetched stays 0 and sni_handle_dbus() sends another. */
+	item->properties_fetching = 0;
+	if (!reply) {
+		awm_warn("SNI: GetAll failed for %s", item->service);
+		return;
+	}
+
 	/* Reply is a{sv} - dict of string->variant */
 	if (!dbus_message_iter_init(reply, &args) ||
 	    dbus_message_iter_get_arg_type(&args) != DBUS_TYPE_ARRAY) {
@@ -806,120 +1179,7 @@ sni_properties_received(DBusMessage *reply, void *user_data)
 			goto next_entry;
 		dbus_message_iter_recurse(&entry, &variant);
 
-		/* Parse known properties */
-		if (strcmp(key, "IconName") == 0) {
-			char *val = dbus_iter_get_variant_string(&variant);
-			if (val) {
-				free(item->icon_name);
-				item->icon_name = val;
-			}
-		} else if (strcmp(key, "Menu") == 0) {
-			/* Menu can be STRING or OBJECT_PATH */
-			int type = dbus_message_iter_get_arg_type(&variant);
-			if (type == DBUS_TYPE_STRING || type == DBUS_TYPE_OBJECT_PATH) {
-				const char *val;
-				dbus_message_iter_get_basic(&variant, &val);
-				free(item->menu_path);
-				item->menu_path = strdup(val);
-			}
-		} else if (strcmp(key, "ItemIsMenu") == 0) {
-			if (dbus_message_iter_get_arg_type(&variant) ==
-			    DBUS_TYPE_BOOLEAN) {
-				dbus_bool_t val;
-				dbus_message_iter_get_basic(&variant, &val);
-				item->item_is_menu = val ? 1 : 0;
-			}
-		} else if (strcmp(key, "Status") == 0) {
-			char *val = dbus_iter_get_variant_string(&variant);
-			if (val) {
-				if (strcmp(val, "Passive") == 0)
-					item->status = SNI_STATUS_PASSIVE;
-				else if (strcmp(val, "Active") == 0)
-					item->status = SNI_STATUS_ACTIVE;
-				else if (strcmp(val, "NeedsAttention") == 0)
-					item->status = SNI_STATUS_NEEDSATTENTION;
-				free(val);
-			}
-		} else if (strcmp(key, "IconPixmap") == 0) {
-			/* Parse IconPixmap: array of (int32, int32, array of bytes) */
-			if (dbus_message_iter_get_arg_type(&variant) == DBUS_TYPE_ARRAY) {
-				DBusMessageIter array_iter, struct_iter, data_iter;
-				int             icon_count = 0;
-				SNIIcon        *icons      = NULL;
-
-				/* Count icons first */
-				DBusMessageIter tmp = variant;
-				dbus_message_iter_recurse(&tmp, &struct_iter);
-				while (dbus_message_iter_get_arg_type(&struct_iter) ==
-				    DBUS_TYPE_STRUCT) {
-					icon_count++;
-					dbus_message_iter_next(&struct_iter);
-				}
-
-				if (icon_count > 0) {
-					icons = calloc(icon_count, sizeof(SNIIcon));
-					if (icons) {
-						int i = 0;
-						dbus_message_iter_recurse(&variant, &array_iter);
-						while (dbus_message_iter_get_arg_type(&array_iter) ==
-						        DBUS_TYPE_STRUCT &&
-						    i < icon_count) {
-							DBusMessageIter inner;
-							dbus_int32_t    width, height;
-
-							dbus_message_iter_recurse(&array_iter, &inner);
-
-							/* Get width */
-							if (dbus_message_iter_get_arg_type(&inner) ==
-							    DBUS_TYPE_INT32) {
-								dbus_message_iter_get_basic(&inner, &width);
-								dbus_message_iter_next(&inner);
-							} else {
-								break;
-							}
-
-							/* Get height */
-							if (dbus_message_iter_get_arg_type(&inner) ==
-							    DBUS_TYPE_INT32) {
-								dbus_message_iter_get_basic(&inner, &height);
-								dbus_message_iter_next(&inner);
-							} else {
-								break;
-							}
-
-							icons[i].width  = width;
-							icons[i].height = height;
-
-							/* Get pixel data */
-							if (dbus_message_iter_get_arg_type(&inner) ==
-							    DBUS_TYPE_ARRAY) {
-								dbus_message_iter_recurse(&inner, &data_iter);
-								int            n_elements = 0;
-								unsigned char *data;
-
-								dbus_message_iter_get_fixed_array(
-								    &data_iter, &data, &n_elements);
-
-								if (n_elements == width * height * 4) {
-									icons[i].pixels = malloc(n_elements);
-									if (icons[i].pixels)
-										memcpy(
-										    icons[i].pixels, data, n_elements);
-								}
-							}
-
-							i++;
-							dbus_message_iter_next(&array_iter);
-						}
-
-						item->icon_pixmap       = icons;
-						item->icon_pixmap_count = i;
-						awm_debug("SNI: Parsed %d IconPixmap icons for %s", i,
-						    item->service);
-					}
-				}
-			}
-		}
+		sni_apply_property(item, key, &variant);
 
 	next_entry:
 		dbus_message_iter_next(&dict_iter);
@@ -936,10 +1196,10 @@ sni_properties_received(DBusMessage *reply, void *user_data)
 	    item->icon_name ? item->icon_name : "none");
 
 	/* Mark properties as fetched */
-	item->properties_fetched  = 1;
-	item->properties_fetching = 0;
+	item->properties_fetched = 1;
 
 	/* Render icon now that we have properties */
+	item->icon_hash = sni_icon_hash(item);
 	sni_render_item(item);
 	/* Note: systray will update automatically when window is mapped */
 
@@ -953,6 +1213,109 @@ sni_properties_received(DBusMessage *reply, void *user_data)
 	}
 }
 
+/* Reply to one targeted Get: the value is a single variant */
+static void
+sni_property_received(DBusMessage *reply, void *user_data)
+{
+	SNIGetCtx      *ctx = (SNIGetCtx *) user_data;
+	SNIItem        *item;
+	DBusMessageIter args, variant;
+
+	if (!ctx)
+		return;
+	item = ctx->item;
+	if (!sni_item_alive(item, ctx->generation)) {
+		free(ctx);
+		return;
+	}
+
+	/* An error reply (property not implemented) keeps the old value */
+	if (reply && dbus_message_iter_init(reply, &args) &&
+	    dbus_message_iter_get_arg_type(&args) == DBUS_TYPE_VARIANT) {
+		dbus_message_iter_recurse(&args, &variant);
+		sni_apply_property(item, ctx->property, &variant);
+	}
+
+	/* Once every icon Get of this refresh is back, decide on a render */
+	if (ctx->group == SNI_DIRTY_ICON && --item->icon_gets == 0)
+		sni_icon_refreshed(item);
+	free(ctx);
+}
+
+static int
+sni_get_property_async(SNIItem *item, const char *property, int group)
+{
+	SNIGetCtx *ctx = malloc(sizeof(SNIGetCtx));
+
+	if (!ctx)
+		return 0;
+	ctx->item       = item;
+	ctx->generation = item->generation;
+	ctx->property   = property;
+	ctx->group      = group;
+	if (!dbus_helper_get_property_async(sni_watcher->conn, item->service,
+	        item->path, ITEM_INTERFACE, property, sni_property_received,
+	        ctx)) {
+		free(ctx);
+		return 0;
+	}
+	return 1;
+}
+
+/* Refresh timer: one targeted Get per property of each stale group */
+static gboolean
+sni_refresh_cb(gpointer data)
+{
+	SNIItem *item = (SNIItem *) data;
+	int      dirty;
+	size_t   i;
+
+	/* A GetAll in flight may predate the signals: wait for it first, but
+	 * not for ever if its reply never comes */
+	if (item->properties_fetching &&
+	    ++item->refresh_waits < SNI_REFRESH_MAX_WAITS)
+		return G_SOURCE_CONTINUE;
+
+	item->refresh_waits = 0;
+	item->refresh_id    = 0;
+	dirty            = item->dirty;
+	item->dirty      = 0;
+
+	/* Never fetched (GetAll failed): sni_handle_dbus() retries a GetAll */
+	if (!item->properties_fetched || !sni_watcher || !sni_watcher->conn)
+		return G_SOURCE_REMOVE;
+
+	for (i = 0; i < sizeof(sni_props) / sizeof(sni_props[0]); i++) {
+		if (!(dirty & sni_props[i].group))
+			continue;
+		if (!sni_get_property_async(item, sni_props[i].name,
+		        sni_props[i].group)) {
+			awm_warn("SNI: Failed to request %s of %s", sni_props[i].name,
+			    item->service);
+			continue;
+		}
+		if (sni_props[i].group == SNI_DIRTY_ICON)
+			item->icon_gets++;
+	}
+
+	/* No icon Get outstanding to make the call: make it now */
+	if ((dirty & (SNI_DIRTY_ICON | SNI_DIRTY_RENDER)) && !item->icon_gets)
+		sni_icon_refreshed(item);
+	return G_SOURCE_REMOVE;
+}
+
+/* Record stale groups and start the coalescing window if not running */
+static void
+sni_mark_dirty(SNIItem *item, int groups)
+{
+	if (!groups)
+		return;
+	item->dirty |= groups;
+	if (!item->refresh_id)
+		item->refresh_id =
+		    g_timeout_add(SNI_REFRESH_DELAY_MS, sni_refresh_cb, item);
+}
+
 static void
 sni_fetch_item_properties(SNIItem *item)
 {
@@ -984,9 +1347,8 @@ sni_fetch_item_properties(SNIItem *item)
 	item->properties_fetching = 1;
 
 	/* Subscribe to property changes — add match rules only once per item.
-	 * sni_fetch_item_properties() is also called from sni_update_item()
-	 * (on every NewIcon/PropertiesChanged signal), so without the guard
-	 * the match rule table grows unboundedly. */
+	 * sni_handle_dbus() calls this again whenever a GetAll failed, so
+	 * without the guard the match rule table grows unboundedly. */
 	if (!item->matches_added) {
 		item->matches_added = 1;
 
@@ -1006,36 +1368,25 @@ sni_fetch_item_properties(SNIItem *item)
 		if (!dbus_helper_add_match(sni_watcher->conn, match))
 			awm_warn(
 			    "SNI: Failed to add item signal match for %s", item->service);
+
+		/* And to menu changes, which keep the cached layout current */
+		snprintf(match, sizeof(match),
+		    "type='signal',sender='%s',interface='%s'", item->service,
+		    DBUSMENU_INTERFACE);
+		if (!dbus_helper_add_match(sni_watcher->conn, match))
+			awm_warn(
+			    "SNI: Failed to add menu signal match for %s", item->service);
 	}
 }
 
+/* Refresh every property group of the item after the coalescing delay */
 void
 sni_update_item(SNIItem *item)
 {
 	if (!item)
 		return;
 
-	/* Free old data */
-	free(item->icon_name);
-	item->icon_name = NULL;
-
-	if (item->icon_pixmap) {
-		sni_free_icons(item->icon_pixmap, item->icon_pixmap_count);
-		item->icon_pixmap       = NULL;
-		item->icon_pixmap_count = 0;
-	}
-
-	/* Reset fetch guards so sni_fetch_item_properties() is allowed to send
-	 * a new GetAll request.  Without this, a second call to sni_update_item()
-	 * while a GetAll reply is still in flight (properties_fetching=1) would
-	 * silently drop the re-fetch; and once properties_fetched=1 was set the
-	 * guard in sni_handle_dbus() would never re-fetch at all. */
-	item->properties_fetched  = 0;
-	item->properties_fetching = 0;
-
-	/* Re-fetch properties */
-	sni_fetch_item_properties(item);
-	/* Render will happen in async callback */
+	sni_mark_dirty(item, SNI_DIRTY_ALL);
 }
 
 /* ============================================================================
@@ -1274,7 +1625,7 @@ sni_icon_render(SNIItem *item, cairo_surface_t *surface)
 	awm_debug("SNI: Icon rendered for %s", item->service);
 }
 
-/* Callback from icon_load_async() — called on the GLib main loop. */
+/* Callback from icon_load_threaded() — called on the GLib main loop. */
 static void
 sni_icon_loaded_cb(cairo_surface_t *surface, void *userdata)
 {
@@ -1286,21 +1637,9 @@ sni_icon_loaded_cb(cairo_surface_t *surface, void *userdata)
 
 	item = data->item;
 
-	/* Guard against use-after-free: walk the live list first to confirm the
-	 * item pointer is still valid, THEN check the generation.  Reading
-	 * item->generation before the list walk would dereference a potentially
-	 * freed pointer. */
-	if (item && sni_watcher) {
-		SNIItem *p;
-		for (p = sni_watcher->items; p; p = p->next) {
-			if (p == item)
-				break;
-		}
-		if (p == item && p->generation == data->generation && surface &&
-		    cairo_surface_status(surface) == CAIRO_STATUS_SUCCESS) {
-			sni_icon_render(item, surface);
-		}
-	}
+	if (sni_item_alive(item, data->generation) && surface &&
+	    cairo_surface_status(surface) == CAIRO_STATUS_SUCCESS)
+		sni_icon_render(item, surface);
 
 	if (surface)
 		cairo_surface_destroy(surface);
@@ -1324,38 +1663,16 @@ sni_queue_icon_load(SNIItem *item)
 			cairo_surface_destroy(surface);
 		}
 	} else if (item->icon_name && item->icon_name[0] != '\0') {
-		if (item->icon_name[0] == '/') {
-			const char *n = item->icon_name;
-			int         is_svg =
-			    (strstr(n, ".svg") != NULL || strstr(n, ".SVG") != NULL);
-			if (is_svg) {
-				/* SVG: rasterize synchronously via librsvg (no gdk-pixbuf
-				 * SVG loader required, and it's fast at icon sizes). */
-				cairo_surface_t *surface =
-				    icon_load(item->icon_name, (int) sniconsize);
-				if (surface) {
-					sni_icon_render(item, surface);
-					cairo_surface_destroy(surface);
-				}
-			} else {
-				/* Non-SVG absolute path — async load via gdk-pixbuf. */
-				SNIIconLoadData *data = malloc(sizeof(SNIIconLoadData));
-				if (!data)
-					return;
-				data->item       = item;
-				data->generation = item->generation;
-				icon_load_async(item->icon_name, (int) sniconsize,
-				    sni_icon_loaded_cb, data);
-			}
-		} else {
-			/* Theme name — icon_load() handles GTK theme lookup + caching. */
-			cairo_surface_t *surface =
-			    icon_load(item->icon_name, (int) sniconsize);
-			if (surface) {
-				sni_icon_render(item, surface);
-				cairo_surface_destroy(surface);
-			}
-		}
+		/* Theme name or file: resolved here, decoded on the icon worker
+		 * pool ahead of background work; a cache hit calls back now. */
+		SNIIconLoadData *data = malloc(sizeof(SNIIconLoadData));
+		if (!data)
+			return;
+		data->item       = item;
+		data->generation = item->generation;
+		if (icon_load_threaded(item->icon_name, (int) sniconsize,
+		        ICON_PRIO_VISIBLE, NULL, sni_icon_loaded_cb, data) < 0)
+			free(data);
 	}
 	/* If neither pixmap nor name is available, the placeholder stays. */
 }
@@ -1566,16 +1883,19 @@ sni_menu_item_activated(int item_id, SNIItem *item)
 	dbus_message_unref(msg);
 }
 
-/* Build menu structure from DBusMenu layout - returns MenuItem list */
+/* Menu layouts are cached per item as an SNIMenuItem tree.  The first
+ * GetLayout goes out as soon as the Menu property is known; LayoutUpdated
+ * refetches just the subtree that changed and ItemsPropertiesUpdated is
+ * applied to the cached nodes in place.  A right-click pops the cache up at
+ * once and revalidates it in the background for the next time. */
 
-/* Helper structure for parsing menu item properties */
-struct MenuItemProperties {
-	char          *label;
-	int            enabled;
-	int            visible;
-	MenuToggleType toggle_type;
-	int            toggle_state;
-};
+/* Context for an async GetLayout */
+typedef struct {
+	SNIItem *item;
+	uint32_t generation;
+	int      parent; /* node whose subtree was asked for; 0 = root */
+	char    *path;   /* menu_path asked; the reply is void if it moved */
+} SNILayoutCtx;
 
 /*
  * Strip DBusMenu mnemonic underscores from a label in-place.
@@ -1601,28 +1921,33 @@ sni_strip_mnemonics(char *s)
 	*w = '\0';
 }
 
-/* Callback for parsing menu item property dict */
+/* Callback for parsing menu item property dict into a cached node */
 static void
 sni_parse_menu_property(
     const char *key, DBusMessageIter *value, void *user_data)
 {
-	struct MenuItemProperties *props = user_data;
+	SNIMenuItem *mi = user_data;
 
 	if (strcmp(key, "label") == 0) {
-		props->label = dbus_iter_get_variant_string(value);
-		if (props->label)
-			sni_strip_mnemonics(props->label);
+		char *label = dbus_iter_get_variant_string(value);
+		if (label) {
+			sni_strip_mnemonics(label);
+			free(mi->label);
+			mi->label = label;
+		}
 	} else if (strcmp(key, "enabled") == 0) {
-		dbus_iter_get_variant_bool(value, &props->enabled);
+		dbus_iter_get_variant_bool(value, &mi->enabled);
 	} else if (strcmp(key, "visible") == 0) {
-		dbus_iter_get_variant_bool(value, &props->visible);
+		dbus_iter_get_variant_bool(value, &mi->visible);
 	} else if (strcmp(key, "toggle-type") == 0) {
 		char *s = dbus_iter_get_variant_string(value);
 		if (s) {
 			if (strcmp(s, "checkmark") == 0)
-				props->toggle_type = MENU_TOGGLE_CHECKMARK;
+				mi->toggle_type = MENU_TOGGLE_CHECKMARK;
 			else if (strcmp(s, "radio") == 0)
-				props->toggle_type = MENU_TOGGLE_RADIO;
+				mi->toggle_type = MENU_TOGGLE_RADIO;
+			else
+				mi->toggle_type = MENU_TOGGLE_NONE;
 			free(s);
 		}
 	} else if (strcmp(key, "toggle-state") == 0) {
@@ -1633,270 +1958,423 @@ sni_parse_menu_property(
 		if (dbus_message_iter_get_arg_type(&inner) == DBUS_TYPE_INT32) {
 			dbus_int32_t v = 0;
 			dbus_message_iter_get_basic(&inner, &v);
-			props->toggle_state = (v == 1) ? 1 : 0;
+			mi->toggle_state = (v == 1) ? 1 : 0;
 		}
 	}
 }
 
-static MenuItem *
-sni_build_menu_from_layout(SNIItem *item, DBusMessageIter *iter, int depth)
+/* A property the app no longer sets goes back to its spec default */
+static void
+sni_reset_menu_property(SNIMenuItem *mi, const char *key)
 {
-	MenuItem       *head = NULL, *tail = NULL;
-	DBusMessageIter array_iter, struct_iter;
-
-	if (depth > 10) {
-		awm_debug("DBusMenu: Max depth reached");
-		return NULL; /* Prevent infinite recursion */
+	if (strcmp(key, "label") == 0) {
+		free(mi->label);
+		mi->label = NULL;
+	} else if (strcmp(key, "enabled") == 0) {
+		mi->enabled = 1;
+	} else if (strcmp(key, "visible") == 0) {
+		mi->visible = 1;
+	} else if (strcmp(key, "toggle-type") == 0) {
+		mi->toggle_type = MENU_TOGGLE_NONE;
+	} else if (strcmp(key, "toggle-state") == 0) {
+		mi->toggle_state = 0;
 	}
+}
+
+static SNIMenuItem *sni_parse_menu_children(DBusMessageIter *iter, int depth);
 
-	if (dbus_message_iter_get_arg_type(iter) != DBUS_TYPE_ARRAY) {
-		awm_debug("DBusMenu: Expected ARRAY, got type %c at depth %d",
-		    dbus_message_iter_get_arg_type(iter), depth);
+/* Parse one (ia{sv}av) layout node */
+static SNIMenuItem *
+sni_parse_menu_node(DBusMessageIter *node, int depth)
+{
+	DBusMessageIter struct_iter, dict_iter;
+	SNIMenuItem    *mi;
+	dbus_int32_t    id;
+
+	if (dbus_message_iter_get_arg_type(node) != DBUS_TYPE_STRUCT)
+		return NULL;
+	dbus_message_iter_recurse(node, &struct_iter);
+	if (dbus_message_iter_get_arg_type(&struct_iter) != DBUS_TYPE_INT32)
+		return NULL;
+	dbus_message_iter_get_basic(&struct_iter, &id);
+	dbus_message_iter_next(&struct_iter);
+
+	mi = calloc(1, sizeof(SNIMenuItem));
+	if (!mi)
 		return NULL;
+	mi->id      = id;
+	mi->enabled = 1;
+	mi->visible = 1;
+
+	if (dbus_message_iter_get_arg_type(&struct_iter) == DBUS_TYPE_ARRAY) {
+		dbus_message_iter_recurse(&struct_iter, &dict_iter);
+		dbus_iter_parse_dict(&dict_iter, sni_parse_menu_property, mi);
+		dbus_message_iter_next(&struct_iter);
 	}
+	if (dbus_message_iter_get_arg_type(&struct_iter) == DBUS_TYPE_ARRAY)
+		mi->submenu = sni_parse_menu_children(&struct_iter, depth + 1);
+	return mi;
+}
 
-	dbus_message_iter_recurse(iter, &array_iter);
+/* Parse a children array (av).  Hidden entries are kept: a later
+ * ItemsPropertiesUpdated may make them visible. */
+static SNIMenuItem *
+sni_parse_menu_children(DBusMessageIter *iter, int depth)
+{
+	SNIMenuItem    *head = NULL, **tail = &head, *mi;
+	DBusMessageIter array_iter, item_iter;
 
-	while (dbus_message_iter_get_arg_type(&array_iter) != DBUS_TYPE_INVALID) {
-		dbus_int32_t    id;
-		char           *label   = NULL;
-		int             enabled = 1;
-		int             visible = 1;
-		MenuItem       *mi;
-		DBusMessageIter item_iter;
+	if (depth > 10) {
+		awm_debug("DBusMenu: Max depth reached");
+		return NULL; /* Prevent infinite recursion */
+	}
 
-		/* Check if we need to unwrap a variant */
-		if (dbus_message_iter_get_arg_type(&array_iter) == DBUS_TYPE_VARIANT) {
+	dbus_message_iter_recurse(iter, &array_iter);
+	for (; dbus_message_iter_get_arg_type(&array_iter) != DBUS_TYPE_INVALID;
+	     dbus_message_iter_next(&array_iter)) {
+		/* Children are normally variants wrapping the struct */
+		if (dbus_message_iter_get_arg_type(&array_iter) == DBUS_TYPE_VARIANT)
 			dbus_message_iter_recurse(&array_iter, &item_iter);
-		} else if (dbus_message_iter_get_arg_type(&array_iter) ==
-		    DBUS_TYPE_STRUCT) {
+		else
 			item_iter = array_iter;
-		} else {
-			dbus_message_iter_next(&array_iter);
-			continue;
-		}
 
-		/* Now item_iter should point to a struct */
-		if (dbus_message_iter_get_arg_type(&item_iter) != DBUS_TYPE_STRUCT) {
-			dbus_message_iter_next(&array_iter);
-			continue;
+		mi = sni_parse_menu_node(&item_iter, depth);
+		if (mi) {
+			*tail = mi;
+			tail  = &mi->next;
 		}
+	}
+	return head;
+}
 
-		dbus_message_iter_recurse(&item_iter, &struct_iter);
-
-		/* Get item ID */
-		if (dbus_message_iter_get_arg_type(&struct_iter) == DBUS_TYPE_INT32) {
-			dbus_message_iter_get_basic(&struct_iter, &id);
-			dbus_message_iter_next(&struct_iter);
-		} else {
-			dbus_message_iter_next(&array_iter);
-			continue;
-		}
+static SNIMenuItem *
+sni_menu_find(SNIMenuItem *menu, int id)
+{
+	SNIMenuItem *mi, *found;
 
-		/* Parse properties dictionary using helper */
-		struct MenuItemProperties props = { NULL, 1, 1, MENU_TOGGLE_NONE, 0 };
-		if (dbus_message_iter_get_arg_type(&struct_iter) == DBUS_TYPE_ARRAY) {
-			DBusMessageIter dict_iter;
-			dbus_message_iter_recurse(&struct_iter, &dict_iter);
-			dbus_iter_parse_dict(&dict_iter, sni_parse_menu_property, &props);
-			dbus_message_iter_next(&struct_iter);
-		}
+	for (mi = menu; mi; mi = mi->next) {
+		if (mi->id == id)
+			return mi;
+		if ((found = sni_menu_find(mi->submenu, id)))
+			return found;
+	}
+	return NULL;
+}
 
-		label   = props.label;
-		enabled = props.enabled;
-		visible = props.visible;
+/* MenuItem list for menu.c from the visible part of a cached tree */
+static MenuItem *
+sni_menu_to_items(const SNIMenuItem *menu)
+{
+	MenuItem          *head = NULL, **tail = &head, *mi;
+	const SNIMenuItem *m;
 
-		/* Skip if not visible */
-		if (!visible) {
-			free(label);
-			dbus_message_iter_next(&array_iter);
+	for (m = menu; m; m = m->next) {
+		if (!m->visible)
 			continue;
-		}
 
 		/* Create menu item - separator if no label */
-		if (!label || strcmp(label, "") == 0) {
+		if (!m->label || m->label[0] == '\0') {
 			mi = menu_separator_create();
 		} else {
-			mi = menu_item_create(id, label, enabled);
+			mi = menu_item_create(m->id, m->label, m->enabled);
 			if (mi) {
-				mi->toggle_type  = props.toggle_type;
-				mi->toggle_state = props.toggle_state;
+				mi->toggle_type  = (MenuToggleType) m->toggle_type;
+				mi->toggle_state = m->toggle_state;
+				mi->submenu      = sni_menu_to_items(m->submenu);
 			}
 		}
+		if (!mi)
+			continue;
+		*tail = mi;
+		tail  = &mi->next;
+	}
+	return head;
+}
 
-		/* Free the label string now that menu_item_create has copied it */
-		free(label);
+/* Pop up item's cached menu.  Returns 0 if there is nothing to show. */
+static int
+sni_menu_popup(SNIItem *item, int x, int y, xcb_timestamp_t event_time)
+{
+	MenuItem *menu_items = sni_menu_to_items(item->menu);
 
-		if (!mi) {
-			dbus_message_iter_next(&array_iter);
-			continue;
-		}
+	if (!menu_items)
+		return 0;
+#ifdef AWM_DEBUG
+	awm_debug("DBusMenu: Showing %d items for %s",
+	    menu_items_count(menu_items), item->service);
+#endif
+	/* Track which item triggered this menu for the activation callback */
+	sni_current_menu_item = item;
+
+	/* Callback wrapper: call sni_menu_item_activated directly instead of
+	 * round-tripping over the socket. */
+	menu_set_items(sni_menu, menu_items);
+	menu_show(sni_menu, x, y, (MenuCallback) sni_menu_item_activated_cb, item,
+	    event_time);
+	return 1;
+}
 
-		/* Check for submenu (children) */
-		if (dbus_message_iter_get_arg_type(&struct_iter) == DBUS_TYPE_ARRAY) {
-			mi->submenu =
-			    sni_build_menu_from_layout(item, &struct_iter, depth + 1);
-		}
+static void sni_layout_received(DBusMessage *reply, void *user_data);
 
-		/* Add to linked list */
-		if (!head) {
-			head = tail = mi;
-		} else {
-			tail->next = mi;
-			tail       = mi;
-		}
+/* Ask for the layout below node parent (0 = the whole menu) */
+static int
+sni_menu_fetch(SNIItem *item, int parent)
+{
+	DBusMessage    *msg;
+	DBusMessageIter args, array_iter;
+	SNILayoutCtx   *ctx;
+	dbus_int32_t    parent_id       = parent;
+	dbus_int32_t    recursion_depth = -1; /* -1 = all levels */
 
-		dbus_message_iter_next(&array_iter);
+	if (!item->menu_path || !sni_watcher || !sni_watcher->conn)
+		return 0;
+
+	msg = dbus_message_new_method_call(
+	    item->service, item->menu_path, DBUSMENU_INTERFACE, "GetLayout");
+	if (!msg)
+		return 0;
+
+	/* Arguments: parent_id, recursion_depth, propertyNames (empty array
+	 * means "all properties") */
+	dbus_message_iter_init_append(msg, &args);
+	dbus_message_iter_append_basic(&args, DBUS_TYPE_INT32, &parent_id);
+	dbus_message_iter_append_basic(&args, DBUS_TYPE_INT32, &recursion_depth);
+	dbus_message_iter_open_container(&args, DBUS_TYPE_ARRAY, "s", &array_iter);
+	dbus_message_iter_close_container(&args, &array_iter);
+
+	ctx = malloc(sizeof(SNILayoutCtx));
+	if (!ctx || !(ctx->path = strdup(item->menu_path))) {
+		free(ctx);
+		dbus_message_unref(msg);
+		return 0;
+	}
+	ctx->item       = item;
+	ctx->generation = item->generation;
+	ctx->parent     = parent;
+	if (!dbus_helper_send_async(
+	        sni_watcher->conn, msg, sni_layout_received, ctx)) {
+		awm_warn("DBusMenu: Failed to request layout of %s", item->service);
+		dbus_message_unref(msg);
+		free(ctx->path);
+		free(ctx);
+		return 0;
 	}
+	dbus_message_unref(msg);
 
-	return head;
+	item->menu_fetching = 1;
+	item->menu_stale    = 0;
+	return 1;
 }
 
-/* Context passed to the async GetLayout reply callback.
- * generation mirrors item->generation at call time so the callback can
- * detect if the item was freed before the reply arrived. */
-typedef struct {
-	SNIItem        *item;
-	uint32_t        generation;
-	int             x;
-	int             y;
-	xcb_timestamp_t event_time;
-} SNIMenuContext;
-
-/* DBusPendingCall notify function for GetLayout reply */
+/* The menu moved to another path (or appeared): drop the cache and fetch
+ * the new layout */
 static void
-sni_get_layout_notify(DBusPendingCall *pending, void *user_data)
+sni_menu_invalidate(SNIItem *item)
 {
-	SNIMenuContext *ctx = (SNIMenuContext *) user_data;
-	SNIItem        *item;
-	int             x, y;
-	xcb_timestamp_t event_time;
-	DBusMessage    *reply;
-	DBusMessageIter iter, struct_iter;
-	MenuItem       *menu_items;
+	sni_free_menu(item->menu);
+	item->menu          = NULL;
+	item->menu_revision = 0;
+	if (item->menu_fetching)
+		item->menu_stale = 1;
+	else
+		sni_menu_fetch(item, 0);
+}
 
-	reply = dbus_pending_call_steal_reply(pending);
-	dbus_pending_call_unref(pending);
+/* Put a fetched node into the cache: the root's children replace the whole
+ * tree, any other node replaces its cached counterpart */
+static void
+sni_menu_store(SNIItem *item, int parent, SNIMenuItem *node, uint32_t revision)
+{
+	SNIMenuItem *old, tmp;
 
-	if (!ctx) {
-		/* Should never happen, but be safe. */
-		sni_menu_pending = 0;
-		goto done;
+	if (parent == 0) {
+		sni_free_menu(item->menu);
+		item->menu    = node->submenu;
+		node->submenu = NULL;
+	} else if ((old = sni_menu_find(item->menu, parent))) {
+		/* Swap contents, keeping old's place in its list */
+		tmp       = *old;
+		*old      = *node;
+		old->next = tmp.next;
+		tmp.next  = NULL;
+		*node     = tmp;
+	} else {
+		/* Gone from the cache meanwhile: fall back to the whole menu */
+		sni_free_menu(node);
+		sni_menu_fetch(item, 0);
+		return;
 	}
+	sni_free_menu(node);
+	item->menu_revision = revision;
+}
 
-	item       = ctx->item;
-	x          = ctx->x;
-	y          = ctx->y;
-	event_time = ctx->event_time;
+/* GetLayout reply: (u revision, (ia{sv}av) layout) */
+static void
+sni_layout_received(DBusMessage *reply, void *user_data)
+{
+	SNILayoutCtx   *ctx = (SNILayoutCtx *) user_data;
+	SNIItem        *item;
+	int             parent;
+	DBusMessageIter iter;
+	dbus_uint32_t   revision;
+	SNIMenuItem    *node;
+	int             moved;
 
-	/* Guard against use-after-free: walk the live list and verify the item
-	 * pointer is still valid and has not been recycled (generation check).
-	 * Same pattern as SNIGetAllCtx in sni_properties_received(). */
-	{
-		SNIItem *p;
-		int      still_alive = 0;
-		if (sni_watcher) {
-			for (p = sni_watcher->items; p; p = p->next) {
-				if (p == item && p->generation == ctx->generation) {
-					still_alive = 1;
-					break;
-				}
-			}
-		}
-		if (!still_alive) {
-			awm_debug("DBusMenu: item gone before GetLayout reply arrived");
-			free(ctx);
-			sni_menu_pending = 0;
-			goto done;
-		}
+	if (!ctx)
+		return;
+	item   = ctx->item;
+	parent = ctx->parent;
+	if (!sni_item_alive(item, ctx->generation)) {
+		free(ctx->path);
+		free(ctx);
+		return;
 	}
+	moved = !item->menu_path || strcmp(item->menu_path, ctx->path) != 0;
+	free(ctx->path);
 	free(ctx);
+	item->menu_fetching = 0;
+
+	/* A reply overtaken by LayoutUpdated is still newer than the cache, so
+	 * it goes in and the refetch follows.  Dropping it instead would starve
+	 * the cache, and any waiting popup, for as long as an app signals faster
+	 * than the round trip.  Only a reply for a menu path the item no longer
+	 * has is useless. */
+	if (moved) {
+		awm_debug("DBusMenu: %s moved its menu, dropping reply",
+		    item->service);
+	} else if (dbus_message_get_type(reply) == DBUS_MESSAGE_TYPE_ERROR) {
+		awm_warn("DBusMenu: GetLayout on %s failed: %s", item->service,
+		    dbus_message_get_error_name(reply));
+	} else if (dbus_message_iter_init(reply, &iter) &&
+	    dbus_message_iter_get_arg_type(&iter) == DBUS_TYPE_UINT32) {
+		dbus_message_iter_get_basic(&iter, &revision);
+		dbus_message_iter_next(&iter);
+		node = sni_parse_menu_node(&iter, 0);
+		if (node)
+			sni_menu_store(item, parent, node, revision);
+		else
+			awm_debug("DBusMenu: Unparsable layout from %s", item->service);
+	}
 
-	if (!reply) {
-		awm_error("DBusMenu: No reply to GetLayout");
-		sni_menu_pending = 0;
+	/* With nothing cached yet, a waiting popup waits for the refetch */
+	if (item->menu_stale && sni_menu_fetch(item, 0) && !item->menu)
 		return;
-	}
 
-	if (dbus_message_get_type(reply) == DBUS_MESSAGE_TYPE_ERROR) {
-		awm_error("DBusMenu: GetLayout failed: %s",
-		    dbus_message_get_error_name(reply));
-		sni_menu_pending = 0;
-		goto done;
+	/* A right-click was waiting for this layout */
+	if (sni_menu_wait.item == item) {
+		sni_menu_wait.item = NULL;
+		if (!sni_menu_popup(item, sni_menu_wait.x, sni_menu_wait.y,
+		        sni_menu_wait.event_time)) {
+			awm_debug("DBusMenu: No menu items for %s", item->service);
+			sni_menu_pending = 0;
+		}
 	}
+}
 
-	/* Parse reply: (uint revision, (id, props, children)) */
-	dbus_message_iter_init(reply, &iter);
+/* Item whose menu sent a DBusMenu signal.  Menus live at their own path,
+ * outside the route index; the item list is short enough to walk. */
+static SNIItem *
+sni_find_item_for_menu(DBusMessage *msg)
+{
+	const char *sender = dbus_message_get_sender(msg);
+	const char *path   = dbus_message_get_path(msg);
+	SNIItem    *item;
 
-	/* Skip revision number */
-	if (dbus_message_iter_get_arg_type(&iter) == DBUS_TYPE_UINT32)
-		dbus_message_iter_next(&iter);
+	if (!sni_watcher || !sender || !path)
+		return NULL;
+	for (item = sni_watcher->items; item; item = item->next)
+		if (item->menu_path && strcmp(item->menu_path, path) == 0 &&
+		    (strcmp(item->owner, sender) == 0 ||
+		        strcmp(item->service, sender) == 0))
+			return item;
+	return NULL;
+}
 
-	/* Get root menu structure */
-	if (dbus_message_iter_get_arg_type(&iter) == DBUS_TYPE_STRUCT) {
-		dbus_message_iter_recurse(&iter, &struct_iter);
+/* LayoutUpdated (u revision, i parent): refetch the subtree that changed.
+ * A burst of these while a fetch is out costs one more fetch. */
+static DBusHandlerResult
+sni_handle_layout_updated(DBusConnection *conn, DBusMessage *msg, void *data)
+{
+	SNIItem      *item = sni_find_item_for_menu(msg);
+	dbus_uint32_t revision;
+	dbus_int32_t  parent;
 
-		/* Skip root ID and properties */
-		dbus_message_iter_next(&struct_iter);
-		dbus_message_iter_next(&struct_iter);
+	if (!item)
+		return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+	if (!dbus_message_get_args(msg, NULL, DBUS_TYPE_UINT32, &revision,
+	        DBUS_TYPE_INT32, &parent, DBUS_TYPE_INVALID))
+		return DBUS_HANDLER_RESULT_HANDLED;
 
-		/* Get children array */
-		if (dbus_message_iter_get_arg_type(&struct_iter) == DBUS_TYPE_ARRAY) {
-			awm_debug("DBusMenu: Parsing menu items");
-			menu_items = sni_build_menu_from_layout(item, &struct_iter, 0);
+	/* Some apps always send revision 0; trust only real numbers */
+	if (item->menu && revision && revision <= item->menu_revision)
+		return DBUS_HANDLER_RESULT_HANDLED;
 
-			if (menu_items) {
-#ifdef AWM_DEBUG
-				int count = menu_items_count(menu_items);
-				awm_debug("DBusMenu: Built menu with %d items", count);
-#endif
-				/* Track which item triggered this menu for the
-				 * activation callback */
-				sni_current_menu_item = item;
-
-				if (sni_menu) {
-					/* Callback wrapper: call sni_menu_item_activated
-					 * directly instead of round-tripping over the socket. */
-					menu_set_items(sni_menu, menu_items);
-					menu_show(sni_menu, x, y,
-					    (MenuCallback) sni_menu_item_activated_cb, item,
-					    (xcb_timestamp_t) event_time);
-				} else {
-					awm_warn("DBusMenu: sni_menu not initialised");
-					sni_menu_pending = 0;
-					menu_items_free(menu_items);
-				}
+	if (item->menu_fetching)
+		item->menu_stale = 1;
+	else if (parent && sni_menu_find(item->menu, parent))
+		sni_menu_fetch(item, parent);
+	else
+		sni_menu_fetch(item, 0);
+	return DBUS_HANDLER_RESULT_HANDLED;
+}
 
-				awm_debug("DBusMenu: Menu shown");
-			} else {
-				awm_debug("DBusMenu: No menu items parsed");
-				sni_menu_pending = 0;
+/* ItemsPropertiesUpdated (a(ia{sv}) updated, a(ias) removed): patch the
+ * cached nodes in place, no refetch */
+static DBusHandlerResult
+sni_handle_menu_props_updated(
+    DBusConnection *conn, DBusMessage *msg, void *data)
+{
+	SNIItem        *item = sni_find_item_for_menu(msg);
+	DBusMessageIter args, list, entry, sub;
+	SNIMenuItem    *mi;
+	dbus_int32_t    id;
+	const char     *key;
+	int             removed;
+
+	if (!item)
+		return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+	if (!item->menu || !dbus_message_iter_init(msg, &args))
+		return DBUS_HANDLER_RESULT_HANDLED;
+
+	for (removed = 0; removed < 2; removed++) {
+		if (removed && !dbus_message_iter_next(&args))
+			break;
+		if (dbus_message_iter_get_arg_type(&args) != DBUS_TYPE_ARRAY)
+			break;
+		dbus_message_iter_recurse(&args, &list);
+		for (; dbus_message_iter_get_arg_type(&list) == DBUS_TYPE_STRUCT;
+		     dbus_message_iter_next(&list)) {
+			dbus_message_iter_recurse(&list, &entry);
+			if (dbus_message_iter_get_arg_type(&entry) != DBUS_TYPE_INT32)
+				continue;
+			dbus_message_iter_get_basic(&entry, &id);
+			dbus_message_iter_next(&entry);
+			mi = sni_menu_find(item->menu, id);
+			if (!mi ||
+			    dbus_message_iter_get_arg_type(&entry) != DBUS_TYPE_ARRAY)
+				continue;
+			dbus_message_iter_recurse(&entry, &sub);
+			if (!removed) {
+				dbus_iter_parse_dict(&sub, sni_parse_menu_property, mi);
+				continue;
+			}
+			for (; dbus_message_iter_get_arg_type(&sub) == DBUS_TYPE_STRING;
+			     dbus_message_iter_next(&sub)) {
+				dbus_message_iter_get_basic(&sub, &key);
+				sni_reset_menu_property(mi, key);
 			}
-		} else {
-			awm_debug("DBusMenu: Children is not an array (type=%c)",
-			    dbus_message_iter_get_arg_type(&struct_iter));
-			sni_menu_pending = 0;
 		}
-	} else {
-		awm_debug("DBusMenu: Root layout is not a struct (type=%c)",
-		    dbus_message_iter_get_arg_type(&iter));
-		sni_menu_pending = 0;
 	}
-
-done:
-	if (reply)
-		dbus_message_unref(reply);
+	return DBUS_HANDLER_RESULT_HANDLED;
 }
 
-/* Show DBusMenu for an item — fully async, does not block the WM */
+/* Show DBusMenu for an item — from the cache when there is one, otherwise
+ * as soon as GetLayout answers.  Never blocks the WM. */
 void
 sni_show_menu(SNIItem *item, int x, int y, xcb_timestamp_t event_time)
 {
-	DBusMessage     *msg;
-	DBusPendingCall *pending;
-	SNIMenuContext  *ctx;
-	dbus_int32_t     parent_id       = 0;
-	dbus_int32_t     recursion_depth = -1; /* -1 = all levels */
+	DBusMessage *msg;
+	dbus_int32_t parent_id = 0;
 
 	if (!item || !item->service || !item->menu_path || !sni_menu)
 		return;
@@ -1905,10 +2383,8 @@ sni_show_menu(SNIItem *item, int x, int y, xcb_timestamp_t event_time)
 	 * dropped in sni_handle_click while the async D-Bus reply is pending. */
 	sni_menu_pending = 1;
 
-	awm_debug(
-	    "DBusMenu: Fetching menu from %s%s", item->service, item->menu_path);
-
-	/* Fire AboutToShow — fire-and-forget, no reply needed */
+	/* Fire AboutToShow — fire-and-forget.  Apps that fill their menu in
+	 * lazily answer with LayoutUpdated, which refreshes the cache. */
 	msg = dbus_message_new_method_call(
 	    item->service, item->menu_path, DBUSMENU_INTERFACE, "AboutToShow");
 	if (msg) {
@@ -1918,67 +2394,23 @@ sni_show_menu(SNIItem *item, int x, int y, xcb_timestamp_t event_time)
 		dbus_message_unref(msg);
 	}
 
-	/* Build GetLayout message with arguments */
-	msg = dbus_message_new_method_call(
-	    item->service, item->menu_path, DBUSMENU_INTERFACE, "GetLayout");
-	if (!msg) {
-		awm_debug("DBusMenu: Failed to create GetLayout message");
-		return;
-	}
-
-	/* Arguments: parent_id (0 = root), recursion_depth (-1 = all),
-	 * propertyNames (empty array) */
-	{
-		DBusMessageIter args, array_iter;
-
-		dbus_message_iter_init_append(msg, &args);
-		dbus_message_iter_append_basic(&args, DBUS_TYPE_INT32, &parent_id);
-		dbus_message_iter_append_basic(
-		    &args, DBUS_TYPE_INT32, &recursion_depth);
-
-		/* Empty array of strings means "all properties" */
-		dbus_message_iter_open_container(
-		    &args, DBUS_TYPE_ARRAY, "s", &array_iter);
-		dbus_message_iter_close_container(&args, &array_iter);
-	}
-
-	ctx = malloc(sizeof(SNIMenuContext));
-	if (!ctx) {
-		dbus_message_unref(msg);
-		sni_menu_pending = 0;
-		return;
-	}
-	ctx->item       = item;
-	ctx->generation = item->generation;
-	ctx->x          = x;
-	ctx->y          = y;
-	ctx->event_time = event_time;
-
-	/* Send with async reply — the pending call is dispatched via the D-Bus fd
-	 * source already registered on the GLib main loop in awm.c:run(). */
-	if (!dbus_connection_send_with_reply(
-	        sni_watcher->conn, msg, &pending, -1)) {
-		dbus_message_unref(msg);
-		free(ctx);
-		sni_menu_pending = 0;
-		return;
-	}
-	dbus_message_unref(msg);
-
-	if (!pending) {
-		free(ctx);
-		sni_menu_pending = 0;
+	if (sni_menu_popup(item, x, y, event_time)) {
+		/* Revalidate behind the open menu, for the next time */
+		if (!item->menu_fetching)
+			sni_menu_fetch(item, 0);
 		return;
 	}
 
-	if (!dbus_pending_call_set_notify(
-	        pending, sni_get_layout_notify, ctx, NULL)) {
-		dbus_pending_call_cancel(pending);
-		dbus_pending_call_unref(pending);
-		free(ctx);
-		sni_menu_pending = 0;
+	awm_debug(
+	    "DBusMenu: Fetching menu from %s%s", item->service, item->menu_path);
+	sni_menu_wait.item       = item;
+	sni_menu_wait.x          = x;
+	sni_menu_wait.y          = y;
+	sni_menu_wait.event_time = event_time;
+	if (!item->menu_fetching && !sni_menu_fetch(item, 0)) {
+		sni_menu_wait.item = NULL;
+		sni_menu_pending   = 0;
 	}
-	/* pending is unref'd inside sni_get_layout_notify when reply arrives */
 }
 
 #endif /* STATUSNOTIFIER */
@@ -36,7 +36,9 @@ typedef struct SNIMenuItem {
 /* StatusNotifier item structure */
 typedef struct SNIItem {
 	char *service; /* D-Bus service name */
+	char *owner;   /* Unique bus name of the registering client */
 	char *path;    /* D-Bus object path */
+	char *route;   /* owner + path: key of SNIWatcher.by_route */
 	int   status;  /* Passive, Active, NeedsAttention */
 
 	/* Icon data */
@@ -46,8 +48,11 @@ typedef struct SNIItem {
 
 	/* Menu */
 	char        *menu_path; /* DBusMenu object path */
-	SNIMenuItem *menu;      /* Parsed menu structure */
-	int item_is_menu;       /* ItemIsMenu=true: icon is a pure menu trigger */
+	SNIMenuItem *menu;      /* Cached layout, hidden entries included */
+	uint32_t     menu_revision; /* Layout revision the cache is at */
+	int          menu_fetching; /* GetLayout in flight */
+	int          menu_stale; /* Layout changed since: refetch on reply */
+	int item_is_menu;        /* ItemIsMenu=true: icon is a pure menu trigger */
 
 	/* Internal state */
 	xcb_window_t win;                /* X11 window for this item */
@@ -56,6 +61,11 @@ typedef struct SNIItem {
 	int          properties_fetched; /* Set when GetAll reply arrives */
 	int properties_fetching; /* In-flight guard: prevents re-sending GetAll */
 	int matches_added; /* D-Bus match rules added (add only once per item) */
+	int dirty;         /* Property groups awaiting a targeted refresh */
+	unsigned int refresh_id; /* GLib timer coalescing a burst of signals */
+	int          refresh_waits; /* refresh_id windows spent on a GetAll */
+	int          icon_gets;  /* Icon property Gets still in flight */
+	uint64_t     icon_hash;  /* Hash of the icon data last rendered */
 	uint32_t
 	    generation; /* Incremented when item is freed (use-after-free guard) */
 
@@ -75,6 +85,8 @@ typedef struct {
 	char           *unique_name;
 	SNIItem        *items;
 	int             item_count;
+	GHashTable     *by_service; /* service -> SNIItem */
+	GHashTable     *by_route;   /* owner + path -> SNIItem */
 	int             host_registered;
 } SNIWatcher;
 
@@ -93,7 +105,9 @@ int  sni_get_fd(void);
 
 /* Item management */
 SNIItem *sni_find_item(const char *service);
-void     sni_add_item(const char *service, const char *path);
+SNIItem *sni_find_item_by_route(const char *owner, const char *path);
+void     sni_add_item(
+        const char *service, const char *owner, const char *path);
 void     sni_remove_item(SNIItem *item);
 void     sni_update_item(SNIItem *item);
 
@@ -2,11 +2,13 @@
  * See LICENSE file for copyright and license details. */
 
 #include <assert.h>
+#include <limits.h>
 #include "spawn.h"
 #include "awm.h"
 #include "wmstate.h"
 #include "client.h"
 #include "monitor.h"
+#include "startup.h"
 #include "xrdb.h"
 #include "config.h"
 
@@ -104,29 +106,113 @@ runautostart(void)
 	free(path);
 }
 
-void
-spawn(const Arg *arg)
+/* execvp()'s $PATH search, done before vfork() so that the child can
+ * execve() with an environment of our choosing.  Returns file unchanged if
+ * it contains a '/' or is not found (exec then fails with ENOENT). */
+static const char *
+spawn_which(const char *file, char *buf, size_t sz)
 {
+	const char *path = getenv("PATH"), *p, *e;
+	struct stat st;
+
+	if (strchr(file, '/'))
+		return file;
+	if (!path)
+		path = "/usr/local/bin:/usr/bin:/bin";
+	for (p = path;; p = e + 1) {
+		if (!(e = strchr(p, ':')))
+			e = p + strlen(p);
+		/* an empty element means the current directory */
+		snprintf(buf, sz, "%.*s%s%s", (int) (e - p), p, e > p ? "/" : "",
+		    file);
+		if (stat(buf, &st) == 0 && S_ISREG(st.st_mode) &&
+		    access(buf, X_OK) == 0)
+			return buf;
+		if (!*e)
+			return file;
+	}
+}
+
+/* Start argv[0], searched in $PATH, as a detached child.  envp replaces
+ * the environment; NULL inherits awm's.
+ *
+ * awm is a big process (GL context, GTK heaps, mapped textures) and fork()
+ * would spend milliseconds copying its page tables on every launch, long
+ * enough to miss a compositor frame.  vfork() lends the child our address
+ * space instead and suspends this thread until it has exec'd, so between
+ * the two the child may only write its own locals and make plain syscalls.
+ * Every signal is blocked across the call: one of our handlers running in
+ * the child would scribble on our memory.  The child puts each signal back
+ * to its default disposition before unblocking them all -- awm ignores
+ * SIGCHLD with SA_NOCLDWAIT, and shells or launch wrappers that track their
+ * own children with waitpid() fail when they inherit that (observed on
+ * FreeBSD).  It also drops the X connection and starts a new session.
+ *
+ * An exec failure is reported back through the shared memory, so the
+ * caller gets -1 (logged) rather than a pid that has already exited. */
+pid_t
+spawn_argv(char *const argv[], char *const envp[])
+{
+	static gint64    slowest;
 	struct sigaction sa;
+	sigset_t         all, old;
+	volatile int     err = 0;
+	gint64           t0, dt;
+	pid_t            pid;
+	char             buf[PATH_MAX];
+	const char      *file = NULL;
+	int              xfd  = xc ? xcb_get_file_descriptor(xc) : -1;
+
+	if (envp)
+		file = spawn_which(argv[0], buf, sizeof(buf));
+	sigfillset(&all);
+	sigprocmask(SIG_SETMASK, &all, &old);
+	t0  = g_get_monotonic_time();
+	pid = vfork();
+	if (pid == 0) {
+		sigemptyset(&sa.sa_mask);
+		sa.sa_flags   = 0;
+		sa.sa_handler = SIG_DFL;
+		for (int sig = 1; sig < NSIG; sig++)
+			if (sig != SIGKILL && sig != SIGSTOP)
+				sigaction(sig, &sa, NULL);
+		if (xfd >= 0)
+			close(xfd);
+		setsid();
+		sigemptyset(&all);
+		sigprocmask(SIG_SETMASK, &all, NULL);
+		if (envp)
+			execve(file, argv, envp);
+		else
+			execvp(argv[0], argv);
+		err = errno;
+		_exit(127);
+	}
+	if (pid < 0)
+		err = errno;
+	dt = g_get_monotonic_time() - t0;
+	sigprocmask(SIG_SETMASK, &old, NULL);
+
+	if (err) {
+		awm_error("spawn: '%s' failed: %s", argv[0], strerror(err));
+		return -1;
+	}
+	if (dt > slowest)
+		slowest = dt;
+	awm_debug("spawn: '%s' pid %d in %.3f ms (slowest %.3f ms)", argv[0],
+	    (int) pid, dt / 1000.0, slowest / 1000.0);
+	return pid;
+}
 
+void
+spawn(const Arg *arg)
+{
 	assert(arg != NULL);
 	assert(arg->v != NULL);
 
 	if (arg->v == dmenucmd)
 		dmenumon[0] = '0' + g_awm_selmon->num;
-	if (fork() == 0) {
-		if (xc)
-			close(xcb_get_file_descriptor(xc));
-		setsid();
-
-		sigemptyset(&sa.sa_mask);
-		sa.sa_flags   = 0;
-		sa.sa_handler = SIG_DFL;
-		sigaction(SIGCHLD, &sa, NULL);
-
-		execvp(((char **) arg->v)[0], (char **) arg->v);
-		die("awm: execvp '%s' failed:", ((char **) arg->v)[0]);
-	}
+	startup_launch((char *const *) arg->v, NULL);
 }
 
 void
@@ -135,13 +221,5 @@ spawnscratch(const Arg *arg)
 	assert(arg != NULL);
 	assert(arg->v != NULL);
 	assert(((char **) arg->v)[1] != NULL);
-	if (fork() == 0) {
-		if (xc)
-			close(xcb_get_file_descriptor(xc));
-		setsid();
-		execvp(((char **) arg->v)[1], ((char **) arg->v) + 1);
-		awm_error(
-		    "execvp '%s' failed: %s", ((char **) arg->v)[1], strerror(errno));
-		exit(EXIT_SUCCESS);
-	}
+	startup_launch(((char *const *) arg->v) + 1, NULL);
 }
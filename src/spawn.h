@@ -6,6 +6,11 @@
 
 #include "awm.h"
 
+/* Launch argv[0] without fork()ing awm (see spawn.c).  envp replaces the
+ * environment, NULL inherits it.  Returns the child's pid, or -1 if it
+ * could not be started. */
+pid_t spawn_argv(char *const argv[], char *const envp[]);
+
 void runautostart(void);
 void spawn(const Arg *arg);
 void spawnscratch(const Arg *arg);
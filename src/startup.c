@@ -0,0 +1,403 @@
+/* AndrathWM - startup notification and launch tracking
+ * See LICENSE file for copyright and license details. */
+
+#include "startup.h"
+#include "awm.h"
+#include "spawn.h"
+#include "startup_util.h"
+#include "wmstate.h"
+
+/* How long a launch waits for its first window.  Generous: a cold start
+ * of a large application can take several seconds. */
+#define STARTUP_TIMEOUT_MS 30000
+/* After "remove:" the launchee's MapRequest may still be queued. */
+#define STARTUP_REMOVE_GRACE_MS 2000
+/* Parents of _NET_WM_PID tried against launch pids (sh -c, wrappers). */
+#define STARTUP_PID_DEPTH 4
+/* Longest _NET_STARTUP_INFO message reassembled. */
+#define STARTUP_MSG_MAX 4096
+/* Launches tracked at once.  "new:" messages may come from any client, so
+ * past this the oldest launch is dropped. */
+#define STARTUP_MAX_LAUNCHES 32
+/* Latencies are written to the stats file in batches, this long after the
+ * first unwritten one, so that applyrules() never waits on the disk. */
+#define STARTUP_FLUSH_MS 5000
+/* Unwritten latencies kept; later ones are dropped until the flush. */
+#define STARTUP_PENDING_MAX 64
+
+typedef struct Launch {
+	char           id[96];
+	char           name[64]; /* for messages */
+	char           key[64];  /* executable basename, keys the stats */
+	pid_t          pid;  /* 0 if announced without one */
+	gint64         t0;   /* monotonic time of exec / announcement (us) */
+	int            mon;  /* Monitor.num at launch */
+	unsigned int   tags; /* that monitor's tagset at launch */
+	guint          timer;
+	struct Launch *next;
+} Launch;
+
+extern char **environ;
+
+static Launch     *launches;
+static GHashTable *partial; /* sender window -> GString being reassembled */
+static unsigned    seq;
+
+static StartupSample pending[STARTUP_PENDING_MAX];
+static int           npending;
+static guint         flush_timer;
+
+/* -------------------------------------------------------------------------
+ * Launch records
+ * ---------------------------------------------------------------------- */
+
+static void
+launch_free(Launch *l)
+{
+	Launch **pp;
+
+	for (pp = &launches; *pp; pp = &(*pp)->next) {
+		if (*pp == l) {
+			*pp = l->next;
+			break;
+		}
+	}
+	if (l->timer)
+		g_source_remove(l->timer);
+	free(l);
+}
+
+static gboolean
+launch_expire_cb(gpointer data)
+{
+	Launch *l = data;
+
+	l->timer = 0;
+	awm_debug("startup: %s (%s) ended without a window", l->id, l->name);
+	launch_free(l);
+	return G_SOURCE_REMOVE;
+}
+
+static void
+launch_expire_in(Launch *l, guint ms)
+{
+	if (l->timer)
+		g_source_remove(l->timer);
+	l->timer = g_timeout_add(ms, launch_expire_cb, l);
+}
+
+static Launch *
+launch_new(const char *id, const char *name, const char *key)
+{
+	Launch *l, *oldest = NULL;
+	int     n = 0;
+
+	for (l = launches; l; l = l->next, n++)
+		oldest = l; /* the list is newest first */
+	if (n >= STARTUP_MAX_LAUNCHES) {
+		awm_debug("startup: too many launches, dropping %s", oldest->id);
+		launch_free(oldest);
+	}
+
+	l = ecalloc(1, sizeof(*l));
+	snprintf(l->id, sizeof(l->id), "%s", id);
+	snprintf(l->name, sizeof(l->name), "%s", name);
+	snprintf(l->key, sizeof(l->key), "%s", *key ? key : name);
+	l->t0   = g_get_monotonic_time();
+	l->mon  = g_awm_selmon->num;
+	l->tags = g_awm_selmon->tagset[g_awm_selmon->seltags];
+	l->next = launches;
+	launches = l;
+	launch_expire_in(l, STARTUP_TIMEOUT_MS);
+	return l;
+}
+
+static Launch *
+launch_by_id(const char *id)
+{
+	for (Launch *l = launches; l; l = l->next)
+		if (strcmp(l->id, id) == 0)
+			return l;
+	return NULL;
+}
+
+/* Parent of pid from /proc, or 0.  The comm field may hold spaces and
+ * parentheses, so the state and ppid are read after its last ')'. */
+static pid_t
+parent_pid(pid_t pid)
+{
+	char   path[64], buf[512], *p;
+	FILE  *f;
+	int    ppid = 0;
+	size_t n;
+
+	snprintf(path, sizeof(path), "/proc/%d/stat", (int) pid);
+	if (!(f = fopen(path, "r")))
+		return 0;
+	n      = fread(buf, 1, sizeof(buf) - 1, f);
+	buf[n] = '\0';
+	fclose(f);
+	if ((p = strrchr(buf, ')')) && sscanf(p + 1, " %*c %d", &ppid) == 1)
+		return (pid_t) ppid;
+	return 0;
+}
+
+/* The launch whose pid is pid or one of its first few ancestors. */
+static Launch *
+launch_by_pid(pid_t pid)
+{
+	for (int depth = 0; depth < STARTUP_PID_DEPTH && pid > 1; depth++) {
+		for (Launch *l = launches; l; l = l->next)
+			if (l->pid == pid)
+				return l;
+		pid = parent_pid(pid);
+	}
+	return NULL;
+}
+
+/* -------------------------------------------------------------------------
+ * Launching
+ * ---------------------------------------------------------------------- */
+
+pid_t
+startup_launch(char *const argv[], const char *name)
+{
+	char    id[96], var[128], key[64];
+	char  **envp;
+	size_t  n = 0, j = 0;
+	Launch *l;
+	pid_t   pid;
+
+	/* key "sh -c cmd" by the program cmd runs, not by the shell */
+	if (argv[1] && strcmp(argv[1], "-c") == 0 && argv[2])
+		startup_cmd_key(argv[2], key, sizeof(key));
+	else
+		startup_cmd_key(argv[0], key, sizeof(key));
+	if (!name)
+		name = key;
+	/* _TIME carries the user event behind the launch, per the spec */
+	if (last_event_time != XCB_CURRENT_TIME)
+		snprintf(id, sizeof(id), "awm-%ld-%u_TIME%u", (long) getpid(), ++seq,
+		    (unsigned) last_event_time);
+	else
+		snprintf(id, sizeof(id), "awm-%ld-%u", (long) getpid(), ++seq);
+	snprintf(var, sizeof(var), "DESKTOP_STARTUP_ID=%s", id);
+
+	while (environ[n])
+		n++;
+	envp = ecalloc(n + 2, sizeof(*envp));
+	for (size_t i = 0; i < n; i++)
+		if (strncmp(environ[i], "DESKTOP_STARTUP_ID=", 19) != 0)
+			envp[j++] = environ[i];
+	envp[j] = var;
+
+	l   = launch_new(id, name, key);
+	pid = spawn_argv(argv, envp);
+	free(envp);
+	if (pid < 0) {
+		launch_free(l);
+		return -1;
+	}
+	l->pid = pid;
+	return pid;
+}
+
+/* -------------------------------------------------------------------------
+ * Launch statistics
+ * ---------------------------------------------------------------------- */
+
+static void
+stats_flush(void)
+{
+	char path[512];
+
+	if (flush_timer) {
+		g_source_remove(flush_timer);
+		flush_timer = 0;
+	}
+	if (!npending)
+		return;
+	startup_stats_path(path, sizeof(path));
+	if (startup_stats_record_n(path, pending, npending) < 0)
+		awm_warn("startup: cannot write %s", path);
+	npending = 0;
+}
+
+static gboolean
+stats_flush_cb(gpointer data)
+{
+	(void) data;
+	flush_timer = 0;
+	stats_flush();
+	return G_SOURCE_REMOVE;
+}
+
+static void
+stats_add(const char *key, double ms)
+{
+	if (npending == STARTUP_PENDING_MAX)
+		return;
+	snprintf(pending[npending].name, sizeof(pending[npending].name), "%s",
+	    key);
+	pending[npending++].ms = ms;
+	if (!flush_timer)
+		flush_timer = g_timeout_add(STARTUP_FLUSH_MS, stats_flush_cb, NULL);
+}
+
+/* -------------------------------------------------------------------------
+ * Window matching
+ * ---------------------------------------------------------------------- */
+
+/* Copy the _NET_STARTUP_ID fetched by ck into out.  Returns 0, or -1 if
+ * the window has none. */
+static int
+window_startup_id(xcb_get_property_cookie_t ck, char *out, size_t sz)
+{
+	xcb_get_property_reply_t *r = xcb_get_property_reply(xc, ck, NULL);
+	int                       len, ret = -1;
+
+	if (r && (len = xcb_get_property_value_length(r)) > 0) {
+		snprintf(
+		    out, sz, "%.*s", len, (const char *) xcb_get_property_value(r));
+		ret = 0;
+	}
+	free(r);
+	return ret;
+}
+
+unsigned int
+startup_claim(Client *c)
+{
+	xcb_get_property_cookie_t id_ck, pid_ck, hints_ck, lid_ck;
+	xcb_icccm_wm_hints_t      hints;
+	xcb_get_property_reply_t *r;
+	char                      id[96];
+	Launch                   *l = NULL;
+	pid_t                     pid = 0;
+	unsigned int              tags;
+	Monitor                  *m;
+	double                    ms;
+
+	if (!launches)
+		return 0;
+
+	/* issue the three lookups together: one round trip, not three */
+	id_ck    = xcb_get_property(xc, 0, c->win, netatom[NetStartupId],
+	    XCB_GET_PROPERTY_TYPE_ANY, 0, sizeof(id) / 4);
+	pid_ck   = xcb_get_property(
+	    xc, 0, c->win, netatom[NetWMPid], XCB_ATOM_CARDINAL, 0, 1);
+	hints_ck = xcb_icccm_get_wm_hints(xc, c->win);
+
+	if (window_startup_id(id_ck, id, sizeof(id)) == 0)
+		l = launch_by_id(id);
+	if ((r = xcb_get_property_reply(xc, pid_ck, NULL))) {
+		const uint32_t *v = xcb_get_property_value(r);
+		if (xcb_get_property_value_length(r) >= 4)
+			pid = (pid_t) v[0];
+		free(r);
+	}
+	/* toolkits such as GTK set the ID on the group leader instead */
+	if (xcb_icccm_get_wm_hints_reply(xc, hints_ck, &hints, NULL) &&
+	    (hints.flags & XCB_ICCCM_WM_HINT_WINDOW_GROUP) &&
+	    hints.window_group != c->win && !l) {
+		lid_ck = xcb_get_property(xc, 0, hints.window_group,
+		    netatom[NetStartupId], XCB_GET_PROPERTY_TYPE_ANY, 0,
+		    sizeof(id) / 4);
+		if (window_startup_id(lid_ck, id, sizeof(id)) == 0)
+			l = launch_by_id(id);
+	}
+	if (!l && pid > 0)
+		l = launch_by_pid(pid);
+	if (!l)
+		return 0;
+
+	FOR_EACH_MON(m)
+	if (m->num == l->mon) {
+		c->mon = m;
+		break;
+	}
+	tags = l->tags;
+	ms   = (double) (g_get_monotonic_time() - l->t0) / 1000.0;
+	awm_debug("startup: %s (%s) mapped 0x%x after %.1f ms", l->id, l->name,
+	    (unsigned) c->win, ms);
+	stats_add(l->key, ms);
+	launch_free(l);
+	return tags;
+}
+
+/* -------------------------------------------------------------------------
+ * _NET_STARTUP_INFO
+ *
+ * Other launchers broadcast "new:" / "change:" / "remove:" messages to the
+ * root window, split into 20-byte client messages: the first of type
+ * _NET_STARTUP_INFO_BEGIN, the rest _NET_STARTUP_INFO, ending at a NUL.
+ * ---------------------------------------------------------------------- */
+
+static void
+startup_info_handle(const char *msg)
+{
+	char    type[16], id[96], v[64], key[64];
+	Launch *l;
+
+	if (startup_msg_type(msg, type, sizeof(type)) < 0 ||
+	    startup_msg_get(msg, "ID", id, sizeof(id)) < 0)
+		return;
+	l = launch_by_id(id);
+	if (strcmp(type, "new") == 0 && !l) {
+		/* BIN is the executable, the same key as our own launches */
+		if (startup_msg_get(msg, "BIN", v, sizeof(v)) == 0)
+			startup_cmd_key(v, key, sizeof(key));
+		else
+			key[0] = '\0';
+		if (startup_msg_get(msg, "NAME", v, sizeof(v)) < 0)
+			snprintf(v, sizeof(v), "%s", *key ? key : id);
+		l = launch_new(id, v, key);
+		if (startup_msg_get(msg, "PID", v, sizeof(v)) == 0)
+			l->pid = (pid_t) atoi(v);
+		awm_debug("startup: tracking %s (%s)", l->id, l->name);
+	} else if (strcmp(type, "remove") == 0 && l) {
+		launch_expire_in(l, STARTUP_REMOVE_GRACE_MS);
+	}
+}
+
+static void
+gstring_free(gpointer s)
+{
+	g_string_free(s, TRUE);
+}
+
+void
+startup_info_message(const xcb_client_message_event_t *cme)
+{
+	const char *d   = (const char *) cme->data.data8;
+	size_t      n   = strnlen(d, sizeof(cme->data.data8));
+	gpointer    key = GUINT_TO_POINTER(cme->window);
+	GString    *s;
+
+	if (!partial)
+		partial = g_hash_table_new_full(NULL, NULL, NULL, gstring_free);
+	if (cme->type == netatom[NetStartupInfoBegin]) {
+		s = g_string_new(NULL);
+		g_hash_table_replace(partial, key, s);
+	} else if (!(s = g_hash_table_lookup(partial, key))) {
+		return;
+	}
+	g_string_append_len(s, d, (gssize) n);
+	if (n == sizeof(cme->data.data8) && s->len < STARTUP_MSG_MAX)
+		return; /* more to come */
+	if (n < sizeof(cme->data.data8))
+		startup_info_handle(s->str);
+	g_hash_table_remove(partial, key);
+}
+
+void
+startup_cleanup(void)
+{
+	while (launches)
+		launch_free(launches);
+	stats_flush();
+	if (partial) {
+		g_hash_table_destroy(partial);
+		partial = NULL;
+	}
+}
@@ -0,0 +1,38 @@
+/* AndrathWM - startup notification and launch tracking
+ * See LICENSE file for copyright and license details.
+ *
+ * Every program awm starts gets a DESKTOP_STARTUP_ID and is remembered
+ * with its pid, the monitor and tags it was launched from and the time of
+ * exec.  When a window is managed, applyrules() asks startup_claim()
+ * whether it belongs to a pending launch -- by _NET_STARTUP_ID on the
+ * window or its group leader, else by _NET_WM_PID or one of that pid's
+ * parents -- and if so places it where the launch was made and records
+ * the launch-to-map latency, written in batches from a timer to the launch
+ * stats file (startup_util.h).  Stats are keyed by executable basename.
+ * Launches announced by other launchers with _NET_STARTUP_INFO "new:"
+ * messages are tracked the same way.  A "remove:" message or a timeout
+ * ends tracking.
+ */
+
+#ifndef STARTUP_H
+#define STARTUP_H
+
+#include "awm.h"
+
+/* Start argv with DESKTOP_STARTUP_ID set and track the launch.  name
+ * labels it in messages; NULL uses the executable's basename, which always
+ * keys the launch statistics.  Returns the child's pid, or -1 if it could
+ * not be started. */
+pid_t startup_launch(char *const argv[], const char *name);
+
+/* If c belongs to a pending launch, move it to the launch's monitor,
+ * record the launch-to-map latency and stop tracking the launch.  Returns
+ * the tagset the launch was made from, or 0 if c matched no launch. */
+unsigned int startup_claim(Client *c);
+
+/* Feed a _NET_STARTUP_INFO_BEGIN or _NET_STARTUP_INFO client message. */
+void startup_info_message(const xcb_client_message_event_t *cme);
+
+void startup_cleanup(void);
+
+#endif /* STARTUP_H */
@@ -0,0 +1,259 @@
+/* AndrathWM - startup notification utilities
+ * See LICENSE file for copyright and license details. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "startup_util.h"
+
+/* -------------------------------------------------------------------------
+ * _NET_STARTUP_INFO messages
+ *
+ * A message is "type: KEY=VALUE KEY=VALUE ...".  Values may be quoted with
+ * '"', and a backslash escapes the next byte (space, quote or backslash).
+ * ---------------------------------------------------------------------- */
+
+/* Scan the KEY=VALUE pair at *pp into key and val and advance past it.
+ * Returns 0 once the message is exhausted. */
+static int
+msg_next(const char **pp, char *key, size_t ksz, char *val, size_t vsz)
+{
+	const char *p      = *pp;
+	size_t      k      = 0, v = 0;
+	int         quoted = 0;
+
+	while (*p == ' ')
+		p++;
+	if (!*p)
+		return 0;
+	while (*p && *p != '=' && *p != ' ') {
+		if (k + 1 < ksz)
+			key[k++] = *p;
+		p++;
+	}
+	if (*p == '=') {
+		for (p++; *p; p++) {
+			if (*p == '\\' && p[1]) {
+				p++;
+			} else if (*p == '"') {
+				quoted = !quoted;
+				continue;
+			} else if (*p == ' ' && !quoted) {
+				break;
+			}
+			if (v + 1 < vsz)
+				val[v++] = *p;
+		}
+	}
+	key[k] = '\0';
+	val[v] = '\0';
+	*pp    = p;
+	return 1;
+}
+
+int
+startup_msg_type(const char *msg, char *out, size_t outsz)
+{
+	const char *colon = strchr(msg, ':');
+	size_t      n;
+
+	if (!colon || colon == msg || outsz == 0)
+		return -1;
+	n = (size_t) (colon - msg);
+	if (memchr(msg, ' ', n))
+		return -1;
+	if (n >= outsz)
+		n = outsz - 1;
+	memcpy(out, msg, n);
+	out[n] = '\0';
+	return 0;
+}
+
+int
+startup_msg_get(const char *msg, const char *key, char *out, size_t outsz)
+{
+	const char *p = strchr(msg, ':');
+	char        k[64];
+
+	if (!p || outsz == 0)
+		return -1;
+	p++;
+	while (msg_next(&p, k, sizeof(k), out, outsz))
+		if (strcmp(k, key) == 0)
+			return 0;
+	out[0] = '\0';
+	return -1;
+}
+
+void
+startup_cmd_key(const char *cmd, char *out, size_t outsz)
+{
+	const char *p, *end, *slash;
+	size_t      n;
+
+	if (outsz == 0)
+		return;
+	for (p = cmd; *p == ' ' || *p == '\t'; p++)
+		;
+	for (end = p; *end && *end != ' ' && *end != '\t'; end++)
+		;
+	for (slash = p; slash < end; slash++)
+		if (*slash == '/')
+			p = slash + 1;
+	n = (size_t) (end - p);
+	if (n >= outsz)
+		n = outsz - 1;
+	memcpy(out, p, n);
+	out[n] = '\0';
+}
+
+/* -------------------------------------------------------------------------
+ * Launch statistics file
+ * ---------------------------------------------------------------------- */
+
+void
+startup_stats_path(char *out, size_t sz)
+{
+	const char *state = getenv("XDG_STATE_HOME");
+	const char *home  = getenv("HOME");
+
+	if (state && *state)
+		snprintf(out, sz, "%s/awm/launch_stats", state);
+	else if (home && *home)
+		snprintf(out, sz, "%s/.local/state/awm/launch_stats", home);
+	else
+		snprintf(out, sz, "/tmp/awm_launch_stats");
+}
+
+StartupStat *
+startup_stats_load(const char *path, int *n)
+{
+	StartupStat *v   = NULL, *nv;
+	int          cap = 0;
+	char         line[256], *tab;
+	size_t       len;
+	FILE        *f;
+
+	*n = 0;
+	if (!(f = fopen(path, "r")))
+		return NULL;
+	while (fgets(line, sizeof(line), f)) {
+		if (!(tab = strchr(line, '\t')))
+			continue;
+		*tab = '\0';
+		if (*n == cap) {
+			cap = cap ? cap * 2 : 32;
+			if (!(nv = realloc(v, (size_t) cap * sizeof(*v))))
+				break;
+			v = nv;
+		}
+		len = strnlen(line, sizeof(v->name) - 1);
+		memcpy(v[*n].name, line, len);
+		v[*n].name[len] = '\0';
+		if (sscanf(tab + 1, "%u\t%lf\t%lf", &v[*n].launches, &v[*n].avg_ms,
+		        &v[*n].last_ms) == 3)
+			(*n)++;
+	}
+	fclose(f);
+	return v;
+}
+
+/* mkdir -p of the directory part of path */
+static void
+mkdir_parents(const char *path)
+{
+	char tmp[512];
+	int  n = snprintf(tmp, sizeof(tmp), "%s", path);
+
+	while (n > 0 && tmp[n - 1] != '/')
+		n--;
+	for (int i = 1; i < n; i++) {
+		if (tmp[i] == '/') {
+			tmp[i] = '\0';
+			mkdir(tmp, 0700);
+			tmp[i] = '/';
+		}
+	}
+}
+
+int
+startup_stats_record_n(const char *path, const StartupSample *smp, int ns)
+{
+	StartupStat *v, *s, *nv;
+	char         key[sizeof(smp->name)], tmp[512];
+	int          n, i, j, ret = 0;
+	FILE        *f;
+
+	v = startup_stats_load(path, &n);
+	for (j = 0; j < ns; j++) {
+		/* tabs and newlines would break the line format */
+		snprintf(key, sizeof(key), "%s", smp[j].name);
+		for (i = 0; key[i]; i++)
+			if (key[i] == '\t' || key[i] == '\n')
+				key[i] = ' ';
+
+		s = NULL;
+		for (i = 0; i < n; i++)
+			if (strcmp(v[i].name, key) == 0)
+				s = &v[i];
+		if (!s) {
+			if (!(nv = realloc(v, (size_t) (n + 1) * sizeof(*v)))) {
+				free(v);
+				return -1;
+			}
+			v = nv;
+			s = &v[n++];
+			memset(s, 0, sizeof(*s));
+			memcpy(s->name, key, sizeof(key));
+		}
+		s->launches++;
+		s->avg_ms += (smp[j].ms - s->avg_ms) / s->launches;
+		s->last_ms = smp[j].ms;
+	}
+
+	mkdir_parents(path);
+	snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+	if (!(f = fopen(tmp, "w"))) {
+		free(v);
+		return -1;
+	}
+	for (i = 0; i < n; i++)
+		fprintf(f, "%s\t%u\t%.1f\t%.1f\n", v[i].name, v[i].launches,
+		    v[i].avg_ms, v[i].last_ms);
+	if (fclose(f) != 0 || rename(tmp, path) != 0) {
+		remove(tmp);
+		ret = -1;
+	}
+	free(v);
+	return ret;
+}
+
+int
+startup_stats_record(const char *path, const char *name, double ms)
+{
+	StartupSample smp;
+
+	snprintf(smp.name, sizeof(smp.name), "%s", name);
+	smp.ms = ms;
+	return startup_stats_record_n(path, &smp, 1);
+}
+
+int
+startup_stats_get(const char *path, const char *name, StartupStat *out)
+{
+	StartupStat *v;
+	int          n, ret = -1;
+
+	v = startup_stats_load(path, &n);
+	for (int i = 0; i < n; i++) {
+		if (strcmp(v[i].name, name) == 0) {
+			*out = v[i];
+			ret  = 0;
+			break;
+		}
+	}
+	free(v);
+	return ret;
+}
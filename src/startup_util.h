@@ -0,0 +1,62 @@
+/* AndrathWM - startup notification utilities
+ * See LICENSE file for copyright and license details.
+ *
+ * The X-free half of launch tracking (startup.c): parsing the text of
+ * _NET_STARTUP_INFO messages and keeping the per-application launch
+ * statistics file.  Pure C, linked into the unit tests as-is.
+ */
+
+#ifndef STARTUP_UTIL_H
+#define STARTUP_UTIL_H
+
+#include <stddef.h>
+
+/* Copy the type of a startup-notification message ("new", "change",
+ * "remove") into out.  Returns 0, or -1 if msg has no "type:" prefix. */
+int startup_msg_type(const char *msg, char *out, size_t outsz);
+
+/* Find key in the KEY=VALUE list of msg and copy its value, unquoted and
+ * unescaped, into out.  Returns 0, or -1 if the key is absent. */
+int startup_msg_get(const char *msg, const char *key, char *out, size_t outsz);
+
+/* The basename of the first word of the command line cmd: the name a
+ * launch is keyed by in the stats file, however it was started.  Empty if
+ * cmd is blank. */
+void startup_cmd_key(const char *cmd, char *out, size_t outsz);
+
+/* One application's line in the stats file:
+ *   name<TAB>launches<TAB>avg_ms<TAB>last_ms
+ * launches counts launches whose first window was mapped; avg_ms and
+ * last_ms are launch-to-map latencies. */
+typedef struct {
+	char     name[64];
+	unsigned launches;
+	double   avg_ms;
+	double   last_ms;
+} StartupStat;
+
+/* One launch-to-map latency waiting to be written. */
+typedef struct {
+	char   name[64];
+	double ms;
+} StartupSample;
+
+/* $XDG_STATE_HOME/awm/launch_stats, or ~/.local/state/awm/launch_stats. */
+void startup_stats_path(char *out, size_t sz);
+
+/* Add one launch of name that mapped its first window ms milliseconds
+ * after exec.  The file (and its directory) is created if needed and
+ * replaced atomically.  Returns 0, or -1 on I/O error. */
+int startup_stats_record(const char *path, const char *name, double ms);
+
+/* Add the n launches in smp with a single rewrite of the file. */
+int startup_stats_record_n(const char *path, const StartupSample *smp, int n);
+
+/* Read every entry of the stats file into a malloc'd array; *n is set to
+ * the count.  A missing or unreadable file reads as empty (NULL, *n = 0). */
+StartupStat *startup_stats_load(const char *path, int *n);
+
+/* Read name's entry from the stats file.  Returns 0, or -1 if absent. */
+int startup_stats_get(const char *path, const char *name, StartupStat *out);
+
+#endif /* STARTUP_UTIL_H */
@@ -8,6 +8,15 @@
 
 #include <glib.h>
 
+#if defined(__linux__)
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <glib-unix.h>
+#include <linux/netlink.h>
+#endif
+
 #include "awm.h"
 #include "monitor.h"
 #include "status.h"
@@ -21,10 +30,26 @@
  * plus label overhead — 2048 matches STATUS_MAXLEN in status_config.h. */
 #define STATUS_COMPONENT_MAX 2048
 
-static guint  status_timer_id = 0;
-static time_t last_update_time[STATUS_ARGS_LEN];
-static char   cached_results[STATUS_ARGS_LEN][STATUS_COMPONENT_MAX];
-static int    slot_disabled[STATUS_ARGS_LEN];
+#define USEC_PER_SEC G_GINT64_CONSTANT(1000000)
+
+/* The status source is a bare GSource driven purely by
+ * g_source_set_ready_time(): it wakes the loop exactly when the earliest
+ * component is due and sleeps indefinitely when nothing is scheduled. */
+static GSource *status_src = NULL;
+static gint64   next_due[STATUS_ARGS_LEN]; /* g_get_monotonic_time() units */
+static char     cached_results[STATUS_ARGS_LEN][STATUS_COMPONENT_MAX];
+static int      slot_disabled[STATUS_ARGS_LEN];
+/* Wall-clock minus monotonic time when last checked.  It only moves when
+ * the real-time clock is stepped (settimeofday, NTP) or across a suspend,
+ * and then clock-aligned slots hold stale times until realigned. */
+static gint64 wall_offset;
+
+#if defined(__linux__)
+static int   uevent_fd     = -1;
+static guint uevent_src_id = 0;
+static int   clock_fd      = -1; /* timerfd cancelled on clock steps */
+static guint clock_src_id  = 0;
+#endif
 
 static void
 status_set_text(const char *text)
@@ -36,9 +61,75 @@ status_set_text(const char *text)
 	len = strlen(text);
 	if (len >= sizeof(stext))
 		len = sizeof(stext) - 1;
+	/* Identical output: leave stext and barsdirty alone so the bars are
+	 * not redrawn for nothing. */
+	if (strncmp(stext, text, len) == 0 && stext[len] == '\0')
+		return;
 	memcpy(stext, text, len);
 	stext[len] = '\0';
-	barsdirty  = 1;
+	drw_status_compile(drw, stext);
+	barsdirty = 1;
+}
+
+/* Next time slot i should run, given that it has just been refreshed at
+ * monotonic time @now.  STATUS_TRIG_CLOCK slots are aligned to the next
+ * wall-clock multiple of their interval (second, minute, ...) so a
+ * "%H:%M" clock ticks once per minute exactly when the minute changes. */
+static gint64
+status_schedule(size_t i, gint64 now)
+{
+	gint64 period = (gint64) status_args[i].interval * USEC_PER_SEC;
+
+	if (period <= 0)
+		period = USEC_PER_SEC;
+
+	if (status_args[i].trigger == STATUS_TRIG_CLOCK) {
+		gint64 real = g_get_real_time();
+		/* +1 ms so the wakeup lands after the boundary, not on it. */
+		return now + (period - real % period) + 1000;
+	}
+
+	return now + period;
+}
+
+/* Make every STATUS_TRIG_CLOCK slot due now, so it refreshes and is
+ * scheduled again against the new wall clock. */
+static void
+status_realign_clock(gint64 now)
+{
+	size_t i;
+
+	wall_offset = g_get_real_time() - now;
+	for (i = 0; i < STATUS_ARGS_LEN; i++)
+		if (status_args[i].trigger == STATUS_TRIG_CLOCK)
+			next_due[i] = now;
+}
+
+/* Realign clock slots if the wall clock jumped against monotonic time
+ * since the last check.  Catches steps and resumes everywhere, though
+ * only at the next wakeup; Linux also gets woken at once (clock_fd). */
+static void
+status_check_clock(gint64 now)
+{
+	gint64 drift = g_get_real_time() - now - wall_offset;
+
+	if (drift <= -USEC_PER_SEC || drift >= USEC_PER_SEC)
+		status_realign_clock(now);
+}
+
+/* Refresh a single component.  Returns 1 if its output changed. */
+static int
+status_refresh_slot(size_t i)
+{
+	const char *res;
+
+	res = status_args[i].func(status_args[i].args);
+	if (!res || res == status_priming || strcmp(cached_results[i], res) == 0)
+		return 0;
+
+	strncpy(cached_results[i], res, sizeof(cached_results[i]) - 1);
+	cached_results[i][sizeof(cached_results[i]) - 1] = '\0';
+	return 1;
 }
 
 static void
@@ -46,29 +137,38 @@ status_prime_components(void)
 {
 	size_t      i;
 	const char *res;
+	gint64      now = g_get_monotonic_time();
 
-	memset(last_update_time, 0, sizeof(last_update_time));
 	memset(slot_disabled, 0, sizeof(slot_disabled));
+	wall_offset = g_get_real_time() - now;
 	for (i = 0; i < STATUS_ARGS_LEN; i++) {
 		strncpy(cached_results[i], status_unknown_str,
 		    sizeof(cached_results[i]) - 1);
 		cached_results[i][sizeof(cached_results[i]) - 1] = '\0';
+		next_due[i]                                      = now;
 	}
 
 	/* Prime components that require an initial call to seed their state
 	 * (e.g. cpu_perc needs an initial CPU-time snapshot before the first delta
 	 * can be computed).  Using the explicit prime flag avoids fragile
-	 * function-pointer comparisons that break under LTO. */
+	 * function-pointer comparisons that break under LTO.  The seeding
+	 * call's output is discarded, and the first real refresh waits a full
+	 * interval: a delta taken straight after the seed spans microseconds
+	 * and would put a garbage sample into the ^g^ histories. */
+	status_tick++;
 	for (i = 0; i < STATUS_ARGS_LEN; i++) {
-		if (status_args[i].prime)
-			(void) status_args[i].func(status_args[i].args);
+		if (!status_args[i].prime)
+			continue;
+		(void) status_args[i].func(status_args[i].args);
+		next_due[i] = status_schedule(i, now);
 	}
 
 	/* Probe non-prime components once at startup.  If a component returns
 	 * NULL (e.g. battery_status on a machine with no battery), mark the
 	 * slot disabled so it is silently omitted from every status_build()
 	 * pass.  The cache seed is cleared for disabled slots so no stale
-	 * "n/a" string leaks into the bar output. */
+	 * "n/a" string leaks into the bar output.  status_priming (a rate
+	 * with one sample so far) keeps the slot and its "n/a" seed. */
 	for (i = 0; i < STATUS_ARGS_LEN; i++) {
 		if (status_args[i].prime)
 			continue;
@@ -76,40 +176,52 @@ status_prime_components(void)
 		if (res == NULL) {
 			slot_disabled[i]     = 1;
 			cached_results[i][0] = '\0';
-		} else {
+			continue;
+		}
+		if (res != status_priming) {
 			strncpy(cached_results[i], res, sizeof(cached_results[i]) - 1);
 			cached_results[i][sizeof(cached_results[i]) - 1] = '\0';
-			last_update_time[i]                              = time(NULL);
 		}
+		next_due[i] = status_schedule(i, now);
+	}
+}
+
+/* Run every component whose deadline has passed.  Returns 1 if at least
+ * one cached result changed, i.e. the assembled string must be rebuilt. */
+static int
+status_update(gint64 now)
+{
+	size_t i;
+	int    changed = 0;
+
+	status_check_clock(now);
+	status_tick++;
+	for (i = 0; i < STATUS_ARGS_LEN; i++) {
+		if (slot_disabled[i] || next_due[i] > now)
+			continue;
+		changed |= status_refresh_slot(i);
+		next_due[i] = status_schedule(i, now);
 	}
+
+	return changed;
 }
 
 static void
 status_build(char *out, size_t out_len)
 {
 	size_t      i, len;
-	time_t      current_time;
 	const char *res;
 	int         ret;
 
 	if (!out || out_len == 0)
 		return;
 
-	out[0]       = '\0';
-	len          = 0;
-	current_time = time(NULL);
+	out[0] = '\0';
+	len    = 0;
 
 	for (i = 0; i < STATUS_ARGS_LEN; i++) {
 		if (slot_disabled[i])
 			continue;
-		if (current_time - last_update_time[i] >= status_args[i].interval) {
-			res = status_args[i].func(status_args[i].args);
-			if (res) {
-				strncpy(cached_results[i], res, sizeof(cached_results[i]) - 1);
-				cached_results[i][sizeof(cached_results[i]) - 1] = '\0';
-			}
-			last_update_time[i] = current_time;
-		}
 
 		res = cached_results[i];
 		ret = status_esnprintf(status_buf, sizeof(status_buf),
@@ -124,50 +236,306 @@ status_build(char *out, size_t out_len)
 	}
 }
 
-/* GLib timer callback — fires at each status_interval_ms tick. */
-static gboolean
-status_timer_cb(gpointer user_data)
+/* Earliest deadline across all enabled slots, or -1 if nothing is due
+ * (every slot disabled) so the source never wakes. */
+static gint64
+status_next_wakeup(void)
 {
-	(void) user_data;
-	status_resume();
-	/* barsdirty was set by status_set_text; flush immediately since there
-	 * may be no pending X events to trigger x_dispatch_cb. */
+	size_t i;
+	gint64 t = -1;
+
+	for (i = 0; i < STATUS_ARGS_LEN; i++) {
+		if (slot_disabled[i])
+			continue;
+		if (t < 0 || next_due[i] < t)
+			t = next_due[i];
+	}
+
+	return t;
+}
+
+/* Refresh due components and, only if the produced string differs from
+ * the one on screen, redraw the bars.  There may be no pending X events to
+ * trigger x_dispatch_cb, so flush immediately. */
+static void
+status_wakeup(void)
+{
+	char text[STATUS_MAXLEN];
+
+	if (status_update(g_get_monotonic_time())) {
+		status_build(text, sizeof(text));
+		status_set_text(text);
+	}
+	/* A ^g^ graph must be repainted when its history grows even though
+	 * the escape text itself never changes.  Only the histories shown
+	 * count, each against the samples its cached path was built from. */
+	if (drw_status_graphs_stale(drw))
+		barsdirty = 1;
 	if (barsdirty) {
 		drawbars();
 		updatesystray();
 		barsdirty = 0;
 	}
+}
+
+static gboolean
+status_source_dispatch(GSource *src, GSourceFunc cb, gpointer data)
+{
+	(void) cb;
+	(void) data;
+
+	status_wakeup();
+	g_source_set_ready_time(src, status_next_wakeup());
 	return G_SOURCE_CONTINUE;
 }
 
+static GSourceFuncs status_source_funcs = {
+	NULL,
+	NULL,
+	status_source_dispatch,
+	NULL,
+	NULL,
+	NULL,
+};
+
+#if defined(__linux__)
+/* Kernel uevent callback: a power_supply change (AC plugged, battery
+ * status or capacity update) makes every STATUS_TRIG_POWER slot due after
+ * a short debounce, since a single plug event emits several uevents. */
+static gboolean
+status_uevent_cb(gint fd, GIOCondition condition, gpointer user_data)
+{
+	char    buf[4096];
+	ssize_t n;
+	int     hit = 0;
+	size_t  i;
+	gint64  due;
+
+	(void) condition;
+	(void) user_data;
+
+	while ((n = recv(fd, buf, sizeof(buf) - 1, MSG_DONTWAIT)) > 0) {
+		const char *p   = buf;
+		const char *end = buf + n;
+
+		buf[n] = '\0';
+		/* Payload: "action@devpath\0KEY=VALUE\0KEY=VALUE\0..." */
+		for (; p < end; p += strlen(p) + 1) {
+			if (strcmp(p, "SUBSYSTEM=power_supply") == 0) {
+				hit = 1;
+				break;
+			}
+		}
+	}
+	if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+		awm_warn("status: uevent recv: %s", strerror(errno));
+		uevent_src_id = 0;
+		close(uevent_fd);
+		uevent_fd = -1;
+		return G_SOURCE_REMOVE;
+	}
+	if (!hit || !status_src)
+		return G_SOURCE_CONTINUE;
+
+	due = g_get_monotonic_time() + (gint64) status_uevent_delay_ms * 1000;
+	for (i = 0; i < STATUS_ARGS_LEN; i++) {
+		if (status_args[i].trigger == STATUS_TRIG_POWER && next_due[i] > due)
+			next_due[i] = due;
+	}
+	g_source_set_ready_time(status_src, status_next_wakeup());
+
+	return G_SOURCE_CONTINUE;
+}
+
+/* Subscribe to kernel uevents, but only if an enabled slot wants them. */
+static void
+status_uevent_open(GMainContext *ctx)
+{
+	struct sockaddr_nl sa;
+	GSource           *src;
+	size_t             i;
+	int                want = 0;
+
+	for (i = 0; i < STATUS_ARGS_LEN; i++)
+		if (!slot_disabled[i] && status_args[i].trigger == STATUS_TRIG_POWER)
+			want = 1;
+	if (!want)
+		return;
+
+	uevent_fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK,
+	    NETLINK_KOBJECT_UEVENT);
+	if (uevent_fd < 0) {
+		awm_warn("status: uevent socket: %s", strerror(errno));
+		return;
+	}
+
+	memset(&sa, 0, sizeof(sa));
+	sa.nl_family = AF_NETLINK;
+	sa.nl_groups = 1; /* kernel uevent multicast group */
+	if (bind(uevent_fd, (struct sockaddr *) &sa, sizeof(sa)) < 0) {
+		awm_warn("status: uevent bind: %s", strerror(errno));
+		close(uevent_fd);
+		uevent_fd = -1;
+		return;
+	}
+
+	src = g_unix_fd_source_new(uevent_fd, G_IO_IN);
+	g_source_set_callback(src, (GSourceFunc) status_uevent_cb, NULL, NULL);
+	uevent_src_id = g_source_attach(src, ctx);
+	g_source_unref(src);
+}
+
+static void
+status_uevent_close(void)
+{
+	if (uevent_src_id > 0) {
+		g_source_remove(uevent_src_id);
+		uevent_src_id = 0;
+	}
+	if (uevent_fd >= 0) {
+		close(uevent_fd);
+		uevent_fd = -1;
+	}
+}
+
+/* Arm clock_fd for a year ahead.  It is not meant to expire: with
+ * TFD_TIMER_CANCEL_ON_SET, a clock step or a resume from suspend makes it
+ * readable early, with ECANCELED. */
+static int
+status_clock_arm(void)
+{
+	struct itimerspec its;
+
+	memset(&its, 0, sizeof(its));
+	its.it_value.tv_sec = time(NULL) + 365 * 24 * 3600;
+	return timerfd_settime(clock_fd,
+	    TFD_TIMER_ABSTIME | TFD_TIMER_CANCEL_ON_SET, &its, NULL);
+}
+
+static gboolean
+status_clock_cb(gint fd, GIOCondition condition, gpointer user_data)
+{
+	uint64_t expirations;
+
+	(void) condition;
+	(void) user_data;
+
+	/* ECANCELED (the clock was set) or a real expiry: either way rearm */
+	if (read(fd, &expirations, sizeof(expirations)) < 0 &&
+	    errno != ECANCELED && errno != EAGAIN) {
+		awm_warn("status: clock timerfd read: %s", strerror(errno));
+		clock_src_id = 0;
+		close(clock_fd);
+		clock_fd = -1;
+		return G_SOURCE_REMOVE;
+	}
+	status_clock_arm();
+	if (status_src) {
+		status_realign_clock(g_get_monotonic_time());
+		g_source_set_ready_time(status_src, status_next_wakeup());
+	}
+	return G_SOURCE_CONTINUE;
+}
+
+/* Watch for wall-clock steps, but only if an enabled slot is aligned to
+ * the wall clock. */
+static void
+status_clock_open(GMainContext *ctx)
+{
+	GSource *src;
+	size_t   i;
+	int      want = 0;
+
+	for (i = 0; i < STATUS_ARGS_LEN; i++)
+		if (!slot_disabled[i] && status_args[i].trigger == STATUS_TRIG_CLOCK)
+			want = 1;
+	if (!want)
+		return;
+
+	clock_fd = timerfd_create(CLOCK_REALTIME, TFD_CLOEXEC | TFD_NONBLOCK);
+	if (clock_fd < 0 || status_clock_arm() < 0) {
+		awm_warn("status: clock timerfd: %s", strerror(errno));
+		if (clock_fd >= 0)
+			close(clock_fd);
+		clock_fd = -1;
+		return;
+	}
+
+	src = g_unix_fd_source_new(clock_fd, G_IO_IN);
+	g_source_set_callback(src, (GSourceFunc) status_clock_cb, NULL, NULL);
+	clock_src_id = g_source_attach(src, ctx);
+	g_source_unref(src);
+}
+
+static void
+status_clock_close(void)
+{
+	if (clock_src_id > 0) {
+		g_source_remove(clock_src_id);
+		clock_src_id = 0;
+	}
+	if (clock_fd >= 0) {
+		close(clock_fd);
+		clock_fd = -1;
+	}
+}
+#else
+/* No uevent equivalent wired up: STATUS_TRIG_POWER slots fall back to
+ * polling on their interval. */
+static void
+status_uevent_open(GMainContext *ctx)
+{
+	(void) ctx;
+}
+
+static void
+status_uevent_close(void)
+{
+}
+
+/* Clock steps are caught by status_check_clock() at the next wakeup */
+static void
+status_clock_open(GMainContext *ctx)
+{
+	(void) ctx;
+}
+
+static void
+status_clock_close(void)
+{
+}
+#endif
+
 void
 status_init(GMainContext *ctx)
 {
-	unsigned int interval_ms = status_interval_ms ? status_interval_ms : 1000;
-
 	status_prime_components();
+	drw_set_graph_fetch(drw, status_hist_fetch);
 
-	/* Attach the repeating timer to the provided context.
+	/* Attach the scheduling source to the provided context.
 	 * g_source_attach() requires we create the source manually so we can
 	 * target a specific context rather than always the default one. */
-	{
-		GSource *src = g_timeout_source_new(interval_ms);
-		g_source_set_callback(src, status_timer_cb, NULL, NULL);
-		g_source_set_priority(src, G_PRIORITY_DEFAULT);
-		status_timer_id = g_source_attach(src, ctx);
-		g_source_unref(src);
-	}
+	status_src = g_source_new(&status_source_funcs, sizeof(GSource));
+	g_source_set_priority(status_src, G_PRIORITY_DEFAULT);
+	g_source_attach(status_src, ctx);
+
+	status_uevent_open(ctx);
+	status_clock_open(ctx);
 
 	/* Fire once immediately so the bar shows data before the first tick. */
 	status_resume();
+	g_source_set_ready_time(status_src, status_next_wakeup());
 }
 
 void
 status_cleanup(void)
 {
-	if (status_timer_id > 0) {
-		g_source_remove(status_timer_id);
-		status_timer_id = 0;
+	status_uevent_close();
+	status_clock_close();
+	if (status_src) {
+		g_source_destroy(status_src);
+		g_source_unref(status_src);
+		status_src = NULL;
 	}
 }
 
@@ -176,6 +544,7 @@ status_resume(void)
 {
 	char text[STATUS_MAXLEN];
 
+	(void) status_update(g_get_monotonic_time());
 	status_build(text, sizeof(text));
 	status_set_text(text);
 }
@@ -7,14 +7,15 @@
 #include <glib.h>
 
 /*
- * status_init - initialise the status bar timer.
+ * status_init - initialise the status bar scheduler.
  *
- * @ctx: the GMainContext to attach the timer source to.  Pass NULL to use
+ * @ctx: the GMainContext to attach the sources to.  Pass NULL to use
  *       the default (main-thread) context.
  *
- * Creates a GTimeout source and attaches it to @ctx so that status_resume()
- * is called automatically at each tick without the caller needing to watch
- * any file descriptor.
+ * Attaches a ready-time GSource to @ctx that wakes only when the earliest
+ * component is due (per its interval or wall-clock alignment), plus a
+ * kernel uevent source on Linux for power_supply-triggered components.
+ * The bars are redrawn only when the assembled string changes.
  */
 void status_init(GMainContext *ctx);
 void status_cleanup(void);
@@ -11,11 +11,77 @@
 
 #define CPU_PERCPU_MAX 64
 
+/* Maximum distinct interfaces/disks tracked by the rate components. */
+#define RATE_KEYS_MAX 16
+
 #if defined(__linux__)
 #include <stdint.h>
 #include <unistd.h>
 #endif
 
+#if defined(__linux__) || defined(__OpenBSD__) || defined(__FreeBSD__)
+/* Per-key pair of rate trackers (rx/tx, read/write) for the components
+ * that report counter deltas.  Keyed by the status_args argument so that
+ * several interfaces or disks can be shown at once. */
+struct rate_pair {
+	char               key[32];
+	struct status_rate r[2];
+};
+
+static struct status_rate *
+rate_lookup(struct rate_pair *tab, const char *key, int which)
+{
+	int i;
+
+	for (i = 0; i < RATE_KEYS_MAX && tab[i].key[0]; i++)
+		if (!strcmp(tab[i].key, key))
+			return &tab[i].r[which];
+	if (i == RATE_KEYS_MAX)
+		return NULL;
+
+	snprintf(tab[i].key, sizeof(tab[i].key), "%s", key);
+	return &tab[i].r[which];
+}
+
+/* Feed a counter into the tracker for (key, which) and format the rate.
+ * Returns status_priming until two samples far enough apart have been
+ * seen, and NULL only if the tracker table is full.  If
+ * @hist is a history id, rates of the first key in @tab are recorded. */
+static const char *
+rate_fmt(struct rate_pair *tab, const char *key, int which, uintmax_t value,
+    double t, int hist)
+{
+	struct status_rate *r;
+	double              rate;
+
+	if (!key || !(r = rate_lookup(tab, key, which)))
+		return NULL;
+	rate = status_rate_update(r, value, t);
+	if (rate < 0)
+		return status_priming;
+	if (hist >= 0 && r == &tab[0].r[which])
+		status_hist_record((unsigned int) hist, rate);
+
+	return status_fmt_human((uintmax_t) rate, 1024);
+}
+
+/* Record per-core samples and their mean as total CPU.  Skipped for the
+ * seeding call, whose out[] values carry no delta yet. */
+static void
+cpu_hist_record(const int *out, int n, int primed)
+{
+	int i, sum = 0;
+
+	if (!primed || n <= 0)
+		return;
+	for (i = 0; i < n; i++) {
+		status_hist_record(STATUS_HIST_CORE0 + (unsigned int) i, out[i]);
+		sum += out[i];
+	}
+	status_hist_record(STATUS_HIST_CPU, (double) sum / n);
+}
+#endif
+
 const char *
 battery_status(const char *bat)
 {
@@ -299,6 +365,7 @@ cpu_perc(const char *unused)
 {
 	static long double a[7];
 	long double        b[7], sum;
+	int                perc;
 
 	memcpy(b, a, sizeof(b));
 	if (status_pscanf("/proc/stat", "%*s %Lf %Lf %Lf %Lf %Lf %Lf %Lf", &a[0],
@@ -314,11 +381,13 @@ cpu_perc(const char *unused)
 	if (sum == 0)
 		return NULL;
 
-	return status_bprintf("%d",
-	    (int) (100 *
-	        ((b[0] + b[1] + b[2] + b[5] + b[6]) -
-	            (a[0] + a[1] + a[2] + a[5] + a[6])) /
-	        sum));
+	perc = (int) (100 *
+	    ((b[0] + b[1] + b[2] + b[5] + b[6]) -
+	        (a[0] + a[1] + a[2] + a[5] + a[6])) /
+	    sum);
+	status_hist_record(STATUS_HIST_CPU, perc);
+
+	return status_bprintf("%d", perc);
 }
 
 /* cpu_percpu — read per-core usage from /proc/stat.
@@ -334,6 +403,7 @@ cpu_percpu(int *out, int maxcores)
 	char               line[256];
 	int                n = 0;
 	int                i;
+	int                primed = prev[0][0] != 0;
 
 	fp = fopen("/proc/stat", "r");
 	if (!fp)
@@ -375,6 +445,7 @@ cpu_percpu(int *out, int maxcores)
 		}
 		memcpy(prev[i], cur[i], sizeof(prev[i]));
 	}
+	cpu_hist_record(out, n, primed);
 
 	return n;
 }
@@ -390,6 +461,7 @@ cpu_perc(const char *unused)
 	static uintmax_t a[CPUSTATES];
 	uintmax_t        b[CPUSTATES], sum;
 	size_t           size;
+	int              perc;
 
 	mib[0] = CTL_KERN;
 	mib[1] = KERN_CPTIME;
@@ -407,11 +479,13 @@ cpu_perc(const char *unused)
 	if (sum == 0)
 		return NULL;
 
-	return status_bprintf("%d",
-	    100 *
-	        ((a[CP_USER] + a[CP_NICE] + a[CP_SYS] + a[CP_INTR]) -
-	            (b[CP_USER] + b[CP_NICE] + b[CP_SYS] + b[CP_INTR])) /
-	        sum);
+	perc = (int) (100 *
+	    ((a[CP_USER] + a[CP_NICE] + a[CP_SYS] + a[CP_INTR]) -
+	        (b[CP_USER] + b[CP_NICE] + b[CP_SYS] + b[CP_INTR])) /
+	    sum);
+	status_hist_record(STATUS_HIST_CPU, perc);
+
+	return status_bprintf("%d", perc);
 }
 
 int
@@ -423,6 +497,7 @@ cpu_percpu(int *out, int maxcores)
 	uint64_t        sum;
 	int             mib[3];
 	int             ncpu, n, i, j;
+	int             primed = prev[0][CP_USER] != 0;
 	size_t          size;
 
 	if (!out || maxcores <= 0)
@@ -464,6 +539,7 @@ cpu_percpu(int *out, int maxcores)
 		for (j = 0; j < CPUSTATES; j++)
 			prev[i][j] = cur[j];
 	}
+	cpu_hist_record(out, i, primed);
 
 	return i;
 #else
@@ -483,6 +559,7 @@ cpu_perc(const char *unused)
 	size_t      size;
 	static long a[CPUSTATES];
 	long        b[CPUSTATES], sum;
+	int         perc;
 
 	size = sizeof(a);
 	memcpy(b, a, sizeof(b));
@@ -497,11 +574,13 @@ cpu_perc(const char *unused)
 	if (sum == 0)
 		return NULL;
 
-	return status_bprintf("%d",
-	    100 *
-	        ((a[CP_USER] + a[CP_NICE] + a[CP_SYS] + a[CP_INTR]) -
-	            (b[CP_USER] + b[CP_NICE] + b[CP_SYS] + b[CP_INTR])) /
-	        sum);
+	perc = (int) (100 *
+	    ((a[CP_USER] + a[CP_NICE] + a[CP_SYS] + a[CP_INTR]) -
+	        (b[CP_USER] + b[CP_NICE] + b[CP_SYS] + b[CP_INTR])) /
+	    sum);
+	status_hist_record(STATUS_HIST_CPU, perc);
+
+	return status_bprintf("%d", perc);
 }
 
 int
@@ -511,6 +590,7 @@ cpu_percpu(int *out, int maxcores)
 	long        cur[CPU_PERCPU_MAX][CPUSTATES];
 	long        sum;
 	int         ncpu, n, i, j;
+	int         primed = prev[0][CP_USER] != 0;
 	size_t      size;
 
 	if (!out || maxcores <= 0)
@@ -555,6 +635,7 @@ cpu_percpu(int *out, int maxcores)
 		for (j = 0; j < CPUSTATES; j++)
 			prev[i][j] = cur[i][j];
 	}
+	cpu_hist_record(out, n, primed);
 
 	return n;
 }
@@ -571,6 +652,93 @@ cpu_percpu(int *out, int maxcores)
 }
 #endif
 
+#if defined(__linux__)
+/* /proc/diskstats snapshot, re-read at most once per status tick so the
+ * read and write components of every disk share one sample. */
+#define DISKSTATS_MAX 64
+#define DISK_SECTOR 512
+
+static struct {
+	char      name[32];
+	uintmax_t rd, wr; /* sectors */
+} diskstats[DISKSTATS_MAX];
+static int           diskstats_n;
+static double        diskstats_t;
+static unsigned long diskstats_tick = (unsigned long) -1;
+static struct rate_pair disk_rates[RATE_KEYS_MAX];
+
+static int
+diskstats_find(const char *dev)
+{
+	FILE *fp;
+	char  line[256];
+	int   i;
+
+	if (diskstats_tick != status_tick) {
+		diskstats_tick = status_tick;
+		diskstats_n    = 0;
+		diskstats_t    = status_now();
+		if (!(fp = fopen("/proc/diskstats", "r"))) {
+			status_warn("fopen '/proc/diskstats' failed");
+			return -1;
+		}
+		/* major minor name reads merged sectors ms writes merged sectors */
+		while (diskstats_n < DISKSTATS_MAX && fgets(line, sizeof(line), fp)) {
+			if (sscanf(line, "%*u %*u %31s %*u %*u %ju %*u %*u %*u %ju",
+			        diskstats[diskstats_n].name, &diskstats[diskstats_n].rd,
+			        &diskstats[diskstats_n].wr) == 3)
+				diskstats_n++;
+		}
+		fclose(fp);
+	}
+
+	for (i = 0; i < diskstats_n; i++)
+		if (!strcmp(diskstats[i].name, dev))
+			return i;
+
+	return -1;
+}
+
+const char *
+disk_read(const char *dev)
+{
+	int i;
+
+	if (!dev || (i = diskstats_find(dev)) < 0)
+		return NULL;
+
+	return rate_fmt(
+	    disk_rates, dev, 0, diskstats[i].rd * DISK_SECTOR, diskstats_t, -1);
+}
+
+const char *
+disk_write(const char *dev)
+{
+	int i;
+
+	if (!dev || (i = diskstats_find(dev)) < 0)
+		return NULL;
+
+	return rate_fmt(
+	    disk_rates, dev, 1, diskstats[i].wr * DISK_SECTOR, diskstats_t, -1);
+}
+#else
+/* No portable per-disk counters outside Linux; the slot is disabled. */
+const char *
+disk_read(const char *dev)
+{
+	(void) dev;
+	return NULL;
+}
+
+const char *
+disk_write(const char *dev)
+{
+	(void) dev;
+	return NULL;
+}
+#endif
+
 const char *
 datetime(const char *fmt)
 {
@@ -602,6 +770,138 @@ load_avg(const char *unused)
 	return status_bprintf("%d.%d", whole, frac);
 }
 
+#if defined(__linux__) || defined(__OpenBSD__) || defined(__FreeBSD__)
+/* Per-interface byte counters, sampled at most once per status tick so
+ * the rx and tx components of every interface share one read. */
+#define NETDEV_MAX 32
+
+static struct {
+	char      name[32];
+	uintmax_t rx, tx;
+} netdev[NETDEV_MAX];
+static int              netdev_n;
+static double           netdev_t;
+static unsigned long    netdev_tick = (unsigned long) -1;
+static struct rate_pair net_rates[RATE_KEYS_MAX];
+
+#if defined(__linux__)
+static void
+netdev_sample(void)
+{
+	FILE *fp;
+	char  line[512];
+	char *colon, *name;
+
+	if (!(fp = fopen("/proc/net/dev", "r"))) {
+		status_warn("fopen '/proc/net/dev' failed");
+		return;
+	}
+	/* "  eth0: rx_bytes packets errs drop fifo frame compressed multicast
+	 *   tx_bytes ..." — the two header lines have no ':' before a number */
+	while (netdev_n < NETDEV_MAX && fgets(line, sizeof(line), fp)) {
+		if (!(colon = strchr(line, ':')))
+			continue;
+		*colon = '\0';
+		for (name = line; *name == ' '; name++)
+			;
+		if (sscanf(colon + 1, "%ju %*u %*u %*u %*u %*u %*u %*u %ju",
+		        &netdev[netdev_n].rx, &netdev[netdev_n].tx) != 2)
+			continue;
+		snprintf(netdev[netdev_n].name, sizeof(netdev[netdev_n].name), "%s",
+		    name);
+		netdev_n++;
+	}
+	fclose(fp);
+}
+#else
+#include <ifaddrs.h>
+#include <net/if.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+
+static void
+netdev_sample(void)
+{
+	struct ifaddrs *ifal, *ifa;
+	struct if_data *ifd;
+
+	if (getifaddrs(&ifal) < 0) {
+		status_warn("getifaddrs failed");
+		return;
+	}
+	/* One AF_LINK entry per interface carries the if_data counters. */
+	for (ifa = ifal; ifa && netdev_n < NETDEV_MAX; ifa = ifa->ifa_next) {
+		if (!ifa->ifa_addr || ifa->ifa_addr->sa_family != AF_LINK ||
+		    !(ifd = (struct if_data *) ifa->ifa_data))
+			continue;
+		snprintf(netdev[netdev_n].name, sizeof(netdev[netdev_n].name), "%s",
+		    ifa->ifa_name);
+		netdev[netdev_n].rx = ifd->ifi_ibytes;
+		netdev[netdev_n].tx = ifd->ifi_obytes;
+		netdev_n++;
+	}
+	freeifaddrs(ifal);
+}
+#endif
+
+static int
+netdev_find(const char *iface)
+{
+	int i;
+
+	if (netdev_tick != status_tick) {
+		netdev_tick = status_tick;
+		netdev_n    = 0;
+		netdev_t    = status_now();
+		netdev_sample();
+	}
+
+	for (i = 0; i < netdev_n; i++)
+		if (!strcmp(netdev[i].name, iface))
+			return i;
+
+	return -1;
+}
+
+const char *
+netspeed_rx(const char *iface)
+{
+	int i;
+
+	if (!iface || (i = netdev_find(iface)) < 0)
+		return NULL;
+
+	return rate_fmt(
+	    net_rates, iface, 0, netdev[i].rx, netdev_t, STATUS_HIST_NET_RX);
+}
+
+const char *
+netspeed_tx(const char *iface)
+{
+	int i;
+
+	if (!iface || (i = netdev_find(iface)) < 0)
+		return NULL;
+
+	return rate_fmt(
+	    net_rates, iface, 1, netdev[i].tx, netdev_t, STATUS_HIST_NET_TX);
+}
+#else
+const char *
+netspeed_rx(const char *iface)
+{
+	(void) iface;
+	return NULL;
+}
+
+const char *
+netspeed_tx(const char *iface)
+{
+	(void) iface;
+	return NULL;
+}
+#endif
+
 #if defined(__linux__)
 const char *
 ram_total(const char *unused)
@@ -629,6 +929,8 @@ ram_used(const char *unused)
 		return NULL;
 
 	used = (total - free - buffers - cached);
+	if (total > 0)
+		status_hist_record(STATUS_HIST_RAM, (double) used * 100 / total);
 	return status_fmt_human(used * 1024, 1024);
 }
 #elif defined(__OpenBSD__)
@@ -712,6 +1014,79 @@ ram_used(const char *unused)
 }
 #endif
 
+#if defined(__linux__)
+#define THERMAL_TEMP "/sys/class/thermal/%s/temp"
+
+const char *
+temp(const char *zone)
+{
+	uintmax_t millic;
+	char      path[PATH_MAX];
+
+	if (!zone)
+		return NULL;
+	if (zone[0] == '/')
+		snprintf(path, sizeof(path), "%s", zone);
+	else if (status_esnprintf(path, sizeof(path), THERMAL_TEMP, zone) < 0)
+		return NULL;
+	if (status_pscanf(path, "%ju", &millic) != 1)
+		return NULL;
+
+	return status_bprintf("%ju", millic / 1000);
+}
+#elif defined(__OpenBSD__)
+#include <sys/time.h> /* before <sys/sensors.h> for struct timeval */
+#include <sys/sensors.h>
+
+const char *
+temp(const char *unused)
+{
+	int           mib[5];
+	size_t        size;
+	struct sensor sensor;
+
+	mib[0] = CTL_HW;
+	mib[1] = HW_SENSORS;
+	mib[2] = 0; /* cpu0 */
+	mib[3] = SENSOR_TEMP;
+	mib[4] = 0; /* temp0 */
+
+	size = sizeof(sensor);
+	if (sysctl(mib, 5, &sensor, &size, NULL, 0) < 0) {
+		status_warn("sysctl 'SENSOR_TEMP' failed");
+		return NULL;
+	}
+
+	/* µK to Celsius */
+	return status_bprintf("%d", (int) ((sensor.value - 273150000) / 1000000));
+}
+#elif defined(__FreeBSD__)
+#define ACPI_TEMP "hw.acpi.thermal.%s.temperature"
+
+const char *
+temp(const char *zone)
+{
+	char   name[256];
+	int    t;
+	size_t len;
+
+	len = sizeof(t);
+	if (status_esnprintf(name, sizeof(name), ACPI_TEMP, zone) < 0 ||
+	    sysctlbyname(name, &t, &len, NULL, 0) < 0 || !len)
+		return NULL;
+
+	/* decikelvin to Celsius */
+	return status_bprintf("%d", (t - 2731) / 10);
+}
+#else
+const char *
+temp(const char *zone)
+{
+	(void) zone;
+	return NULL;
+}
+#endif
+
 #if defined(CLOCK_BOOTTIME)
 #define UPTIME_FLAG CLOCK_BOOTTIME
 #elif defined(CLOCK_UPTIME)
@@ -20,16 +20,32 @@ const char *cpu_perc(const char *unused);
  * platforms return 0 immediately. */
 int cpu_percpu(int *out, int maxcores);
 
+/* disk I/O throughput (bytes/s) for a block device from /proc/diskstats,
+ * e.g. "nvme0n1".  Rate components return status_priming until their
+ * second sample; prime=1 in status_args takes the first one earlier. */
+const char *disk_read(const char *dev);
+const char *disk_write(const char *dev);
+
 /* datetime */
 const char *datetime(const char *fmt);
 
 /* load average */
 const char *load_avg(const char *unused);
 
+/* network throughput (bytes/s) for an interface, e.g. "wlan0".
+ * A rate component, as disk_read above. */
+const char *netspeed_rx(const char *iface);
+const char *netspeed_tx(const char *iface);
+
 /* ram */
 const char *ram_total(const char *unused);
 const char *ram_used(const char *unused);
 
+/* temperature in degrees Celsius.  Linux: a thermal zone name under
+ * /sys/class/thermal (e.g. "thermal_zone0") or an absolute sysfs path;
+ * FreeBSD: an ACPI zone (e.g. "tz0"); OpenBSD: ignored (cpu0 temp0). */
+const char *temp(const char *zone);
+
 /* uptime */
 const char *uptime(const char *unused);
 
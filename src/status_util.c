@@ -4,12 +4,18 @@
 #include <errno.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #include "log.h"
 #include "status_util.h"
 
-char status_buf[1024];
+char          status_buf[1024];
+unsigned long status_tick;
+const char    status_priming[] = "";
+
+static struct status_hist status_hists[STATUS_HIST_LAST];
 
 void
 status_warn(const char *fmt, ...)
@@ -119,3 +125,129 @@ status_pscanf(const char *path, const char *fmt, ...)
 
 	return (n == EOF) ? -1 : n;
 }
+
+/* Monotonic time in seconds, for rate computations. */
+double
+status_now(void)
+{
+	struct timespec ts;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &ts) < 0)
+		return 0.0;
+
+	return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
+
+/* Feed a sample of counter @value taken at time @t.  Returns the rate in
+ * units per second, or -1 when no rate is available yet: on the first
+ * sample, or after the counter went backwards (interface re-created,
+ * device re-plugged), which restarts the tracker.  A sample taken less
+ * than STATUS_RATE_MIN_DT after the previous one (e.g. the prime call
+ * immediately followed by the first update) is ignored and the previous
+ * rate returned, so a tiny window never produces a wildly noisy value. */
+double
+status_rate_update(struct status_rate *r, uintmax_t value, double t)
+{
+	if (r->primed && t - r->prev_t < STATUS_RATE_MIN_DT)
+		return r->rate;
+
+	if (!r->primed || value < r->prev)
+		r->rate = -1.0;
+	else
+		r->rate = (double) (value - r->prev) / (t - r->prev_t);
+
+	r->prev   = value;
+	r->prev_t = t;
+	r->primed = 1;
+
+	return r->rate;
+}
+
+/* Append a sample to @h, evicting the oldest once full. */
+void
+status_hist_push(struct status_hist *h, double value)
+{
+	h->v[h->head]                   = (float) value;
+	h->v[h->head + STATUS_HIST_LEN] = (float) value;
+	h->head                         = (h->head + 1) % STATUS_HIST_LEN;
+	if (h->n < STATUS_HIST_LEN)
+		h->n++;
+	h->seq++;
+}
+
+/* Contiguous newest-last view of the samples in @h; *n receives the count. */
+const float *
+status_hist_view(const struct status_hist *h, unsigned int *n)
+{
+	*n = h->n;
+	return &h->v[h->head + STATUS_HIST_LEN - h->n];
+}
+
+/* Record a sample for metric @id.  Several components may feed the same
+ * metric (cpu_perc and cpu_percpu both know total CPU); within one status
+ * tick the newest value replaces the previous one instead of adding a
+ * second sample, so the history advances exactly once per tick. */
+void
+status_hist_record(unsigned int id, double value)
+{
+	struct status_hist *h;
+	unsigned int        last;
+
+	if (id >= STATUS_HIST_LAST)
+		return;
+	h = &status_hists[id];
+
+	if (h->n > 0 && h->tick == status_tick) {
+		last = (h->head + STATUS_HIST_LEN - 1) % STATUS_HIST_LEN;
+		h->v[last]                   = (float) value;
+		h->v[last + STATUS_HIST_LEN] = (float) value;
+		h->seq++;
+	} else {
+		status_hist_push(h, value);
+	}
+	h->tick = status_tick;
+}
+
+/* Graph source for drw_draw_statusd(): returns the history's seq (0 if the
+ * metric is unknown or empty) and its newest-last samples via @v/@n. */
+unsigned long
+status_hist_fetch(unsigned int id, const float **v, unsigned int *n)
+{
+	if (id >= STATUS_HIST_LAST || status_hists[id].n == 0) {
+		*n = 0;
+		return 0;
+	}
+
+	*v = status_hist_view(&status_hists[id], n);
+	return status_hists[id].seq;
+}
+
+/* Map a metric name ("cpu", "ram", "rx", "tx", "core<N>") to its id, and
+ * its natural full-scale value to @max (0 = autoscale to the window peak).
+ * Returns -1 for unknown names. */
+int
+status_hist_lookup(const char *name, double *max)
+{
+	char *end;
+	long  core;
+
+	*max = 100.0;
+	if (!strcmp(name, "cpu"))
+		return STATUS_HIST_CPU;
+	if (!strcmp(name, "ram"))
+		return STATUS_HIST_RAM;
+	if (!strncmp(name, "core", 4)) {
+		core = strtol(name + 4, &end, 10);
+		if (end == name + 4 || *end || core < 0 || core >= STATUS_HIST_CORES)
+			return -1;
+		return STATUS_HIST_CORE0 + (int) core;
+	}
+
+	*max = 0.0;
+	if (!strcmp(name, "rx"))
+		return STATUS_HIST_NET_RX;
+	if (!strcmp(name, "tx"))
+		return STATUS_HIST_NET_TX;
+
+	return -1;
+}
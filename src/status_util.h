@@ -9,12 +9,67 @@
 
 #define STATUS_LEN(x) (sizeof(x) / sizeof((x)[0]))
 
+/* Minimum spacing (seconds) between two samples fed to a status_rate. */
+#define STATUS_RATE_MIN_DT 0.5
+
 extern char status_buf[1024];
 
+/* Bumped by status.c once per update pass.  Components that read a shared
+ * source (/proc/net/dev, /proc/diskstats) re-read it only when this changes,
+ * so several slots fed from one file cost a single sample per tick. */
+extern unsigned long status_tick;
+
+/* Returned by a component that works but has no value yet, such as a rate
+ * before its second sample.  Unlike NULL ("not available here") it keeps
+ * the slot enabled; the previous output stays on screen. */
+extern const char status_priming[];
+
+/* Delta-rate tracker for a monotonically increasing counter (bytes,
+ * sectors, ...).  Zero-initialise before first use. */
+struct status_rate {
+	uintmax_t prev;   /* counter value at the previous sample */
+	double    prev_t; /* monotonic timestamp of the previous sample (s) */
+	double    rate;   /* last computed rate (units/s), -1 if none */
+	int       primed; /* prev/prev_t hold a valid sample */
+};
+
 void status_warn(const char *fmt, ...);
 int status_esnprintf(char *str, size_t size, const char *fmt, ...);
 const char *status_bprintf(const char *fmt, ...);
 const char *status_fmt_human(uintmax_t num, int base);
 int status_pscanf(const char *path, const char *fmt, ...);
+double status_now(void);
+double status_rate_update(struct status_rate *r, uintmax_t value, double t);
+
+/* Sample histories for the ^g^ status2d graph escape.  Each metric keeps
+ * the last STATUS_HIST_LEN samples in a ring written twice (at i and
+ * i + STATUS_HIST_LEN), so the newest-last window is always one contiguous
+ * slice and the renderer never copies or wraps. */
+#define STATUS_HIST_LEN 64
+#define STATUS_HIST_CORES 64
+
+enum {
+	STATUS_HIST_CPU,    /* total CPU busy, percent */
+	STATUS_HIST_RAM,    /* used RAM, percent */
+	STATUS_HIST_NET_RX, /* first tracked interface, bytes/s */
+	STATUS_HIST_NET_TX,
+	STATUS_HIST_CORE0, /* per-core busy percent: STATUS_HIST_CORE0 + n */
+	STATUS_HIST_LAST = STATUS_HIST_CORE0 + STATUS_HIST_CORES
+};
+
+struct status_hist {
+	float         v[STATUS_HIST_LEN * 2];
+	unsigned int  head;  /* slot of the next write, 0..STATUS_HIST_LEN-1 */
+	unsigned int  n;     /* valid samples, <= STATUS_HIST_LEN */
+	unsigned long seq;   /* bumped on every change; 0 = never written */
+	unsigned long tick;  /* status_tick of the newest sample */
+};
+
+void status_hist_push(struct status_hist *h, double value);
+const float *status_hist_view(const struct status_hist *h, unsigned int *n);
+void status_hist_record(unsigned int id, double value);
+unsigned long status_hist_fetch(
+    unsigned int id, const float **v, unsigned int *n);
+int status_hist_lookup(const char *name, double *max);
 
 #endif /* STATUS_UTIL_H */
@@ -132,7 +132,7 @@ updatesystray(void)
 	Client      *i;
 	Monitor     *m = systraytomon(NULL);
 	int          x;
-	unsigned int sw = TEXTW(stext) - lrpad + systrayspacing;
+	unsigned int sw = (unsigned int) drw_status_width(drw) + systrayspacing;
 	unsigned int w  = 1;
 
 	assert(m != NULL);
@@ -0,0 +1,315 @@
+/* AndrathWM — awm/awm-ui message encoding and validation
+ * See LICENSE file for copyright and license details.
+ *
+ * Everything here is driven by the UI_PROTO_MESSAGES schema in ui_proto.h.
+ * Pure C (no GLib, no X), linked into awm, awm-ui and the unit tests.
+ */
+
+#include <errno.h>
+#include <stddef.h>
+#include <sys/socket.h>
+
+#include "ui_proto.h"
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+/* -------------------------------------------------------------------------
+ * Spec table
+ * ---------------------------------------------------------------------- */
+
+#define S_EMPTY(NAME, name, id) [id] = { #NAME, UI_SHAPE_EMPTY, 0, 0, 0, 0 },
+#define S_FIXED(NAME, name, id, T) \
+	[id] = { #NAME, UI_SHAPE_FIXED, sizeof(T), 0, 0, 0 },
+#define S_ARRAY(NAME, name, id, T, E, count) \
+	[id] = { #NAME, UI_SHAPE_ARRAY, sizeof(T), sizeof(E), \
+		offsetof(T, count), 0 },
+#define S_STRINGS(NAME, name, id, max) \
+	[id] = { #NAME, UI_SHAPE_STRINGS, 0, 0, 0, max },
+#define S_BULK(NAME, name, id, T, E, count) \
+	[id] = { #NAME, UI_SHAPE_BULK, sizeof(T), sizeof(E), \
+		offsetof(T, count), 0 },
+#define S_FD(NAME, name, id) [id] = { #NAME, UI_SHAPE_FD, 0, 0, 0, 0 },
+
+static const UiMsgSpec specs[UI_MSG_ID_MAX + 1] = { UI_PROTO_MESSAGES(
+	S_EMPTY, S_FIXED, S_ARRAY, S_STRINGS, S_BULK, S_FD) };
+
+#undef S_EMPTY
+#undef S_FIXED
+#undef S_ARRAY
+#undef S_STRINGS
+#undef S_BULK
+#undef S_FD
+
+const UiMsgSpec *
+ui_msg_spec(uint32_t type)
+{
+	if (type > UI_MSG_ID_MAX || !specs[type].name)
+		return NULL;
+	return &specs[type];
+}
+
+const char *
+ui_msg_name(uint32_t type)
+{
+	const UiMsgSpec *s = ui_msg_spec(type);
+
+	return s ? s->name : "?";
+}
+
+uint32_t
+ui_msg_max_elems(UiMsgType type)
+{
+	const UiMsgSpec *s = ui_msg_spec(type);
+
+	if (!s || s->shape != UI_SHAPE_ARRAY)
+		return 0;
+	return (UI_MSG_MAX_PAYLOAD - s->fixed) / s->elem;
+}
+
+/* -------------------------------------------------------------------------
+ * T + E[count] layout, shared by ARRAY payloads and BULK contents
+ * ---------------------------------------------------------------------- */
+
+static ssize_t
+array_encode(const UiMsgSpec *s, uint8_t *dst, size_t cap, const void *fixed,
+    const void *elems, uint32_t n)
+{
+	size_t len;
+
+	if (!fixed || (n && !elems)) {
+		errno = EINVAL;
+		return -1;
+	}
+	if (n > (SIZE_MAX - s->fixed) / s->elem ||
+	    (len = s->fixed + (size_t) n * s->elem) > cap) {
+		errno = EMSGSIZE;
+		return -1;
+	}
+	memcpy(dst, fixed, s->fixed);
+	memcpy(dst + s->count_off, &n, sizeof(n));
+	if (n)
+		memcpy(dst + s->fixed, elems, (size_t) n * s->elem);
+	return (ssize_t) len;
+}
+
+static int
+array_decode(const UiMsgSpec *s, const uint8_t *p, size_t len, UiMsgView *v)
+{
+	uint32_t n;
+
+	if (len < s->fixed)
+		return -1;
+	memcpy(&n, p + s->count_off, sizeof(n));
+	/* exact: a count that disagrees with the length is a broken sender */
+	if (n != (len - s->fixed) / s->elem ||
+	    (len - s->fixed) % s->elem != 0)
+		return -1;
+	v->elems = p + s->fixed;
+	v->count = n;
+	return 0;
+}
+
+/* -------------------------------------------------------------------------
+ * Inline messages
+ * ---------------------------------------------------------------------- */
+
+ssize_t
+ui_msg_encode(void *buf, size_t cap, UiMsgType type, const void *fixed,
+    const void *elems, uint32_t n)
+{
+	const UiMsgSpec *s = ui_msg_spec(type);
+	uint8_t         *p = (uint8_t *) buf + sizeof(UiMsgHeader);
+	UiMsgHeader      hdr;
+	ssize_t          len = 0;
+
+	if (!s || s->shape == UI_SHAPE_FD) {
+		errno = EINVAL;
+		return -1;
+	}
+	if (cap < sizeof(hdr)) {
+		errno = EMSGSIZE;
+		return -1;
+	}
+	cap -= sizeof(hdr);
+	if (cap > UI_MSG_MAX_PAYLOAD)
+		cap = UI_MSG_MAX_PAYLOAD;
+
+	switch (s->shape) {
+	case UI_SHAPE_EMPTY:
+		break;
+	case UI_SHAPE_FIXED:
+	case UI_SHAPE_BULK: {
+		size_t sz = s->shape == UI_SHAPE_BULK ? sizeof(UiArenaRef) : s->fixed;
+		if (!fixed) {
+			errno = EINVAL;
+			return -1;
+		}
+		if (sz > cap) {
+			errno = EMSGSIZE;
+			return -1;
+		}
+		memcpy(p, fixed, sz);
+		len = (ssize_t) sz;
+		break;
+	}
+	case UI_SHAPE_ARRAY:
+		if ((len = array_encode(s, p, cap, fixed, elems, n)) < 0)
+			return -1;
+		break;
+	case UI_SHAPE_STRINGS: {
+		const char *const *str = elems;
+		if (n == 0 || n > s->max || !str) {
+			errno = EINVAL;
+			return -1;
+		}
+		for (uint32_t i = 0; i < n; i++) {
+			size_t sl = strlen(str[i]) + 1;
+			if (sl > cap - (size_t) len) {
+				errno = EMSGSIZE;
+				return -1;
+			}
+			memcpy(p + len, str[i], sl);
+			len += (ssize_t) sl;
+		}
+		break;
+	}
+	case UI_SHAPE_FD:
+		break;
+	}
+
+	hdr.type        = (uint32_t) type;
+	hdr.payload_len = (uint32_t) len;
+	memcpy(buf, &hdr, sizeof(hdr));
+	return (ssize_t) sizeof(hdr) + len;
+}
+
+int
+ui_msg_send(int fd, UiMsgType type, const void *fixed, const void *elems,
+    uint32_t n)
+{
+	uint8_t buf[UI_MSG_TOTAL(UI_MSG_MAX_PAYLOAD)];
+	ssize_t len, sent;
+
+	if ((len = ui_msg_encode(buf, sizeof(buf), type, fixed, elems, n)) < 0)
+		return -1;
+	do
+		sent = send(fd, buf, (size_t) len, MSG_NOSIGNAL);
+	while (sent < 0 && errno == EINTR);
+	return sent < 0 ? -1 : 0;
+}
+
+int
+ui_msg_decode(const void *buf, size_t len, UiMsgView *v)
+{
+	const UiMsgSpec *s;
+	const uint8_t   *p = (const uint8_t *) buf + sizeof(UiMsgHeader);
+	UiMsgHeader      hdr;
+
+	memset(v, 0, sizeof(*v));
+	if (len < sizeof(hdr))
+		return -1;
+	memcpy(&hdr, buf, sizeof(hdr));
+	if (!(s = ui_msg_spec(hdr.type)) || s->shape == UI_SHAPE_FD ||
+	    hdr.payload_len > UI_MSG_MAX_PAYLOAD ||
+	    hdr.payload_len > len - sizeof(hdr))
+		return -1;
+
+	v->type    = (UiMsgType) hdr.type;
+	v->payload = p;
+	v->len     = hdr.payload_len;
+
+	switch (s->shape) {
+	case UI_SHAPE_EMPTY:
+		return v->len == 0 ? 0 : -1;
+	case UI_SHAPE_FIXED:
+		return v->len == s->fixed ? 0 : -1;
+	case UI_SHAPE_BULK:
+		return v->len == sizeof(UiArenaRef) ? 0 : -1;
+	case UI_SHAPE_ARRAY:
+		return array_decode(s, p, v->len, v);
+	case UI_SHAPE_STRINGS: {
+		const char *q = (const char *) p, *end = q + v->len;
+		while (q < end) {
+			const char *nul = memchr(q, '\0', (size_t) (end - q));
+			if (!nul || v->count == s->max)
+				return -1;
+			v->str[v->count++] = q;
+			q                  = nul + 1;
+		}
+		return v->count ? 0 : -1;
+	}
+	case UI_SHAPE_FD:
+		break;
+	}
+	return -1;
+}
+
+int
+ui_msg_get_arena_ref(const UiMsgView *v, UiArenaRef *out)
+{
+	const UiMsgSpec *s = ui_msg_spec(v->type);
+
+	if (!s || s->shape != UI_SHAPE_BULK || v->bulk ||
+	    v->len != sizeof(*out))
+		return -1;
+	memcpy(out, v->payload, sizeof(*out));
+	return 0;
+}
+
+/* -------------------------------------------------------------------------
+ * Bulk contents
+ * ---------------------------------------------------------------------- */
+
+size_t
+ui_bulk_size(UiMsgType type, uint32_t n)
+{
+	const UiMsgSpec *s = ui_msg_spec(type);
+
+	if (!s || s->shape != UI_SHAPE_BULK)
+		return 0;
+	return s->fixed + (size_t) n * s->elem;
+}
+
+ssize_t
+ui_bulk_encode(void *dst, size_t cap, UiMsgType type, const void *fixed,
+    const void *elems, uint32_t n)
+{
+	const UiMsgSpec *s = ui_msg_spec(type);
+
+	if (!s || s->shape != UI_SHAPE_BULK) {
+		errno = EINVAL;
+		return -1;
+	}
+	return array_encode(s, dst, cap, fixed, elems, n);
+}
+
+int
+ui_bulk_decode(UiMsgType type, const void *base, size_t size, UiMsgView *v)
+{
+	const UiMsgSpec *s = ui_msg_spec(type);
+
+	memset(v, 0, sizeof(*v));
+	if (!s || s->shape != UI_SHAPE_BULK || size > UINT32_MAX)
+		return -1;
+	v->type    = type;
+	v->payload = base;
+	v->len     = (uint32_t) size;
+	v->bulk    = 1;
+	return array_decode(s, base, size, v);
+}
+
+/* -------------------------------------------------------------------------
+ * Version negotiation
+ * ---------------------------------------------------------------------- */
+
+uint32_t
+ui_proto_negotiate(const UiHelloPayload *peer)
+{
+	if (peer->version < UI_PROTO_MIN_VERSION ||
+	    peer->min_version > UI_PROTO_VERSION)
+		return 0;
+	return peer->version < UI_PROTO_VERSION ? peer->version
+	                                        : UI_PROTO_VERSION;
+}
@@ -6,11 +6,21 @@
  * remaining bytes (header.payload_len) are the variable payload defined per
  * message type below.
  *
- * For messages that carry bulk data (PREVIEW_SHOW, PREVIEW_UPDATE), the
- * payload is written into a POSIX SHM segment and the file descriptor is
- * passed as SCM_RIGHTS ancillary data alongside the message.  The header's
- * payload_len field then describes the byte size of the SHM mapping.
- * Ordinary messages (no SHM fd) continue to use the inline payload path.
+ * Every message type is described once, in UI_PROTO_MESSAGES below.  The
+ * preprocessor expands that table into the UiMsgType enum, the spec table
+ * ui_proto.c encodes and validates against, and typed ui_msg_send_*() /
+ * ui_msg_get_*() wrappers, so no caller builds or parses a message by hand
+ * and a variable-length array can never be read past what was received.
+ *
+ * Messages that carry bulk data (PREVIEW_SHOW, PREVIEW_UPDATE) are written
+ * into a shared memory arena set up once per connection (see "Bulk arena"
+ * below) and sent as a small inline UiArenaRef.  When the arena is full
+ * the payload instead goes into a one-off POSIX SHM segment whose file
+ * descriptor is passed as SCM_RIGHTS ancillary data; the header's
+ * payload_len then describes the byte size of that mapping.
+ *
+ * Both ends open with UI_MSG_HELLO and drop a peer whose protocol version
+ * range does not overlap their own (an awm-ui from another build).
  *
  * All integers are native byte order (both ends are the same process image).
  */
@@ -18,31 +28,15 @@
 #ifndef UI_PROTO_H
 #define UI_PROTO_H
 
+#include <stdatomic.h>
 #include <stdint.h>
+#include <string.h>
+#include <sys/types.h>
 
-/* -------------------------------------------------------------------------
- * Message types
- * ---------------------------------------------------------------------- */
-
-typedef enum {
-	/* awm → awm-ui */
-	UI_MSG_LAUNCHER_SHOW  = 1, /* payload: UiLauncherShowPayload        */
-	UI_MSG_LAUNCHER_HIDE  = 2, /* payload: none (payload_len == 0)      */
-	UI_MSG_MONITOR_GEOM   = 3, /* payload: UiMonitorGeomPayload         */
-	UI_MSG_PREVIEW_SHOW   = 4, /* payload_len = SHM size; fd via SCM    */
-	UI_MSG_PREVIEW_HIDE   = 5, /* payload: none                         */
-	UI_MSG_PREVIEW_UPDATE = 6, /* payload_len = SHM size; fd via SCM    */
-	UI_MSG_THEME          = 7, /* payload: UiThemePayload               */
-
-	/* awm-ui → awm */
-	UI_MSG_LAUNCHER_EXEC      = 10, /* payload: NUL-terminated cmd string */
-	UI_MSG_PREVIEW_FOCUS      = 11, /* payload: UiPreviewFocusPayload     */
-	UI_MSG_PREVIEW_DONE       = 12, /* payload: UiPreviewDonePayload      */
-	UI_MSG_LAUNCHER_DISMISSED = 13, /* payload: none — launcher hidden    */
-	UI_MSG_LAUNCHER_READY     = 14, /* payload: UiLauncherReadyPayload    */
-	UI_MSG_LAUNCHER_SHOWN =
-	    15, /* payload: UiLauncherShownPayload (x/y reserved) */
-} UiMsgType;
+/* Bump UI_PROTO_VERSION on any wire change; raise UI_PROTO_MIN_VERSION
+ * when the change is not backwards compatible. */
+#define UI_PROTO_VERSION 2
+#define UI_PROTO_MIN_VERSION 2
 
 /* -------------------------------------------------------------------------
  * Wire header — precedes every message
@@ -56,6 +50,57 @@ typedef struct {
 #define UI_MSG_MAX_PAYLOAD \
 	4096 /* sanity cap for inline payloads; SHM messages are unlimited */
 
+/* Each end drains up to this many queued messages per main-loop wakeup
+ * before yielding to its other event sources. */
+#define UI_DRAIN_MAX 64
+
+/* -------------------------------------------------------------------------
+ * Bulk arena
+ *
+ * Right after spawning awm-ui, awm creates one shared memory segment of
+ * UI_ARENA_MAP_SIZE bytes (a sealed memfd where available) and passes its
+ * fd once with UI_MSG_ARENA.  Both ends keep it mapped for the life of the
+ * connection, so a bulk message costs the writer one memcpy into the ring
+ * and the reader no syscalls at all.
+ *
+ * The mapping is a UiArenaHeader followed by a ring of UI_ARENA_RING
+ * bytes.  awm owns the write position; awm-ui stores each message's `end`
+ * into `tail` once it has copied what it needs, releasing the space.
+ * Positions are free-running byte counts (mod 2^32).  A message never
+ * wraps: when it does not fit before the end of the ring the writer skips
+ * the remainder, which is released together with the message.
+ * ---------------------------------------------------------------------- */
+
+#define UI_ARENA_MAGIC 0x41574d41u   /* "AWMA" */
+#define UI_ARENA_RING (256u * 1024u) /* power of two */
+#define UI_ARENA_MAP_SIZE (sizeof(UiArenaHeader) + UI_ARENA_RING)
+
+typedef struct {
+	uint32_t         magic; /* UI_ARENA_MAGIC */
+	uint32_t         size;  /* ring bytes, UI_ARENA_RING */
+	_Atomic uint32_t tail;  /* released up to here (written by awm-ui) */
+	uint32_t         _pad;
+} UiArenaHeader;
+
+/* Inline payload of an arena-backed bulk message. */
+typedef struct {
+	uint32_t offset; /* message start within the ring */
+	uint32_t len;    /* message bytes */
+	uint32_t end;    /* value to store into tail once consumed */
+} UiArenaRef;
+
+/* -------------------------------------------------------------------------
+ * Payloads sent both ways
+ * ---------------------------------------------------------------------- */
+
+/* UI_MSG_HELLO — the first message each end sends.  The two ends are
+ * compatible when each one's version is at least the other's min_version;
+ * they then speak the lower of the two versions. */
+typedef struct {
+	uint32_t version;     /* UI_PROTO_VERSION of the sender */
+	uint32_t min_version; /* oldest peer version the sender accepts */
+} UiHelloPayload;
+
 /* -------------------------------------------------------------------------
  * awm → awm-ui payloads
  * ---------------------------------------------------------------------- */
@@ -81,8 +126,8 @@ typedef struct {
 
 /* UI_MSG_PREVIEW_SHOW / UI_MSG_PREVIEW_UPDATE
  *
- * The message header's payload_len carries the total byte size of the SHM
- * segment.  The segment layout is:
+ * The payload (in the arena, or in a one-off SHM segment whose byte size
+ * the header's payload_len carries) is laid out as:
  *
  *   UiPreviewShowPayload hdr     (fixed, at offset 0)
  *   UiPreviewEntry       [0]     (at offset sizeof(UiPreviewShowPayload))
@@ -90,10 +135,8 @@ typedef struct {
  *   ...
  *   UiPreviewEntry       [hdr.count - 1]
  *
- * The SHM fd is passed as SCM_RIGHTS ancillary data.  The receiver mmap()s
- * the fd, reads the entries, then closes and munmap()s it.  The snapshot
- * pixmap XIDs are owned by the receiver; it must return them via
- * UI_MSG_PREVIEW_DONE so awm can call xcb_free_pixmap(). */
+ * The snapshot pixmap XIDs are owned by the receiver; it must return them
+ * via UI_MSG_PREVIEW_DONE so awm can call xcb_free_pixmap(). */
 
 typedef struct {
 	int32_t  anchor_x; /* hint: popup anchor point (bar button centre) */
@@ -135,7 +178,9 @@ typedef struct {
  * ---------------------------------------------------------------------- */
 
 /* UI_MSG_LAUNCHER_EXEC: payload is a NUL-terminated UTF-8 command string,
- * length = payload_len (includes the NUL byte). */
+ * optionally followed by the NUL-terminated display name of the launched
+ * item (labels the launch in awm's messages); payload_len covers both
+ * NULs. */
 
 /* UI_MSG_LAUNCHER_READY: sent once by awm-ui after the launcher window is
  * realized, so awm can call xcb_set_input_focus directly on show. */
@@ -157,10 +202,11 @@ typedef struct {
 	uint32_t xwin; /* XCB window ID to focus */
 } UiPreviewFocusPayload;
 
-/* UI_MSG_PREVIEW_DONE — preview is done; free the listed snapshot pixmaps. */
+/* UI_MSG_PREVIEW_DONE — preview is done; free the listed snapshot pixmaps.
+ * Followed by count uint32_t pixmap XIDs.  More XIDs than one message
+ * holds (ui_msg_max_elems()) are returned in several messages. */
 typedef struct {
-	uint32_t count;    /* number of XIDs in xids[] */
-	uint32_t xids[32]; /* snapshot pixmap XIDs to free */
+	uint32_t count; /* number of XIDs that follow */
 } UiPreviewDonePayload;
 
 /* -------------------------------------------------------------------------
@@ -170,4 +216,238 @@ typedef struct {
 #define UI_MSG_TOTAL(payload_len) \
 	(sizeof(UiMsgHeader) + (size_t) (payload_len))
 
+/* -------------------------------------------------------------------------
+ * Message schema
+ *
+ * One line per message type, in one of six shapes:
+ *
+ *   EMPTY(NAME, name, id)                   no payload
+ *   FIXED(NAME, name, id, T)                payload is exactly one T
+ *   ARRAY(NAME, name, id, T, E, count)      a T whose uint32_t field count
+ *                                           gives the number of E following
+ *   STRINGS(NAME, name, id, max)            1..max NUL-terminated strings
+ *   BULK(NAME, name, id, T, E, count)       a UiArenaRef (or SHM fd) to an
+ *                                           ARRAY-shaped T + E[count]
+ *   FD(NAME, name, id)                      SCM_RIGHTS fd, payload_len = size
+ *
+ * To add a message: add its payload struct above and one line here.
+ * ---------------------------------------------------------------------- */
+
+#define UI_PROTO_MESSAGES(EMPTY, FIXED, ARRAY, STRINGS, BULK, FD)            \
+	/* both directions */                                                    \
+	FIXED(HELLO, hello, 9, UiHelloPayload)                                   \
+	/* awm → awm-ui */                                                       \
+	FIXED(LAUNCHER_SHOW, launcher_show, 1, UiLauncherShowPayload)            \
+	EMPTY(LAUNCHER_HIDE, launcher_hide, 2)                                   \
+	FIXED(MONITOR_GEOM, monitor_geom, 3, UiMonitorGeomPayload)               \
+	BULK(PREVIEW_SHOW, preview_show, 4, UiPreviewShowPayload,                \
+	    UiPreviewEntry, count)                                               \
+	EMPTY(PREVIEW_HIDE, preview_hide, 5)                                     \
+	BULK(PREVIEW_UPDATE, preview_update, 6, UiPreviewShowPayload,            \
+	    UiPreviewEntry, count)                                               \
+	FIXED(THEME, theme, 7, UiThemePayload)                                   \
+	FD(ARENA, arena, 8)                                                      \
+	/* awm-ui → awm */                                                       \
+	STRINGS(LAUNCHER_EXEC, launcher_exec, 10, 2) /* cmd [, name] */          \
+	FIXED(PREVIEW_FOCUS, preview_focus, 11, UiPreviewFocusPayload)           \
+	ARRAY(PREVIEW_DONE, preview_done, 12, UiPreviewDonePayload, uint32_t,    \
+	    count)                                                               \
+	EMPTY(LAUNCHER_DISMISSED, launcher_dismissed, 13)                        \
+	FIXED(LAUNCHER_READY, launcher_ready, 14, UiLauncherReadyPayload)        \
+	FIXED(LAUNCHER_SHOWN, launcher_shown, 15, UiLauncherShownPayload)
+
+/* Highest message id in the schema. */
+#define UI_MSG_ID_MAX 15
+
+#define UI_X_ENUM(NAME, name, id) UI_MSG_##NAME = id,
+#define UI_X_ENUMV(NAME, name, id, ...) UI_MSG_##NAME = id,
+
+typedef enum {
+	UI_PROTO_MESSAGES(
+	    UI_X_ENUM, UI_X_ENUMV, UI_X_ENUMV, UI_X_ENUMV, UI_X_ENUMV, UI_X_ENUM)
+} UiMsgType;
+
+#undef UI_X_ENUM
+#undef UI_X_ENUMV
+
+/* -------------------------------------------------------------------------
+ * Encoding and validation (ui_proto.c)
+ * ---------------------------------------------------------------------- */
+
+typedef enum {
+	UI_SHAPE_EMPTY,
+	UI_SHAPE_FIXED,
+	UI_SHAPE_ARRAY,
+	UI_SHAPE_STRINGS,
+	UI_SHAPE_BULK,
+	UI_SHAPE_FD,
+} UiMsgShape;
+
+/* What the schema says about one message type. */
+typedef struct {
+	const char *name;      /* "PREVIEW_DONE", for logs */
+	UiMsgShape  shape;     /* 0 (EMPTY) with name NULL: no such type */
+	uint32_t    fixed;     /* bytes of the fixed part (T) */
+	uint32_t    elem;      /* ARRAY/BULK: bytes per element (E) */
+	uint32_t    count_off; /* ARRAY/BULK: offset of the count field in T */
+	uint32_t    max;       /* STRINGS: most strings */
+} UiMsgSpec;
+
+#define UI_MSG_MAX_STRINGS 2
+
+/* A validated message.  Pointers point into the buffer passed to
+ * ui_msg_decode() / ui_bulk_decode() and are not necessarily aligned. */
+typedef struct {
+	UiMsgType      type;
+	const uint8_t *payload; /* fixed part, or the whole inline payload */
+	uint32_t       len;     /* payload bytes */
+	const uint8_t *elems;   /* ARRAY/BULK: first element */
+	uint32_t       count;   /* ARRAY/BULK: elements; STRINGS: strings */
+	const char    *str[UI_MSG_MAX_STRINGS]; /* STRINGS */
+	int            bulk; /* BULK: 1 if this views the bulk contents */
+} UiMsgView;
+
+/* The schema entry for type, or NULL for an unknown type. */
+const UiMsgSpec *ui_msg_spec(uint32_t type);
+
+/* Name of type for log messages ("?" if unknown). */
+const char *ui_msg_name(uint32_t type);
+
+/* Most elements one inline ARRAY message of type can carry. */
+uint32_t ui_msg_max_elems(UiMsgType type);
+
+/* Encode a message (header and payload) into buf.  fixed is the T of
+ * FIXED/ARRAY messages or the UiArenaRef of BULK ones; elems is the E
+ * array of ARRAY messages (n elements; the count field of the copy of T
+ * is set to n) or the const char *const[] of STRINGS ones (n strings).
+ * Returns the message length, or -1 with errno EMSGSIZE if it does not
+ * fit in cap or the inline limit, EINVAL if it breaks the schema. */
+ssize_t ui_msg_encode(void *buf, size_t cap, UiMsgType type,
+    const void *fixed, const void *elems, uint32_t n);
+
+/* Encode and send one message on fd.  Returns 0, or -1 with errno set. */
+int ui_msg_send(int fd, UiMsgType type, const void *fixed, const void *elems,
+    uint32_t n);
+
+/* Validate the inline message of len bytes at buf (as received, header
+ * included) against the schema and fill *v.  Returns 0, or -1 if the type
+ * is unknown or the lengths do not add up. */
+int ui_msg_decode(const void *buf, size_t len, UiMsgView *v);
+
+/* Bytes of the bulk contents of a BULK message with n elements. */
+size_t ui_bulk_size(UiMsgType type, uint32_t n);
+
+/* Write the bulk contents of a BULK message into dst (ui_bulk_size()
+ * bytes).  Returns the bytes written, or -1 as for ui_msg_encode(). */
+ssize_t ui_bulk_encode(void *dst, size_t cap, UiMsgType type,
+    const void *fixed, const void *elems, uint32_t n);
+
+/* Validate the bulk contents of a BULK message (size bytes at base) and
+ * fill *v.  Returns 0 or -1.  (ui_msg_decode() of a BULK message yields
+ * only its inline UiArenaRef; see ui_msg_get_arena_ref().) */
+int ui_bulk_decode(
+    UiMsgType type, const void *base, size_t size, UiMsgView *v);
+
+/* Copy the inline UiArenaRef of a BULK message.  Returns 0, or -1 if v is
+ * not an inline BULK message. */
+int ui_msg_get_arena_ref(const UiMsgView *v, UiArenaRef *out);
+
+/* The version to speak with a peer that sent hello, or 0 if the two are
+ * incompatible. */
+uint32_t ui_proto_negotiate(const UiHelloPayload *peer);
+
+/* -------------------------------------------------------------------------
+ * Typed wrappers, generated from the schema:
+ *
+ *   EMPTY    int ui_msg_send_<name>(int fd)
+ *   FIXED    int ui_msg_send_<name>(int fd, const T *p)
+ *            int ui_msg_get_<name>(const UiMsgView *v, T *out)
+ *   ARRAY    int ui_msg_send_<name>(int fd, const T *p, const E *e, n)
+ *            int ui_msg_get_<name>(const UiMsgView *v, T *out)
+ *            int ui_msg_elem_<name>(const UiMsgView *v, uint32_t i, E *out)
+ *   STRINGS  int ui_msg_send_<name>(int fd, const char *const *s, n)
+ *   BULK     int ui_msg_send_<name>(int fd, const UiArenaRef *ref)
+ *            ssize_t ui_bulk_put_<name>(void *dst, size_t cap,
+ *                const T *p, const E *e, n)
+ *            int ui_bulk_get_<name>(const UiMsgView *v, T *out)
+ *            int ui_bulk_elem_<name>(const UiMsgView *v, uint32_t i, E *out)
+ *
+ * The get functions return -1 if v is not a message of that type.
+ * ---------------------------------------------------------------------- */
+
+#define UI_X_NONE(...)
+
+#define UI_X_SEND_EMPTY(NAME, name, id)                                      \
+	static inline int ui_msg_send_##name(int fd)                             \
+	{                                                                        \
+		return ui_msg_send(fd, UI_MSG_##NAME, NULL, NULL, 0);                \
+	}
+
+#define UI_X_GET(NAME, fn, T, bulk_)                                         \
+	static inline int fn(const UiMsgView *v, T *out)                         \
+	{                                                                        \
+		if (v->type != UI_MSG_##NAME || v->bulk != (bulk_) ||                \
+		    v->len < sizeof(*out))                                           \
+			return -1;                                                       \
+		memcpy(out, v->payload, sizeof(*out));                               \
+		return 0;                                                            \
+	}
+
+#define UI_X_FIXED(NAME, name, id, T)                                        \
+	static inline int ui_msg_send_##name(int fd, const T *p)                 \
+	{                                                                        \
+		return ui_msg_send(fd, UI_MSG_##NAME, p, NULL, 0);                   \
+	}                                                                        \
+	UI_X_GET(NAME, ui_msg_get_##name, T, 0)
+
+#define UI_X_ELEM(NAME, fn, E, bulk_)                                        \
+	static inline int fn(const UiMsgView *v, uint32_t i, E *out)             \
+	{                                                                        \
+		if (v->type != UI_MSG_##NAME || v->bulk != (bulk_) || i >= v->count) \
+			return -1;                                                       \
+		memcpy(out, v->elems + (size_t) i * sizeof(*out), sizeof(*out));     \
+		return 0;                                                            \
+	}
+
+#define UI_X_ARRAY(NAME, name, id, T, E, count)                              \
+	static inline int ui_msg_send_##name(                                    \
+	    int fd, const T *p, const E *e, uint32_t n)                          \
+	{                                                                        \
+		return ui_msg_send(fd, UI_MSG_##NAME, p, e, n);                      \
+	}                                                                        \
+	UI_X_GET(NAME, ui_msg_get_##name, T, 0)                                  \
+	UI_X_ELEM(NAME, ui_msg_elem_##name, E, 0)
+
+#define UI_X_STRINGS(NAME, name, id, max)                                    \
+	static inline int ui_msg_send_##name(                                    \
+	    int fd, const char *const *s, uint32_t n)                            \
+	{                                                                        \
+		return ui_msg_send(fd, UI_MSG_##NAME, NULL, s, n);                   \
+	}
+
+#define UI_X_BULK(NAME, name, id, T, E, count)                               \
+	static inline int ui_msg_send_##name(int fd, const UiArenaRef *ref)      \
+	{                                                                        \
+		return ui_msg_send(fd, UI_MSG_##NAME, ref, NULL, 0);                 \
+	}                                                                        \
+	static inline ssize_t ui_bulk_put_##name(                                \
+	    void *dst, size_t cap, const T *p, const E *e, uint32_t n)           \
+	{                                                                        \
+		return ui_bulk_encode(dst, cap, UI_MSG_##NAME, p, e, n);             \
+	}                                                                        \
+	UI_X_GET(NAME, ui_bulk_get_##name, T, 1)                                 \
+	UI_X_ELEM(NAME, ui_bulk_elem_##name, E, 1)
+
+UI_PROTO_MESSAGES(UI_X_SEND_EMPTY, UI_X_FIXED, UI_X_ARRAY, UI_X_STRINGS,
+    UI_X_BULK, UI_X_NONE)
+
+#undef UI_X_NONE
+#undef UI_X_SEND_EMPTY
+#undef UI_X_GET
+#undef UI_X_FIXED
+#undef UI_X_ELEM
+#undef UI_X_ARRAY
+#undef UI_X_STRINGS
+#undef UI_X_BULK
+
 #endif /* UI_PROTO_H */
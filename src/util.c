@@ -38,3 +38,12 @@ ecalloc(size_t nmemb, size_t size)
 		die("calloc:");
 	return p;
 }
+
+void *
+erealloc(void *p, size_t size)
+{
+	assert(size > 0);
+	if (!(p = realloc(p, size)))
+		die("realloc:");
+	return p;
+}
@@ -16,6 +16,7 @@
 
 noreturn void die(const char *fmt, ...);
 void         *ecalloc(size_t nmemb, size_t size);
+void         *erealloc(void *p, size_t size);
 
 /* Signal-safe logging - uses write() syscall, safe in signal handlers
  * NOTE: Only use string literals for prefix and msg (no formatting)
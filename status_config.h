@@ -16,16 +16,26 @@
  * real bar height instead of a hardcoded constant. */
 extern int bh;
 
+/* What makes a component refresh.  The bar is only redrawn when a refresh
+ * actually changes the produced string, so slow triggers mean an idle bar
+ * costs no wakeups at all. */
+enum {
+	STATUS_TRIG_INTERVAL = 0, /* every `interval` seconds */
+	STATUS_TRIG_CLOCK,        /* on wall-clock multiples of `interval` */
+	STATUS_TRIG_POWER,        /* power_supply uevents, `interval` fallback */
+};
+
 struct status_arg {
 	const char *(*func)(const char *);
 	const char  *fmt;
 	const char  *args;
 	unsigned int interval; /* interval in seconds to call this function */
 	int          prime;    /* 1 = call once at startup to seed state */
+	int          trigger;  /* STATUS_TRIG_*; 0 = plain interval */
 };
 
-/* interval between updates (in ms) */
-static const unsigned int status_interval_ms = 1000;
+/* debounce after a power_supply uevent before re-reading (in ms) */
+static const unsigned int status_uevent_delay_ms = 250;
 
 /* text to show if no value can be retrieved */
 static const char status_unknown_str[] = "n/a";
@@ -51,6 +61,11 @@ static const char status_unknown_str[] = "n/a";
 /* Border colour for hbar (matches bar norm-bg). */
 #define S2D_BORDER_COL "444444"
 
+/* Width of a sparkline graph (pixels, one sample per pixel). */
+#define S2D_GRAPH_W 32
+/* Graph fill colour. */
+#define S2D_GRAPH_COL "5294E2"
+
 /* shared scratch buffer — written before return, never nested */
 static char s2d_buf[STATUS_MAXLEN];
 
@@ -314,12 +329,46 @@ s2d_bat(const char *bat)
 	return bbuf;
 }
 
+/* -------------------------------------------------------------------------
+ * s2d_graph — sparkline of a recorded metric history.
+ *
+ * @metric: "cpu", "ram", "core<N>" (percent, fixed scale) or "rx"/"tx"
+ * (bytes/s of the first netspeed interface, autoscaled).  The history is
+ * only fed while the component producing it (s2d_cpu/cpu_perc, s2d_ram/
+ * ram_used, netspeed_rx/tx) is in status_args.  The escape text is
+ * constant; status.c repaints the bar whenever a new sample arrives.
+ * ---------------------------------------------------------------------- */
+static const char *
+s2d_graph(const char *metric)
+{
+	double max;
+	int    id, h = bh - S2D_VBAR_PAD * 2;
+
+	if (!metric || (id = status_hist_lookup(metric, &max)) < 0)
+		return NULL;
+	if (h < 1)
+		h = 1;
+
+	snprintf(s2d_buf, sizeof(s2d_buf), "^b222222^^c%s^^g%d,%d,%d,%d^^d^",
+	    S2D_GRAPH_COL, id, S2D_GRAPH_W, h, (int) max);
+	return s2d_buf;
+}
+
 static const struct status_arg status_args[] = {
-	/* function   format  argument  interval  prime */
-	{ s2d_cpu, "%s", NULL, 2, 1 },
-	{ s2d_ram, "%s", NULL, 10, 0 },
-	{ s2d_bat, "%s", "BAT0", 30, 0 },
-	{ datetime, "%s", " %a %d %b  %H:%M:%S ", 1, 0 },
+	/* function   format  argument  interval  prime  trigger */
+	{ s2d_cpu, "%s", NULL, 2, 1, STATUS_TRIG_INTERVAL },
+	{ s2d_ram, "%s", NULL, 10, 0, STATUS_TRIG_INTERVAL },
+	{ s2d_bat, "%s", "BAT0", 60, 0, STATUS_TRIG_POWER },
+	/* Rate components show n/a until their second sample, one interval
+	 * after startup:
+	{ netspeed_rx, "↓%sB/s ", "wlan0", 2, 1, STATUS_TRIG_INTERVAL },
+	{ netspeed_tx, "↑%sB/s ", "wlan0", 2, 1, STATUS_TRIG_INTERVAL },
+	{ disk_read, "R %sB/s ", "nvme0n1", 2, 1, STATUS_TRIG_INTERVAL },
+	{ disk_write, "W %sB/s ", "nvme0n1", 2, 1, STATUS_TRIG_INTERVAL },
+	{ temp, "%s°C ", "thermal_zone0", 5, 0, STATUS_TRIG_INTERVAL },
+	{ s2d_graph, "%s CPU ", "cpu", 3600, 0, STATUS_TRIG_INTERVAL },
+	*/
+	{ datetime, "%s", " %a %d %b  %H:%M:%S ", 1, 0, STATUS_TRIG_CLOCK },
 };
 
 #define STATUS_ARGS_LEN (sizeof(status_args) / sizeof(status_args[0]))
@@ -0,0 +1,209 @@
+/* See LICENSE file for copyright and license details. */
+/* Benchmark for the launcher $PATH scan (src/launcher_index.c).
+ *
+ * Builds a synthetic PATH of BENCH_DIRS directories holding BENCH_ENTRIES
+ * files in total (a quarter of the names repeated across directories, a
+ * tenth not executable, a few subdirectories), then times:
+ *
+ *   - the previous algorithm: one stat() per built path and a linear
+ *     duplicate search over every name found so far;
+ *   - launcher_scan_dirs() on one thread plus a name-map merge;
+ *   - launcher_scan_dirs() on the default worker pool plus the same merge.
+ *
+ * Usage: build/bench_launcher_scan [entries] [dirs]
+ * Run with a warm page cache; the first pass is discarded.
+ */
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../src/launcher_index.h"
+
+#define BENCH_ENTRIES 20000
+#define BENCH_DIRS 40
+#define BENCH_RUNS 5
+
+static double
+now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
+
+static void
+make_tree(const char *root, int entries, int ndirs, char **dirs)
+{
+	char path[512];
+	int  d, i, fd;
+
+	mkdir(root, 0700);
+	for (d = 0; d < ndirs; d++) {
+		snprintf(path, sizeof(path), "%s/bin%02d", root, d);
+		mkdir(path, 0755);
+		dirs[d] = strdup(path);
+	}
+	for (i = 0; i < entries; i++) {
+		d = i % ndirs;
+		/* every 4th name also exists in the directory before it */
+		int id = (i % 4 == 0 && i >= ndirs) ? i - 1 : i;
+		snprintf(path, sizeof(path), "%s/cmd%05d", dirs[d], id);
+		fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0755);
+		if (fd >= 0)
+			close(fd);
+		if (i % 10 == 0)
+			chmod(path, 0644);
+		if (i % 500 == 0) {
+			snprintf(path, sizeof(path), "%s/sub%05d", dirs[d], i);
+			mkdir(path, 0755);
+		}
+	}
+}
+
+static void
+rm_tree(const char *root, int ndirs, char **dirs)
+{
+	char           path[1024];
+	DIR           *dir;
+	struct dirent *e;
+
+	for (int d = 0; d < ndirs; d++) {
+		if ((dir = opendir(dirs[d]))) {
+			while ((e = readdir(dir))) {
+				if (e->d_name[0] == '.')
+					continue;
+				snprintf(path, sizeof(path), "%s/%s", dirs[d], e->d_name);
+				if (unlink(path) < 0)
+					rmdir(path);
+			}
+			closedir(dir);
+		}
+		rmdir(dirs[d]);
+		free(dirs[d]);
+	}
+	rmdir(root);
+}
+
+/* The pre-index algorithm: path building, stat(), O(n^2) dedup. */
+static int
+scan_naive(char **dirs, int ndirs)
+{
+	char         **found = NULL;
+	int            n = 0, cap = 0, i;
+	char           full[1024];
+	struct stat    st;
+	DIR           *dir;
+	struct dirent *e;
+
+	for (int d = 0; d < ndirs; d++) {
+		if (!(dir = opendir(dirs[d])))
+			continue;
+		while ((e = readdir(dir))) {
+			if (e->d_name[0] == '.')
+				continue;
+			snprintf(full, sizeof(full), "%s/%s", dirs[d], e->d_name);
+			if (stat(full, &st) != 0 || !S_ISREG(st.st_mode) ||
+			    !(st.st_mode & 0111))
+				continue;
+			for (i = 0; i < n; i++)
+				if (strcmp(found[i], e->d_name) == 0)
+					break;
+			if (i < n)
+				continue;
+			if (n == cap) {
+				cap   = cap ? cap * 2 : 256;
+				found = realloc(found, (size_t) cap * sizeof(*found));
+			}
+			found[n++] = strdup(e->d_name);
+		}
+		closedir(dir);
+	}
+	for (i = 0; i < n; i++)
+		free(found[i]);
+	free(found);
+	return n;
+}
+
+static int
+scan_indexed(char **dirs, int ndirs, int nthreads)
+{
+	LauncherDirScan *scans = calloc((size_t) ndirs, sizeof(*scans));
+	LauncherNameMap  seen  = { 0 };
+	int              n     = 0;
+
+	launcher_scan_dirs((const char *const *) dirs, ndirs, nthreads, scans);
+	for (int d = 0; d < ndirs; d++)
+		for (int j = 0; j < scans[d].n; j++)
+			if (launcher_namemap_add(&seen, scans[d].names[j], &seen) == 0)
+				n++;
+	launcher_namemap_clear(&seen);
+	launcher_dirscan_free(scans, ndirs);
+	free(scans);
+	return n;
+}
+
+static void
+report(const char *what, int items, double *t)
+{
+	double best = t[0], sum = 0;
+
+	for (int r = 0; r < BENCH_RUNS; r++) {
+		sum += t[r];
+		if (t[r] < best)
+			best = t[r];
+	}
+	printf("%-22s %6d items  best %8.2f ms  mean %8.2f ms\n", what, items,
+	    best * 1e3, sum / BENCH_RUNS * 1e3);
+}
+
+int
+main(int argc, char **argv)
+{
+	int    entries = argc > 1 ? atoi(argv[1]) : BENCH_ENTRIES;
+	int    ndirs   = argc > 2 ? atoi(argv[2]) : BENCH_DIRS;
+	char   root[256];
+	char **dirs;
+	double t[BENCH_RUNS], t0;
+	int    items = 0, r;
+
+	if (entries <= 0 || ndirs <= 0)
+		return 1;
+	dirs = calloc((size_t) ndirs, sizeof(*dirs));
+	snprintf(root, sizeof(root), "/tmp/awm_bench_path.%ld", (long) getpid());
+	make_tree(root, entries, ndirs, dirs);
+	printf("synthetic PATH: %d entries in %d directories\n", entries, ndirs);
+
+	scan_naive(dirs, ndirs); /* warm the dentry cache */
+
+	for (r = 0; r < BENCH_RUNS; r++) {
+		t0    = now();
+		items = scan_naive(dirs, ndirs);
+		t[r]  = now() - t0;
+	}
+	report("stat + linear dedup", items, t);
+
+	for (r = 0; r < BENCH_RUNS; r++) {
+		t0    = now();
+		items = scan_indexed(dirs, ndirs, 1);
+		t[r]  = now() - t0;
+	}
+	report("fstatat + hash, 1 thr", items, t);
+
+	for (r = 0; r < BENCH_RUNS; r++) {
+		t0    = now();
+		items = scan_indexed(dirs, ndirs, 0);
+		t[r]  = now() - t0;
+	}
+	report("fstatat + hash, pool", items, t);
+
+	rm_tree(root, ndirs, dirs);
+	free(dirs);
+	return 0;
+}
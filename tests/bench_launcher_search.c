@@ -0,0 +1,133 @@
+/* See LICENSE file for copyright and license details. */
+/* Benchmark for the launcher search engine (src/launcher_search.c).
+ *
+ * Builds an index over BENCH_ITEMS synthetic applications (names, exec
+ * lines, generic names and keywords assembled from a syllable table) and
+ * reports the mean time per launcher_search_query() for queries of
+ * increasing selectivity, returning the top BENCH_TOPK, both cold and
+ * while typing a query one character at a time.
+ *
+ * Usage: build/bench_launcher_search [items]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../src/launcher_search.h"
+
+#define BENCH_ITEMS 20000
+#define BENCH_TOPK 200
+#define BENCH_RUNS 200
+
+static const char *syl[] = { "fire", "fox", "term", "nal", "gnome", "kde",
+	"edit", "or", "view", "er", "office", "calc", "write", "music", "play",
+	"box", "code", "vim", "x", "mail", "net", "work", "sys", "mon", "tool",
+	"image", "photo", "draw", "shot", "zilla" };
+#define NSYL ((int) (sizeof(syl) / sizeof(syl[0])))
+
+static double
+now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
+
+static char *
+make_word(unsigned *seed, int parts, int cap)
+{
+	char *w = malloc(64);
+	int   n = 0;
+
+	w[0] = '\0';
+	for (int i = 0; i < parts; i++) {
+		const char *s = syl[rand_r(seed) % NSYL];
+		int         l = (int) strlen(s);
+		if (n + l + 1 >= 64)
+			break;
+		memcpy(w + n, s, (size_t) l);
+		if (cap && i == 0)
+			w[n] = (char) (w[n] - 'a' + 'A');
+		n += l;
+	}
+	w[n] = '\0';
+	return w;
+}
+
+int
+main(int argc, char **argv)
+{
+	static const char *queries[] = { "f", "fi", "fire", "term", "gnm",
+		"fxz", "web br", "qqq" };
+	int                n = argc > 1 ? atoi(argv[1]) : BENCH_ITEMS;
+	LauncherSearchDoc *docs;
+	LauncherSearch    *s;
+	unsigned           seed = 1;
+	int                out[BENCH_TOPK], hits = 0;
+	double             t0;
+
+	if (n <= 0)
+		return 1;
+	docs = calloc((size_t) n, sizeof(*docs));
+	for (int i = 0; i < n; i++) {
+		docs[i].name         = make_word(&seed, 2 + i % 2, 1);
+		docs[i].exec         = make_word(&seed, 2, 0);
+		docs[i].generic      = i % 3 ? NULL : "Web Browser";
+		docs[i].keywords     = i % 5 ? NULL : "network;internet;";
+		docs[i].launch_count = i % 50 ? 0 : i % 7;
+	}
+
+	t0 = now();
+	s  = launcher_search_build(docs, n);
+	printf("index build: %d items in %.2f ms\n", n, (now() - t0) * 1e3);
+
+	/* Cold: each query from scratch (the empty query resets the
+	 * incremental state and is not timed) */
+	for (size_t q = 0; q < sizeof(queries) / sizeof(queries[0]); q++) {
+		double total = 0;
+		for (int r = 0; r < BENCH_RUNS; r++) {
+			launcher_search_query(s, "", out, BENCH_TOPK);
+			t0 = now();
+			hits = launcher_search_query(s, queries[q], out, BENCH_TOPK);
+			total += now() - t0;
+		}
+		printf("query %-8s %4d results  %8.1f us/query\n", queries[q], hits,
+		    total / BENCH_RUNS * 1e6);
+	}
+
+	t0 = now();
+	for (int r = 0; r < BENCH_RUNS; r++)
+		hits = launcher_search_query(s, "", out, BENCH_TOPK);
+	printf("query %-8s %4d results  %8.1f us/query\n", "(empty)", hits,
+	    (now() - t0) / BENCH_RUNS * 1e6);
+
+	/* Typing: each keystroke extends the previous query */
+	{
+		static const char *typed[] = { "f", "fi", "fir", "fire", "firef" };
+		double              per[5] = { 0 };
+
+		for (int r = 0; r < BENCH_RUNS; r++) {
+			launcher_search_query(s, "", out, BENCH_TOPK);
+			for (int k = 0; k < 5; k++) {
+				t0 = now();
+				launcher_search_query(s, typed[k], out, BENCH_TOPK);
+				per[k] += now() - t0;
+			}
+		}
+		printf("typing f > firef:");
+		for (int k = 0; k < 5; k++)
+			printf(" %.1f", per[k] / BENCH_RUNS * 1e6);
+		printf(" us/keystroke\n");
+	}
+
+	launcher_search_free(s);
+	for (int i = 0; i < n; i++) {
+		free((char *) docs[i].name);
+		free((char *) docs[i].exec);
+	}
+	free(docs);
+	return 0;
+}
@@ -0,0 +1,85 @@
+/* See LICENSE file for copyright and license details. */
+/* Benchmark for the pixel conversion kernels (src/pixel.c).
+ *
+ * For every implementation this CPU can run, reports the throughput of
+ * converting a BENCH_SIDE x BENCH_SIDE icon from each source format to
+ * premultiplied ARGB32, and of box-downscaling it to a bar icon.
+ *
+ * Usage: build/bench_pixel [side]
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../src/pixel.h"
+
+#define BENCH_SIDE 256
+#define BENCH_DST 32
+#define BENCH_SECS 0.2
+
+static const char *const impls[] = { "scalar", "sse2", "avx2" };
+static const char *const fmts[]  = { "argb32", "argb-be", "rgba", "rgb" };
+
+static double
+now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
+
+int
+main(int argc, char **argv)
+{
+	int       side = argc > 1 ? atoi(argv[1]) : BENCH_SIDE;
+	size_t    npx;
+	uint8_t  *src;
+	uint32_t *dst, *small;
+	unsigned  seed = 1;
+	double    t0, t;
+	long      runs;
+
+	if (side < BENCH_DST) {
+		fprintf(stderr, "side must be at least %d\n", BENCH_DST);
+		return 1;
+	}
+	npx   = (size_t) side * side;
+	src   = malloc(npx * 4);
+	dst   = malloc(npx * 4);
+	small = malloc((size_t) BENCH_DST * BENCH_DST * 4);
+	if (!src || !dst || !small)
+		return 1;
+	for (size_t i = 0; i < npx * 4; i++)
+		src[i] = (uint8_t) rand_r(&seed);
+
+	printf("%dx%d source, %dx%d box target\n", side, side, BENCH_DST,
+	    BENCH_DST);
+	for (size_t i = 0; i < sizeof(impls) / sizeof(impls[0]); i++) {
+		if (pixel_use(impls[i]) < 0) {
+			printf("%-7s unsupported on this CPU\n", impls[i]);
+			continue;
+		}
+		for (int f = PIXEL_ARGB32; f <= PIXEL_RGB; f++) {
+			int bpp = pixel_format_bpp((PixelFormat) f);
+			t0      = now();
+			for (runs = 0; (t = now() - t0) < BENCH_SECS; runs++)
+				pixel_to_argb32(dst, (size_t) side * 4, src,
+				    (size_t) side * bpp, side, side, (PixelFormat) f);
+			printf("%-7s %-8s %8.1f Mpx/s\n", impls[i], fmts[f],
+			    (double) npx * runs / t / 1e6);
+		}
+		t0 = now();
+		for (runs = 0; (t = now() - t0) < BENCH_SECS; runs++)
+			pixel_downscale_box(small, BENCH_DST * 4, BENCH_DST, BENCH_DST,
+			    dst, (size_t) side * 4, side, side);
+		printf("%-7s %-8s %8.1f Mpx/s\n", impls[i], "box",
+		    (double) npx * runs / t / 1e6);
+	}
+	free(src);
+	free(dst);
+	free(small);
+	return 0;
+}
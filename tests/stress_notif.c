@@ -0,0 +1,414 @@
+/* See LICENSE file for copyright and license details. */
+/* Stress test for the notification admission engine (src/notif_engine.c).
+ *
+ * Starts a private dbus-daemon, claims org.freedesktop.Notifications on one
+ * connection and fires Notify calls at it from another: several synthetic
+ * apps, some repeating a summary, one updating its popup via replaces_id,
+ * one flooding distinct messages with the odd critical one among them.
+ * The server side runs every call through the engine, as notif.c does, and
+ * keeps the popup stack it would have drawn.
+ *
+ * Checks that every call gets a reply, that the stack never exceeds
+ * max_visible and that no app opened more popups than its token bucket
+ * allows.  Skips if dbus-daemon is not installed.
+ *
+ * Usage: build/stress_notif [calls]
+ */
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <dbus/dbus.h>
+
+#include "../src/notif_engine.h"
+
+#define STRESS_CALLS  10000
+#define STRESS_WINDOW 64   /* calls in flight at once */
+#define STRESS_APPS   8
+#define STRESS_SECS   60.0 /* give up after this long */
+
+#define NOTIF_NAME  "org.freedesktop.Notifications"
+#define NOTIF_PATH  "/org/freedesktop/Notifications"
+#define NOTIF_IFACE "org.freedesktop.Notifications"
+
+static const NotifLimits lim = { .max_visible = 5, .rate = 1.0, .burst = 5 };
+
+static NotifEngine *engine;
+
+static struct {
+	unsigned long shows, updates, drops, evicts, critical;
+	int           max_live;
+	unsigned long app_shows[STRESS_APPS]; /* non-critical only */
+} srv;
+
+static struct {
+	unsigned long replies, errors;
+	uint32_t      last_id[STRESS_APPS];
+} cli;
+
+static double
+now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
+
+/* -------------------------------------------------------------------------
+ * Private bus
+ * ---------------------------------------------------------------------- */
+
+/* Start dbus-daemon and read its address; returns its pid, or -1 */
+static pid_t
+bus_start(char *addr, size_t len)
+{
+	int     fds[2];
+	pid_t   pid;
+	ssize_t n;
+	size_t  got = 0;
+
+	if (pipe(fds) < 0)
+		return -1;
+	pid = fork();
+	if (pid < 0)
+		return -1;
+	if (pid == 0) {
+		char arg[32];
+
+		close(fds[0]);
+		snprintf(arg, sizeof(arg), "--print-address=%d", fds[1]);
+		execlp("dbus-daemon", "dbus-daemon", "--session", "--nofork", arg,
+		    (char *) NULL);
+		_exit(127);
+	}
+	close(fds[1]);
+	while (got < len - 1 &&
+	    (n = read(fds[0], addr + got, len - 1 - got)) > 0) {
+		got += (size_t) n;
+		if (memchr(addr, '\n', got))
+			break;
+	}
+	close(fds[0]);
+	addr[got] = '\0';
+	addr[strcspn(addr, "\n")] = '\0';
+	if (!addr[0]) {
+		waitpid(pid, NULL, 0);
+		return -1;
+	}
+	return pid;
+}
+
+static DBusConnection *
+bus_connect(const char *addr)
+{
+	DBusConnection *conn;
+	DBusError       err;
+
+	dbus_error_init(&err);
+	conn = dbus_connection_open_private(addr, &err);
+	if (conn && !dbus_bus_register(conn, &err)) {
+		dbus_connection_close(conn);
+		dbus_connection_unref(conn);
+		conn = NULL;
+	}
+	if (!conn) {
+		fprintf(stderr, "stress_notif: %s\n", err.message);
+		dbus_error_free(&err);
+	}
+	return conn;
+}
+
+/* -------------------------------------------------------------------------
+ * Server: what notif.c's handle_notify does, minus the drawing
+ * ---------------------------------------------------------------------- */
+
+/* Hints a{sv}: only "urgency" (byte) matters here */
+static int
+hints_urgency(DBusMessageIter *hints)
+{
+	DBusMessageIter entry, var;
+	const char     *key;
+	unsigned char   u;
+
+	for (; dbus_message_iter_get_arg_type(hints) == DBUS_TYPE_DICT_ENTRY;
+	     dbus_message_iter_next(hints)) {
+		dbus_message_iter_recurse(hints, &entry);
+		dbus_message_iter_get_basic(&entry, &key);
+		dbus_message_iter_next(&entry);
+		dbus_message_iter_recurse(&entry, &var);
+		if (strcmp(key, "urgency") == 0 &&
+		    dbus_message_iter_get_arg_type(&var) == DBUS_TYPE_BYTE) {
+			dbus_message_iter_get_basic(&var, &u);
+			return u;
+		}
+	}
+	return 1;
+}
+
+static int
+app_index(const char *app)
+{
+	int i;
+
+	if (sscanf(app, "app%d", &i) == 1 && i >= 0 && i < STRESS_APPS)
+		return i;
+	return 0;
+}
+
+static DBusHandlerResult
+server_filter(DBusConnection *conn, DBusMessage *msg, void *user_data)
+{
+	DBusMessageIter it, sub;
+	DBusMessage    *reply;
+	const char     *app, *icon, *summary, *body;
+	uint32_t        replaces_id;
+	int             urgency;
+	NotifVerdict    v;
+
+	(void) user_data;
+	if (!dbus_message_is_method_call(msg, NOTIF_IFACE, "Notify") ||
+	    !dbus_message_has_signature(msg, "susssasa{sv}i"))
+		return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+
+	dbus_message_iter_init(msg, &it);
+	dbus_message_iter_get_basic(&it, &app);
+	dbus_message_iter_next(&it);
+	dbus_message_iter_get_basic(&it, &replaces_id);
+	dbus_message_iter_next(&it);
+	dbus_message_iter_get_basic(&it, &icon);
+	dbus_message_iter_next(&it);
+	dbus_message_iter_get_basic(&it, &summary);
+	dbus_message_iter_next(&it);
+	dbus_message_iter_get_basic(&it, &body);
+	dbus_message_iter_next(&it); /* actions */
+	dbus_message_iter_next(&it);
+	dbus_message_iter_recurse(&it, &sub);
+	urgency = hints_urgency(&sub);
+
+	v = notif_engine_submit(engine, app, summary, replaces_id, urgency == 2,
+	    (int64_t) (now() * 1000));
+	switch (v.action) {
+	case NOTIF_SHOW:
+		srv.shows++;
+		if (urgency == 2)
+			srv.critical++;
+		else
+			srv.app_shows[app_index(app)]++;
+		if (v.evict)
+			srv.evicts++;
+		break;
+	case NOTIF_UPDATE:
+		srv.updates++;
+		break;
+	case NOTIF_DROP:
+		srv.drops++;
+		break;
+	}
+	if (notif_engine_live(engine) > srv.max_live)
+		srv.max_live = notif_engine_live(engine);
+
+	reply = dbus_message_new_method_return(msg);
+	if (!reply)
+		return DBUS_HANDLER_RESULT_NEED_MEMORY;
+	dbus_message_append_args(
+	    reply, DBUS_TYPE_UINT32, &v.id, DBUS_TYPE_INVALID);
+	dbus_connection_send(conn, reply, NULL);
+	dbus_message_unref(reply);
+	return DBUS_HANDLER_RESULT_HANDLED;
+}
+
+/* -------------------------------------------------------------------------
+ * Client
+ * ---------------------------------------------------------------------- */
+
+static void
+on_reply(DBusPendingCall *pending, void *user_data)
+{
+	DBusMessage *reply = dbus_pending_call_steal_reply(pending);
+	int          app   = (int) (intptr_t) user_data;
+	uint32_t     id;
+
+	cli.replies++;
+	if (reply && dbus_message_get_args(reply, NULL, DBUS_TYPE_UINT32, &id,
+	                 DBUS_TYPE_INVALID))
+		cli.last_id[app] = id;
+	else
+		cli.errors++;
+	if (reply)
+		dbus_message_unref(reply);
+	dbus_pending_call_unref(pending);
+}
+
+/* Call i comes from app i % STRESS_APPS:
+ *   app0      progress bar, updates its popup through replaces_id
+ *   app1-3    the same summary over and over
+ *   app4-6    a distinct summary every time
+ *   app7      like app4-6, every 50th call critical */
+static int
+send_notify(DBusConnection *conn, int i)
+{
+	DBusMessage    *msg;
+	DBusMessageIter it, sub, entry, var;
+	DBusPendingCall *pending;
+	int             app = i % STRESS_APPS;
+	char            appname[16], sumbuf[32];
+	const char     *appp = appname, *summary = sumbuf, *empty = "";
+	const char     *key = "urgency";
+	uint32_t        replaces_id = app == 0 ? cli.last_id[0] : 0;
+	unsigned char   urgency = app == 7 && i % 50 == 7 ? 2 : 1;
+	int32_t         timeout = -1;
+
+	snprintf(appname, sizeof(appname), "app%d", app);
+	if (app == 0)
+		snprintf(sumbuf, sizeof(sumbuf), "%d%% done", i % 100);
+	else if (app <= 3)
+		snprintf(sumbuf, sizeof(sumbuf), "build failed");
+	else
+		snprintf(sumbuf, sizeof(sumbuf), "message %d", i);
+
+	msg = dbus_message_new_method_call(
+	    NOTIF_NAME, NOTIF_PATH, NOTIF_IFACE, "Notify");
+	if (!msg)
+		return -1;
+	dbus_message_iter_init_append(msg, &it);
+	dbus_message_iter_append_basic(&it, DBUS_TYPE_STRING, &appp);
+	dbus_message_iter_append_basic(&it, DBUS_TYPE_UINT32, &replaces_id);
+	dbus_message_iter_append_basic(&it, DBUS_TYPE_STRING, &empty);
+	dbus_message_iter_append_basic(&it, DBUS_TYPE_STRING, &summary);
+	dbus_message_iter_append_basic(&it, DBUS_TYPE_STRING, &empty);
+	dbus_message_iter_open_container(&it, DBUS_TYPE_ARRAY, "s", &sub);
+	dbus_message_iter_close_container(&it, &sub);
+	dbus_message_iter_open_container(&it, DBUS_TYPE_ARRAY, "{sv}", &sub);
+	dbus_message_iter_open_container(
+	    &sub, DBUS_TYPE_DICT_ENTRY, NULL, &entry);
+	dbus_message_iter_append_basic(&entry, DBUS_TYPE_STRING, &key);
+	dbus_message_iter_open_container(&entry, DBUS_TYPE_VARIANT, "y", &var);
+	dbus_message_iter_append_basic(&var, DBUS_TYPE_BYTE, &urgency);
+	dbus_message_iter_close_container(&entry, &var);
+	dbus_message_iter_close_container(&sub, &entry);
+	dbus_message_iter_close_container(&it, &sub);
+	dbus_message_iter_append_basic(&it, DBUS_TYPE_INT32, &timeout);
+
+	if (!dbus_connection_send_with_reply(conn, msg, &pending, -1) ||
+	    !pending) {
+		dbus_message_unref(msg);
+		return -1;
+	}
+	dbus_pending_call_set_notify(
+	    pending, on_reply, (void *) (intptr_t) app, NULL);
+	dbus_message_unref(msg);
+	return 0;
+}
+
+/* -------------------------------------------------------------------------
+ * main
+ * ---------------------------------------------------------------------- */
+
+int
+main(int argc, char **argv)
+{
+	int             ncalls = argc > 1 ? atoi(argv[1]) : STRESS_CALLS;
+	char            addr[512];
+	pid_t           bus;
+	DBusConnection *server = NULL, *client = NULL;
+	DBusError       err;
+	int             sent = 0, fail = 0;
+	double          t0, t;
+
+	if (ncalls < 1) {
+		fprintf(stderr, "calls must be positive\n");
+		return 1;
+	}
+	bus = bus_start(addr, sizeof(addr));
+	if (bus < 0) {
+		printf("stress_notif: no dbus-daemon, skipped\n");
+		return 0;
+	}
+
+	engine = notif_engine_new(&lim);
+	server = bus_connect(addr);
+	client = bus_connect(addr);
+	if (!engine || !server || !client) {
+		fail = 1;
+		goto out;
+	}
+	dbus_error_init(&err);
+	if (dbus_bus_request_name(server, NOTIF_NAME,
+	        DBUS_NAME_FLAG_DO_NOT_QUEUE, &err) !=
+	    DBUS_REQUEST_NAME_REPLY_PRIMARY_OWNER) {
+		fprintf(stderr, "stress_notif: cannot own %s\n", NOTIF_NAME);
+		dbus_error_free(&err);
+		fail = 1;
+		goto out;
+	}
+	dbus_connection_add_filter(server, server_filter, NULL, NULL);
+
+	t0 = now();
+	while (cli.replies < (unsigned long) ncalls) {
+		while (sent < ncalls &&
+		    (unsigned long) sent - cli.replies < STRESS_WINDOW) {
+			if (send_notify(client, sent) < 0) {
+				fprintf(stderr, "stress_notif: out of memory\n");
+				fail = 1;
+				goto out;
+			}
+			sent++;
+		}
+		dbus_connection_read_write_dispatch(client, 0);
+		dbus_connection_read_write_dispatch(server, 0);
+		if (now() - t0 > STRESS_SECS) {
+			fprintf(stderr, "stress_notif: timed out, %lu/%d replies\n",
+			    cli.replies, ncalls);
+			fail = 1;
+			goto out;
+		}
+	}
+	t = now() - t0;
+
+	printf("%d Notify calls in %.2f s (%.0f/s)\n", ncalls, t, ncalls / t);
+	printf("  %lu shown (%lu critical, %lu evicting), %lu updated, "
+	       "%lu dropped\n",
+	    srv.shows, srv.critical, srv.evicts, srv.updates, srv.drops);
+	printf("  at most %d popups live\n", srv.max_live);
+
+	if (cli.errors) {
+		fprintf(stderr, "FAIL: %lu error replies\n", cli.errors);
+		fail = 1;
+	}
+	if (srv.max_live > lim.max_visible) {
+		fprintf(stderr, "FAIL: %d popups live, limit %d\n", srv.max_live,
+		    lim.max_visible);
+		fail = 1;
+	}
+	for (int a = 0; a < STRESS_APPS; a++) {
+		double allowed = lim.burst + lim.rate * t + 1;
+
+		if ((double) srv.app_shows[a] > allowed) {
+			fprintf(stderr, "FAIL: app%d opened %lu popups, allowed %.0f\n",
+			    a, srv.app_shows[a], allowed);
+			fail = 1;
+		}
+	}
+
+out:
+	if (client) {
+		dbus_connection_close(client);
+		dbus_connection_unref(client);
+	}
+	if (server) {
+		dbus_connection_close(server);
+		dbus_connection_unref(server);
+	}
+	notif_engine_free(engine);
+	kill(bus, SIGTERM);
+	waitpid(bus, NULL, 0);
+	if (!fail)
+		printf("stress_notif: ok\n");
+	return fail;
+}
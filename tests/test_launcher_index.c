@@ -0,0 +1,346 @@
+/* See LICENSE file for copyright and license details. */
+/* Tests for src/launcher_index.c: index and icon cache write/open round
+ * trips and staleness detection, the name map, the $PATH directory scan. */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "greatest.h"
+#include "../src/launcher_index.h"
+
+static char idx_path[256];
+
+static const LauncherIndexSrc srcs[] = {
+	{ "/usr/share/applications", 1000 },
+	{ "/usr/bin", 2000 },
+};
+
+static const LauncherIndexEnt ents[] = {
+	{ "Firefox", "firefox", "firefox", "firefox.desktop", 0, 1, 0,
+	    "Web Browser", "Internet;WWW;" },
+	{ "htop", "htop", NULL, "htop.desktop", 0, 1, 1 },
+	{ "ls", "ls", NULL, NULL, 1, 0, 0 },
+};
+
+static void
+setup(void *arg)
+{
+	(void) arg;
+	snprintf(idx_path, sizeof(idx_path), "/tmp/awm_test_idx.%ld/launcher.idx",
+	    (long) getpid());
+}
+
+static void
+teardown(void *arg)
+{
+	char dir[256];
+
+	(void) arg;
+	unlink(idx_path);
+	snprintf(dir, sizeof(dir), "/tmp/awm_test_idx.%ld", (long) getpid());
+	rmdir(dir);
+}
+
+/* -------------------------------------------------------------------------
+ * Round trip
+ * ---------------------------------------------------------------------- */
+
+TEST
+index_round_trip(void)
+{
+	LauncherIndex   *idx;
+	LauncherIndexEnt e;
+
+	ASSERT_EQ(0, launcher_index_write(idx_path, srcs, 2, ents, 3));
+	idx = launcher_index_open(idx_path, srcs, 2);
+	ASSERT(idx != NULL);
+	ASSERT_EQ(3, launcher_index_count(idx));
+
+	launcher_index_get(idx, 0, &e);
+	ASSERT_STR_EQ("Firefox", e.name);
+	ASSERT_STR_EQ("firefox", e.icon_name);
+	ASSERT_STR_EQ("firefox.desktop", e.file);
+	ASSERT_EQ(1, e.is_desktop);
+	ASSERT_STR_EQ("Web Browser", e.generic);
+	ASSERT_STR_EQ("Internet;WWW;", e.keywords);
+
+	launcher_index_get(idx, 1, &e);
+	ASSERT_EQ(NULL, e.generic);
+	ASSERT_EQ(NULL, e.icon_name);
+	ASSERT_EQ(1, e.terminal);
+
+	launcher_index_get(idx, 2, &e);
+	ASSERT_STR_EQ("ls", e.exec);
+	ASSERT_EQ(NULL, e.file);
+	ASSERT_EQ(1, e.src);
+	ASSERT_EQ(0, e.is_desktop);
+
+	launcher_index_close(idx);
+	PASS();
+}
+
+TEST
+index_empty(void)
+{
+	LauncherIndex *idx;
+
+	ASSERT_EQ(0, launcher_index_write(idx_path, srcs, 2, NULL, 0));
+	idx = launcher_index_open(idx_path, srcs, 2);
+	ASSERT(idx != NULL);
+	ASSERT_EQ(0, launcher_index_count(idx));
+	launcher_index_close(idx);
+	PASS();
+}
+
+/* -------------------------------------------------------------------------
+ * Staleness
+ * ---------------------------------------------------------------------- */
+
+TEST
+index_stale_mtime(void)
+{
+	LauncherIndexSrc changed[2] = { srcs[0], srcs[1] };
+
+	ASSERT_EQ(0, launcher_index_write(idx_path, srcs, 2, ents, 3));
+	changed[1].mtime_ns = 2001;
+	ASSERT_EQ(NULL, launcher_index_open(idx_path, changed, 2));
+	PASS();
+}
+
+TEST
+index_stale_sources(void)
+{
+	LauncherIndexSrc other[2] = { srcs[0], { "/usr/local/bin", 2000 } };
+
+	ASSERT_EQ(0, launcher_index_write(idx_path, srcs, 2, ents, 3));
+	ASSERT_EQ(NULL, launcher_index_open(idx_path, other, 2));
+	ASSERT_EQ(NULL, launcher_index_open(idx_path, srcs, 1));
+	PASS();
+}
+
+TEST
+index_truncated(void)
+{
+	ASSERT_EQ(0, launcher_index_write(idx_path, srcs, 2, ents, 3));
+	ASSERT_EQ(0, truncate(idx_path, 40));
+	ASSERT_EQ(NULL, launcher_index_open(idx_path, srcs, 2));
+	PASS();
+}
+
+TEST
+index_missing(void)
+{
+	ASSERT_EQ(NULL, launcher_index_open(idx_path, srcs, 2));
+	PASS();
+}
+
+SUITE(suite_index)
+{
+	SET_SETUP(setup, NULL);
+	SET_TEARDOWN(teardown, NULL);
+	RUN_TEST(index_round_trip);
+	RUN_TEST(index_empty);
+	RUN_TEST(index_stale_mtime);
+	RUN_TEST(index_stale_sources);
+	RUN_TEST(index_truncated);
+	RUN_TEST(index_missing);
+}
+
+/* -------------------------------------------------------------------------
+ * Icon cache
+ * ---------------------------------------------------------------------- */
+
+TEST
+iconcache_round_trip(void)
+{
+	static uint32_t    red[4 * 4], blue[4 * 4];
+	LauncherIconEnt    in[2];
+	LauncherIconCache *c;
+	const uint32_t    *px;
+	int                i;
+
+	for (i = 0; i < 16; i++) {
+		red[i]  = 0xffff0000;
+		blue[i] = 0xff0000ff;
+	}
+	/* unsorted on purpose: the writer sorts for lookup */
+	in[0] = (LauncherIconEnt) { "zed", blue };
+	in[1] = (LauncherIconEnt) { "firefox", red };
+	ASSERT_EQ(0, launcher_iconcache_write(idx_path, "Adwaita", 4, in, 2));
+
+	c = launcher_iconcache_open(idx_path, "Adwaita", 4);
+	ASSERT(c != NULL);
+	ASSERT((px = launcher_iconcache_get(c, "firefox")) != NULL);
+	ASSERT_EQ(0, memcmp(px, red, sizeof(red)));
+	ASSERT((px = launcher_iconcache_get(c, "zed")) != NULL);
+	ASSERT_EQ(0, memcmp(px, blue, sizeof(blue)));
+	ASSERT_EQ(NULL, launcher_iconcache_get(c, "htop"));
+	ASSERT_EQ(NULL, launcher_iconcache_get(c, "a"));
+	launcher_iconcache_close(c);
+	PASS();
+}
+
+TEST
+iconcache_stale(void)
+{
+	static uint32_t pix[4 * 4];
+	LauncherIconEnt in = { "firefox", pix };
+
+	ASSERT_EQ(0, launcher_iconcache_write(idx_path, "Adwaita", 4, &in, 1));
+	ASSERT_EQ(NULL, launcher_iconcache_open(idx_path, "Papirus", 4));
+	ASSERT_EQ(NULL, launcher_iconcache_open(idx_path, "Adwaita", 8));
+	ASSERT_EQ(0, truncate(idx_path, 60));
+	ASSERT_EQ(NULL, launcher_iconcache_open(idx_path, "Adwaita", 4));
+	PASS();
+}
+
+SUITE(suite_iconcache)
+{
+	SET_SETUP(setup, NULL);
+	SET_TEARDOWN(teardown, NULL);
+	RUN_TEST(iconcache_round_trip);
+	RUN_TEST(iconcache_stale);
+}
+
+/* -------------------------------------------------------------------------
+ * Name map
+ * ---------------------------------------------------------------------- */
+
+TEST
+namemap_add_get(void)
+{
+	LauncherNameMap m = { 0 };
+	int             a, b;
+
+	ASSERT_EQ(NULL, launcher_namemap_get(&m, "ls"));
+	ASSERT_EQ(0, launcher_namemap_add(&m, "ls", &a));
+	ASSERT_EQ(1, launcher_namemap_add(&m, "ls", &b)); /* first one stays */
+	ASSERT_EQ(&a, launcher_namemap_get(&m, "ls"));
+	ASSERT_EQ(1, m.n);
+	launcher_namemap_clear(&m);
+	PASS();
+}
+
+/* Fill past several grow steps, delete every other key, check the rest
+ * are still reachable (exercises backward-shift deletion). */
+TEST
+namemap_grow_and_delete(void)
+{
+	static char     keys[2000][8];
+	LauncherNameMap m = { 0 };
+	int             i;
+
+	for (i = 0; i < 2000; i++) {
+		snprintf(keys[i], sizeof(keys[i]), "k%d", i);
+		ASSERT_EQ(0, launcher_namemap_add(&m, keys[i], keys[i]));
+	}
+	for (i = 0; i < 2000; i += 2)
+		launcher_namemap_del(&m, keys[i]);
+	ASSERT_EQ(1000, m.n);
+	for (i = 0; i < 2000; i++) {
+		if (i % 2)
+			ASSERT_EQ(keys[i], launcher_namemap_get(&m, keys[i]));
+		else
+			ASSERT_EQ(NULL, launcher_namemap_get(&m, keys[i]));
+	}
+	launcher_namemap_del(&m, "absent");
+	ASSERT_EQ(1000, m.n);
+	launcher_namemap_clear(&m);
+	PASS();
+}
+
+/* -------------------------------------------------------------------------
+ * Directory scan
+ * ---------------------------------------------------------------------- */
+
+static void
+touch(const char *dir, const char *name, mode_t mode)
+{
+	char path[512];
+	int  fd;
+
+	snprintf(path, sizeof(path), "%s/%s", dir, name);
+	fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, mode);
+	if (fd >= 0)
+		close(fd);
+	chmod(path, mode);
+}
+
+static int
+has_name(const LauncherDirScan *s, const char *name)
+{
+	for (int i = 0; i < s->n; i++)
+		if (strcmp(s->names[i], name) == 0)
+			return 1;
+	return 0;
+}
+
+TEST
+scan_dirs_executables_only(void)
+{
+	char            dir[256], sub[300], link[300];
+	const char     *dirs[2];
+	LauncherDirScan out[2];
+
+	snprintf(dir, sizeof(dir), "/tmp/awm_test_scan.%ld", (long) getpid());
+	mkdir(dir, 0700);
+	touch(dir, "tool", 0755);
+	touch(dir, "data", 0644);
+	touch(dir, ".hidden", 0755);
+	snprintf(sub, sizeof(sub), "%s/subdir", dir);
+	mkdir(sub, 0755);
+	snprintf(link, sizeof(link), "%s/alias", dir);
+	ASSERT_EQ(0, symlink("tool", link));
+
+	dirs[0] = dir;
+	dirs[1] = "/nonexistent/awm";
+	ASSERT_EQ(0, launcher_scan_dirs(dirs, 2, 2, out));
+	ASSERT_EQ(2, out[0].n);
+	ASSERT(has_name(&out[0], "tool"));
+	ASSERT(has_name(&out[0], "alias"));
+	ASSERT_EQ(0, out[1].n);
+	launcher_dirscan_free(out, 2);
+
+	unlink(link);
+	rmdir(sub);
+	snprintf(sub, sizeof(sub), "%s/tool", dir);
+	unlink(sub);
+	snprintf(sub, sizeof(sub), "%s/data", dir);
+	unlink(sub);
+	snprintf(sub, sizeof(sub), "%s/.hidden", dir);
+	unlink(sub);
+	rmdir(dir);
+	PASS();
+}
+
+SUITE(suite_namemap)
+{
+	RUN_TEST(namemap_add_get);
+	RUN_TEST(namemap_grow_and_delete);
+}
+
+SUITE(suite_scan)
+{
+	RUN_TEST(scan_dirs_executables_only);
+}
+
+/* -------------------------------------------------------------------------
+ * main
+ * ---------------------------------------------------------------------- */
+
+GREATEST_MAIN_DEFS();
+
+int
+main(int argc, char **argv)
+{
+	GREATEST_MAIN_BEGIN();
+	RUN_SUITE(suite_index);
+	RUN_SUITE(suite_iconcache);
+	RUN_SUITE(suite_namemap);
+	RUN_SUITE(suite_scan);
+	GREATEST_MAIN_END();
+}
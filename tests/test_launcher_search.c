@@ -0,0 +1,218 @@
+/* See LICENSE file for copyright and license details. */
+/* Tests for src/launcher_search.c: fuzzy scoring, ranking, top-K and the
+ * empty-query order. */
+
+#include <string.h>
+
+#include "greatest.h"
+#include "../src/launcher_search.h"
+
+static const LauncherSearchDoc docs[] = {
+	/* 0 */ { "Firefox", "/usr/lib/firefox/firefox %u", "Web Browser",
+	    "Internet;WWW;", 0 },
+	/* 1 */ { "Terminal", "gnome-terminal", NULL, "shell;prompt;", 0 },
+	/* 2 */ { "xterm", "xterm", NULL, NULL, 0 },
+	/* 3 */ { "Files", "nautilus --new-window", "File Manager", NULL, 0 },
+	/* 4 */ { "FileZilla", "filezilla", "FTP Client", NULL, 0 },
+	/* 5 */ { "GIMP", "env GTK_THEME=Adwaita gimp-2.10 %U", "Image Editor",
+	    NULL, 0 },
+};
+#define NDOCS ((int) (sizeof(docs) / sizeof(docs[0])))
+
+static LauncherSearch *s;
+
+static void
+setup(void *arg)
+{
+	(void) arg;
+	s = launcher_search_build(docs, NDOCS);
+}
+
+static void
+teardown(void *arg)
+{
+	(void) arg;
+	launcher_search_free(s);
+	s = NULL;
+}
+
+/* -------------------------------------------------------------------------
+ * Matching
+ * ---------------------------------------------------------------------- */
+
+TEST
+match_subsequence(void)
+{
+	ASSERT(launcher_search_score(s, 0, "ffx") > 0);
+	ASSERT(launcher_search_score(s, 0, "FIREFOX") > 0);
+	ASSERT_EQ(-1, launcher_search_score(s, 0, "xff"));
+	ASSERT_EQ(-1, launcher_search_score(s, 0, "qz"));
+	PASS();
+}
+
+/* Long gaps cost more than the two matches earn; still a result */
+TEST
+match_scattered(void)
+{
+	char              name[256];
+	LauncherSearchDoc doc = { name, "tool", NULL, NULL, 0 };
+	LauncherSearch   *one;
+
+	memset(name, 'b', sizeof(name) - 1);
+	name[0]               = 'a';
+	name[sizeof(name) - 2] = 'z';
+	name[sizeof(name) - 1] = '\0';
+	one = launcher_search_build(&doc, 1);
+	ASSERT(one != NULL);
+	ASSERT(launcher_search_score(one, 0, "az") >= 0);
+	ASSERT_EQ(-1, launcher_search_score(one, 0, "za"));
+	launcher_search_free(one);
+	PASS();
+}
+
+TEST
+match_other_fields(void)
+{
+	ASSERT(launcher_search_score(s, 0, "browser") > 0); /* GenericName */
+	ASSERT(launcher_search_score(s, 0, "www") > 0);     /* Keywords */
+	ASSERT(launcher_search_score(s, 3, "nautilus") > 0); /* exec basename */
+	ASSERT(launcher_search_score(s, 5, "gimp-2") > 0);  /* env skipped */
+	ASSERT_EQ(-1, launcher_search_score(s, 5, "adwaita"));
+	PASS();
+}
+
+TEST
+match_all_terms(void)
+{
+	ASSERT(launcher_search_score(s, 0, "web fire") > 0);
+	ASSERT_EQ(-1, launcher_search_score(s, 0, "web term"));
+	PASS();
+}
+
+TEST
+boundary_beats_inner(void)
+{
+	/* "term" starts "Terminal" but sits mid-word in "xterm" */
+	ASSERT(launcher_search_score(s, 1, "term") >
+	    launcher_search_score(s, 2, "term"));
+	/* a name hit outranks the same hit in another field */
+	ASSERT(launcher_search_score(s, 3, "files") >
+	    launcher_search_score(s, 4, "client"));
+	PASS();
+}
+
+/* -------------------------------------------------------------------------
+ * Ranking
+ * ---------------------------------------------------------------------- */
+
+TEST
+rank_order(void)
+{
+	int out[NDOCS], n;
+
+	n = launcher_search_query(s, "term", out, NDOCS);
+	ASSERT_EQ(2, n);
+	ASSERT_EQ(1, out[0]);
+	ASSERT_EQ(2, out[1]);
+	PASS();
+}
+
+TEST
+rank_launch_count(void)
+{
+	int out[NDOCS], n;
+
+	/* equal matches: the shorter name wins until the other is used */
+	n = launcher_search_query(s, "fil", out, NDOCS);
+	ASSERT(n >= 2);
+	ASSERT_EQ(3, out[0]);
+	launcher_search_set_count(s, 4, 20);
+	launcher_search_query(s, "fil", out, NDOCS);
+	ASSERT_EQ(4, out[0]);
+	PASS();
+}
+
+TEST
+rank_launch_speed(void)
+{
+	int out[NDOCS];
+
+	/* equal matches and counts: the faster start wins over the shorter
+	 * name, in both orders; more launches still beat a faster start */
+	launcher_search_set_launch_ms(s, 3, 2000);
+	launcher_search_set_launch_ms(s, 4, 300);
+	launcher_search_query(s, "fil", out, NDOCS);
+	ASSERT_EQ(4, out[0]);
+	launcher_search_query(s, "", out, NDOCS);
+	ASSERT_EQ(4, out[0]);
+	ASSERT_EQ(3, out[1]);
+	launcher_search_set_count(s, 3, 1);
+	launcher_search_query(s, "fil", out, NDOCS);
+	ASSERT_EQ(3, out[0]);
+	PASS();
+}
+
+TEST
+rank_top_k(void)
+{
+	int all[NDOCS], top[NDOCS], n;
+
+	n = launcher_search_query(s, "e", all, NDOCS);
+	ASSERT(n > 2);
+	ASSERT_EQ(2, launcher_search_query(s, "e", top, 2));
+	ASSERT_EQ(all[0], top[0]);
+	ASSERT_EQ(all[1], top[1]);
+	PASS();
+}
+
+TEST
+rank_empty_query(void)
+{
+	int out[NDOCS];
+
+	launcher_search_set_count(s, 2, 3);
+	ASSERT_EQ(NDOCS, launcher_search_query(s, "", out, NDOCS));
+	ASSERT_EQ(2, out[0]); /* launched first */
+	ASSERT_EQ(3, out[1]); /* then alphabetical: Files, FileZilla, ... */
+	ASSERT_EQ(4, out[2]);
+	ASSERT_EQ(0, out[3]);
+	ASSERT_EQ(NDOCS, launcher_search_query(s, NULL, out, NDOCS));
+	PASS();
+}
+
+SUITE(suite_match)
+{
+	SET_SETUP(setup, NULL);
+	SET_TEARDOWN(teardown, NULL);
+	RUN_TEST(match_subsequence);
+	RUN_TEST(match_scattered);
+	RUN_TEST(match_other_fields);
+	RUN_TEST(match_all_terms);
+	RUN_TEST(boundary_beats_inner);
+}
+
+SUITE(suite_rank)
+{
+	SET_SETUP(setup, NULL);
+	SET_TEARDOWN(teardown, NULL);
+	RUN_TEST(rank_order);
+	RUN_TEST(rank_launch_count);
+	RUN_TEST(rank_launch_speed);
+	RUN_TEST(rank_top_k);
+	RUN_TEST(rank_empty_query);
+}
+
+/* -------------------------------------------------------------------------
+ * main
+ * ---------------------------------------------------------------------- */
+
+GREATEST_MAIN_DEFS();
+
+int
+main(int argc, char **argv)
+{
+	GREATEST_MAIN_BEGIN();
+	RUN_SUITE(suite_match);
+	RUN_SUITE(suite_rank);
+	GREATEST_MAIN_END();
+}
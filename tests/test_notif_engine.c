@@ -0,0 +1,220 @@
+/* See LICENSE file for copyright and license details. */
+/* Tests for src/notif_engine.c: replacement, coalescing, per-app token
+ * buckets and the visible-popup cap. */
+
+#include <stdio.h>
+
+#include "greatest.h"
+#include "../src/notif_engine.h"
+
+static const NotifLimits lim = { .max_visible = 3, .rate = 2.0, .burst = 2 };
+
+static NotifEngine *e;
+
+static void
+setup(void *arg)
+{
+	(void) arg;
+	e = notif_engine_new(&lim);
+}
+
+static void
+teardown(void *arg)
+{
+	(void) arg;
+	notif_engine_free(e);
+	e = NULL;
+}
+
+TEST
+new_popups_get_fresh_ids(void)
+{
+	NotifVerdict a = notif_engine_submit(e, "mail", "one", 0, 0, 0);
+	NotifVerdict b = notif_engine_submit(e, "chat", "two", 0, 0, 0);
+
+	ASSERT_EQ(NOTIF_SHOW, a.action);
+	ASSERT_EQ(NOTIF_SHOW, b.action);
+	ASSERT(a.id != 0 && b.id != 0 && a.id != b.id);
+	ASSERT_EQ(0, a.evict);
+	ASSERT_EQ(1, a.count);
+	ASSERT_EQ(2, notif_engine_live(e));
+	PASS();
+}
+
+TEST
+replaces_id_updates_in_place(void)
+{
+	NotifVerdict a = notif_engine_submit(e, "chat", "typing", 0, 0, 0);
+	NotifVerdict b = notif_engine_submit(e, "chat", "sent", a.id, 0, 0);
+
+	ASSERT_EQ(NOTIF_UPDATE, b.action);
+	ASSERT_EQ(a.id, b.id);
+	ASSERT_EQ(1, b.count);
+	ASSERT_EQ(1, notif_engine_live(e));
+
+	/* a stale replaces_id is an ordinary new notification */
+	notif_engine_close(e, a.id);
+	b = notif_engine_submit(e, "chat", "again", a.id, 0, 0);
+	ASSERT_EQ(NOTIF_SHOW, b.action);
+	ASSERT(b.id != a.id);
+	PASS();
+}
+
+TEST
+same_summary_coalesces(void)
+{
+	NotifVerdict a = notif_engine_submit(e, "ci", "build failed", 0, 0, 0);
+	NotifVerdict v;
+
+	for (int i = 2; i <= 50; i++) {
+		v = notif_engine_submit(e, "ci", "build failed", 0, 0, i);
+		ASSERT_EQ(NOTIF_UPDATE, v.action);
+		ASSERT_EQ(a.id, v.id);
+		ASSERT_EQ(i, (int) v.count);
+	}
+	/* another app with the same summary is not merged */
+	v = notif_engine_submit(e, "other", "build failed", 0, 0, 0);
+	ASSERT_EQ(NOTIF_SHOW, v.action);
+	ASSERT_EQ(2, notif_engine_live(e));
+	PASS();
+}
+
+TEST
+rate_limit_folds_then_refills(void)
+{
+	NotifVerdict v;
+
+	/* burst of two new popups */
+	notif_engine_submit(e, "bot", "msg 0", 0, 0, 0);
+	v = notif_engine_submit(e, "bot", "msg 1", 0, 0, 0);
+	ASSERT_EQ(NOTIF_SHOW, v.action);
+
+	/* out of tokens: everything lands on the newest popup */
+	for (int i = 2; i < 100; i++) {
+		NotifVerdict f = notif_engine_submit(e, "bot", "msg", 0, 0, 100);
+		ASSERT_EQ(NOTIF_UPDATE, f.action);
+		ASSERT_EQ(v.id, f.id);
+	}
+	ASSERT_EQ(2, notif_engine_live(e));
+
+	/* 2 tokens/s: half a second buys the next popup */
+	v = notif_engine_submit(e, "bot", "later", 0, 0, 600);
+	ASSERT_EQ(NOTIF_SHOW, v.action);
+
+	/* other apps have their own bucket */
+	v = notif_engine_submit(e, "mail", "hi", 0, 0, 600);
+	ASSERT_EQ(NOTIF_SHOW, v.action);
+	PASS();
+}
+
+TEST
+rate_limited_without_popup_drops(void)
+{
+	NotifVerdict a = notif_engine_submit(e, "bot", "a", 0, 0, 0);
+	NotifVerdict b = notif_engine_submit(e, "bot", "b", 0, 0, 0);
+	NotifVerdict v;
+
+	notif_engine_close(e, a.id);
+	notif_engine_close(e, b.id);
+	v = notif_engine_submit(e, "bot", "c", 0, 0, 0);
+	ASSERT_EQ(NOTIF_DROP, v.action);
+	ASSERT(v.id != 0 && v.id != b.id);
+	ASSERT_EQ(0, notif_engine_live(e));
+
+	/* critical notifications are never rate-limited */
+	v = notif_engine_submit(e, "bot", "disk full", 0, 1, 0);
+	ASSERT_EQ(NOTIF_SHOW, v.action);
+	PASS();
+}
+
+/* critical notifications have their own bucket, not an unlimited one */
+TEST
+critical_flood_folds(void)
+{
+	NotifVerdict v, first = { 0 };
+	char         sum[16];
+
+	for (int i = 0; i < 50; i++) {
+		snprintf(sum, sizeof(sum), "alert %d", i);
+		v = notif_engine_submit(e, "bot", sum, 0, 1, 0);
+		ASSERT_EQ(i < 2 ? NOTIF_SHOW : NOTIF_UPDATE, v.action);
+		if (i == 0)
+			first = v;
+	}
+	ASSERT_EQ(2, notif_engine_live(e));
+	ASSERT_EQ(49, (int) v.count);
+
+	/* out of critical tokens and nothing to fold into: still shown */
+	notif_engine_close(e, v.id);
+	notif_engine_close(e, first.id);
+	ASSERT_EQ(0, notif_engine_live(e));
+	v = notif_engine_submit(e, "bot", "alert again", 0, 1, 0);
+	ASSERT_EQ(NOTIF_SHOW, v.action);
+	/* normal ones still have their own tokens */
+	v = notif_engine_submit(e, "bot", "info", 0, 0, 0);
+	ASSERT_EQ(NOTIF_SHOW, v.action);
+	PASS();
+}
+
+TEST
+cap_evicts_oldest(void)
+{
+	NotifVerdict v[4];
+	const char  *apps[] = { "a", "b", "c", "d" };
+
+	for (int i = 0; i < 4; i++)
+		v[i] = notif_engine_submit(e, apps[i], "x", 0, 0, 0);
+	ASSERT_EQ(NOTIF_SHOW, v[3].action);
+	ASSERT_EQ(v[0].id, v[3].evict);
+	ASSERT_EQ(3, notif_engine_live(e));
+
+	/* the evicted popup can no longer be replaced */
+	notif_engine_close(e, 12345); /* unknown: ignored */
+	ASSERT_EQ(NOTIF_SHOW,
+	    notif_engine_submit(e, "e", "y", v[0].id, 0, 0).action);
+	PASS();
+}
+
+TEST
+bad_limits(void)
+{
+	NotifLimits l = lim;
+
+	l.max_visible = 0;
+	ASSERT_EQ(NULL, notif_engine_new(&l));
+	l       = lim;
+	l.burst = 0.5;
+	ASSERT_EQ(NULL, notif_engine_new(&l));
+	ASSERT_EQ(NULL, notif_engine_new(NULL));
+	PASS();
+}
+
+SUITE(suite_engine)
+{
+	SET_SETUP(setup, NULL);
+	SET_TEARDOWN(teardown, NULL);
+	RUN_TEST(new_popups_get_fresh_ids);
+	RUN_TEST(replaces_id_updates_in_place);
+	RUN_TEST(same_summary_coalesces);
+	RUN_TEST(rate_limit_folds_then_refills);
+	RUN_TEST(rate_limited_without_popup_drops);
+	RUN_TEST(critical_flood_folds);
+	RUN_TEST(cap_evicts_oldest);
+	SET_SETUP(NULL, NULL);
+	SET_TEARDOWN(NULL, NULL);
+	RUN_TEST(bad_limits);
+}
+
+/* -------------------------------------------------------------------------
+ * main
+ * ---------------------------------------------------------------------- */
+
+GREATEST_MAIN_DEFS();
+
+int
+main(int argc, char **argv)
+{
+	GREATEST_MAIN_BEGIN();
+	RUN_SUITE(suite_engine);
+	GREATEST_MAIN_END();
+}
@@ -0,0 +1,233 @@
+/* See LICENSE file for copyright and license details. */
+/* Tests for src/pixel.c: every implementation this CPU can run is checked
+ * against a plain per-pixel reference written with divisions. */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "greatest.h"
+#include "../src/pixel.h"
+
+static const char *const impls[] = { "scalar", "sse2", "avx2" };
+
+static uint32_t rng = 0x9e3779b9u;
+
+static uint32_t
+rnd(void)
+{
+	rng ^= rng << 13;
+	rng ^= rng >> 17;
+	rng ^= rng << 5;
+	return rng;
+}
+
+/* Reference: straight (a, r, g, b) to premultiplied 0xAARRGGBB */
+static uint32_t
+ref_premul(unsigned a, unsigned r, unsigned g, unsigned b)
+{
+#define M(c) (((c) * a * 2 + 255) / 510) /* round(c * a / 255) */
+	return (uint32_t) a << 24 | M(r) << 16 | M(g) << 8 | M(b);
+#undef M
+}
+
+static uint32_t
+ref_pixel(const uint8_t *s, PixelFormat fmt)
+{
+	uint32_t w;
+
+	switch (fmt) {
+	case PIXEL_ARGB32:
+		memcpy(&w, s, 4);
+		return ref_premul(w >> 24, (w >> 16) & 0xff, (w >> 8) & 0xff,
+		    w & 0xff);
+	case PIXEL_ARGB_BE:
+		return ref_premul(s[0], s[1], s[2], s[3]);
+	case PIXEL_RGBA:
+		return ref_premul(s[3], s[0], s[1], s[2]);
+	case PIXEL_RGB:
+		return ref_premul(255, s[0], s[1], s[2]);
+	}
+	return 0;
+}
+
+/* -------------------------------------------------------------------------
+ * Conversion
+ * ---------------------------------------------------------------------- */
+
+/* Every (colour, alpha) pair in every format, in rows of awkward widths
+ * so vector bodies and scalar tails are both hit. */
+TEST
+convert_exhaustive(const char *name)
+{
+	enum { N = 256 * 256 };
+	static uint8_t  src[N * 4];
+	static uint32_t dst[N];
+
+	if (pixel_use(name) < 0)
+		SKIPm(name);
+	for (int fmt = PIXEL_ARGB32; fmt <= PIXEL_RGB; fmt++) {
+		int bpp = pixel_format_bpp((PixelFormat) fmt);
+		int w   = 61, h = N / w;
+
+		for (int i = 0; i < N; i++) {
+			uint8_t c = (uint8_t) (i & 0xff), a = (uint8_t) (i >> 8);
+			uint8_t px[4] = { a, c, (uint8_t) (255 - c), (uint8_t) (c ^ a) };
+			memcpy(src + (size_t) i * bpp, px, (size_t) bpp);
+		}
+		pixel_to_argb32(dst, (size_t) w * 4, src, (size_t) w * bpp, w, h,
+		    (PixelFormat) fmt);
+		for (int i = 0; i < w * h; i++)
+			ASSERT_EQ_FMT(ref_pixel(src + (size_t) i * bpp, (PixelFormat) fmt),
+			    dst[i], "%08x");
+	}
+	PASS();
+}
+
+/* Random images with padded strides; the padding must be left alone */
+TEST
+convert_strides(const char *name)
+{
+	static uint8_t  src[70 * 40 * 4];
+	static uint32_t dst[80 * 40];
+
+	if (pixel_use(name) < 0)
+		SKIPm(name);
+	for (int iter = 0; iter < 200; iter++) {
+		PixelFormat fmt = (PixelFormat) (rnd() % 4);
+		int         bpp = pixel_format_bpp(fmt);
+		int         w = 1 + (int) (rnd() % 64), h = 1 + (int) (rnd() % 40);
+		size_t      ss = (size_t) w * bpp + rnd() % 8;
+
+		for (size_t i = 0; i < sizeof(src); i++)
+			src[i] = (uint8_t) rnd();
+		memset(dst, 0xab, sizeof(dst));
+		pixel_to_argb32(dst, 80 * 4, src, ss, w, h, fmt);
+		for (int y = 0; y < h; y++) {
+			for (int x = 0; x < 80; x++) {
+				uint32_t want = x < w
+				    ? ref_pixel(src + y * ss + (size_t) x * bpp, fmt)
+				    : 0xabababab;
+				ASSERT_EQ_FMT(want, dst[y * 80 + x], "%08x");
+			}
+		}
+	}
+	PASS();
+}
+
+/* -------------------------------------------------------------------------
+ * Box downscale
+ * ---------------------------------------------------------------------- */
+
+static void
+ref_box(uint32_t *dst, int dw, int dh, const uint32_t *src, int sw, int sh)
+{
+	for (int y = 0; y < dh; y++) {
+		for (int x = 0; x < dw; x++) {
+			int      y0 = y * sh / dh, y1 = (y + 1) * sh / dh;
+			int      x0 = x * sw / dw, x1 = (x + 1) * sw / dw;
+			uint32_t n = (uint32_t) ((y1 - y0) * (x1 - x0)), s[4] = { 0 };
+			uint8_t  px[4];
+
+			for (int sy = y0; sy < y1; sy++) {
+				for (int sx = x0; sx < x1; sx++) {
+					const uint8_t *p =
+					    (const uint8_t *) &src[sy * sw + sx];
+					for (int c = 0; c < 4; c++)
+						s[c] += p[c];
+				}
+			}
+			for (int c = 0; c < 4; c++)
+				px[c] = (uint8_t) ((s[c] + n / 2) / n);
+			memcpy(&dst[y * dw + x], px, 4);
+		}
+	}
+}
+
+TEST
+box_matches_reference(const char *name)
+{
+	static uint32_t src[97 * 83], dst[97 * 83], want[97 * 83];
+
+	if (pixel_use(name) < 0)
+		SKIPm(name);
+	for (int iter = 0; iter < 100; iter++) {
+		int sw = 1 + (int) (rnd() % 97), sh = 1 + (int) (rnd() % 83);
+		int dw = 1 + (int) (rnd() % (unsigned) sw);
+		int dh = 1 + (int) (rnd() % (unsigned) sh);
+
+		for (int i = 0; i < sw * sh; i++) {
+			uint32_t a = rnd() & 0xff, c = rnd();
+			src[i] =
+			    ref_premul(a, c & 0xff, (c >> 8) & 0xff, (c >> 16) & 0xff);
+		}
+		ref_box(want, dw, dh, src, sw, sh);
+		ASSERT_EQ(0, pixel_downscale_box(dst, (size_t) dw * 4, dw, dh, src,
+		                 (size_t) sw * 4, sw, sh));
+		ASSERT_MEM_EQ(want, dst, (size_t) (dw * dh) * 4);
+	}
+	PASS();
+}
+
+TEST
+box_uniform_and_invalid(void)
+{
+	static uint32_t src[256 * 256], dst[32 * 32];
+
+	for (int i = 0; i < 256 * 256; i++)
+		src[i] = 0x80402010u;
+	ASSERT_EQ(0, pixel_downscale_box(
+	                 dst, 32 * 4, 32, 32, src, 256 * 4, 256, 256));
+	for (int i = 0; i < 32 * 32; i++)
+		ASSERT_EQ_FMT(0x80402010u, dst[i], "%08x");
+
+	/* upscaling and empty sizes are refused */
+	ASSERT_EQ(-1, pixel_downscale_box(dst, 4, 2, 1, src, 4, 1, 1));
+	ASSERT_EQ(-1, pixel_downscale_box(dst, 4, 0, 1, src, 4, 1, 1));
+	ASSERT_EQ(-1, pixel_downscale_box(dst, 4, 1, 1, src, 4, 1 << 13, 1 << 12));
+	PASS();
+}
+
+TEST
+dispatch(void)
+{
+	ASSERT_EQ(0, pixel_use("scalar"));
+	ASSERT_STR_EQ("scalar", pixel_impl());
+	ASSERT_EQ(-1, pixel_use("mmx"));
+	PASS();
+}
+
+SUITE(suite_convert)
+{
+	for (size_t i = 0; i < sizeof(impls) / sizeof(impls[0]); i++) {
+		greatest_set_test_suffix(impls[i]);
+		RUN_TEST1(convert_exhaustive, impls[i]);
+		greatest_set_test_suffix(impls[i]);
+		RUN_TEST1(convert_strides, impls[i]);
+	}
+}
+
+SUITE(suite_box)
+{
+	for (size_t i = 0; i < sizeof(impls) / sizeof(impls[0]); i++) {
+		greatest_set_test_suffix(impls[i]);
+		RUN_TEST1(box_matches_reference, impls[i]);
+	}
+	RUN_TEST(box_uniform_and_invalid);
+	RUN_TEST(dispatch);
+}
+
+/* -------------------------------------------------------------------------
+ * main
+ * ---------------------------------------------------------------------- */
+
+GREATEST_MAIN_DEFS();
+
+int
+main(int argc, char **argv)
+{
+	GREATEST_MAIN_BEGIN();
+	RUN_SUITE(suite_convert);
+	RUN_SUITE(suite_box);
+	GREATEST_MAIN_END();
+}
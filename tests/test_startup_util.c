@@ -0,0 +1,187 @@
+/* See LICENSE file for copyright and license details. */
+/* Tests for src/startup_util.c: _NET_STARTUP_INFO message parsing and the
+ * launch statistics file. */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "greatest.h"
+#include "../src/startup_util.h"
+
+/* -------------------------------------------------------------------------
+ * Message parsing
+ * ---------------------------------------------------------------------- */
+
+TEST
+msg_type(void)
+{
+	char t[16];
+
+	ASSERT_EQ(0, startup_msg_type("new: ID=a", t, sizeof(t)));
+	ASSERT_STR_EQ("new", t);
+	ASSERT_EQ(0, startup_msg_type("remove: ID=a", t, sizeof(t)));
+	ASSERT_STR_EQ("remove", t);
+	ASSERT_EQ(-1, startup_msg_type("ID=a", t, sizeof(t)));
+	ASSERT_EQ(-1, startup_msg_type("bad type: ID=a", t, sizeof(t)));
+	PASS();
+}
+
+TEST
+msg_get_plain(void)
+{
+	const char *m = "new: ID=foo-1_TIME123 SCREEN=0 BIN=firefox";
+	char        v[64];
+
+	ASSERT_EQ(0, startup_msg_get(m, "ID", v, sizeof(v)));
+	ASSERT_STR_EQ("foo-1_TIME123", v);
+	ASSERT_EQ(0, startup_msg_get(m, "BIN", v, sizeof(v)));
+	ASSERT_STR_EQ("firefox", v);
+	ASSERT_EQ(-1, startup_msg_get(m, "NAME", v, sizeof(v)));
+	ASSERT_STR_EQ("", v);
+	PASS();
+}
+
+TEST
+msg_get_quoted_escaped(void)
+{
+	const char *m =
+	    "new: NAME=\"Web Browser\" DESCRIPTION=a\\ b\\\"c ID=\"x\\\\y\"";
+	char v[64];
+
+	ASSERT_EQ(0, startup_msg_get(m, "NAME", v, sizeof(v)));
+	ASSERT_STR_EQ("Web Browser", v);
+	ASSERT_EQ(0, startup_msg_get(m, "DESCRIPTION", v, sizeof(v)));
+	ASSERT_STR_EQ("a b\"c", v);
+	ASSERT_EQ(0, startup_msg_get(m, "ID", v, sizeof(v)));
+	ASSERT_STR_EQ("x\\y", v);
+	PASS();
+}
+
+TEST
+msg_get_truncates(void)
+{
+	char v[4];
+
+	ASSERT_EQ(0, startup_msg_get("new: ID=abcdef", "ID", v, sizeof(v)));
+	ASSERT_STR_EQ("abc", v);
+	PASS();
+}
+
+TEST
+cmd_key(void)
+{
+	char k[16];
+
+	startup_cmd_key("  /usr/bin/firefox --new-window %u", k, sizeof(k));
+	ASSERT_STR_EQ("firefox", k);
+	startup_cmd_key("st", k, sizeof(k));
+	ASSERT_STR_EQ("st", k);
+	startup_cmd_key("", k, sizeof(k));
+	ASSERT_STR_EQ("", k);
+	PASS();
+}
+
+SUITE(suite_msg)
+{
+	RUN_TEST(msg_type);
+	RUN_TEST(msg_get_plain);
+	RUN_TEST(msg_get_quoted_escaped);
+	RUN_TEST(msg_get_truncates);
+	RUN_TEST(cmd_key);
+}
+
+/* -------------------------------------------------------------------------
+ * Stats file
+ * ---------------------------------------------------------------------- */
+
+static char stats_path[256];
+
+static void
+setup(void *arg)
+{
+	(void) arg;
+	snprintf(stats_path, sizeof(stats_path),
+	    "/tmp/awm_test_stats.%ld/launch_stats", (long) getpid());
+}
+
+static void
+teardown(void *arg)
+{
+	char dir[256];
+
+	(void) arg;
+	unlink(stats_path);
+	snprintf(dir, sizeof(dir), "/tmp/awm_test_stats.%ld", (long) getpid());
+	rmdir(dir);
+}
+
+TEST
+stats_record_average(void)
+{
+	StartupStat s;
+
+	ASSERT_EQ(-1, startup_stats_get(stats_path, "Firefox", &s));
+	ASSERT_EQ(0, startup_stats_record(stats_path, "Firefox", 100.0));
+	ASSERT_EQ(0, startup_stats_record(stats_path, "st", 20.0));
+	ASSERT_EQ(0, startup_stats_record(stats_path, "Firefox", 300.0));
+
+	ASSERT_EQ(0, startup_stats_get(stats_path, "Firefox", &s));
+	ASSERT_EQ(2, s.launches);
+	ASSERT_IN_RANGE(200.0, s.avg_ms, 0.01);
+	ASSERT_IN_RANGE(300.0, s.last_ms, 0.01);
+	ASSERT_EQ(0, startup_stats_get(stats_path, "st", &s));
+	ASSERT_EQ(1, s.launches);
+	PASS();
+}
+
+TEST
+stats_name_sanitised(void)
+{
+	StartupStat s;
+
+	ASSERT_EQ(0, startup_stats_record(stats_path, "a\tb", 5.0));
+	ASSERT_EQ(0, startup_stats_get(stats_path, "a b", &s));
+	ASSERT_EQ(1, s.launches);
+	PASS();
+}
+
+TEST
+stats_record_batch(void)
+{
+	StartupSample smp[] = { { "st", 10.0 }, { "xterm", 50.0 },
+		{ "st", 30.0 } };
+	StartupStat   s;
+
+	ASSERT_EQ(0, startup_stats_record_n(stats_path, smp, 3));
+	ASSERT_EQ(0, startup_stats_get(stats_path, "st", &s));
+	ASSERT_EQ(2, s.launches);
+	ASSERT_IN_RANGE(20.0, s.avg_ms, 0.01);
+	ASSERT_EQ(0, startup_stats_get(stats_path, "xterm", &s));
+	ASSERT_EQ(1, s.launches);
+	PASS();
+}
+
+SUITE(suite_stats)
+{
+	SET_SETUP(setup, NULL);
+	SET_TEARDOWN(teardown, NULL);
+	RUN_TEST(stats_record_average);
+	RUN_TEST(stats_name_sanitised);
+	RUN_TEST(stats_record_batch);
+}
+
+/* -------------------------------------------------------------------------
+ * main
+ * ---------------------------------------------------------------------- */
+
+GREATEST_MAIN_DEFS();
+
+int
+main(int argc, char **argv)
+{
+	GREATEST_MAIN_BEGIN();
+	RUN_SUITE(suite_msg);
+	RUN_SUITE(suite_stats);
+	GREATEST_MAIN_END();
+}
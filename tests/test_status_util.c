@@ -1,5 +1,6 @@
 /* See LICENSE file for copyright and license details. */
-/* Tests for src/status_util.c: status_fmt_human(), status_esnprintf(). */
+/* Tests for src/status_util.c: status_fmt_human(), status_esnprintf(),
+ * status_rate_update(), the status_hist sample ring. */
 
 #include <stdint.h>
 #include <string.h>
@@ -129,6 +130,126 @@ esnprintf_truncation(void)
 	PASS();
 }
 
+/* -------------------------------------------------------------------------
+ * status_rate_update
+ * ---------------------------------------------------------------------- */
+
+TEST
+rate_first_sample_unavailable(void)
+{
+	struct status_rate r = { 0 };
+	ASSERT(status_rate_update(&r, 1000, 10.0) < 0);
+	PASS();
+}
+
+TEST
+rate_delta_per_second(void)
+{
+	struct status_rate r = { 0 };
+	(void) status_rate_update(&r, 1000, 10.0);
+	ASSERT_IN_RANGE(500.0, status_rate_update(&r, 2000, 12.0), 1e-9);
+	ASSERT_IN_RANGE(0.0, status_rate_update(&r, 2000, 13.0), 1e-9);
+	PASS();
+}
+
+TEST
+rate_close_sample_reuses(void)
+{
+	struct status_rate r = { 0 };
+	(void) status_rate_update(&r, 0, 1.0);
+	(void) status_rate_update(&r, 100, 2.0);
+	ASSERT_IN_RANGE(100.0, status_rate_update(&r, 5000, 2.0), 1e-9);
+	ASSERT_IN_RANGE(100.0, status_rate_update(&r, 5000, 2.1), 1e-9);
+	/* the ignored samples did not move the baseline */
+	ASSERT_IN_RANGE(200.0, status_rate_update(&r, 300, 3.0), 1e-9);
+	PASS();
+}
+
+TEST
+rate_counter_reset_restarts(void)
+{
+	struct status_rate r = { 0 };
+	(void) status_rate_update(&r, 5000, 1.0);
+	ASSERT(status_rate_update(&r, 10, 2.0) < 0);
+	ASSERT_IN_RANGE(90.0, status_rate_update(&r, 100, 3.0), 1e-9);
+	PASS();
+}
+
+/* -------------------------------------------------------------------------
+ * status_hist
+ * ---------------------------------------------------------------------- */
+
+TEST
+hist_view_newest_last(void)
+{
+	struct status_hist h = { 0 };
+	const float       *v;
+	unsigned int       n;
+
+	status_hist_push(&h, 1);
+	status_hist_push(&h, 2);
+	status_hist_push(&h, 3);
+	v = status_hist_view(&h, &n);
+	ASSERT_EQ(3u, n);
+	ASSERT_EQ(1.0f, v[0]);
+	ASSERT_EQ(3.0f, v[2]);
+	PASS();
+}
+
+TEST
+hist_view_contiguous_after_wrap(void)
+{
+	struct status_hist h = { 0 };
+	const float       *v;
+	unsigned int       n, i;
+
+	for (i = 0; i < STATUS_HIST_LEN + 10; i++)
+		status_hist_push(&h, (double) i);
+	v = status_hist_view(&h, &n);
+	ASSERT_EQ((unsigned int) STATUS_HIST_LEN, n);
+	for (i = 0; i < n; i++)
+		ASSERT_EQ((float) (i + 10), v[i]);
+	PASS();
+}
+
+TEST
+hist_record_once_per_tick(void)
+{
+	const float  *v;
+	unsigned int  n;
+	unsigned long seq;
+
+	status_tick++;
+	status_hist_record(STATUS_HIST_RAM, 10);
+	status_hist_record(STATUS_HIST_RAM, 20);
+	seq = status_hist_fetch(STATUS_HIST_RAM, &v, &n);
+	ASSERT(seq != 0);
+	ASSERT_EQ(1u, n);
+	ASSERT_EQ(20.0f, v[0]);
+
+	status_tick++;
+	status_hist_record(STATUS_HIST_RAM, 30);
+	ASSERT(status_hist_fetch(STATUS_HIST_RAM, &v, &n) != seq);
+	ASSERT_EQ(2u, n);
+	ASSERT_EQ(30.0f, v[1]);
+	PASS();
+}
+
+TEST
+hist_lookup_names(void)
+{
+	double max;
+
+	ASSERT_EQ(STATUS_HIST_CPU, status_hist_lookup("cpu", &max));
+	ASSERT_IN_RANGE(100.0, max, 1e-9);
+	ASSERT_EQ(STATUS_HIST_CORE0 + 3, status_hist_lookup("core3", &max));
+	ASSERT_EQ(STATUS_HIST_NET_RX, status_hist_lookup("rx", &max));
+	ASSERT_IN_RANGE(0.0, max, 1e-9);
+	ASSERT_EQ(-1, status_hist_lookup("core", &max));
+	ASSERT_EQ(-1, status_hist_lookup("gpu", &max));
+	PASS();
+}
+
 /* -------------------------------------------------------------------------
  * Suites
  * ---------------------------------------------------------------------- */
@@ -155,6 +276,22 @@ SUITE(suite_esnprintf)
 	RUN_TEST(esnprintf_truncation);
 }
 
+SUITE(suite_rate)
+{
+	RUN_TEST(rate_first_sample_unavailable);
+	RUN_TEST(rate_delta_per_second);
+	RUN_TEST(rate_close_sample_reuses);
+	RUN_TEST(rate_counter_reset_restarts);
+}
+
+SUITE(suite_hist)
+{
+	RUN_TEST(hist_view_newest_last);
+	RUN_TEST(hist_view_contiguous_after_wrap);
+	RUN_TEST(hist_record_once_per_tick);
+	RUN_TEST(hist_lookup_names);
+}
+
 /* -------------------------------------------------------------------------
  * main
  * ---------------------------------------------------------------------- */
@@ -167,5 +304,7 @@ main(int argc, char **argv)
 	GREATEST_MAIN_BEGIN();
 	RUN_SUITE(suite_fmt_human);
 	RUN_SUITE(suite_esnprintf);
+	RUN_SUITE(suite_rate);
+	RUN_SUITE(suite_hist);
 	GREATEST_MAIN_END();
 }
@@ -0,0 +1,397 @@
+/* See LICENSE file for copyright and license details. */
+/* Tests for src/ui_proto.c: round trips of every message shape, rejection
+ * of malformed messages, version negotiation, and a fuzz pass that feeds
+ * random and mutated messages to the decoders. */
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "greatest.h"
+#include "../src/ui_proto.h"
+
+static uint8_t buf[UI_MSG_TOTAL(UI_MSG_MAX_PAYLOAD)];
+
+/* -------------------------------------------------------------------------
+ * Round trips
+ * ---------------------------------------------------------------------- */
+
+TEST
+roundtrip_empty(void)
+{
+	UiMsgView v;
+	ssize_t   n;
+
+	n = ui_msg_encode(
+	    buf, sizeof(buf), UI_MSG_LAUNCHER_DISMISSED, NULL, NULL, 0);
+
+	ASSERT_EQ((ssize_t) sizeof(UiMsgHeader), n);
+	ASSERT_EQ(0, ui_msg_decode(buf, (size_t) n, &v));
+	ASSERT_EQ(UI_MSG_LAUNCHER_DISMISSED, v.type);
+	ASSERT_EQ(0, v.len);
+	PASS();
+}
+
+TEST
+roundtrip_fixed(void)
+{
+	UiThemePayload in, out;
+	UiMsgView      v;
+	ssize_t        n;
+
+	memset(&in, 0, sizeof(in));
+	in.norm_fg[0] = 0xffff;
+	in.dpi        = 192.0;
+	snprintf(in.font, sizeof(in.font), "monospace 12");
+
+	n = ui_msg_encode(buf, sizeof(buf), UI_MSG_THEME, &in, NULL, 0);
+	ASSERT_EQ((ssize_t) UI_MSG_TOTAL(sizeof(in)), n);
+	ASSERT_EQ(0, ui_msg_decode(buf, (size_t) n, &v));
+	ASSERT_EQ(0, ui_msg_get_theme(&v, &out));
+	ASSERT_EQ(0, memcmp(&in, &out, sizeof(in)));
+	/* the wrong typed getter refuses */
+	{
+		UiMonitorGeomPayload g;
+		ASSERT_EQ(-1, ui_msg_get_monitor_geom(&v, &g));
+	}
+	PASS();
+}
+
+TEST
+roundtrip_array(void)
+{
+	UiPreviewDonePayload dp = { 0 }, out;
+	uint32_t             xids[100], x;
+	UiMsgView            v;
+	ssize_t              n;
+
+	for (uint32_t i = 0; i < 100; i++)
+		xids[i] = 0x400000 + i;
+	n = ui_msg_encode(buf, sizeof(buf), UI_MSG_PREVIEW_DONE, &dp, xids, 100);
+	ASSERT(n > 0);
+	ASSERT_EQ(0, ui_msg_decode(buf, (size_t) n, &v));
+	ASSERT_EQ(0, ui_msg_get_preview_done(&v, &out));
+	ASSERT_EQ(100, out.count); /* count filled in by the encoder */
+	ASSERT_EQ(100, v.count);
+	ASSERT_EQ(0, ui_msg_elem_preview_done(&v, 99, &x));
+	ASSERT_EQ(0x400000 + 99, x);
+	ASSERT_EQ(-1, ui_msg_elem_preview_done(&v, 100, &x));
+	PASS();
+}
+
+TEST
+array_limit(void)
+{
+	static uint32_t      xids[2048];
+	UiPreviewDonePayload dp  = { 0 };
+	uint32_t             max = ui_msg_max_elems(UI_MSG_PREVIEW_DONE);
+	UiMsgView            v;
+	ssize_t              n;
+
+	ASSERT(max >= 32);
+	ASSERT(max < 2048);
+	n = ui_msg_encode(buf, sizeof(buf), UI_MSG_PREVIEW_DONE, &dp, xids, max);
+	ASSERT(n > 0);
+	ASSERT_EQ(0, ui_msg_decode(buf, (size_t) n, &v));
+	ASSERT_EQ(max, v.count);
+
+	errno = 0;
+	ASSERT_EQ(-1, ui_msg_encode(buf, sizeof(buf), UI_MSG_PREVIEW_DONE, &dp,
+	                  xids, max + 1));
+	ASSERT_EQ(EMSGSIZE, errno);
+	PASS();
+}
+
+TEST
+roundtrip_strings(void)
+{
+	const char *two[] = { "firefox --new-window", "Firefox" };
+	const char *one[] = { "st" };
+	UiMsgView   v;
+	ssize_t     n;
+
+	n = ui_msg_encode(buf, sizeof(buf), UI_MSG_LAUNCHER_EXEC, NULL, two, 2);
+	ASSERT_EQ(0, ui_msg_decode(buf, (size_t) n, &v));
+	ASSERT_EQ(2, v.count);
+	ASSERT_STR_EQ("firefox --new-window", v.str[0]);
+	ASSERT_STR_EQ("Firefox", v.str[1]);
+
+	n = ui_msg_encode(buf, sizeof(buf), UI_MSG_LAUNCHER_EXEC, NULL, one, 1);
+	ASSERT_EQ(0, ui_msg_decode(buf, (size_t) n, &v));
+	ASSERT_EQ(1, v.count);
+	ASSERT_STR_EQ("st", v.str[0]);
+	PASS();
+}
+
+TEST
+roundtrip_bulk(void)
+{
+	static uint8_t       area[4096];
+	UiPreviewShowPayload hdr = { 10, 20, 0 }, outh;
+	UiPreviewEntry       e[3], oute;
+	UiArenaRef           ref = { 64, 300, 400 }, outr;
+	UiMsgView            v;
+	ssize_t              n;
+
+	memset(e, 0, sizeof(e));
+	e[2].xwin = 42;
+	snprintf(e[2].title, sizeof(e[2].title), "term");
+
+	/* inline part: just the reference */
+	n = ui_msg_encode(buf, sizeof(buf), UI_MSG_PREVIEW_SHOW, &ref, NULL, 0);
+	ASSERT_EQ(0, ui_msg_decode(buf, (size_t) n, &v));
+	ASSERT_EQ(0, ui_msg_get_arena_ref(&v, &outr));
+	ASSERT_EQ(300, outr.len);
+	ASSERT_EQ(-1, ui_bulk_get_preview_show(&v, &outh));
+
+	/* contents */
+	ASSERT_EQ(sizeof(hdr) + 3 * sizeof(UiPreviewEntry),
+	    ui_bulk_size(UI_MSG_PREVIEW_SHOW, 3));
+	n = ui_bulk_put_preview_show(area, sizeof(area), &hdr, e, 3);
+	ASSERT_EQ((ssize_t) ui_bulk_size(UI_MSG_PREVIEW_SHOW, 3), n);
+	ASSERT_EQ(0, ui_bulk_decode(UI_MSG_PREVIEW_SHOW, area, (size_t) n, &v));
+	ASSERT_EQ(0, ui_bulk_get_preview_show(&v, &outh));
+	ASSERT_EQ(3, outh.count);
+	ASSERT_EQ(20, outh.anchor_y);
+	ASSERT_EQ(0, ui_bulk_elem_preview_show(&v, 2, &oute));
+	ASSERT_EQ(42, oute.xwin);
+	ASSERT_STR_EQ("term", oute.title);
+	ASSERT_EQ(-1, ui_msg_get_arena_ref(&v, &outr));
+	PASS();
+}
+
+SUITE(suite_roundtrip)
+{
+	RUN_TEST(roundtrip_empty);
+	RUN_TEST(roundtrip_fixed);
+	RUN_TEST(roundtrip_array);
+	RUN_TEST(array_limit);
+	RUN_TEST(roundtrip_strings);
+	RUN_TEST(roundtrip_bulk);
+}
+
+/* -------------------------------------------------------------------------
+ * Malformed messages
+ * ---------------------------------------------------------------------- */
+
+static void
+put_header(uint32_t type, uint32_t len)
+{
+	UiMsgHeader h = { type, len };
+	memcpy(buf, &h, sizeof(h));
+}
+
+TEST
+reject_malformed(void)
+{
+	UiPreviewDonePayload dp = { 0 };
+	uint32_t             xids[4] = { 1, 2, 3, 4 }, big = 1000;
+	UiMsgView            v;
+	ssize_t              n;
+
+	/* short header, unknown type, fd-only type inline */
+	ASSERT_EQ(-1, ui_msg_decode(buf, 3, &v));
+	put_header(99, 0);
+	ASSERT_EQ(-1, ui_msg_decode(buf, sizeof(UiMsgHeader), &v));
+	put_header(UI_MSG_ARENA, 0);
+	ASSERT_EQ(-1, ui_msg_decode(buf, sizeof(UiMsgHeader), &v));
+
+	/* payload_len beyond what was received, or a payload on EMPTY */
+	put_header(UI_MSG_PREVIEW_HIDE, 4);
+	ASSERT_EQ(-1, ui_msg_decode(buf, sizeof(UiMsgHeader), &v));
+	ASSERT_EQ(-1, ui_msg_decode(buf, sizeof(UiMsgHeader) + 4, &v));
+
+	/* FIXED of the wrong size */
+	put_header(UI_MSG_MONITOR_GEOM, sizeof(UiMonitorGeomPayload) - 1);
+	ASSERT_EQ(-1, ui_msg_decode(buf, sizeof(buf), &v));
+
+	/* ARRAY whose count claims more than was sent */
+	n = ui_msg_encode(buf, sizeof(buf), UI_MSG_PREVIEW_DONE, &dp, xids, 4);
+	memcpy(buf + sizeof(UiMsgHeader), &big, sizeof(big));
+	ASSERT_EQ(-1, ui_msg_decode(buf, (size_t) n, &v));
+
+	/* STRINGS without the final NUL, with too many, or with none */
+	put_header(UI_MSG_LAUNCHER_EXEC, 3);
+	memcpy(buf + sizeof(UiMsgHeader), "abc", 3);
+	ASSERT_EQ(-1, ui_msg_decode(buf, UI_MSG_TOTAL(3), &v));
+	put_header(UI_MSG_LAUNCHER_EXEC, 6);
+	memcpy(buf + sizeof(UiMsgHeader), "a\0b\0c\0", 6);
+	ASSERT_EQ(-1, ui_msg_decode(buf, UI_MSG_TOTAL(6), &v));
+	put_header(UI_MSG_LAUNCHER_EXEC, 0);
+	ASSERT_EQ(-1, ui_msg_decode(buf, UI_MSG_TOTAL(0), &v));
+
+	/* encoder refuses what the decoder would refuse */
+	n = ui_msg_encode(buf, sizeof(buf), UI_MSG_ARENA, NULL, NULL, 0);
+	ASSERT_EQ(-1, n);
+	n = ui_msg_encode(buf, sizeof(buf), UI_MSG_THEME, NULL, NULL, 0);
+	ASSERT_EQ(-1, n);
+	n = ui_msg_encode(buf, sizeof(buf), UI_MSG_LAUNCHER_EXEC, NULL, NULL, 0);
+	ASSERT_EQ(-1, n);
+	PASS();
+}
+
+TEST
+reject_bulk(void)
+{
+	static uint8_t       area[1024];
+	UiPreviewShowPayload hdr = { 0, 0, 0 };
+	UiPreviewEntry       e[2];
+	UiMsgView            v;
+	ssize_t              n;
+
+	memset(e, 0, sizeof(e));
+	n = ui_bulk_put_preview_show(area, sizeof(area), &hdr, e, 2);
+	ASSERT(n > 0);
+	ASSERT_EQ(
+	    -1, ui_bulk_decode(UI_MSG_PREVIEW_SHOW, area, (size_t) n - 1, &v));
+	ASSERT_EQ(
+	    -1, ui_bulk_decode(UI_MSG_PREVIEW_SHOW, area, (size_t) n + 1, &v));
+	ASSERT_EQ(-1, ui_bulk_decode(UI_MSG_THEME, area, (size_t) n, &v));
+	ASSERT_EQ(-1, ui_bulk_put_preview_show(area, 10, &hdr, e, 2));
+	PASS();
+}
+
+SUITE(suite_reject)
+{
+	RUN_TEST(reject_malformed);
+	RUN_TEST(reject_bulk);
+}
+
+/* -------------------------------------------------------------------------
+ * Version negotiation
+ * ---------------------------------------------------------------------- */
+
+TEST
+negotiate(void)
+{
+	UiHelloPayload same  = { UI_PROTO_VERSION, UI_PROTO_MIN_VERSION };
+	UiHelloPayload newer = { UI_PROTO_VERSION + 3, UI_PROTO_MIN_VERSION };
+	UiHelloPayload picky = { UI_PROTO_VERSION + 3, UI_PROTO_VERSION + 1 };
+	UiHelloPayload old   = { UI_PROTO_MIN_VERSION - 1, 0 };
+
+	ASSERT_EQ(UI_PROTO_VERSION, ui_proto_negotiate(&same));
+	ASSERT_EQ(UI_PROTO_VERSION, ui_proto_negotiate(&newer));
+	ASSERT_EQ(0, ui_proto_negotiate(&picky));
+	ASSERT_EQ(0, ui_proto_negotiate(&old));
+	PASS();
+}
+
+SUITE(suite_version)
+{
+	RUN_TEST(negotiate);
+}
+
+/* -------------------------------------------------------------------------
+ * Fuzz
+ *
+ * Random bytes and single-byte mutations of valid messages.  Whatever the
+ * decoders accept must lie entirely inside the received buffer.
+ * ---------------------------------------------------------------------- */
+
+static uint32_t rng = 0x9e3779b9u;
+
+static uint32_t
+rnd(void)
+{
+	rng ^= rng << 13;
+	rng ^= rng >> 17;
+	rng ^= rng << 5;
+	return rng;
+}
+
+/* Check that an accepted view v of len bytes at base stays inside it. */
+static int
+view_inside(const UiMsgView *v, const uint8_t *base, size_t len)
+{
+	const uint8_t   *end = base + len;
+	const UiMsgSpec *s   = ui_msg_spec(v->type);
+
+	if (!s || v->payload < base || v->payload + v->len > end)
+		return 0;
+	if (v->elems &&
+	    (v->elems < v->payload ||
+	        v->elems + (size_t) v->count * s->elem > v->payload + v->len))
+		return 0;
+	for (uint32_t i = 0; s->shape == UI_SHAPE_STRINGS && i < v->count; i++)
+		if ((const uint8_t *) v->str[i] + strlen(v->str[i]) >= end)
+			return 0;
+	return 1;
+}
+
+TEST
+fuzz_decode(void)
+{
+	static uint8_t       in[UI_MSG_TOTAL(UI_MSG_MAX_PAYLOAD)];
+	UiPreviewDonePayload dp      = { 0 };
+	uint32_t             xids[8] = { 0 };
+	const char          *strs[]  = { "sh -c true", "Name" };
+	UiThemePayload       th;
+	UiMsgView            v;
+	int                  accepted = 0;
+
+	memset(&th, 0, sizeof(th));
+	for (int iter = 0; iter < 200000; iter++) {
+		size_t len;
+
+		switch (iter % 4) {
+		case 0: /* random header and bytes */
+			len = rnd() % sizeof(in);
+			for (size_t i = 0; i < len; i++)
+				in[i] = (uint8_t) rnd();
+			if (len >= sizeof(UiMsgHeader)) {
+				UiMsgHeader h = { rnd() % (UI_MSG_ID_MAX + 2),
+					(uint32_t) (rnd() % (len + 8)) };
+				memcpy(in, &h, sizeof(h));
+			}
+			break;
+		case 1:
+			len = (size_t) ui_msg_encode(in, sizeof(in),
+			    UI_MSG_PREVIEW_DONE, &dp, xids, rnd() % 8);
+			break;
+		case 2:
+			len = (size_t) ui_msg_encode(
+			    in, sizeof(in), UI_MSG_LAUNCHER_EXEC, NULL, strs, 2);
+			break;
+		default:
+			len = (size_t) ui_msg_encode(
+			    in, sizeof(in), UI_MSG_THEME, &th, NULL, 0);
+			break;
+		}
+		if (iter % 4 && len) {
+			/* flip a byte and maybe cut the message short */
+			in[rnd() % len] ^= (uint8_t) (1u << (rnd() % 8));
+			if (rnd() % 2)
+				len = rnd() % len;
+		}
+		if (ui_msg_decode(in, len, &v) == 0) {
+			accepted++;
+			ASSERT(view_inside(&v, in, len));
+		}
+		if (ui_bulk_decode(UI_MSG_PREVIEW_SHOW, in, len, &v) == 0)
+			ASSERT(view_inside(&v, in, len));
+	}
+	ASSERT(accepted > 0);
+	PASS();
+}
+
+SUITE(suite_fuzz)
+{
+	RUN_TEST(fuzz_decode);
+}
+
+/* -------------------------------------------------------------------------
+ * main
+ * ---------------------------------------------------------------------- */
+
+GREATEST_MAIN_DEFS();
+
+int
+main(int argc, char **argv)
+{
+	GREATEST_MAIN_BEGIN();
+	RUN_SUITE(suite_roundtrip);
+	RUN_SUITE(suite_reject);
+	RUN_SUITE(suite_version);
+	RUN_SUITE(suite_fuzz);
+	GREATEST_MAIN_END();
+}